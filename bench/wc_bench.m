@@ -0,0 +1,393 @@
+/**
+ * @file wc_bench.m
+ * @brief Benchmark harness for WindowControlInjector hot paths
+ *
+ * Creates borderless windows and helper processes in this process, then
+ * times the scanner, the window bridge, helper process lookup, swizzled
+ * NSWindow call-through and the logger. Results are written as JSON so
+ * they can be tracked per commit. Built and run by `make bench`.
+ */
+
+#import <AppKit/AppKit.h>
+#import "../src/core/wc_window_bridge.h"
+#import "../src/core/wc_window_scanner.h"
+#import "../src/interceptors/nswindow_interceptor.h"
+#import "../src/util/logger.h"
+#import "../src/util/wc_cgs_functions.h"
+#import "../src/util/wc_metrics.h"
+#import "../src/util/wc_process_manager.h"
+#import "../src/util/wc_process_tree.h"
+#import <copyfile.h>
+#import <signal.h>
+#import <spawn.h>
+#import <sys/wait.h>
+
+extern char **environ;
+
+// Argument that turns the harness into an idle helper process
+static const char *const kWCBenchHelperArgument = "--bench-helper";
+
+// Helper executables are copies of the harness named like Chrome helpers
+static NSString *const kWCBenchHelperName = @"WCBench Helper";
+
+// Untimed iterations run before each benchmark
+static const NSUInteger kWCBenchWarmupIterations = 3;
+
+/**
+ * Command line options
+ */
+typedef struct {
+    NSUInteger windowCount;
+    NSUInteger helperCount;
+    NSUInteger iterations;
+    NSUInteger callsPerIteration;
+    NSString *outputPath;
+} WCBenchOptions;
+
+#pragma mark - Measurement
+
+static int WCBenchCompareSamples(const void *a, const void *b) {
+    uint64_t left = *(const uint64_t *)a;
+    uint64_t right = *(const uint64_t *)b;
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+/**
+ * Time a block and summarize the samples
+ *
+ * @param name Benchmark name in the results
+ * @param iterations Timed iterations
+ * @param operationsPerIteration Operations the block performs, for the per-operation time
+ * @param body The code to time
+ * @return Dictionary of results in nanoseconds
+ */
+static NSDictionary *WCBenchMeasure(NSString *name,
+                                    NSUInteger iterations,
+                                    NSUInteger operationsPerIteration,
+                                    void (^body)(void)) {
+    fprintf(stderr, "Running %s...\n", name.UTF8String);
+
+    for (NSUInteger i = 0; i < kWCBenchWarmupIterations; i++) {
+        @autoreleasepool {
+            body();
+        }
+    }
+
+    uint64_t *samples = calloc(iterations, sizeof(uint64_t));
+    if (!samples) {
+        return @{ @"name": name, @"error": @"out of memory" };
+    }
+
+    uint64_t total = 0;
+    for (NSUInteger i = 0; i < iterations; i++) {
+        @autoreleasepool {
+            uint64_t start = WCMetricsNow();
+            body();
+            samples[i] = WCMetricsNow() - start;
+        }
+        total += samples[i];
+    }
+
+    qsort(samples, iterations, sizeof(uint64_t), WCBenchCompareSamples);
+
+    double mean = (double)total / (double)iterations;
+    NSDictionary *result = @{
+        @"name": name,
+        @"iterations": @(iterations),
+        @"operationsPerIteration": @(operationsPerIteration),
+        @"meanNs": @(mean),
+        @"minNs": @(samples[0]),
+        @"p50Ns": @(samples[iterations / 2]),
+        @"p90Ns": @(samples[(iterations * 9) / 10]),
+        @"p99Ns": @(samples[(iterations * 99) / 100]),
+        @"maxNs": @(samples[iterations - 1]),
+        @"nsPerOperation": @(mean / (double)operationsPerIteration)
+    };
+
+    free(samples);
+    return result;
+}
+
+#pragma mark - Fixtures
+
+static void WCBenchRunHelper(void) {
+    // Idle until the harness kills us, and never outlive it
+    while (getppid() != 1) {
+        sleep(1);
+    }
+    exit(0);
+}
+
+static NSArray<NSWindow *> *WCBenchCreateWindows(NSUInteger count) {
+    NSMutableArray<NSWindow *> *windows = [NSMutableArray arrayWithCapacity:count];
+
+    for (NSUInteger i = 0; i < count; i++) {
+        NSRect frame = NSMakeRect(20.0 + (CGFloat)(i % 10) * 8.0, 20.0 + (CGFloat)(i / 10) * 8.0, 64.0, 64.0);
+        NSWindow *window = [[NSWindow alloc] initWithContentRect:frame
+                                                       styleMask:NSWindowStyleMaskBorderless
+                                                         backing:NSBackingStoreBuffered
+                                                           defer:NO];
+        window.releasedWhenClosed = NO;
+        [window orderFrontRegardless];
+        [windows addObject:window];
+    }
+
+    // Let the window server register the windows before they are scanned
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.25]];
+    return [windows copy];
+}
+
+static NSString *WCBenchCreateHelperExecutable(void) {
+    NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent:
+                           [NSString stringWithFormat:@"wc_bench_%d", (int)getpid()]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory
+                              withIntermediateDirectories:YES
+                                               attributes:nil
+                                                    error:NULL];
+
+    NSString *helperPath = [directory stringByAppendingPathComponent:kWCBenchHelperName];
+    NSString *selfPath = [[NSBundle mainBundle] executablePath];
+    if (copyfile(selfPath.fileSystemRepresentation, helperPath.fileSystemRepresentation, NULL, COPYFILE_ALL) != 0) {
+        fprintf(stderr, "Could not create helper executable at %s: %s\n", helperPath.UTF8String, strerror(errno));
+        return nil;
+    }
+    return helperPath;
+}
+
+static NSArray<NSNumber *> *WCBenchSpawnHelpers(NSString *helperPath, NSUInteger count) {
+    NSMutableArray<NSNumber *> *helperPIDs = [NSMutableArray arrayWithCapacity:count];
+    if (!helperPath) return helperPIDs;
+
+    for (NSUInteger i = 0; i < count; i++) {
+        char *argv[] = { (char *)helperPath.fileSystemRepresentation, (char *)kWCBenchHelperArgument, NULL };
+        pid_t pid = 0;
+        int status = posix_spawn(&pid, argv[0], NULL, NULL, argv, environ);
+        if (status != 0) {
+            fprintf(stderr, "Could not spawn helper %lu: %s\n", (unsigned long)i, strerror(status));
+            break;
+        }
+        [helperPIDs addObject:@(pid)];
+    }
+
+    // Make sure the helpers have exec'd so the process table shows their names
+    usleep(200 * 1000);
+    [WCProcessTree invalidateRecentTree];
+    return helperPIDs;
+}
+
+static void WCBenchStopHelpers(NSArray<NSNumber *> *helperPIDs, NSString *helperPath) {
+    for (NSNumber *pid in helperPIDs) {
+        kill([pid intValue], SIGTERM);
+    }
+    for (NSNumber *pid in helperPIDs) {
+        waitpid([pid intValue], NULL, 0);
+    }
+    if (helperPath) {
+        [[NSFileManager defaultManager] removeItemAtPath:[helperPath stringByDeletingLastPathComponent] error:NULL];
+    }
+}
+
+#pragma mark - Benchmarks
+
+static NSArray<NSDictionary *> *WCBenchRunAll(const WCBenchOptions *options, NSArray<NSWindow *> *windows) {
+    NSMutableArray<NSDictionary *> *results = [NSMutableArray array];
+    NSUInteger iterations = options->iterations;
+    NSUInteger calls = options->callsPerIteration;
+    pid_t currentPID = getpid();
+    NSWindow *window = windows.firstObject;
+
+    // Window bridge: AppKit windows merged with the window server list
+    [results addObject:WCBenchMeasure(@"bridge.getAllWindowsForCurrentApplication", iterations, 1, ^{
+        (void)[WCWindowBridge getAllWindowsForCurrentApplication];
+    })];
+
+    // Helper lookup, once reading the process table every time and once from the shared snapshot
+    [results addObject:WCBenchMeasure(@"processManager.getChromeRendererProcesses.freshTree", iterations, 1, ^{
+        [WCProcessTree invalidateRecentTree];
+        (void)[WCWindowBridge getChromeRendererProcessesForMainPID:currentPID];
+    })];
+    [results addObject:WCBenchMeasure(@"processManager.getChromeRendererProcesses.recentTree", iterations, 1, ^{
+        (void)[WCWindowBridge getChromeRendererProcessesForMainPID:currentPID];
+    })];
+
+    // Scanner: the first scan protects every window, later scans only reconcile
+    WCWindowScanner *scanner = [WCWindowScanner sharedScanner];
+    [scanner configureForApplicationType:WCApplicationTypeStandard];
+    [results addObject:WCBenchMeasure(@"scanner.scanAndProtectWindows.first", 1, 1, ^{
+        [scanner scanNowAndWait];
+    })];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    [results addObject:WCBenchMeasure(@"scanner.scanAndProtectWindows.steady", iterations, 1, ^{
+        [scanner scanNowAndWait];
+    })];
+
+    if (window) {
+        // NSWindow call-through before and after the interceptor is installed
+        [results addObject:WCBenchMeasure(@"nswindow.level.original", iterations, calls, ^{
+            for (NSUInteger i = 0; i < calls; i++) {
+                (void)[window level];
+            }
+        })];
+        [results addObject:WCBenchMeasure(@"nswindow.setLevel.original", iterations, calls, ^{
+            for (NSUInteger i = 0; i < calls; i++) {
+                [window setLevel:NSFloatingWindowLevel];
+            }
+        })];
+
+        if ([WCNSWindowInterceptor install]) {
+            [results addObject:WCBenchMeasure(@"nswindow.level.swizzled", iterations, calls, ^{
+                for (NSUInteger i = 0; i < calls; i++) {
+                    (void)[window level];
+                }
+            })];
+            [results addObject:WCBenchMeasure(@"nswindow.setLevel.swizzled", iterations, calls, ^{
+                for (NSUInteger i = 0; i < calls; i++) {
+                    [window setLevel:NSFloatingWindowLevel];
+                }
+            })];
+            [WCNSWindowInterceptor uninstall];
+        } else {
+            fprintf(stderr, "NSWindow interceptor could not be installed, skipping swizzled benchmarks\n");
+        }
+    }
+
+    // Logger: messages that reach the file handler and messages filtered by level
+    WCLogger *logger = [WCLogger sharedLogger];
+    [results addObject:WCBenchMeasure(@"logger.enabled", iterations, calls, ^{
+        for (NSUInteger i = 0; i < calls; i++) {
+            WCLogInfo(@"Bench", @"Benchmark message %lu for window %ld", (unsigned long)i, (long)window.windowNumber);
+        }
+        [logger flush];
+    })];
+    [results addObject:WCBenchMeasure(@"logger.filtered", iterations, calls, ^{
+        for (NSUInteger i = 0; i < calls; i++) {
+            WCLogDebug(@"Bench", @"Filtered message %lu for window %ld", (unsigned long)i, (long)window.windowNumber);
+        }
+    })];
+
+    return results;
+}
+
+#pragma mark - Main
+
+static void WCBenchPrintUsage(const char *programName) {
+    fprintf(stderr, "Usage: %s [--windows N] [--helpers M] [--iterations K] [--calls C] [--output PATH]\n", programName);
+    fprintf(stderr, "  --windows N      Borderless windows to create (default 20)\n");
+    fprintf(stderr, "  --helpers M      Helper processes to spawn (default 8)\n");
+    fprintf(stderr, "  --iterations K   Timed iterations per benchmark (default 200)\n");
+    fprintf(stderr, "  --calls C        Calls per iteration for call-through and logger benchmarks (default 1000)\n");
+    fprintf(stderr, "  --output PATH    Write JSON results to PATH instead of stdout\n");
+}
+
+static BOOL WCBenchParseOptions(int argc, const char *argv[], WCBenchOptions *options) {
+    options->windowCount = 20;
+    options->helperCount = 8;
+    options->iterations = 200;
+    options->callsPerIteration = 1000;
+    options->outputPath = nil;
+
+    for (int i = 1; i < argc; i++) {
+        const char *argument = argv[i];
+        BOOL hasValue = i + 1 < argc;
+
+        if (strcmp(argument, "--windows") == 0 && hasValue) {
+            options->windowCount = (NSUInteger)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argument, "--helpers") == 0 && hasValue) {
+            options->helperCount = (NSUInteger)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argument, "--iterations") == 0 && hasValue) {
+            options->iterations = (NSUInteger)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argument, "--calls") == 0 && hasValue) {
+            options->callsPerIteration = (NSUInteger)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argument, "--output") == 0 && hasValue) {
+            options->outputPath = [NSString stringWithUTF8String:argv[++i]];
+        } else {
+            return NO;
+        }
+    }
+
+    if (options->iterations == 0) options->iterations = 1;
+    if (options->callsPerIteration == 0) options->callsPerIteration = 1;
+    return YES;
+}
+
+int main(int argc, const char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], kWCBenchHelperArgument) == 0) {
+        WCBenchRunHelper();
+    }
+
+    @autoreleasepool {
+        WCBenchOptions options;
+        if (!WCBenchParseOptions(argc, argv, &options)) {
+            WCBenchPrintUsage(argv[0]);
+            return 1;
+        }
+
+        // Log the way an injected application does, to a scratch file instead of the console
+        NSString *logPath = [NSTemporaryDirectory() stringByAppendingPathComponent:
+                             [NSString stringWithFormat:@"wc_bench_%d.log", (int)getpid()]];
+        WCLogger *logger = [WCLogger sharedLogger];
+        [logger removeLogHandlerWithIdentifier:@"console"];
+        [logger setLogFilePath:logPath];
+        [logger setLogLevel:WCLogLevelInfo];
+
+        [NSApplication sharedApplication];
+        [NSApp setActivationPolicy:NSApplicationActivationPolicyAccessory];
+        [NSApp finishLaunching];
+
+        [[WCCGSFunctions sharedFunctions] resolveAllFunctions];
+        [WCWindowBridge setupWindowBridge];
+
+        NSString *helperPath = options.helperCount > 0 ? WCBenchCreateHelperExecutable() : nil;
+        NSArray<NSNumber *> *helperPIDs = WCBenchSpawnHelpers(helperPath, options.helperCount);
+        NSArray<NSWindow *> *windows = WCBenchCreateWindows(options.windowCount);
+
+        WCMetricsReset();
+        NSArray<NSDictionary *> *results = WCBenchRunAll(&options, windows);
+        NSDictionary *metrics = WCMetricsCurrentSnapshot();
+
+        for (NSWindow *window in windows) {
+            [window orderOut:nil];
+        }
+        WCBenchStopHelpers(helperPIDs, helperPath);
+        [logger flush];
+        [[NSFileManager defaultManager] removeItemAtPath:logPath error:NULL];
+
+        NSString *commit = [[NSProcessInfo processInfo] environment][@"WC_BENCH_COMMIT"];
+        NSDictionary *report = @{
+            @"commit": commit.length > 0 ? commit : @"unknown",
+            @"date": [[[NSISO8601DateFormatter alloc] init] stringFromDate:[NSDate date]],
+            @"host": [[NSProcessInfo processInfo] operatingSystemVersionString],
+            @"parameters": @{
+                @"windows": @(options.windowCount),
+                @"helpers": @(helperPIDs.count),
+                @"iterations": @(options.iterations),
+                @"callsPerIteration": @(options.callsPerIteration)
+            },
+            @"results": results,
+            @"metrics": metrics
+        };
+
+        NSError *error = nil;
+        NSData *json = [NSJSONSerialization dataWithJSONObject:report
+                                                       options:NSJSONWritingPrettyPrinted | NSJSONWritingSortedKeys
+                                                         error:&error];
+        if (!json) {
+            fprintf(stderr, "Could not encode results: %s\n", error.localizedDescription.UTF8String);
+            return 1;
+        }
+
+        if (options.outputPath) {
+            if (![json writeToFile:options.outputPath options:NSDataWritingAtomic error:&error]) {
+                fprintf(stderr, "Could not write %s: %s\n", options.outputPath.UTF8String,
+                        error.localizedDescription.UTF8String);
+                return 1;
+            }
+            fprintf(stderr, "Results written to %s\n", options.outputPath.UTF8String);
+        } else {
+            fwrite(json.bytes, 1, json.length, stdout);
+            fputc('\n', stdout);
+        }
+    }
+
+    return 0;
+}
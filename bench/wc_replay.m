@@ -0,0 +1,767 @@
+/**
+ * @file wc_replay.m
+ * @brief Deterministic replay of recorded window and process event traces
+ *
+ * Feeds a trace recorded with WCI_TRACE_PATH through the window scanner,
+ * the window bridge and the process watcher in this process, with the
+ * window list, the CGS functions and the process table replaced by mocks
+ * that serve the recorded windows and helpers. Every window the trace
+ * exposes is timed until the scanner protects it, and the CPU time spent
+ * is measured, so scheduler and discovery strategies can be compared
+ * across commits on the same real-world workload. Results are written as
+ * JSON in the layout of wc_bench. Built and run by `make replay`.
+ *
+ * The trace is the window server state the recording scanner observed, so
+ * it also contains that scanner's own changes. Those come back as no-ops:
+ * sharing changes to none are never replayed, and level changes that match
+ * what the replayed scanner set are skipped.
+ */
+
+#import <AppKit/AppKit.h>
+#import "../src/core/wc_app_profile.h"
+#import "../src/core/wc_window_bridge.h"
+#import "../src/core/wc_window_scanner.h"
+#import "../src/util/logger.h"
+#import "../src/util/wc_cgs_functions.h"
+#import "../src/util/wc_event_trace.h"
+#import "../src/util/wc_metrics.h"
+#import "../src/util/wc_process_tree.h"
+#import "../src/util/wc_process_watcher.h"
+#import "../src/util/wc_window_id_set.h"
+#import "../src/util/wc_window_list.h"
+#import <os/lock.h>
+#import <stdatomic.h>
+#import <sys/resource.h>
+
+// Replayed helpers get PIDs above the kernel's maximum, so they never name a real process
+static const pid_t kWCReplayPIDBase = 100000;
+
+// Notification handlers the mock window server can hold
+enum { kWCReplayMaxNotifyProcs = 16 };
+
+/**
+ * Command line options
+ */
+typedef struct {
+    NSString *tracePath;
+    double speed;
+    NSTimeInterval sweepInterval;
+    NSTimeInterval periodicInterval;
+    NSTimeInterval settleTime;
+    NSUInteger workerCount;
+    BOOL onScreenScanning;
+    NSString *outputPath;
+} WCReplayOptions;
+
+#pragma mark - Mock Window Server
+
+/**
+ * One window served by the mock window server
+ */
+typedef struct {
+    pid_t ownerPID;
+    int32_t level;
+    int32_t injectedLevel;      // Last level set through CGS, INT32_MIN if none
+    int32_t sharingType;
+    uint64_t exposedTime;       // When the window became capturable, 0 while protected
+} WCReplayWindow;
+
+typedef struct {
+    CGSNotifyProcPtr proc;
+    CGSNotificationType type;
+    void *userData;
+} WCReplayNotifyProc;
+
+// Mock state, guarded by gMockLock; the scanner reads it from its queue while the replay writes it
+static os_unfair_lock gMockLock = OS_UNFAIR_LOCK_INIT;
+static WCWindowIDMap gWindows;
+static NSMutableDictionary<NSNumber *, NSNumber *> *gParentByPID;
+static NSMutableDictionary<NSNumber *, NSString *> *gNameByPID;
+static WCReplayNotifyProc gNotifyProcs[kWCReplayMaxNotifyProcs];
+static NSUInteger gNotifyProcCount;
+static uint64_t *gLatencySamples;
+static NSUInteger gLatencyCount;
+static NSUInteger gLatencyCapacity;
+
+// Read without the lock for the report
+static _Atomic(uint64_t) gWindowListCopies;
+static _Atomic(uint64_t) gCGSCalls;
+
+static void WCReplayRecordLatencyLocked(uint64_t latency) {
+    if (gLatencyCount == gLatencyCapacity) {
+        NSUInteger capacity = MAX(gLatencyCapacity * 2, 256);
+        uint64_t *samples = realloc(gLatencySamples, capacity * sizeof(uint64_t));
+        if (!samples) return;
+        gLatencySamples = samples;
+        gLatencyCapacity = capacity;
+    }
+    gLatencySamples[gLatencyCount++] = latency;
+}
+
+static void WCReplaySetSharingLocked(WCReplayWindow *window, int32_t sharingType, uint64_t now) {
+    if (sharingType == CGSWindowSharingNone) {
+        if (window->exposedTime != 0) {
+            WCReplayRecordLatencyLocked(now - window->exposedTime);
+            window->exposedTime = 0;
+        }
+    } else if (window->exposedTime == 0) {
+        window->exposedTime = now;
+    }
+    window->sharingType = sharingType;
+}
+
+static void WCReplayAppendWindow(CGWindowID windowID, void *value, void *context) {
+    const WCReplayWindow *window = value;
+    CFMutableArrayRef list = context;
+
+    NSDictionary *entry = @{
+        (__bridge NSString *)kCGWindowNumber: @(windowID),
+        (__bridge NSString *)kCGWindowOwnerPID: @(window->ownerPID),
+        (__bridge NSString *)kCGWindowOwnerName: gNameByPID[@(window->ownerPID)] ?: @"",
+        (__bridge NSString *)kCGWindowName: @"",
+        (__bridge NSString *)kCGWindowLayer: @(window->level),
+        (__bridge NSString *)kCGWindowSharingState: @(window->sharingType),
+        (__bridge NSString *)kCGWindowIsOnscreen: @YES,
+        (__bridge NSString *)kCGWindowAlpha: @1.0,
+        (__bridge NSString *)kCGWindowBounds: CFBridgingRelease(
+            CGRectCreateDictionaryRepresentation(CGRectMake(0, 0, 800, 600)))
+    };
+    CFArrayAppendValue(list, (__bridge CFDictionaryRef)entry);
+}
+
+static CFArrayRef WCReplayCopyWindowList(CGWindowListOption option, CGWindowID relativeToWindow) {
+    atomic_fetch_add_explicit(&gWindowListCopies, 1, memory_order_relaxed);
+
+    CFMutableArrayRef list = CFArrayCreateMutable(kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks);
+
+    os_unfair_lock_lock(&gMockLock);
+    if (option & kCGWindowListOptionIncludingWindow) {
+        WCReplayWindow *window = WCWindowIDMapGet(&gWindows, relativeToWindow);
+        if (window) {
+            WCReplayAppendWindow(relativeToWindow, window, list);
+        }
+    } else {
+        // Every replayed window is on screen, so both list modes see all of them
+        WCWindowIDMapForEach(&gWindows, WCReplayAppendWindow, list);
+    }
+    os_unfair_lock_unlock(&gMockLock);
+
+    return list;
+}
+
+#pragma mark - Mock CGS Functions
+
+static CGSConnectionID WCReplayDefaultConnection(void) {
+    return 1;
+}
+
+static CGError WCReplaySetWindowSharingState(CGSConnectionID cid, CGSWindowID wid, CGSWindowSharingType sharing) {
+    (void)cid;
+
+    atomic_fetch_add_explicit(&gCGSCalls, 1, memory_order_relaxed);
+    uint64_t now = WCMetricsNow();
+
+    os_unfair_lock_lock(&gMockLock);
+    WCReplayWindow *window = WCWindowIDMapGet(&gWindows, wid);
+    if (window) {
+        WCReplaySetSharingLocked(window, (int32_t)sharing, now);
+    }
+    os_unfair_lock_unlock(&gMockLock);
+
+    return window ? kCGErrorSuccess : kCGErrorIllegalArgument;
+}
+
+static CGError WCReplayGetWindowSharingState(CGSConnectionID cid, CGSWindowID wid, CGSWindowSharingType *sharing) {
+    (void)cid;
+
+    atomic_fetch_add_explicit(&gCGSCalls, 1, memory_order_relaxed);
+
+    os_unfair_lock_lock(&gMockLock);
+    WCReplayWindow *window = WCWindowIDMapGet(&gWindows, wid);
+    if (window && sharing) {
+        *sharing = (CGSWindowSharingType)window->sharingType;
+    }
+    os_unfair_lock_unlock(&gMockLock);
+
+    return window ? kCGErrorSuccess : kCGErrorIllegalArgument;
+}
+
+static CGError WCReplaySetWindowLevel(CGSConnectionID cid, CGSWindowID wid, CGWindowLevel level) {
+    (void)cid;
+
+    atomic_fetch_add_explicit(&gCGSCalls, 1, memory_order_relaxed);
+
+    os_unfair_lock_lock(&gMockLock);
+    WCReplayWindow *window = WCWindowIDMapGet(&gWindows, wid);
+    if (window) {
+        window->level = level;
+        window->injectedLevel = level;
+    }
+    os_unfair_lock_unlock(&gMockLock);
+
+    return window ? kCGErrorSuccess : kCGErrorIllegalArgument;
+}
+
+static CGError WCReplayGetWindowLevel(CGSConnectionID cid, CGSWindowID wid, CGWindowLevel *level) {
+    (void)cid;
+
+    atomic_fetch_add_explicit(&gCGSCalls, 1, memory_order_relaxed);
+
+    os_unfair_lock_lock(&gMockLock);
+    WCReplayWindow *window = WCWindowIDMapGet(&gWindows, wid);
+    if (window && level) {
+        *level = window->level;
+    }
+    os_unfair_lock_unlock(&gMockLock);
+
+    return window ? kCGErrorSuccess : kCGErrorIllegalArgument;
+}
+
+static CGError WCReplayRegisterNotifyProc(CGSNotifyProcPtr proc, CGSNotificationType type, void *userData) {
+    os_unfair_lock_lock(&gMockLock);
+    BOOL registered = gNotifyProcCount < kWCReplayMaxNotifyProcs;
+    if (registered) {
+        gNotifyProcs[gNotifyProcCount++] = (WCReplayNotifyProc){ proc, type, userData };
+    }
+    os_unfair_lock_unlock(&gMockLock);
+
+    return registered ? kCGErrorSuccess : kCGErrorCannotComplete;
+}
+
+static CGError WCReplayRemoveNotifyProc(CGSNotifyProcPtr proc, CGSNotificationType type, void *userData) {
+    os_unfair_lock_lock(&gMockLock);
+    for (NSUInteger i = 0; i < gNotifyProcCount; i++) {
+        WCReplayNotifyProc *entry = &gNotifyProcs[i];
+        if (entry->proc == proc && entry->type == type && entry->userData == userData) {
+            gNotifyProcs[i] = gNotifyProcs[--gNotifyProcCount];
+            break;
+        }
+    }
+    os_unfair_lock_unlock(&gMockLock);
+    return kCGErrorSuccess;
+}
+
+static CGError WCReplaySetWindowTags(CGSConnectionID cid, CGSWindowID wid, const CGSWindowTag *tags, int tagSize) {
+    (void)cid;
+    (void)wid;
+    (void)tags;
+    (void)tagSize;
+
+    atomic_fetch_add_explicit(&gCGSCalls, 1, memory_order_relaxed);
+    return kCGErrorSuccess;
+}
+
+static CGError WCReplayUpdate(CGSConnectionID cid) {
+    (void)cid;
+
+    atomic_fetch_add_explicit(&gCGSCalls, 1, memory_order_relaxed);
+    return kCGErrorSuccess;
+}
+
+/**
+ * Level queued on a mock transaction
+ */
+typedef struct {
+    CGSWindowID windowID;
+    CGWindowLevel level;
+} WCReplayQueuedLevel;
+
+static CGSTransactionRef WCReplayTransactionCreate(CGSConnectionID cid) {
+    (void)cid;
+
+    atomic_fetch_add_explicit(&gCGSCalls, 1, memory_order_relaxed);
+    return CFDataCreateMutable(kCFAllocatorDefault, 0);
+}
+
+static CGError WCReplayTransactionSetWindowLevel(CGSTransactionRef transaction, CGSWindowID wid, CGWindowLevel level) {
+    WCReplayQueuedLevel queued = { wid, level };
+    CFDataAppendBytes((CFMutableDataRef)transaction, (const UInt8 *)&queued, sizeof(queued));
+    return kCGErrorSuccess;
+}
+
+static CGError WCReplayTransactionCommit(CGSTransactionRef transaction, int32_t synchronous) {
+    (void)synchronous;
+
+    atomic_fetch_add_explicit(&gCGSCalls, 1, memory_order_relaxed);
+
+    CFDataRef data = (CFDataRef)transaction;
+    const WCReplayQueuedLevel *queued = (const WCReplayQueuedLevel *)CFDataGetBytePtr(data);
+    CFIndex count = CFDataGetLength(data) / (CFIndex)sizeof(WCReplayQueuedLevel);
+
+    os_unfair_lock_lock(&gMockLock);
+    for (CFIndex i = 0; i < count; i++) {
+        WCReplayWindow *window = WCWindowIDMapGet(&gWindows, queued[i].windowID);
+        if (window) {
+            window->level = queued[i].level;
+            window->injectedLevel = queued[i].level;
+        }
+    }
+    os_unfair_lock_unlock(&gMockLock);
+    return kCGErrorSuccess;
+}
+
+static void WCReplayInstallMocks(pid_t rootPID, NSString *rootName) {
+    WCWindowIDMapInit(&gWindows, sizeof(WCReplayWindow), 256);
+    gParentByPID = [NSMutableDictionary dictionaryWithObject:@1 forKey:@(rootPID)];
+    gNameByPID = [NSMutableDictionary dictionaryWithObject:rootName forKey:@(rootPID)];
+
+    WCCGSFunctionTable table = {
+        .defaultConnection = WCReplayDefaultConnection,
+        .setWindowSharingState = WCReplaySetWindowSharingState,
+        .getWindowSharingState = WCReplayGetWindowSharingState,
+        .setWindowLevel = WCReplaySetWindowLevel,
+        .getWindowLevel = WCReplayGetWindowLevel,
+        .registerNotifyProc = WCReplayRegisterNotifyProc,
+        .removeNotifyProc = WCReplayRemoveNotifyProc,
+        .setWindowTags = WCReplaySetWindowTags,
+        .clearWindowTags = WCReplaySetWindowTags,
+        .disableUpdate = WCReplayUpdate,
+        .reenableUpdate = WCReplayUpdate,
+        .transactionCreate = WCReplayTransactionCreate,
+        .transactionSetWindowLevel = WCReplayTransactionSetWindowLevel,
+        .transactionCommit = WCReplayTransactionCommit
+    };
+    [[WCCGSFunctions sharedFunctions] installFunctionTable:&table];
+    WCWindowListSetCopyFunction(WCReplayCopyWindowList);
+
+    [WCProcessTree setProcessTableLoader:^(NSMutableDictionary<NSNumber *, NSNumber *> *parentByPID,
+                                           NSMutableDictionary<NSNumber *, NSString *> *nameByPID) {
+        os_unfair_lock_lock(&gMockLock);
+        [parentByPID addEntriesFromDictionary:gParentByPID];
+        [nameByPID addEntriesFromDictionary:gNameByPID];
+        os_unfair_lock_unlock(&gMockLock);
+    }];
+}
+
+#pragma mark - Replay
+
+/**
+ * State of one replay run, only used on the main thread
+ */
+typedef struct {
+    pid_t recordedRootPID;
+    NSMutableDictionary<NSNumber *, NSNumber *> *pidMap;
+    pid_t nextPID;
+    NSString *helperName;
+    NSUInteger windowsCreated;
+    NSUInteger processesForked;
+} WCReplayRun;
+
+static pid_t WCReplayMapPID(WCReplayRun *run, pid_t recordedPID) {
+    if (recordedPID == run->recordedRootPID || recordedPID <= 0) {
+        return getpid();
+    }
+
+    NSNumber *mapped = run->pidMap[@(recordedPID)];
+    if (!mapped) {
+        mapped = @(run->nextPID++);
+        run->pidMap[@(recordedPID)] = mapped;
+    }
+    return [mapped intValue];
+}
+
+/**
+ * Deliver a window server notification the way the window server would
+ */
+static void WCReplayNotify(CGSNotificationType type, CGWindowID windowID) {
+    WCReplayNotifyProc procs[kWCReplayMaxNotifyProcs];
+    NSUInteger count = 0;
+
+    os_unfair_lock_lock(&gMockLock);
+    for (NSUInteger i = 0; i < gNotifyProcCount; i++) {
+        if (gNotifyProcs[i].type == type) {
+            procs[count++] = gNotifyProcs[i];
+        }
+    }
+    os_unfair_lock_unlock(&gMockLock);
+
+    // Called without the lock; the handler reads the window list back
+    CGSWindowID payload = windowID;
+    for (NSUInteger i = 0; i < count; i++) {
+        procs[i].proc(type, &payload, sizeof(payload), procs[i].userData);
+    }
+}
+
+static void WCReplayApplyEntry(WCReplayRun *run, const WCEventTraceEntry *entry) {
+    uint64_t now = WCMetricsNow();
+
+    switch ((WCEventTraceKind)entry->kind) {
+        case WCEventTraceKindWindowCreated: {
+            bool created = false;
+            os_unfair_lock_lock(&gMockLock);
+            WCReplayWindow *window = WCWindowIDMapUpsert(&gWindows, entry->windowID, &created);
+            if (window && created) {
+                window->ownerPID = WCReplayMapPID(run, entry->pid);
+                window->level = entry->value;
+                window->injectedLevel = INT32_MIN;
+                window->sharingType = CGSWindowSharingReadOnly;
+                WCReplaySetSharingLocked(window, entry->flags, now);
+            }
+            os_unfair_lock_unlock(&gMockLock);
+
+            if (created) {
+                run->windowsCreated++;
+                WCReplayNotify(kCGSWindowDidCreate, entry->windowID);
+            }
+            break;
+        }
+
+        case WCEventTraceKindWindowDestroyed: {
+            os_unfair_lock_lock(&gMockLock);
+            bool removed = WCWindowIDMapRemove(&gWindows, entry->windowID);
+            os_unfair_lock_unlock(&gMockLock);
+
+            if (removed) {
+                WCReplayNotify(kCGSWindowIsTerminated, entry->windowID);
+            }
+            break;
+        }
+
+        case WCEventTraceKindWindowLevel: {
+            os_unfair_lock_lock(&gMockLock);
+            WCReplayWindow *window = WCWindowIDMapGet(&gWindows, entry->windowID);
+            if (window && entry->value != window->injectedLevel) {
+                window->level = entry->value;
+            }
+            os_unfair_lock_unlock(&gMockLock);
+            break;
+        }
+
+        case WCEventTraceKindWindowSharing: {
+            // Protection by the recording scanner; the replayed scanner has to do it itself
+            if (entry->value == CGSWindowSharingNone) break;
+
+            os_unfair_lock_lock(&gMockLock);
+            WCReplayWindow *window = WCWindowIDMapGet(&gWindows, entry->windowID);
+            if (window) {
+                WCReplaySetSharingLocked(window, entry->value, now);
+            }
+            os_unfair_lock_unlock(&gMockLock);
+            break;
+        }
+
+        case WCEventTraceKindProcessForked: {
+            pid_t pid = WCReplayMapPID(run, entry->pid);
+            pid_t parentPID = WCReplayMapPID(run, entry->value);
+
+            os_unfair_lock_lock(&gMockLock);
+            gParentByPID[@(pid)] = @(parentPID);
+            gNameByPID[@(pid)] = run->helperName;
+            os_unfair_lock_unlock(&gMockLock);
+
+            run->processesForked++;
+            [WCProcessTree invalidateRecentTree];
+            [[WCProcessWatcher sharedWatcher] refreshProcesses];
+            break;
+        }
+
+        case WCEventTraceKindProcessExited: {
+            pid_t pid = WCReplayMapPID(run, entry->pid);
+
+            os_unfair_lock_lock(&gMockLock);
+            [gParentByPID removeObjectForKey:@(pid)];
+            [gNameByPID removeObjectForKey:@(pid)];
+            os_unfair_lock_unlock(&gMockLock);
+
+            [WCProcessTree invalidateRecentTree];
+            [[WCProcessWatcher sharedWatcher] refreshProcesses];
+            break;
+        }
+
+        case WCEventTraceKindConfigured:
+            break;
+    }
+}
+
+/**
+ * Run the main run loop until a monotonic deadline, so main queue work keeps flowing
+ */
+static void WCReplayRunUntil(uint64_t deadline) {
+    do {
+        uint64_t now = WCMetricsNow();
+        NSTimeInterval remaining = now < deadline ? (double)(deadline - now) / 1e9 : 0;
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                                 beforeDate:[NSDate dateWithTimeIntervalSinceNow:remaining]];
+    } while (WCMetricsNow() < deadline);
+}
+
+typedef struct {
+    NSUInteger count;
+} WCReplayExposedCount;
+
+static void WCReplayCountExposed(CGWindowID windowID, void *value, void *context) {
+    (void)windowID;
+
+    if (((WCReplayWindow *)value)->exposedTime != 0) {
+        ((WCReplayExposedCount *)context)->count++;
+    }
+}
+
+static NSUInteger WCReplayExposedWindowCount(void) {
+    WCReplayExposedCount exposed = { 0 };
+    os_unfair_lock_lock(&gMockLock);
+    WCWindowIDMapForEach(&gWindows, WCReplayCountExposed, &exposed);
+    os_unfair_lock_unlock(&gMockLock);
+    return exposed.count;
+}
+
+static WCApplicationType WCReplayApplicationType(const WCEventTraceEntry *entries, NSUInteger count) {
+    for (NSUInteger i = 0; i < count; i++) {
+        if (entries[i].kind == WCEventTraceKindConfigured) {
+            return (WCApplicationType)entries[i].value;
+        }
+    }
+    return WCApplicationTypeStandard;
+}
+
+static uint64_t WCReplayCPUTime(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return ((uint64_t)usage.ru_utime.tv_sec + (uint64_t)usage.ru_stime.tv_sec) * NSEC_PER_SEC +
+           ((uint64_t)usage.ru_utime.tv_usec + (uint64_t)usage.ru_stime.tv_usec) * NSEC_PER_USEC;
+}
+
+#pragma mark - Results
+
+static int WCReplayCompareSamples(const void *a, const void *b) {
+    uint64_t left = *(const uint64_t *)a;
+    uint64_t right = *(const uint64_t *)b;
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+static NSDictionary *WCReplayLatencySummary(NSUInteger exposedCount) {
+    os_unfair_lock_lock(&gMockLock);
+    NSUInteger count = gLatencyCount;
+    uint64_t *samples = count > 0 ? malloc(count * sizeof(uint64_t)) : NULL;
+    if (samples) memcpy(samples, gLatencySamples, count * sizeof(uint64_t));
+    os_unfair_lock_unlock(&gMockLock);
+
+    if (!samples) {
+        return @{ @"name": @"replay.protectionLatency", @"samples": @0, @"unprotected": @(exposedCount) };
+    }
+
+    qsort(samples, count, sizeof(uint64_t), WCReplayCompareSamples);
+    uint64_t total = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        total += samples[i];
+    }
+
+    NSDictionary *summary = @{
+        @"name": @"replay.protectionLatency",
+        @"samples": @(count),
+        @"unprotected": @(exposedCount),
+        @"meanNs": @((double)total / (double)count),
+        @"minNs": @(samples[0]),
+        @"p50Ns": @(samples[count / 2]),
+        @"p90Ns": @(samples[(count * 9) / 10]),
+        @"p99Ns": @(samples[(count * 99) / 100]),
+        @"maxNs": @(samples[count - 1])
+    };
+    free(samples);
+    return summary;
+}
+
+#pragma mark - Main
+
+static void WCReplayPrintUsage(const char *programName) {
+    fprintf(stderr, "Usage: %s TRACE [--speed S] [--sweep SECONDS | --periodic SECONDS] [--workers N]\n"
+                    "       [--on-screen] [--settle SECONDS] [--output PATH]\n", programName);
+    fprintf(stderr, "  --speed S          Replay S times faster than recorded, 0 for no waiting (default 1)\n");
+    fprintf(stderr, "  --sweep SECONDS    Event-driven scanning with this sweep interval (default 5)\n");
+    fprintf(stderr, "  --periodic SECONDS Periodic scanning at this interval instead of event-driven\n");
+    fprintf(stderr, "  --workers N        Window list workers, 0 for automatic (default 0)\n");
+    fprintf(stderr, "  --on-screen        List only on-screen windows on routine ticks\n");
+    fprintf(stderr, "  --settle SECONDS   Time allowed after the last event for protection (default 5)\n");
+    fprintf(stderr, "  --output PATH      Write JSON results to PATH instead of stdout\n");
+}
+
+static BOOL WCReplayParseOptions(int argc, const char *argv[], WCReplayOptions *options) {
+    options->tracePath = nil;
+    options->speed = 1.0;
+    options->sweepInterval = 5.0;
+    options->periodicInterval = 0;
+    options->settleTime = 5.0;
+    options->workerCount = 0;
+    options->onScreenScanning = NO;
+    options->outputPath = nil;
+
+    for (int i = 1; i < argc; i++) {
+        const char *argument = argv[i];
+        BOOL hasValue = i + 1 < argc;
+
+        if (strcmp(argument, "--speed") == 0 && hasValue) {
+            options->speed = strtod(argv[++i], NULL);
+        } else if (strcmp(argument, "--sweep") == 0 && hasValue) {
+            options->sweepInterval = strtod(argv[++i], NULL);
+        } else if (strcmp(argument, "--periodic") == 0 && hasValue) {
+            options->periodicInterval = strtod(argv[++i], NULL);
+        } else if (strcmp(argument, "--workers") == 0 && hasValue) {
+            options->workerCount = (NSUInteger)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argument, "--on-screen") == 0) {
+            options->onScreenScanning = YES;
+        } else if (strcmp(argument, "--settle") == 0 && hasValue) {
+            options->settleTime = strtod(argv[++i], NULL);
+        } else if (strcmp(argument, "--output") == 0 && hasValue) {
+            options->outputPath = [NSString stringWithUTF8String:argv[++i]];
+        } else if (argument[0] != '-' && !options->tracePath) {
+            options->tracePath = [NSString stringWithUTF8String:argument];
+        } else {
+            return NO;
+        }
+    }
+
+    if (options->speed < 0) options->speed = 0;
+    if (options->sweepInterval <= 0) options->sweepInterval = 5.0;
+    if (options->settleTime < 0) options->settleTime = 0;
+    return options->tracePath != nil;
+}
+
+int main(int argc, const char *argv[]) {
+    @autoreleasepool {
+        WCReplayOptions options;
+        if (!WCReplayParseOptions(argc, argv, &options)) {
+            WCReplayPrintUsage(argv[0]);
+            return 1;
+        }
+
+        WCEventTraceHeader header;
+        NSData *trace = WCEventTraceReadFile(options.tracePath, &header);
+        if (!trace) {
+            fprintf(stderr, "%s is not an event trace\n", options.tracePath.fileSystemRepresentation);
+            return 1;
+        }
+        const WCEventTraceEntry *entries = trace.bytes;
+        NSUInteger entryCount = trace.length / sizeof(WCEventTraceEntry);
+
+        // Log the way an injected application does, to a scratch file instead of the console
+        NSString *logPath = [NSTemporaryDirectory() stringByAppendingPathComponent:
+                             [NSString stringWithFormat:@"wc_replay_%d.log", (int)getpid()]];
+        WCLogger *logger = [WCLogger sharedLogger];
+        [logger removeLogHandlerWithIdentifier:@"console"];
+        [logger setLogFilePath:logPath];
+        [logger setLogLevel:WCLogLevelInfo];
+
+        [NSApplication sharedApplication];
+        [NSApp setActivationPolicy:NSApplicationActivationPolicyAccessory];
+        [NSApp finishLaunching];
+
+        // The mocks must be in place before anything reads the window server or the process table
+        WCReplayInstallMocks(getpid(), [NSString stringWithUTF8String:header.name] ?: @"replay");
+
+        WCApplicationType appType = WCReplayApplicationType(entries, entryCount);
+        WCAppProfile *profile = [WCAppProfile defaultProfileForApplicationType:appType];
+
+        WCReplayRun run = {
+            .recordedRootPID = header.pid,
+            .pidMap = [NSMutableDictionary dictionary],
+            .nextPID = kWCReplayPIDBase,
+            .helperName = profile.helperNamePatterns.firstObject ?: @"Replay Helper",
+            .windowsCreated = 0,
+            .processesForked = 0
+        };
+
+        [WCWindowBridge setupWindowBridge];
+        WCWindowScanner *scanner = [WCWindowScanner sharedScanner];
+        [scanner setCollectionWorkerCount:options.workerCount];
+        if (options.onScreenScanning) {
+            [scanner setOnScreenScanning:YES];
+        }
+        [scanner configureWithApplicationProfile:profile];
+        if (options.periodicInterval > 0) {
+            [scanner startScanningWithInterval:options.periodicInterval];
+        } else {
+            [scanner startEventDrivenScanningWithSweepInterval:options.sweepInterval];
+        }
+
+        fprintf(stderr, "Replaying %lu events from %s (pid %d)...\n",
+                (unsigned long)entryCount, header.name, (int)header.pid);
+
+        WCMetricsReset();
+        atomic_store_explicit(&gWindowListCopies, 0, memory_order_relaxed);
+        atomic_store_explicit(&gCGSCalls, 0, memory_order_relaxed);
+        uint64_t cpuStart = WCReplayCPUTime();
+        uint64_t replayStart = WCMetricsNow();
+
+        for (NSUInteger i = 0; i < entryCount; i++) {
+            if (options.speed > 0) {
+                WCReplayRunUntil(replayStart + (uint64_t)((double)entries[i].time / options.speed));
+            }
+            WCReplayApplyEntry(&run, &entries[i]);
+        }
+
+        // Give the scanner until the settle time to protect what the last events exposed
+        uint64_t settleDeadline = WCMetricsNow() + (uint64_t)(options.settleTime * NSEC_PER_SEC);
+        do {
+            WCReplayRunUntil(MIN(settleDeadline, WCMetricsNow() + 10 * NSEC_PER_MSEC));
+        } while (WCReplayExposedWindowCount() > 0 && WCMetricsNow() < settleDeadline);
+
+        uint64_t wallTime = WCMetricsNow() - replayStart;
+        uint64_t cpuTime = WCReplayCPUTime() - cpuStart;
+        NSUInteger exposedCount = WCReplayExposedWindowCount();
+
+        [scanner stopScanning];
+        NSDictionary *metrics = WCMetricsCurrentSnapshot();
+        [logger flush];
+        [[NSFileManager defaultManager] removeItemAtPath:logPath error:NULL];
+
+        NSArray<NSDictionary *> *results = @[
+            WCReplayLatencySummary(exposedCount),
+            @{
+                @"name": @"replay.cpu",
+                @"wallNs": @(wallTime),
+                @"cpuNs": @(cpuTime),
+                @"cpuShare": @(wallTime > 0 ? (double)cpuTime / (double)wallTime : 0.0)
+            },
+            @{
+                @"name": @"replay.windowServer",
+                @"windowListCopies": @(atomic_load_explicit(&gWindowListCopies, memory_order_relaxed)),
+                @"cgsCalls": @(atomic_load_explicit(&gCGSCalls, memory_order_relaxed))
+            }
+        ];
+
+        NSString *commit = [[NSProcessInfo processInfo] environment][@"WC_BENCH_COMMIT"];
+        NSDictionary *report = @{
+            @"commit": commit.length > 0 ? commit : @"unknown",
+            @"date": [[[NSISO8601DateFormatter alloc] init] stringFromDate:[NSDate date]],
+            @"host": [[NSProcessInfo processInfo] operatingSystemVersionString],
+            @"parameters": @{
+                @"trace": options.tracePath.lastPathComponent,
+                @"tracedProcess": [NSString stringWithUTF8String:header.name] ?: @"",
+                @"events": @(entryCount),
+                @"windows": @(run.windowsCreated),
+                @"helpers": @(run.processesForked),
+                @"applicationType": @(appType),
+                @"speed": @(options.speed),
+                @"scanning": options.periodicInterval > 0 ? @"periodic" : @"eventDriven",
+                @"interval": @(options.periodicInterval > 0 ? options.periodicInterval : options.sweepInterval),
+                @"workers": @(options.workerCount),
+                @"onScreen": @(options.onScreenScanning)
+            },
+            @"results": results,
+            @"metrics": metrics
+        };
+
+        NSError *error = nil;
+        NSData *json = [NSJSONSerialization dataWithJSONObject:report
+                                                       options:NSJSONWritingPrettyPrinted | NSJSONWritingSortedKeys
+                                                         error:&error];
+        if (!json) {
+            fprintf(stderr, "Could not encode results: %s\n", error.localizedDescription.UTF8String);
+            return 1;
+        }
+
+        if (options.outputPath) {
+            if (![json writeToFile:options.outputPath options:NSDataWritingAtomic error:&error]) {
+                fprintf(stderr, "Could not write %s: %s\n", options.outputPath.UTF8String,
+                        error.localizedDescription.UTF8String);
+                return 1;
+            }
+            fprintf(stderr, "Results written to %s\n", options.outputPath.UTF8String);
+        } else {
+            fwrite(json.bytes, 1, json.length, stdout);
+            fputc('\n', stdout);
+        }
+    }
+
+    return 0;
+}
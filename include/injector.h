@@ -162,6 +162,29 @@ typedef NS_OPTIONS(NSUInteger, WCInjectionOptions) {
                        config:(WCInjectorConfig *)config
                         error:(NSError **)error;
 
+/**
+ * @brief Launch an application suspended and wait until the injector protects it
+ *
+ * The application is created with posix_spawn in a suspended state and
+ * resumed once a handshake pipe is being listened to. The dylib reports
+ * through the pipe when it is loaded and when the first window is
+ * protected, so the call returns as soon as protection is confirmed rather
+ * than after a fixed delay. An application that never reports loading the
+ * dylib is terminated.
+ *
+ * @param applicationPath Path to the application to launch
+ * @param arguments Arguments to pass to the application
+ * @param config Configuration object with injection settings, or nil for the defaults
+ * @param timeout Seconds to wait for the first window to be protected
+ * @param error Error object to return error information
+ * @return Process identifier of the launched application, or 0 if launch failed
+ */
++ (pid_t)spawnApplication:(NSString *)applicationPath
+                arguments:(NSArray<NSString *> *)arguments
+                   config:(WCInjectorConfig *)config
+                  timeout:(NSTimeInterval)timeout
+                    error:(NSError **)error;
+
 /**
  * @brief Launch an application with custom environment variables
  *
@@ -8,10 +8,20 @@
 #import "../util/logger.h"
 #import "../util/error_manager.h"
 #import "../util/path_resolver.h"
+#import "../util/configuration_manager.h"
 #import "../util/wc_cgs_functions.h"
 #import "../util/wc_cgs_types.h"
+#import "../util/wc_event_trace.h"
+#import "../util/wc_fleet_metrics.h"
+#import "../util/wc_helper_propagation.h"
+#import "../util/wc_launch_handshake.h"
+#import "../util/wc_metrics.h"
+#import "../util/wc_shared_config.h"
+#import "wc_injection_preflight.h"
+#import "wc_suspended_launcher.h"
 #import "wc_injector_config.h"
 #import "wc_window_bridge.h"
+#import "wc_app_profile.h"
 #import "wc_window_scanner.h"
 #import "wc_window_protector.h"
 #import "wc_window_info.h"
@@ -90,6 +100,11 @@ NSInteger const WCErrorInjectionFailed = 102;
         return NO;
     }
 
+    // Fail now rather than launching an application dyld will refuse to inject into
+    if (![[WCInjectionPreflight sharedPreflight] verifyApplication:applicationPath dylibPath:dylibPath error:error]) {
+        return NO;
+    }
+
     // Create task to launch application with injected dylib
     NSTask *task = [NSTask new];
     [task setLaunchPath:@"/usr/bin/open"];
@@ -144,12 +159,15 @@ NSInteger const WCErrorInjectionFailed = 102;
 }
 
 /**
- * Launch an application with custom configuration
+ * Resolve the executable of an application and build its injection environment
+ *
+ * Shared by the NSTask and suspended-start launch paths, so both check the
+ * same things and pass the same environment.
  */
-+ (NSTask *)launchApplication:(NSString *)applicationPath
-                    arguments:(NSArray<NSString *> *)arguments
-                       config:(WCInjectorConfig *)config
-                        error:(NSError **)error {
++ (NSString *)executablePathForInjectingApplication:(NSString *)applicationPath
+                                             config:(WCInjectorConfig *)config
+                                        environment:(NSDictionary<NSString *, NSString *> **)environment
+                                              error:(NSError **)error {
     if (!applicationPath) {
         if (error) {
             *error = [WCError errorWithCategory:WCErrorCategoryInjection
@@ -181,6 +199,11 @@ NSInteger const WCErrorInjectionFailed = 102;
         return nil;
     }
 
+    // Fail now rather than launching an application dyld will refuse to inject into
+    if (![[WCInjectionPreflight sharedPreflight] verifyApplication:applicationPath dylibPath:dylibPath error:error]) {
+        return nil;
+    }
+
     // Find the executable within the application bundle using path resolver
     NSString *executablePath = [[WCPathResolver sharedResolver] resolveExecutablePathForApplication:applicationPath];
 
@@ -206,10 +229,55 @@ NSInteger const WCErrorInjectionFailed = 102;
     // Add configuration environment variables
     [env addEntriesFromDictionary:injectionEnv];
 
+    *environment = env;
+    return executablePath;
+}
+
+/**
+ * Launch an application with custom configuration
+ */
++ (NSTask *)launchApplication:(NSString *)applicationPath
+                    arguments:(NSArray<NSString *> *)arguments
+                       config:(WCInjectorConfig *)config
+                        error:(NSError **)error {
+    NSDictionary<NSString *, NSString *> *env = nil;
+    NSString *executablePath = [self executablePathForInjectingApplication:applicationPath
+                                                                    config:config
+                                                               environment:&env
+                                                                     error:error];
+    if (!executablePath) {
+        return nil;
+    }
+
     // Launch the application with the prepared environment
     return [self launchApplicationWithPath:executablePath arguments:arguments environment:env error:error];
 }
 
+/**
+ * Launch an application suspended and wait for the injector to confirm protection
+ */
++ (pid_t)spawnApplication:(NSString *)applicationPath
+                arguments:(NSArray<NSString *> *)arguments
+                   config:(WCInjectorConfig *)config
+                  timeout:(NSTimeInterval)timeout
+                    error:(NSError **)error {
+    NSDictionary<NSString *, NSString *> *env = nil;
+    NSString *executablePath = [self executablePathForInjectingApplication:applicationPath
+                                                                    config:config ?: [WCInjectorConfig defaultConfig]
+                                                               environment:&env
+                                                                     error:error];
+    if (!executablePath) {
+        return 0;
+    }
+
+    WCSuspendedLaunchResult *result = [WCSuspendedLauncher launchExecutable:executablePath
+                                                                  arguments:arguments
+                                                                environment:env
+                                                                    timeout:timeout
+                                                                      error:error];
+    return result ? result.processIdentifier : 0;
+}
+
 /**
  * Launch an application with custom environment variables
  */
@@ -316,12 +384,52 @@ BOOL WCInitialize(void) {
     // Register interceptors
     BOOL success = [[WCInterceptorRegistry sharedRegistry] registerAllInterceptors];
 
+    // Swizzle only the hooks the configured options need; this already runs before the first window is shown
+    WCConfigurationManager *config = [WCConfigurationManager sharedManager];
+    if (config.interceptorInstallMode == WCInterceptorInstallModeOnDemand) {
+        [[WCInterceptorRegistry sharedRegistry] installInterceptorsForConfigurationOptions:config.options];
+    }
+
     // Initialize the window bridge
     [WCWindowBridge setupWindowBridge];
 
     // Set up window protector defaults
     [WCWindowProtector setDebounceInterval:0.3]; // 300ms default
 
+    // Let `kill -USR1 <pid>` dump protection latency and overhead metrics
+    WCMetricsInstallSignalHandler();
+
+    // Let `injector --metrics` read this process's counters without asking it
+    if (config.publishesFleetMetrics) {
+        WCFleetMetricsPublish();
+    }
+
+    // Record what the application does with its windows, for `make replay`
+    if (config.traceFilePath.length > 0) {
+        WCEventTraceStart(config.traceFilePath);
+    }
+
+    // Helpers that load the dylib protect their own windows; the rest are still scanned from here
+    WCWindowScanner *scanner = [WCWindowScanner sharedScanner];
+    if (config.propagatesToHelperProcesses && WCHelperPropagationEnable()) {
+        [scanner setSkipsSelfProtectingHelpers:YES];
+    }
+    if (config.windowListMode == WCWindowListModeOnScreen) {
+        [scanner setOnScreenScanning:YES];
+    }
+    if (config.scanWorkerCount != 0) {
+        [scanner setCollectionWorkerCount:config.scanWorkerCount];
+    }
+    if (config.windowRules.count > 0) {
+        [scanner setWindowPolicy:[[WCWindowPolicy alloc] initWithRules:config.windowRules]];
+    }
+
+    // Pick up published configuration now and whenever a controller publishes again
+    WCSharedConfigStartMonitoring(dispatch_get_main_queue(), ^{
+        [scanner reloadSharedConfiguration];
+    });
+    [scanner reloadSharedConfiguration];
+
     [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
                                  category:@"Initialization"
                                      file:__FILE__
@@ -338,8 +446,97 @@ BOOL WCInitialize(void) {
 static BOOL gLibraryInitialized = NO;
 static dispatch_once_t gInitializeOnceToken;
 
+/**
+ * Monotonic time the dylib constructor ran
+ */
+static uint64_t gDylibLoadTime = 0;
+
+/**
+ * Readiness observers, removed as soon as the first one fires
+ */
+static NSArray<id> *gReadinessObservers = nil;
+static CFRunLoopObserverRef gMainRunLoopObserver = NULL;
+
+/**
+ * Initialize and start protecting windows on the first readiness signal
+ *
+ * Runs on the main thread exactly once, for whichever signal arrives first.
+ *
+ * @param reason The signal that fired, for logging
+ */
+static void WCStartWhenReady(NSString *reason) {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        // Later signals have nothing left to do
+        for (id observer in gReadinessObservers) {
+            [[NSNotificationCenter defaultCenter] removeObserver:observer];
+        }
+        gReadinessObservers = nil;
+        if (gMainRunLoopObserver) {
+            CFRunLoopObserverInvalidate(gMainRunLoopObserver);
+            CFRelease(gMainRunLoopObserver);
+            gMainRunLoopObserver = NULL;
+        }
+
+        WCLogInfo(@"Initialization", @"Application ready (%@) %.1f ms after dylib load",
+                  reason, (WCMetricsNow() - gDylibLoadTime) / 1e6);
+
+        @try {
+            // Call the initialization function - this will use the registry
+            BOOL success = WCInitialize();
+
+            // Detect application type and configure scanner accordingly
+            if (success) {
+                // Get the application path
+                NSBundle *mainBundle = [NSBundle mainBundle];
+                NSString *bundlePath = [mainBundle bundlePath];
+
+                // Load the cached profile, or detect the application type on first launch
+                WCAppProfile *profile = [WCWindowBridge applicationProfileForPath:bundlePath];
+
+                // Configure scanner for this application
+                [[WCWindowScanner sharedScanner] configureWithApplicationProfile:profile];
+
+                // Discover windows through window events; the periodic scan is only a safety sweep
+                [[WCWindowScanner sharedScanner] startEventDrivenScanningWithSweepInterval:5.0];
+
+                WCLaunchHandshakeSignal(WCLaunchHandshakeStageReady);
+            }
+
+            // Mark as initialized
+            gLibraryInitialized = YES;
+
+            WCLogInfo(@"Initialization", @"WindowControlInjector initialized %@",
+                      success ? @"successfully" : @"with errors");
+        } @catch (NSException *exception) {
+            // Log the exception but don't crash the host application
+            WCLogError(@"Initialization", @"WindowControlInjector initialization error: %@", exception);
+        }
+    });
+}
+
+/**
+ * Forward a readiness notification to WCStartWhenReady on the main thread
+ */
+static void WCReadinessNotificationReceived(NSNotification *notification) {
+    NSString *reason = notification.name;
+    if ([NSThread isMainThread]) {
+        WCStartWhenReady(reason);
+    } else {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            WCStartWhenReady(reason);
+        });
+    }
+}
+
 /**
  * Dylib initialization function that will be called when the library is loaded
+ *
+ * Only the readiness observers are set up here. Initialization runs at the
+ * first of NSApplicationWillFinishLaunching, NSApplicationDidFinishLaunching,
+ * the first window ordered in, or the main run loop starting, so fast
+ * applications are protected before their first window is shown and slow
+ * ones are not initialized before AppKit is up.
  */
 __attribute__((constructor))
 static void initialize(void) {
@@ -350,85 +547,47 @@ static void initialize(void) {
             return;
         }
 
-        // Direct filesystem logging to confirm dylib is being loaded using path resolver
-        NSString *logPath = [[WCPathResolver sharedResolver] logFilePath];
-        NSString *logMessage = [NSString stringWithFormat:@"[%@] WindowControlInjector dylib loaded\n",
-                               [NSDate date]];
+        gDylibLoadTime = WCMetricsNow();
 
-        // Use a @try/@catch block to prevent crashes during initialization
-        @try {
-            NSFileHandle *fileHandle;
-            if ([[NSFileManager defaultManager] fileExistsAtPath:logPath]) {
-                fileHandle = [NSFileHandle fileHandleForWritingAtPath:logPath];
-                [fileHandle seekToEndOfFile];
-            } else {
-                [[NSFileManager defaultManager] createFileAtPath:logPath contents:[NSData data] attributes:nil];
-                fileHandle = [NSFileHandle fileHandleForWritingAtPath:logPath];
-            }
+        // Configure logger first
+        [[WCLogger sharedLogger] setLogLevel:WCLogLevelInfo];
+        WCLogInfo(@"Initialization", @"WindowControlInjector dylib loaded %.1f ms after launch, waiting for the application",
+                  (gDylibLoadTime - WCMetricsProcessLaunchTime()) / 1e6);
 
-            if (fileHandle) {
-                [fileHandle writeData:[logMessage dataUsingEncoding:NSUTF8StringEncoding]];
-                [fileHandle closeFile];
-            }
+        // A suspended-start launcher is waiting to hear that dyld loaded the dylib
+        if (WCLaunchHandshakeAttach()) {
+            WCLaunchHandshakeSignal(WCLaunchHandshakeStageLoaded);
+        }
 
-            // Log initialization start
-            NSFileHandle *initialFileHandle = [NSFileHandle fileHandleForWritingAtPath:logPath];
-            [initialFileHandle seekToEndOfFile];
-            [initialFileHandle writeData:[@"WindowControlInjector initialization started\n" dataUsingEncoding:NSUTF8StringEncoding]];
-            [initialFileHandle closeFile];
-
-            // Wait a moment before initializing to let the app finish loading
-            // This can help prevent crashes during app startup
-            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.5 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
-                // Configure logger first
-                [[WCLogger sharedLogger] setLogLevel:WCLogLevelInfo];
-
-                // Call the initialization function - this will use the registry
-                BOOL success = WCInitialize();
-
-                // Detect application type and configure scanner accordingly
-                if (success) {
-                    // Get the application path
-                    NSBundle *mainBundle = [NSBundle mainBundle];
-                    NSString *bundlePath = [mainBundle bundlePath];
-
-                    // Detect application type
-                    WCApplicationType appType = [WCWindowBridge detectApplicationTypeForPath:bundlePath];
-
-                    // Configure scanner for this application type
-                    [[WCWindowScanner sharedScanner] configureForApplicationType:appType];
-
-                    // Start the scanner with the appropriate interval
-                    [[WCWindowScanner sharedScanner] startScanningWithInterval:
-                        [[WCWindowScanner sharedScanner] currentScanInterval]];
-                }
-
-                // Mark as initialized
-                gLibraryInitialized = YES;
-
-                // Log result
-                NSFileHandle *finalFileHandle = [NSFileHandle fileHandleForWritingAtPath:logPath];
-                [finalFileHandle seekToEndOfFile];
-                NSString *resultMessage = success ?
-                    @"WindowControlInjector initialized successfully\n" :
-                    @"WindowControlInjector initialization failed\n";
-                [finalFileHandle writeData:[resultMessage dataUsingEncoding:NSUTF8StringEncoding]];
-                [finalFileHandle closeFile];
-
-                [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
-                                             category:@"General"
-                                                 file:__FILE__
-                                                 line:__LINE__
-                                             function:__PRETTY_FUNCTION__
-                                               format:@"WindowControlInjector initialized successfully: %@", success ? @"YES" : @"NO"];
+        // Loaded into an application that already finished launching
+        if (NSApp && [NSApp isRunning]) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                WCStartWhenReady(@"already running");
             });
-        } @catch (NSException *exception) {
-            // Log the exception but don't crash
-            NSFileHandle *errorHandle = [NSFileHandle fileHandleForWritingAtPath:logPath];
-            [errorHandle seekToEndOfFile];
-            NSString *errorMessage = [NSString stringWithFormat:@"WindowControlInjector initialization error: %@\n", exception];
-            [errorHandle writeData:[errorMessage dataUsingEncoding:NSUTF8StringEncoding]];
-            [errorHandle closeFile];
+            return;
+        }
+
+        NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+        void (^ready)(NSNotification *) = ^(NSNotification *notification) {
+            WCReadinessNotificationReceived(notification);
+        };
+
+        // Delivered synchronously on the posting thread so nothing waits for a run loop turn
+        gReadinessObservers = @[
+            [center addObserverForName:NSApplicationWillFinishLaunchingNotification object:nil queue:nil usingBlock:ready],
+            [center addObserverForName:NSApplicationDidFinishLaunchingNotification object:nil queue:nil usingBlock:ready],
+            [center addObserverForName:NSWindowDidChangeOcclusionStateNotification object:nil queue:nil usingBlock:ready]
+        ];
+
+        // Processes that never post the AppKit notifications are ready once the main run loop runs
+        gMainRunLoopObserver = CFRunLoopObserverCreateWithHandler(kCFAllocatorDefault,
+                                                                  kCFRunLoopEntry | kCFRunLoopBeforeWaiting,
+                                                                  false, 0,
+                                                                  ^(CFRunLoopObserverRef observer, CFRunLoopActivity activity) {
+            WCStartWhenReady(activity == kCFRunLoopEntry ? @"main run loop entry" : @"main run loop idle");
+        });
+        if (gMainRunLoopObserver) {
+            CFRunLoopAddObserver(CFRunLoopGetMain(), gMainRunLoopObserver, kCFRunLoopCommonModes);
         }
     });
 }
@@ -11,6 +11,41 @@
 // Error domain for protection operations
 extern NSString *const WCProtectorErrorDomain;
 
+// Default time to wait for an application launch to complete
+extern const NSTimeInterval WCProtectorDefaultLaunchTimeout;
+
+/**
+ * @brief Outcome of protecting one application in a batch
+ */
+@interface WCProtectionResult : NSObject
+
+/**
+ * @brief The application path as it was passed in
+ */
+@property (nonatomic, readonly, copy) NSString *applicationPath;
+
+/**
+ * @brief YES if the application was launched with the injector
+ */
+@property (nonatomic, readonly, getter=isSuccessful) BOOL successful;
+
+/**
+ * @brief Process identifier of the launched application, or 0 if it did not launch
+ */
+@property (nonatomic, readonly) pid_t processIdentifier;
+
+/**
+ * @brief Seconds from the start of the batch until the launch completed or failed
+ */
+@property (nonatomic, readonly) NSTimeInterval launchDuration;
+
+/**
+ * @brief The error if the launch failed, nil otherwise
+ */
+@property (nonatomic, readonly, strong) NSError *error;
+
+@end
+
 /**
  * @brief Core protector class that implements all protection features
  */
@@ -42,6 +77,39 @@ extern NSString *const WCProtectorErrorDomain;
                          withProperties:(NSDictionary *)properties
                                   error:(NSError **)error;
 
+/**
+ * @brief Apply all protection features to an application launched suspended
+ *
+ * Unlike protectApplication:error:, which launches through NSWorkspace and
+ * returns once the launch was requested, this spawns the executable
+ * suspended, resumes it once the launch handshake is in place and returns
+ * when the injector confirms that the first window is protected. An
+ * application that never loads the injector is terminated.
+ *
+ * @param applicationPath The path to the application to protect
+ * @param timeout Seconds to wait for the first window to be protected
+ * @param error On input, a pointer to an error object. If an error occurs, this pointer is set to an actual error object containing the error information.
+ * @return YES if the application is running with the injector, NO otherwise
+ */
++ (BOOL)protectApplicationBySpawning:(NSString *)applicationPath
+                             timeout:(NSTimeInterval)timeout
+                               error:(NSError **)error;
+
+/**
+ * @brief Apply all protection features to several applications at once
+ *
+ * The injector dylib is located and the launch environment is built once
+ * for the whole batch. All launches are then started together and their
+ * completion handlers overlap, so the batch takes about as long as the
+ * slowest launch rather than the sum of all of them.
+ *
+ * @param applicationPaths Paths to the applications to protect
+ * @param timeout Seconds to wait for all launches to complete
+ * @return One result per application path, in the same order
+ */
++ (NSArray<WCProtectionResult *> *)protectApplications:(NSArray<NSString *> *)applicationPaths
+                                                timeout:(NSTimeInterval)timeout;
+
 /**
  * @brief Initialize the WindowControlInjector
  *
@@ -61,6 +129,7 @@ extern NSString *const WCProtectorErrorDomain;
 // C function wrappers for the public API
 BOOL WCProtectApplication(NSString *applicationPath, NSError **error);
 BOOL WCProtectApplicationWithProperties(NSString *applicationPath, NSDictionary *properties, NSError **error);
+NSArray<WCProtectionResult *> *WCProtectApplications(NSArray<NSString *> *applicationPaths, NSTimeInterval timeout);
 BOOL WCProtectorInitialize(void); // Renamed to avoid duplicate symbol with injector.m
 
 #endif /* PROTECTOR_H */
@@ -8,6 +8,8 @@
 #import "../util/error_manager.h"
 #import "../util/configuration_manager.h"
 #import "../util/path_resolver.h"
+#import "wc_injection_preflight.h"
+#import "wc_suspended_launcher.h"
 #import "../interceptors/interceptor_registry.h"
 #import "../interceptors/nswindow_interceptor.h"
 #import "../interceptors/nsapplication_interceptor.h"
@@ -18,6 +20,27 @@
 // Error domain
 NSString *const WCProtectorErrorDomain = @"com.windowcontrolinjector.protector";
 
+// Matches the timeout used for single launches
+const NSTimeInterval WCProtectorDefaultLaunchTimeout = 15.0;
+
+#pragma mark - WCProtectionResult
+
+@interface WCProtectionResult ()
+@property (nonatomic, readwrite, copy) NSString *applicationPath;
+@property (nonatomic, readwrite, getter=isSuccessful) BOOL successful;
+@property (nonatomic, readwrite) pid_t processIdentifier;
+@property (nonatomic, readwrite) NSTimeInterval launchDuration;
+@property (nonatomic, readwrite, strong) NSError *error;
+
+// Set once the launch has completed, failed or timed out; later updates are ignored
+@property (nonatomic, readwrite, getter=isFinished) BOOL finished;
+@end
+
+@implementation WCProtectionResult
+@end
+
+#pragma mark - WCProtector
+
 @implementation WCProtector
 
 /**
@@ -90,6 +113,16 @@ NSString *const WCProtectorErrorDomain = @"com.windowcontrolinjector.protector";
             return NO;
         }
 
+        // Hardened or mismatched targets fail here instead of at the launch timeout
+        NSError *preflightError = nil;
+        if (![[WCInjectionPreflight sharedPreflight] verifyApplication:applicationPath dylibPath:dylibPath error:&preflightError]) {
+            printf("[WindowControlInjector] ERROR: %s\n", [preflightError.localizedDescription UTF8String]);
+            if (error) {
+                *error = preflightError;
+            }
+            return NO;
+        }
+
         printf("[WindowControlInjector] Using dylib: %s\n", [dylibPath UTF8String]);
         [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
                                      category:@"Injection"
@@ -245,6 +278,79 @@ NSString *const WCProtectorErrorDomain = @"com.windowcontrolinjector.protector";
     }
 }
 
+/**
+ * Launch an application suspended and wait for the injector to confirm protection
+ */
++ (BOOL)protectApplicationBySpawning:(NSString *)applicationPath
+                             timeout:(NSTimeInterval)timeout
+                               error:(NSError **)error {
+    if (!applicationPath) {
+        if (error) {
+            *error = [NSError errorWithDomain:WCProtectorErrorDomain
+                                         code:100
+                                     userInfo:@{NSLocalizedDescriptionKey: @"Application path is nil"}];
+        }
+        return NO;
+    }
+
+    if (![[NSFileManager defaultManager] fileExistsAtPath:applicationPath]) {
+        if (error) {
+            *error = [NSError errorWithDomain:WCProtectorErrorDomain
+                                         code:101
+                                     userInfo:@{NSLocalizedDescriptionKey:
+                                               [NSString stringWithFormat:@"Application not found at path: %@", applicationPath]}];
+        }
+        return NO;
+    }
+
+    NSString *dylibPath = [self findInjectorDylibPath];
+    if (!dylibPath) {
+        if (error) {
+            *error = [NSError errorWithDomain:WCProtectorErrorDomain
+                                         code:102
+                                     userInfo:@{NSLocalizedDescriptionKey: @"Couldn't find injector dylib"}];
+        }
+        return NO;
+    }
+
+    if (![[WCInjectionPreflight sharedPreflight] verifyApplication:applicationPath dylibPath:dylibPath error:error]) {
+        return NO;
+    }
+
+    NSString *executablePath = [[WCPathResolver sharedResolver] resolveExecutablePathForApplication:applicationPath];
+    if (!executablePath) {
+        if (error) {
+            *error = [NSError errorWithDomain:WCProtectorErrorDomain
+                                         code:101
+                                     userInfo:@{NSLocalizedDescriptionKey:
+                                               [NSString stringWithFormat:@"Could not find executable in application: %@", applicationPath]}];
+        }
+        return NO;
+    }
+
+    NSMutableDictionary *env = [NSMutableDictionary dictionaryWithDictionary:[[NSProcessInfo processInfo] environment]];
+    env[@"DYLD_INSERT_LIBRARIES"] = dylibPath;
+
+    printf("[WindowControlInjector] Spawning application suspended: %s\n", [executablePath UTF8String]);
+    WCSuspendedLaunchResult *result = [WCSuspendedLauncher launchExecutable:executablePath
+                                                                  arguments:nil
+                                                                environment:env
+                                                                    timeout:timeout
+                                                                      error:error];
+    if (!result) {
+        return NO;
+    }
+
+    if (result.protectionConfirmed) {
+        printf("[WindowControlInjector] Injector loaded after %.1f ms, first window protected after %.1f ms\n",
+               result.timeToLoaded * 1e3, result.timeToProtected * 1e3);
+    } else {
+        printf("[WindowControlInjector] Injector loaded after %.1f ms; no window was shown within %.0f seconds\n",
+               result.timeToLoaded * 1e3, timeout);
+    }
+    return YES;
+}
+
 /**
  * Process existing windows when initializing
  */
@@ -321,7 +427,10 @@ NSString *const WCProtectorErrorDomain = @"com.windowcontrolinjector.protector";
 
     // Install all registered interceptors or just the enabled ones
     BOOL success;
-    if (config.enabledInterceptors == UINT_MAX) {
+    if (config.interceptorInstallMode == WCInterceptorInstallModeOnDemand) {
+        // Only the hooks the configured options need
+        success = [registry installInterceptorsForConfigurationOptions:config.options];
+    } else if (config.enabledInterceptors == UINT_MAX) {
         // All interceptors enabled
         success = [registry installAllInterceptors];
     } else {
@@ -528,6 +637,10 @@ NSString *const WCProtectorErrorDomain = @"com.windowcontrolinjector.protector";
         return NO;
     }
 
+    if (![[WCInjectionPreflight sharedPreflight] verifyApplication:applicationPath dylibPath:dylibPath error:error]) {
+        return NO;
+    }
+
     env[@"DYLD_INSERT_LIBRARIES"] = dylibPath;
 
     // Create application URL
@@ -603,6 +716,138 @@ NSString *const WCProtectorErrorDomain = @"com.windowcontrolinjector.protector";
     }
 }
 
+/**
+ * Apply all protection features to several applications at once
+ */
++ (NSArray<WCProtectionResult *> *)protectApplications:(NSArray<NSString *> *)applicationPaths
+                                                timeout:(NSTimeInterval)timeout {
+    NSMutableArray<WCProtectionResult *> *results = [NSMutableArray arrayWithCapacity:applicationPaths.count];
+    NSTimeInterval startTime = [[NSProcessInfo processInfo] systemUptime];
+
+    for (NSString *applicationPath in applicationPaths) {
+        WCProtectionResult *result = [[WCProtectionResult alloc] init];
+        result.applicationPath = applicationPath;
+        [results addObject:result];
+    }
+
+    // Records the outcome of one launch exactly once, whichever of the handler or the timeout gets there first
+    void (^finishResult)(WCProtectionResult *, NSRunningApplication *, NSError *) =
+        ^(WCProtectionResult *result, NSRunningApplication *app, NSError *launchError) {
+        @synchronized (result) {
+            if (result.finished) return;
+            result.finished = YES;
+            result.launchDuration = [[NSProcessInfo processInfo] systemUptime] - startTime;
+            result.successful = app != nil;
+            result.processIdentifier = app ? app.processIdentifier : 0;
+            result.error = app ? nil : launchError;
+        }
+    };
+
+    // Locate the dylib and build the environment once for every launch
+    NSString *dylibPath = [self findInjectorDylibPath];
+    if (!dylibPath || ![[NSFileManager defaultManager] fileExistsAtPath:dylibPath]) {
+        NSError *dylibError = [NSError errorWithDomain:WCProtectorErrorDomain
+                                                  code:dylibPath ? 103 : 102
+                                              userInfo:@{NSLocalizedDescriptionKey: dylibPath ?
+                                                        [NSString stringWithFormat:@"Dylib not found at path: %@", dylibPath] :
+                                                        @"Couldn't find injector dylib"}];
+        for (WCProtectionResult *result in results) {
+            finishResult(result, nil, dylibError);
+        }
+        return results;
+    }
+
+    NSMutableDictionary *env = [NSMutableDictionary dictionaryWithDictionary:[[NSProcessInfo processInfo] environment]];
+    env[@"DYLD_INSERT_LIBRARIES"] = dylibPath;
+
+    [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                 category:@"Launch"
+                                     file:__FILE__
+                                     line:__LINE__
+                                 function:__PRETTY_FUNCTION__
+                                   format:@"Launching %lu applications with dylib: %@",
+                                          (unsigned long)applicationPaths.count, dylibPath];
+
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    dispatch_group_t group = dispatch_group_create();
+
+    for (WCProtectionResult *result in results) {
+        NSString *applicationPath = result.applicationPath;
+
+        if (![fileManager fileExistsAtPath:applicationPath]) {
+            finishResult(result, nil, [NSError errorWithDomain:WCProtectorErrorDomain
+                                                          code:101
+                                                      userInfo:@{NSLocalizedDescriptionKey:
+                                                                [NSString stringWithFormat:@"Application not found at path: %@", applicationPath]}]);
+            continue;
+        }
+
+        NSError *preflightError = nil;
+        if (![[WCInjectionPreflight sharedPreflight] verifyApplication:applicationPath dylibPath:dylibPath error:&preflightError]) {
+            finishResult(result, nil, preflightError);
+            continue;
+        }
+
+        NSURL *appURL = [NSURL fileURLWithPath:applicationPath];
+
+        if (@available(macOS 11.0, *)) {
+            NSWorkspaceOpenConfiguration *configuration = [NSWorkspaceOpenConfiguration configuration];
+            [configuration setEnvironment:env];
+            [configuration setCreatesNewApplicationInstance:YES];
+
+            // Start every launch before waiting on any of them
+            dispatch_group_enter(group);
+            [[NSWorkspace sharedWorkspace] openApplicationAtURL:appURL
+                                                  configuration:configuration
+                                              completionHandler:^(NSRunningApplication * _Nullable app, NSError * _Nullable appError) {
+                finishResult(result, app, appError ? appError :
+                             [NSError errorWithDomain:WCProtectorErrorDomain
+                                                 code:105
+                                             userInfo:@{NSLocalizedDescriptionKey: @"Failed to launch application"}]);
+                dispatch_group_leave(group);
+            }];
+        } else {
+            // The legacy API is synchronous, so older systems launch one application at a time
+            NSError *launchError = nil;
+            NSRunningApplication *app = [[NSWorkspace sharedWorkspace]
+                                         launchApplicationAtURL:appURL
+                                         options:NSWorkspaceLaunchNewInstance
+                                         configuration:@{NSWorkspaceLaunchConfigurationEnvironment: env}
+                                         error:&launchError];
+            finishResult(result, app, launchError ? launchError :
+                         [NSError errorWithDomain:WCProtectorErrorDomain
+                                             code:106
+                                         userInfo:@{NSLocalizedDescriptionKey: @"Failed to launch application"}]);
+        }
+    }
+
+    // One deadline covers the whole batch
+    dispatch_time_t deadline = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(timeout * NSEC_PER_SEC));
+    if (dispatch_group_wait(group, deadline) != 0) {
+        NSError *timeoutError = [NSError errorWithDomain:WCProtectorErrorDomain
+                                                    code:104
+                                                userInfo:@{NSLocalizedDescriptionKey: @"Timeout waiting for application launch"}];
+        for (WCProtectionResult *result in results) {
+            finishResult(result, nil, timeoutError);
+        }
+    }
+
+    for (WCProtectionResult *result in results) {
+        @synchronized (result) {
+            [[WCLogger sharedLogger] logWithLevel:result.successful ? WCLogLevelInfo : WCLogLevelError
+                                         category:@"Launch"
+                                             file:__FILE__
+                                             line:__LINE__
+                                         function:__PRETTY_FUNCTION__
+                                           format:@"%@ %@ after %.2f s%@", result.successful ? @"Launched" : @"Failed to launch",
+                                                  result.applicationPath, result.launchDuration,
+                                                  result.error ? [NSString stringWithFormat:@": %@", result.error.localizedDescription] : @""];
+        }
+    }
+
+    return results;
+}
+
 @end
 
 // C function wrappers for the public API
@@ -614,6 +859,10 @@ BOOL WCProtectApplicationWithProperties(NSString *applicationPath, NSDictionary
     return [WCProtector protectApplicationWithProperties:applicationPath withProperties:properties error:error];
 }
 
+NSArray<WCProtectionResult *> *WCProtectApplications(NSArray<NSString *> *applicationPaths, NSTimeInterval timeout) {
+    return [WCProtector protectApplications:applicationPaths timeout:timeout];
+}
+
 // Renamed to avoid duplicate symbol with injector.m
 BOOL WCProtectorInitialize(void) {
     return [WCProtector initialize];
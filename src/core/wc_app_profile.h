@@ -0,0 +1,155 @@
+/**
+ * @file wc_app_profile.h
+ * @brief Per-application profiles and their on-disk cache for WindowControlInjector
+ *
+ * This file defines the profile that captures everything the injector needs
+ * to know about an application before it starts protecting windows (its
+ * type, scan and debounce intervals and helper process names), and a cache
+ * that persists profiles across launches so a relaunch of the same build
+ * skips application type detection.
+ */
+
+#ifndef WC_APP_PROFILE_H
+#define WC_APP_PROFILE_H
+
+#import <Foundation/Foundation.h>
+#import "wc_window_bridge.h"
+
+/**
+ * @brief Detected settings for one application
+ *
+ * Profiles are immutable. A profile with no helper name patterns describes
+ * an application whose windows all belong to the main process.
+ */
+@interface WCAppProfile : NSObject
+
+/**
+ * @brief The detected application type
+ */
+@property (nonatomic, readonly) WCApplicationType applicationType;
+
+/**
+ * @brief Interval in seconds between periodic scans
+ */
+@property (nonatomic, readonly) NSTimeInterval scanInterval;
+
+/**
+ * @brief Whether protection of new windows is debounced
+ */
+@property (nonatomic, readonly) BOOL debounceEnabled;
+
+/**
+ * @brief Debounce interval in seconds
+ */
+@property (nonatomic, readonly) NSTimeInterval debounceInterval;
+
+/**
+ * @brief Substrings that identify helper processes among the main process's children
+ */
+@property (nonatomic, readonly, copy) NSArray<NSString *> *helperNamePatterns;
+
+/**
+ * @brief Generations below a matching helper that also count as helpers
+ */
+@property (nonatomic, readonly) NSUInteger helperDescendantDepth;
+
+/**
+ * @brief YES if the profile was read from the on-disk cache rather than detected
+ */
+@property (nonatomic, readonly, getter=isCached) BOOL cached;
+
+/**
+ * @brief Get the built-in profile for an application type
+ *
+ * @param appType The application type
+ * @return The default profile for that type
+ */
++ (instancetype)defaultProfileForApplicationType:(WCApplicationType)appType;
+
+/**
+ * @brief Initialize a profile with explicit settings
+ *
+ * @param appType The application type
+ * @param scanInterval Interval in seconds between periodic scans
+ * @param debounceEnabled Whether protection is debounced
+ * @param debounceInterval Debounce interval in seconds
+ * @param helperNamePatterns Substrings that identify helper processes
+ * @param helperDescendantDepth Generations below a matching helper to include
+ * @return The profile
+ */
+- (instancetype)initWithApplicationType:(WCApplicationType)appType
+                           scanInterval:(NSTimeInterval)scanInterval
+                        debounceEnabled:(BOOL)debounceEnabled
+                       debounceInterval:(NSTimeInterval)debounceInterval
+                     helperNamePatterns:(NSArray<NSString *> *)helperNamePatterns
+                  helperDescendantDepth:(NSUInteger)helperDescendantDepth;
+
+/**
+ * @brief Initialize a profile from its property list form
+ *
+ * @param dictionary A dictionary produced by dictionaryRepresentation
+ * @return The profile, or nil if the dictionary is malformed
+ */
+- (instancetype)initWithDictionary:(NSDictionary *)dictionary;
+
+/**
+ * @brief Get the property list form of the profile
+ *
+ * @return Dictionary containing only property list types
+ */
+- (NSDictionary *)dictionaryRepresentation;
+
+@end
+
+/**
+ * @brief On-disk cache of application profiles
+ *
+ * Profiles are stored one file per bundle identifier under the user's
+ * Application Support directory. Each entry records the bundle version and
+ * the modification time of the main executable it was detected for, and is
+ * ignored once either changes, so an updated application is detected again.
+ */
+@interface WCAppProfileCache : NSObject
+
+/**
+ * @brief Get the shared cache instance
+ *
+ * @return Shared singleton instance of WCAppProfileCache
+ */
++ (instancetype)sharedCache;
+
+/**
+ * @brief Directory that holds the cached profiles
+ */
+@property (nonatomic, copy) NSString *cacheDirectoryPath;
+
+/**
+ * @brief Look up the cached profile for an application bundle
+ *
+ * @param bundlePath Path to the application bundle
+ * @return The cached profile, or nil if there is none or it is stale
+ */
+- (WCAppProfile *)profileForBundlePath:(NSString *)bundlePath;
+
+/**
+ * @brief Store the profile for an application bundle
+ *
+ * The file is replaced atomically, so concurrent launches of the same
+ * application never read a partial entry.
+ *
+ * @param profile The profile to store
+ * @param bundlePath Path to the application bundle
+ * @return YES if the profile was written, NO otherwise
+ */
+- (BOOL)storeProfile:(WCAppProfile *)profile forBundlePath:(NSString *)bundlePath;
+
+/**
+ * @brief Remove the cached profile for an application bundle
+ *
+ * @param bundlePath Path to the application bundle
+ */
+- (void)removeProfileForBundlePath:(NSString *)bundlePath;
+
+@end
+
+#endif /* WC_APP_PROFILE_H */
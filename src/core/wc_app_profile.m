@@ -0,0 +1,323 @@
+/**
+ * @file wc_app_profile.m
+ * @brief Implementation of application profiles and the profile cache
+ */
+
+#import "wc_app_profile.h"
+#import "../util/logger.h"
+#import "../util/path_resolver.h"
+#import <sys/stat.h>
+
+// Bump when the meaning of a stored field changes so old entries are re-detected
+static const NSInteger kWCAppProfileFormatVersion = 1;
+
+// Property list keys
+static NSString * const kWCAppProfileTypeKey = @"applicationType";
+static NSString * const kWCAppProfileScanIntervalKey = @"scanInterval";
+static NSString * const kWCAppProfileDebounceEnabledKey = @"debounceEnabled";
+static NSString * const kWCAppProfileDebounceIntervalKey = @"debounceInterval";
+static NSString * const kWCAppProfileHelperPatternsKey = @"helperNamePatterns";
+static NSString * const kWCAppProfileHelperDepthKey = @"helperDescendantDepth";
+
+static NSString * const kWCAppProfileFormatVersionKey = @"formatVersion";
+static NSString * const kWCAppProfileIdentityKey = @"identity";
+static NSString * const kWCAppProfileProfileKey = @"profile";
+
+static NSString * const kWCAppProfileBundleIdentifierKey = @"bundleIdentifier";
+static NSString * const kWCAppProfileBundleVersionKey = @"bundleVersion";
+static NSString * const kWCAppProfileExecutableMTimeKey = @"executableModificationTime";
+
+@interface WCAppProfile ()
+@property (nonatomic, readwrite, getter=isCached) BOOL cached;
+@end
+
+@implementation WCAppProfile
+
+#pragma mark - Initialization
+
++ (instancetype)defaultProfileForApplicationType:(WCApplicationType)appType {
+    switch (appType) {
+        case WCApplicationTypeElectron:
+            // Renderers and their direct children own the windows
+            return [[self alloc] initWithApplicationType:appType
+                                            scanInterval:0.7
+                                         debounceEnabled:YES
+                                        debounceInterval:0.2
+                                      helperNamePatterns:@[@"Renderer", @"Helper", @"electron"]
+                                   helperDescendantDepth:1];
+
+        case WCApplicationTypeChrome:
+            // Chrome nests helpers up to two levels below the first helper
+            return [[self alloc] initWithApplicationType:appType
+                                            scanInterval:0.5
+                                         debounceEnabled:YES
+                                        debounceInterval:0.15
+                                      helperNamePatterns:@[@"Helper"]
+                                   helperDescendantDepth:2];
+
+        default:
+            return [[self alloc] initWithApplicationType:appType
+                                            scanInterval:1.0
+                                         debounceEnabled:NO
+                                        debounceInterval:0.5
+                                      helperNamePatterns:@[]
+                                   helperDescendantDepth:0];
+    }
+}
+
+- (instancetype)initWithApplicationType:(WCApplicationType)appType
+                           scanInterval:(NSTimeInterval)scanInterval
+                        debounceEnabled:(BOOL)debounceEnabled
+                       debounceInterval:(NSTimeInterval)debounceInterval
+                     helperNamePatterns:(NSArray<NSString *> *)helperNamePatterns
+                  helperDescendantDepth:(NSUInteger)helperDescendantDepth {
+    if (self = [super init]) {
+        _applicationType = appType;
+        _scanInterval = scanInterval;
+        _debounceEnabled = debounceEnabled;
+        _debounceInterval = debounceInterval;
+        _helperNamePatterns = [helperNamePatterns copy] ?: @[];
+        _helperDescendantDepth = helperDescendantDepth;
+        _cached = NO;
+    }
+    return self;
+}
+
+- (instancetype)initWithDictionary:(NSDictionary *)dictionary {
+    if (![dictionary isKindOfClass:[NSDictionary class]]) {
+        return nil;
+    }
+
+    NSNumber *type = dictionary[kWCAppProfileTypeKey];
+    NSNumber *scanInterval = dictionary[kWCAppProfileScanIntervalKey];
+    NSNumber *debounceEnabled = dictionary[kWCAppProfileDebounceEnabledKey];
+    NSNumber *debounceInterval = dictionary[kWCAppProfileDebounceIntervalKey];
+    NSArray *helperPatterns = dictionary[kWCAppProfileHelperPatternsKey];
+    NSNumber *helperDepth = dictionary[kWCAppProfileHelperDepthKey];
+
+    if (![type isKindOfClass:[NSNumber class]] ||
+        ![scanInterval isKindOfClass:[NSNumber class]] ||
+        ![debounceEnabled isKindOfClass:[NSNumber class]] ||
+        ![debounceInterval isKindOfClass:[NSNumber class]] ||
+        ![helperPatterns isKindOfClass:[NSArray class]] ||
+        ![helperDepth isKindOfClass:[NSNumber class]]) {
+        return nil;
+    }
+
+    for (id pattern in helperPatterns) {
+        if (![pattern isKindOfClass:[NSString class]]) {
+            return nil;
+        }
+    }
+
+    // Reject values a scanner could not run with
+    WCApplicationType appType = [type unsignedIntegerValue];
+    if (appType > WCApplicationTypeChrome ||
+        [scanInterval doubleValue] < 0.1 || [scanInterval doubleValue] > 10.0 ||
+        [debounceInterval doubleValue] < 0.0 || [debounceInterval doubleValue] > 10.0) {
+        return nil;
+    }
+
+    return [self initWithApplicationType:appType
+                            scanInterval:[scanInterval doubleValue]
+                         debounceEnabled:[debounceEnabled boolValue]
+                        debounceInterval:[debounceInterval doubleValue]
+                      helperNamePatterns:helperPatterns
+                   helperDescendantDepth:[helperDepth unsignedIntegerValue]];
+}
+
+- (NSDictionary *)dictionaryRepresentation {
+    return @{
+        kWCAppProfileTypeKey: @(_applicationType),
+        kWCAppProfileScanIntervalKey: @(_scanInterval),
+        kWCAppProfileDebounceEnabledKey: @(_debounceEnabled),
+        kWCAppProfileDebounceIntervalKey: @(_debounceInterval),
+        kWCAppProfileHelperPatternsKey: _helperNamePatterns,
+        kWCAppProfileHelperDepthKey: @(_helperDescendantDepth)
+    };
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<WCAppProfile type: %lu, scan: %.2fs, debounce: %@ %.2fs, helpers: %@ depth %lu%@>",
+            (unsigned long)_applicationType, _scanInterval,
+            _debounceEnabled ? @"on" : @"off", _debounceInterval,
+            [_helperNamePatterns componentsJoinedByString:@"|"], (unsigned long)_helperDescendantDepth,
+            _cached ? @", cached" : @""];
+}
+
+@end
+
+@implementation WCAppProfileCache
+
+#pragma mark - Initialization
+
++ (instancetype)sharedCache {
+    static WCAppProfileCache *instance = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        instance = [[self alloc] init];
+    });
+    return instance;
+}
+
+- (instancetype)init {
+    if (self = [super init]) {
+        NSString *supportPath = [[WCPathResolver sharedResolver] applicationSupportDirectoryPath];
+        if (!supportPath) {
+            supportPath = [[WCPathResolver sharedResolver] temporaryDirectoryPath];
+        }
+        _cacheDirectoryPath = [supportPath stringByAppendingPathComponent:@"WindowControlInjector/Profiles"];
+    }
+    return self;
+}
+
+#pragma mark - Cache Access
+
+- (WCAppProfile *)profileForBundlePath:(NSString *)bundlePath {
+    NSDictionary *identity = [self identityForBundlePath:bundlePath];
+    if (!identity) {
+        return nil;
+    }
+
+    NSData *data = [NSData dataWithContentsOfFile:[self entryPathForIdentity:identity]];
+    if (!data) {
+        return nil;
+    }
+
+    NSDictionary *entry = [NSPropertyListSerialization propertyListWithData:data
+                                                                    options:NSPropertyListImmutable
+                                                                     format:NULL
+                                                                      error:NULL];
+    if (![entry isKindOfClass:[NSDictionary class]]) {
+        return nil;
+    }
+
+    // A different build of the application may behave differently, so only trust an exact match
+    if ([entry[kWCAppProfileFormatVersionKey] integerValue] != kWCAppProfileFormatVersion ||
+        ![entry[kWCAppProfileIdentityKey] isEqual:identity]) {
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
+                                     category:@"AppProfile"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Ignoring stale profile for %@", identity[kWCAppProfileBundleIdentifierKey]];
+        return nil;
+    }
+
+    WCAppProfile *profile = [[WCAppProfile alloc] initWithDictionary:entry[kWCAppProfileProfileKey]];
+    profile.cached = YES;
+    return profile;
+}
+
+- (BOOL)storeProfile:(WCAppProfile *)profile forBundlePath:(NSString *)bundlePath {
+    if (!profile) {
+        return NO;
+    }
+
+    NSDictionary *identity = [self identityForBundlePath:bundlePath];
+    if (!identity) {
+        return NO;
+    }
+
+    NSDictionary *entry = @{
+        kWCAppProfileFormatVersionKey: @(kWCAppProfileFormatVersion),
+        kWCAppProfileIdentityKey: identity,
+        kWCAppProfileProfileKey: [profile dictionaryRepresentation]
+    };
+
+    NSError *error = nil;
+    NSData *data = [NSPropertyListSerialization dataWithPropertyList:entry
+                                                              format:NSPropertyListBinaryFormat_v1_0
+                                                             options:0
+                                                               error:&error];
+    if (data) {
+        // Don't go through the path resolver here; it logs every directory it creates
+        [[NSFileManager defaultManager] createDirectoryAtPath:_cacheDirectoryPath
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:NULL];
+        if (![data writeToFile:[self entryPathForIdentity:identity] options:NSDataWritingAtomic error:&error]) {
+            data = nil;
+        }
+    }
+
+    if (!data) {
+        // Sandboxed hosts may not be able to write here; detection just runs again next launch
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
+                                     category:@"AppProfile"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Could not store profile for %@: %@",
+                                             identity[kWCAppProfileBundleIdentifierKey], error.localizedDescription];
+        return NO;
+    }
+
+    [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                 category:@"AppProfile"
+                                     file:__FILE__
+                                     line:__LINE__
+                                 function:__PRETTY_FUNCTION__
+                                   format:@"Stored profile for %@ %@: %@",
+                                         identity[kWCAppProfileBundleIdentifierKey],
+                                         identity[kWCAppProfileBundleVersionKey], profile];
+    return YES;
+}
+
+- (void)removeProfileForBundlePath:(NSString *)bundlePath {
+    NSDictionary *identity = [self identityForBundlePath:bundlePath];
+    if (identity) {
+        [[NSFileManager defaultManager] removeItemAtPath:[self entryPathForIdentity:identity] error:NULL];
+    }
+}
+
+#pragma mark - Helper Methods
+
+/**
+ * Build the key a profile is valid for: bundle ID, version and executable modification time
+ */
+- (NSDictionary *)identityForBundlePath:(NSString *)bundlePath {
+    if (bundlePath.length == 0) {
+        return nil;
+    }
+
+    NSString *infoPlistPath = [bundlePath stringByAppendingPathComponent:@"Contents/Info.plist"];
+    NSDictionary *infoPlist = [NSDictionary dictionaryWithContentsOfFile:infoPlistPath];
+
+    NSString *bundleID = infoPlist[@"CFBundleIdentifier"];
+    NSString *executableName = infoPlist[@"CFBundleExecutable"];
+    if (![bundleID isKindOfClass:[NSString class]] || bundleID.length == 0 ||
+        ![executableName isKindOfClass:[NSString class]] || executableName.length == 0) {
+        return nil;
+    }
+
+    NSString *shortVersion = infoPlist[@"CFBundleShortVersionString"];
+    NSString *buildVersion = infoPlist[@"CFBundleVersion"];
+    NSString *bundleVersion = [NSString stringWithFormat:@"%@ (%@)",
+                               [shortVersion isKindOfClass:[NSString class]] ? shortVersion : @"",
+                               [buildVersion isKindOfClass:[NSString class]] ? buildVersion : @""];
+
+    // Catches rebuilt or patched executables that keep their version string
+    NSString *executablePath = [[bundlePath stringByAppendingPathComponent:@"Contents/MacOS"]
+                                stringByAppendingPathComponent:executableName];
+    struct stat info;
+    if (stat([executablePath fileSystemRepresentation], &info) != 0) {
+        return nil;
+    }
+    long long modificationTime = (long long)info.st_mtimespec.tv_sec * NSEC_PER_SEC + info.st_mtimespec.tv_nsec;
+
+    return @{
+        kWCAppProfileBundleIdentifierKey: bundleID,
+        kWCAppProfileBundleVersionKey: bundleVersion,
+        kWCAppProfileExecutableMTimeKey: @(modificationTime)
+    };
+}
+
+- (NSString *)entryPathForIdentity:(NSDictionary *)identity {
+    NSString *bundleID = identity[kWCAppProfileBundleIdentifierKey];
+    NSString *fileName = [[bundleID stringByReplacingOccurrencesOfString:@"/" withString:@"_"]
+                          stringByAppendingPathExtension:@"plist"];
+    return [_cacheDirectoryPath stringByAppendingPathComponent:fileName];
+}
+
+@end
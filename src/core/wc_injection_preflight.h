@@ -0,0 +1,114 @@
+/**
+ * @file wc_injection_preflight.h
+ * @brief Injection preflight checks for WindowControlInjector
+ *
+ * This file defines a check that runs before an application is launched
+ * with the dylib and predicts whether dyld will actually load it. The code
+ * signature of the executable is inspected for the restrictions that make
+ * dyld ignore DYLD_INSERT_LIBRARIES or reject the dylib, and its
+ * architecture slices are compared with the dylib's. Unsupported targets
+ * fail right away instead of after a launch timeout or as an unprotected
+ * application. Verdicts are cached on disk per executable.
+ */
+
+#ifndef WC_INJECTION_PREFLIGHT_H
+#define WC_INJECTION_PREFLIGHT_H
+
+#import <Foundation/Foundation.h>
+
+/**
+ * @brief Predicted outcome of injecting into an executable
+ */
+typedef NS_ENUM(NSInteger, WCPreflightVerdict) {
+    WCPreflightVerdictSupported            = 0,  // dyld should load the dylib
+    WCPreflightVerdictUnknown              = 1,  // The executable could not be analyzed; injection is attempted
+    WCPreflightVerdictRestricted           = 2,  // Platform or restricted binary, DYLD variables are stripped
+    WCPreflightVerdictHardenedRuntime      = 3,  // Hardened runtime without allow-dyld-environment-variables
+    WCPreflightVerdictLibraryValidation    = 4,  // Library validation rejects the dylib's signature
+    WCPreflightVerdictArchitectureMismatch = 5   // The dylib has no slice for the architecture the executable runs as
+};
+
+/**
+ * @brief Result of a preflight check
+ */
+@interface WCPreflightResult : NSObject
+
+/**
+ * @brief The verdict
+ */
+@property (nonatomic, readonly) WCPreflightVerdict verdict;
+
+/**
+ * @brief Human-readable explanation of the verdict
+ */
+@property (nonatomic, readonly, copy) NSString *reason;
+
+/**
+ * @brief Code directory hash of the executable as hex, or nil if it is unsigned
+ */
+@property (nonatomic, readonly, copy) NSString *cdhash;
+
+/**
+ * @brief YES if the verdict came from the cache rather than an analysis
+ */
+@property (nonatomic, readonly, getter=isCached) BOOL cached;
+
+/**
+ * @brief Whether injection should be attempted
+ *
+ * @return YES for supported and unknown verdicts
+ */
+- (BOOL)allowsInjection;
+
+@end
+
+/**
+ * @brief Analyzes executables and caches the verdicts
+ *
+ * A cached verdict is used while the executable's path, size and
+ * modification time and the dylib's path, size and modification time are
+ * unchanged; re-signing or updating either file rewrites it and invalidates
+ * the entry.
+ * The preflight is thread-safe.
+ */
+@interface WCInjectionPreflight : NSObject
+
+/**
+ * @brief Get the shared preflight instance
+ *
+ * @return Shared singleton instance of WCInjectionPreflight
+ */
++ (instancetype)sharedPreflight;
+
+/**
+ * @brief File that holds the cached verdicts
+ */
+@property (nonatomic, copy) NSString *cacheFilePath;
+
+/**
+ * @brief Check an application bundle or executable
+ *
+ * @param applicationPath Application bundle, resolved to its executable, or an executable
+ * @param dylibPath The dylib that would be injected
+ * @return The result of the check
+ */
+- (WCPreflightResult *)checkApplication:(NSString *)applicationPath dylibPath:(NSString *)dylibPath;
+
+/**
+ * @brief Check an application and describe a failed check as an error
+ *
+ * @param applicationPath Application bundle or executable
+ * @param dylibPath The dylib that would be injected
+ * @param error Set to a WCInjectionErrorTargetUnsupported error if injection would not work
+ * @return YES if injection should be attempted
+ */
+- (BOOL)verifyApplication:(NSString *)applicationPath dylibPath:(NSString *)dylibPath error:(NSError **)error;
+
+/**
+ * @brief Forget all cached verdicts
+ */
+- (void)removeAllVerdicts;
+
+@end
+
+#endif /* WC_INJECTION_PREFLIGHT_H */
@@ -0,0 +1,424 @@
+/**
+ * @file wc_injection_preflight.m
+ * @brief Implementation of the injection preflight checks
+ */
+
+#import "wc_injection_preflight.h"
+#import "../util/error_manager.h"
+#import "../util/logger.h"
+#import "../util/path_resolver.h"
+#import <Security/Security.h>
+#import <mach-o/fat.h>
+#import <mach-o/loader.h>
+#import <mach/machine.h>
+#import <sys/stat.h>
+#import <sys/sysctl.h>
+#import <fcntl.h>
+#import <unistd.h>
+
+// Bump when the analysis changes so old verdicts are recomputed
+static const NSInteger kWCPreflightFormatVersion = 1;
+
+// Property list keys
+static NSString * const kWCPreflightFormatVersionKey = @"formatVersion";
+static NSString * const kWCPreflightEntriesKey = @"entries";
+static NSString * const kWCPreflightSizeKey = @"size";
+static NSString * const kWCPreflightMTimeKey = @"modificationTime";
+static NSString * const kWCPreflightDylibPathKey = @"dylibPath";
+static NSString * const kWCPreflightDylibSizeKey = @"dylibSize";
+static NSString * const kWCPreflightDylibMTimeKey = @"dylibModificationTime";
+static NSString * const kWCPreflightCDHashKey = @"cdhash";
+static NSString * const kWCPreflightVerdictKey = @"verdict";
+static NSString * const kWCPreflightReasonKey = @"reason";
+
+// Entitlements that relax the hardened runtime for injection
+static NSString * const kWCEntitlementAllowDyldEnvironment = @"com.apple.security.cs.allow-dyld-environment-variables";
+static NSString * const kWCEntitlementDisableLibraryValidation = @"com.apple.security.cs.disable-library-validation";
+
+/**
+ * @brief Architecture slices of a Mach-O file
+ */
+typedef NS_OPTIONS(NSUInteger, WCPreflightArchitectures) {
+    WCPreflightArchitectureX86_64 = 1 << 0,
+    WCPreflightArchitectureARM64  = 1 << 1,
+    WCPreflightArchitectureARM64E = 1 << 2
+};
+
+#pragma mark - WCPreflightResult
+
+@implementation WCPreflightResult
+
+- (instancetype)initWithVerdict:(WCPreflightVerdict)verdict
+                         reason:(NSString *)reason
+                         cdhash:(NSString *)cdhash
+                         cached:(BOOL)cached {
+    if (self = [super init]) {
+        _verdict = verdict;
+        _reason = [reason copy];
+        _cdhash = [cdhash copy];
+        _cached = cached;
+    }
+    return self;
+}
+
+- (BOOL)allowsInjection {
+    return _verdict == WCPreflightVerdictSupported || _verdict == WCPreflightVerdictUnknown;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: verdict %ld%@, %@>", NSStringFromClass([self class]),
+            (long)_verdict, _cached ? @" (cached)" : @"", _reason];
+}
+
+@end
+
+#pragma mark - Mach-O Inspection
+
+static WCPreflightArchitectures WCPreflightArchitectureForCPU(cpu_type_t cpuType, cpu_subtype_t cpuSubtype) {
+    if (cpuType == CPU_TYPE_X86_64) return WCPreflightArchitectureX86_64;
+    if (cpuType == CPU_TYPE_ARM64) {
+        return (cpuSubtype & ~CPU_SUBTYPE_MASK) == CPU_SUBTYPE_ARM64E ?
+            WCPreflightArchitectureARM64E : WCPreflightArchitectureARM64;
+    }
+    return 0;
+}
+
+/**
+ * Read the slices from the Mach-O or fat header; 0 if the file is not Mach-O
+ */
+static WCPreflightArchitectures WCPreflightArchitecturesOfFile(NSString *path) {
+    int fd = open([path fileSystemRepresentation], O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+
+    // Headers and the fat table fit in the first page
+    uint8_t header[4096];
+    ssize_t length = pread(fd, header, sizeof(header), 0);
+    close(fd);
+    if (length < (ssize_t)sizeof(uint32_t) * 3) return 0;
+
+    uint32_t magic = *(const uint32_t *)header;
+    WCPreflightArchitectures architectures = 0;
+
+    if (magic == MH_MAGIC_64 || magic == MH_MAGIC) {
+        const struct mach_header *machHeader = (const struct mach_header *)header;
+        return WCPreflightArchitectureForCPU(machHeader->cputype, machHeader->cpusubtype);
+    }
+
+    // Fat headers are big-endian
+    uint32_t fatMagic = OSSwapBigToHostInt32(magic);
+    if (fatMagic != FAT_MAGIC && fatMagic != FAT_MAGIC_64) return 0;
+
+    uint32_t count = OSSwapBigToHostInt32(((const struct fat_header *)header)->nfat_arch);
+    size_t entrySize = fatMagic == FAT_MAGIC_64 ? sizeof(struct fat_arch_64) : sizeof(struct fat_arch);
+    const uint8_t *entry = header + sizeof(struct fat_header);
+
+    for (uint32_t i = 0; i < count && entry + entrySize <= header + length; i++, entry += entrySize) {
+        // cputype and cpusubtype lead both entry layouts
+        const struct fat_arch *arch = (const struct fat_arch *)entry;
+        architectures |= WCPreflightArchitectureForCPU((cpu_type_t)OSSwapBigToHostInt32((uint32_t)arch->cputype),
+                                                       (cpu_subtype_t)OSSwapBigToHostInt32((uint32_t)arch->cpusubtype));
+    }
+
+    return architectures;
+}
+
+static NSString *WCPreflightArchitectureNames(WCPreflightArchitectures architectures) {
+    NSMutableArray<NSString *> *names = [NSMutableArray array];
+    if (architectures & WCPreflightArchitectureARM64) [names addObject:@"arm64"];
+    if (architectures & WCPreflightArchitectureARM64E) [names addObject:@"arm64e"];
+    if (architectures & WCPreflightArchitectureX86_64) [names addObject:@"x86_64"];
+    return names.count > 0 ? [names componentsJoinedByString:@", "] : @"none";
+}
+
+/**
+ * The slice dyld picks for a third-party executable on this machine
+ */
+static WCPreflightArchitectures WCPreflightLaunchArchitecture(WCPreflightArchitectures executable) {
+    // hw.cputype reports x86_64 under Rosetta, so ask whether this process is translated
+    int translated = 0;
+    size_t size = sizeof(translated);
+    BOOL appleSilicon = sysctlbyname("sysctl.proc_translated", &translated, &size, NULL, 0) == 0 && translated;
+
+    cpu_type_t cpuType = 0;
+    size = sizeof(cpuType);
+    if (!appleSilicon && sysctlbyname("hw.cputype", &cpuType, &size, NULL, 0) == 0) {
+        appleSilicon = cpuType == CPU_TYPE_ARM64;
+    }
+
+    if (!appleSilicon) {
+        return executable & WCPreflightArchitectureX86_64;
+    }
+
+    // A third-party arm64e slice is only used without an arm64 one; with neither, Rosetta runs x86_64
+    if (executable & WCPreflightArchitectureARM64) return WCPreflightArchitectureARM64;
+    if (executable & WCPreflightArchitectureARM64E) return WCPreflightArchitectureARM64E;
+    return executable & WCPreflightArchitectureX86_64;
+}
+
+#pragma mark - Code Signature Inspection
+
+/**
+ * Read the signing information of a file; nil if it cannot be read
+ */
+static NSDictionary *WCPreflightSigningInformation(NSString *path) {
+    SecStaticCodeRef code = NULL;
+    if (SecStaticCodeCreateWithPath((__bridge CFURLRef)[NSURL fileURLWithPath:path], kSecCSDefaultFlags, &code) != errSecSuccess) {
+        return nil;
+    }
+
+    CFDictionaryRef information = NULL;
+    OSStatus status = SecCodeCopySigningInformation(code,
+                                                    kSecCSSigningInformation | kSecCSRequirementInformation,
+                                                    &information);
+    CFRelease(code);
+
+    return status == errSecSuccess ? CFBridgingRelease(information) : nil;
+}
+
+static NSString *WCPreflightHexString(NSData *data) {
+    if (![data isKindOfClass:[NSData class]] || data.length == 0) return nil;
+
+    const uint8_t *bytes = data.bytes;
+    NSMutableString *hex = [NSMutableString stringWithCapacity:data.length * 2];
+    for (NSUInteger i = 0; i < data.length; i++) {
+        [hex appendFormat:@"%02x", bytes[i]];
+    }
+    return hex;
+}
+
+#pragma mark - WCInjectionPreflight
+
+@implementation WCInjectionPreflight {
+    NSMutableDictionary<NSString *, NSDictionary *> *_entries;  // Executable path to cache entry, loaded on first use
+}
+
++ (instancetype)sharedPreflight {
+    static WCInjectionPreflight *instance = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        instance = [[self alloc] init];
+    });
+    return instance;
+}
+
+- (instancetype)init {
+    if (self = [super init]) {
+        NSString *supportPath = [[WCPathResolver sharedResolver] applicationSupportDirectoryPath];
+        if (!supportPath) {
+            supportPath = [[WCPathResolver sharedResolver] temporaryDirectoryPath];
+        }
+        _cacheFilePath = [supportPath stringByAppendingPathComponent:@"WindowControlInjector/Preflight.plist"];
+        _entries = nil;
+    }
+    return self;
+}
+
+#pragma mark - Checks
+
+- (WCPreflightResult *)checkApplication:(NSString *)applicationPath dylibPath:(NSString *)dylibPath {
+    BOOL isDirectory = NO;
+    NSString *executablePath = applicationPath;
+    if ([[NSFileManager defaultManager] fileExistsAtPath:applicationPath isDirectory:&isDirectory] && isDirectory) {
+        executablePath = [[WCPathResolver sharedResolver] resolveExecutablePathForApplication:applicationPath];
+    }
+
+    struct stat executableInfo;
+    struct stat dylibInfo;
+    if (!executablePath || stat([executablePath fileSystemRepresentation], &executableInfo) != 0 ||
+        !dylibPath || stat([dylibPath fileSystemRepresentation], &dylibInfo) != 0) {
+        return [[WCPreflightResult alloc] initWithVerdict:WCPreflightVerdictUnknown
+                                                   reason:@"Executable or dylib could not be read"
+                                                   cdhash:nil
+                                                   cached:NO];
+    }
+
+    NSDictionary *identity = @{
+        kWCPreflightSizeKey: @((long long)executableInfo.st_size),
+        kWCPreflightMTimeKey: @((long long)executableInfo.st_mtimespec.tv_sec * NSEC_PER_SEC + executableInfo.st_mtimespec.tv_nsec),
+        kWCPreflightDylibPathKey: dylibPath,
+        kWCPreflightDylibSizeKey: @((long long)dylibInfo.st_size),
+        kWCPreflightDylibMTimeKey: @((long long)dylibInfo.st_mtimespec.tv_sec * NSEC_PER_SEC + dylibInfo.st_mtimespec.tv_nsec)
+    };
+
+    @synchronized (self) {
+        NSDictionary *entry = [self entries][executablePath];
+        BOOL matches = entry != nil;
+        for (NSString *key in identity) {
+            matches = matches && [entry[key] isEqual:identity[key]];
+        }
+        if (matches) {
+            return [[WCPreflightResult alloc] initWithVerdict:[entry[kWCPreflightVerdictKey] integerValue]
+                                                       reason:entry[kWCPreflightReasonKey]
+                                                       cdhash:entry[kWCPreflightCDHashKey]
+                                                       cached:YES];
+        }
+    }
+
+    uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    WCPreflightResult *result = [self analyzeExecutable:executablePath dylibPath:dylibPath];
+
+    [[WCLogger sharedLogger] logWithLevel:result.allowsInjection ? WCLogLevelDebug : WCLogLevelWarning
+                                 category:@"Preflight"
+                                     file:__FILE__
+                                     line:__LINE__
+                                 function:__PRETTY_FUNCTION__
+                                   format:@"Analyzed %@ in %.1f ms: %@", executablePath,
+                                         (clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start) / 1e6, result.reason];
+
+    // Unknown verdicts are retried next time; the file may just have been mid-update
+    if (result.verdict != WCPreflightVerdictUnknown) {
+        NSMutableDictionary *entry = [identity mutableCopy];
+        entry[kWCPreflightVerdictKey] = @(result.verdict);
+        entry[kWCPreflightReasonKey] = result.reason;
+        entry[kWCPreflightCDHashKey] = result.cdhash;
+
+        @synchronized (self) {
+            [self entries][executablePath] = entry;
+            [self writeEntries];
+        }
+    }
+
+    return result;
+}
+
+- (BOOL)verifyApplication:(NSString *)applicationPath dylibPath:(NSString *)dylibPath error:(NSError **)error {
+    WCPreflightResult *result = [self checkApplication:applicationPath dylibPath:dylibPath];
+    if (result.allowsInjection) {
+        return YES;
+    }
+
+    if (error) {
+        *error = [WCError errorWithCategory:WCErrorCategoryInjection
+                                       code:WCInjectionErrorTargetUnsupported
+                                    message:[NSString stringWithFormat:@"Cannot inject into %@: %@",
+                                             applicationPath, result.reason]];
+    }
+    return NO;
+}
+
+- (WCPreflightResult *)analyzeExecutable:(NSString *)executablePath dylibPath:(NSString *)dylibPath {
+    // System executables are protected by SIP, which strips DYLD variables regardless of signature
+    BOOL systemPath = NO;
+    for (NSString *prefix in @[@"/System/", @"/usr/", @"/bin/", @"/sbin/"]) {
+        systemPath = systemPath || [executablePath hasPrefix:prefix];
+    }
+    if (systemPath && ![executablePath hasPrefix:@"/usr/local/"]) {
+        return [[WCPreflightResult alloc] initWithVerdict:WCPreflightVerdictRestricted
+                                                   reason:@"System executables are protected by System Integrity Protection"
+                                                   cdhash:nil
+                                                   cached:NO];
+    }
+
+    WCPreflightArchitectures executableArchitectures = WCPreflightArchitecturesOfFile(executablePath);
+    WCPreflightArchitectures dylibArchitectures = WCPreflightArchitecturesOfFile(dylibPath);
+    if (executableArchitectures == 0 || dylibArchitectures == 0) {
+        return [[WCPreflightResult alloc] initWithVerdict:WCPreflightVerdictUnknown
+                                                   reason:@"Executable or dylib is not a Mach-O file"
+                                                   cdhash:nil
+                                                   cached:NO];
+    }
+
+    NSDictionary *signing = WCPreflightSigningInformation(executablePath);
+    NSString *cdhash = WCPreflightHexString(signing[(__bridge NSString *)kSecCodeInfoUnique]);
+    uint32_t flags = [signing[(__bridge NSString *)kSecCodeInfoFlags] unsignedIntValue];
+    NSDictionary *entitlements = signing[(__bridge NSString *)kSecCodeInfoEntitlementsDict];
+    if (![entitlements isKindOfClass:[NSDictionary class]]) entitlements = nil;
+
+    WCPreflightVerdict verdict = WCPreflightVerdictSupported;
+    NSString *reason = nil;
+    BOOL hardenedRuntime = (flags & kSecCodeSignatureRuntime) != 0;
+
+    if ((flags & kSecCodeSignatureRestrict) || signing[(__bridge NSString *)kSecCodeInfoPlatformIdentifier]) {
+        verdict = WCPreflightVerdictRestricted;
+        reason = @"Restricted or platform binaries ignore DYLD_INSERT_LIBRARIES";
+    } else if (hardenedRuntime && ![entitlements[kWCEntitlementAllowDyldEnvironment] boolValue]) {
+        verdict = WCPreflightVerdictHardenedRuntime;
+        reason = @"Hardened runtime without the allow-dyld-environment-variables entitlement ignores DYLD_INSERT_LIBRARIES";
+    } else if ((flags & kSecCodeSignatureLibraryValidation) ||
+               (hardenedRuntime && ![entitlements[kWCEntitlementDisableLibraryValidation] boolValue])) {
+        // Library validation only loads code signed by the same team
+        NSString *teamID = signing[(__bridge NSString *)kSecCodeInfoTeamIdentifier];
+        NSString *dylibTeamID = WCPreflightSigningInformation(dylibPath)[(__bridge NSString *)kSecCodeInfoTeamIdentifier];
+        if (!teamID || ![teamID isEqual:dylibTeamID]) {
+            verdict = WCPreflightVerdictLibraryValidation;
+            reason = [NSString stringWithFormat:@"Library validation only loads code signed by team %@, the dylib is signed by %@",
+                      teamID ?: @"(none)", dylibTeamID ?: @"(none)"];
+        }
+    }
+
+    if (verdict == WCPreflightVerdictSupported) {
+        WCPreflightArchitectures launchArchitecture = WCPreflightLaunchArchitecture(executableArchitectures);
+        if (launchArchitecture == 0 || !(dylibArchitectures & launchArchitecture)) {
+            verdict = WCPreflightVerdictArchitectureMismatch;
+            reason = [NSString stringWithFormat:@"Executable runs as %@ (slices: %@), dylib has %@",
+                      WCPreflightArchitectureNames(launchArchitecture),
+                      WCPreflightArchitectureNames(executableArchitectures),
+                      WCPreflightArchitectureNames(dylibArchitectures)];
+        } else {
+            reason = [NSString stringWithFormat:@"Supported, runs as %@%@",
+                      WCPreflightArchitectureNames(launchArchitecture),
+                      hardenedRuntime ? @" with hardened runtime exceptions" : @""];
+        }
+    }
+
+    return [[WCPreflightResult alloc] initWithVerdict:verdict reason:reason cdhash:cdhash cached:NO];
+}
+
+#pragma mark - Cache
+
+// Called with self locked
+- (NSMutableDictionary<NSString *, NSDictionary *> *)entries {
+    if (_entries) return _entries;
+
+    _entries = [NSMutableDictionary dictionary];
+
+    NSData *data = [NSData dataWithContentsOfFile:_cacheFilePath];
+    NSDictionary *cache = data ? [NSPropertyListSerialization propertyListWithData:data
+                                                                          options:NSPropertyListImmutable
+                                                                           format:NULL
+                                                                            error:NULL] : nil;
+    if ([cache isKindOfClass:[NSDictionary class]] &&
+        [cache[kWCPreflightFormatVersionKey] integerValue] == kWCPreflightFormatVersion &&
+        [cache[kWCPreflightEntriesKey] isKindOfClass:[NSDictionary class]]) {
+        [_entries addEntriesFromDictionary:cache[kWCPreflightEntriesKey]];
+    }
+
+    return _entries;
+}
+
+// Called with self locked
+- (void)writeEntries {
+    NSDictionary *cache = @{
+        kWCPreflightFormatVersionKey: @(kWCPreflightFormatVersion),
+        kWCPreflightEntriesKey: _entries ?: @{}
+    };
+
+    NSData *data = [NSPropertyListSerialization dataWithPropertyList:cache
+                                                              format:NSPropertyListBinaryFormat_v1_0
+                                                             options:0
+                                                               error:NULL];
+
+    // Don't go through the path resolver here; it logs every directory it creates
+    [[NSFileManager defaultManager] createDirectoryAtPath:[_cacheFilePath stringByDeletingLastPathComponent]
+                              withIntermediateDirectories:YES
+                                               attributes:nil
+                                                    error:NULL];
+    if (!data || ![data writeToFile:_cacheFilePath options:NSDataWritingAtomic error:NULL]) {
+        // The analysis just runs again next time
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
+                                     category:@"Preflight"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Could not store preflight verdicts at %@", _cacheFilePath];
+    }
+}
+
+- (void)removeAllVerdicts {
+    @synchronized (self) {
+        _entries = [NSMutableDictionary dictionary];
+        [[NSFileManager defaultManager] removeItemAtPath:_cacheFilePath error:NULL];
+    }
+}
+
+@end
@@ -0,0 +1,120 @@
+/**
+ * @file wc_injector_daemon.h
+ * @brief Resident injector daemon for WindowControlInjector
+ *
+ * This file defines a long-lived daemon that keeps the resolved dylib path,
+ * the configuration and the application profile cache warm between
+ * protections. Clients send protect, unprotect, status and metrics
+ * requests over a Unix domain socket, and the daemon watches NSWorkspace
+ * launches so that configured applications are protected automatically.
+ *
+ * The protocol is one JSON object per line in each direction. A request
+ * has a "command" key ("protect", "unprotect", "status" or "metrics")
+ * and, for protect and unprotect, a "paths" array. Every response has an
+ * "ok" key and, when it is NO, an "error" string. A metrics response
+ * carries the fleet report of wc_fleet_metrics.h.
+ */
+
+#ifndef WC_INJECTOR_DAEMON_H
+#define WC_INJECTOR_DAEMON_H
+
+#import <Foundation/Foundation.h>
+
+// Error domain for daemon and client errors
+extern NSString *const WCInjectorDaemonErrorDomain;
+
+/**
+ * @brief Resident daemon that serves protection requests over a socket
+ *
+ * All daemon state is confined to a private serial queue. Protections run
+ * on a global queue so a slow launch never blocks status requests.
+ */
+@interface WCInjectorDaemon : NSObject
+
+/**
+ * @brief Get the shared daemon instance
+ *
+ * @return Shared singleton instance of WCInjectorDaemon
+ */
++ (instancetype)sharedDaemon;
+
+/**
+ * @brief Socket path used when none is given
+ *
+ * @return Path of injector.sock in the WindowControlInjector Application Support directory
+ */
++ (NSString *)defaultSocketPath;
+
+/**
+ * @brief Send one request to a running daemon and wait for its response
+ *
+ * @param request The request dictionary
+ * @param socketPath The daemon socket, or nil for the default
+ * @param timeout Seconds to wait for the response
+ * @param error On failure, set to the reason
+ * @return The response dictionary, or nil on failure
+ */
++ (NSDictionary *)sendRequest:(NSDictionary *)request
+                 toSocketPath:(NSString *)socketPath
+                      timeout:(NSTimeInterval)timeout
+                        error:(NSError **)error;
+
+/**
+ * @brief Relaunch watched applications that were started without the injector
+ *
+ * When NO, such launches are only reported in the status. Defaults to NO.
+ */
+@property (atomic, assign) BOOL relaunchesUnprotectedApplications;
+
+/**
+ * @brief Start listening and watching application launches
+ *
+ * The dylib path is resolved once here and reused for every request.
+ * Fails if another daemon is already listening on the socket.
+ *
+ * @param socketPath The socket to listen on, or nil for the default
+ * @param error On failure, set to the reason
+ * @return YES if the daemon started, NO otherwise
+ */
+- (BOOL)startWithSocketPath:(NSString *)socketPath error:(NSError **)error;
+
+/**
+ * @brief Stop listening, close all connections and remove the socket
+ */
+- (void)stop;
+
+/**
+ * @brief Check if the daemon is running
+ *
+ * @return YES if started and not stopped, NO otherwise
+ */
+- (BOOL)isRunning;
+
+/**
+ * @brief Protect an application automatically whenever it is launched
+ *
+ * The application's profile is detected and cached now, so the injected
+ * process finds it on disk at launch.
+ *
+ * @param applicationPath Path to the application bundle
+ */
+- (void)watchApplicationAtPath:(NSString *)applicationPath;
+
+/**
+ * @brief Stop protecting an application automatically
+ *
+ * @param applicationPath Path to the application bundle
+ */
+- (void)unwatchApplicationAtPath:(NSString *)applicationPath;
+
+/**
+ * @brief Handle one request as if it had arrived on the socket
+ *
+ * @param request The request dictionary
+ * @param completion Called on the daemon queue with the response
+ */
+- (void)handleRequest:(NSDictionary *)request completion:(void (^)(NSDictionary *response))completion;
+
+@end
+
+#endif /* WC_INJECTOR_DAEMON_H */
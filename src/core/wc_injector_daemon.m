@@ -0,0 +1,741 @@
+/**
+ * @file wc_injector_daemon.m
+ * @brief Implementation of the resident injector daemon
+ */
+
+#import "wc_injector_daemon.h"
+#import "protector.h"
+#import "wc_app_profile.h"
+#import "wc_window_bridge.h"
+#import "../util/configuration_manager.h"
+#import "../util/wc_fleet_metrics.h"
+#import "../util/logger.h"
+#import "../util/path_resolver.h"
+#import <AppKit/AppKit.h>
+#import <errno.h>
+#import <fcntl.h>
+#import <sys/socket.h>
+#import <sys/stat.h>
+#import <sys/un.h>
+#import <unistd.h>
+
+NSString *const WCInjectorDaemonErrorDomain = @"com.windowcontrolinjector.daemon";
+
+// Largest request line accepted before the connection is dropped
+static const NSUInteger kWCDaemonMaxRequestLength = 64 * 1024;
+
+// Pending connections queued by the kernel
+static const int kWCDaemonListenBacklog = 16;
+
+// Seconds a blocked response write may take before the client is dropped
+static const time_t kWCDaemonWriteTimeout = 2;
+
+#pragma mark - Helpers
+
+static NSError *WCDaemonError(NSInteger code, NSString *description) {
+    return [NSError errorWithDomain:WCInjectorDaemonErrorDomain
+                               code:code
+                           userInfo:@{NSLocalizedDescriptionKey: description}];
+}
+
+static NSString *WCDaemonNormalizePath(NSString *path) {
+    if (![path isKindOfClass:[NSString class]] || path.length == 0) return nil;
+    return [[[path stringByExpandingTildeInPath] stringByStandardizingPath] stringByResolvingSymlinksInPath];
+}
+
+static BOOL WCDaemonFillSocketAddress(NSString *socketPath, struct sockaddr_un *address) {
+    const char *fileSystemPath = socketPath.fileSystemRepresentation;
+    if (!fileSystemPath || strlen(fileSystemPath) >= sizeof(address->sun_path)) {
+        return NO;
+    }
+
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    strlcpy(address->sun_path, fileSystemPath, sizeof(address->sun_path));
+    return YES;
+}
+
+static void WCDaemonSetSocketTimeout(int fd, int option, NSTimeInterval seconds) {
+    struct timeval timeout;
+    timeout.tv_sec = (time_t)seconds;
+    timeout.tv_usec = (suseconds_t)((seconds - (NSTimeInterval)timeout.tv_sec) * 1e6);
+    setsockopt(fd, SOL_SOCKET, option, &timeout, sizeof(timeout));
+}
+
+static BOOL WCDaemonWriteLine(int fd, NSDictionary *object) {
+    NSData *json = [NSJSONSerialization dataWithJSONObject:object options:0 error:NULL];
+    if (!json) return NO;
+
+    NSMutableData *line = [json mutableCopy];
+    [line appendBytes:"\n" length:1];
+
+    const uint8_t *bytes = line.bytes;
+    size_t remaining = line.length;
+    while (remaining > 0) {
+        ssize_t written = write(fd, bytes, remaining);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return NO;
+        }
+        bytes += written;
+        remaining -= (size_t)written;
+    }
+    return YES;
+}
+
+#pragma mark - Connection
+
+/**
+ * One client connection; only touched on the daemon queue
+ */
+@interface WCDaemonConnection : NSObject
+@property (nonatomic, assign) int fileDescriptor;
+@property (nonatomic, strong) dispatch_source_t readSource;
+@property (nonatomic, strong) NSMutableData *buffer;
+@property (nonatomic, assign, getter=isClosed) BOOL closed;
+@end
+
+@implementation WCDaemonConnection
+@end
+
+#pragma mark - WCInjectorDaemon
+
+@implementation WCInjectorDaemon {
+    dispatch_queue_t _queue;
+
+    // Only touched on _queue
+    BOOL _running;
+    int _listenFD;
+    dispatch_source_t _listenSource;
+    NSString *_socketPath;
+    NSString *_dylibPath;
+    NSTimeInterval _startTime;
+    NSUInteger _requestCount;
+    NSMutableSet<WCDaemonConnection *> *_connections;
+    NSMutableSet<NSString *> *_watchedPaths;
+    NSCountedSet<NSString *> *_launchesInFlight;
+    NSMutableDictionary<NSNumber *, NSDictionary *> *_protectedProcesses;
+    NSMutableDictionary<NSNumber *, NSString *> *_unprotectedProcesses;
+    NSMutableSet<NSNumber *> *_pendingRelaunchPIDs;
+
+    // Only touched on the main thread
+    id _launchObserver;
+    id _terminateObserver;
+}
+
+#pragma mark - Lifecycle
+
++ (instancetype)sharedDaemon {
+    static WCInjectorDaemon *instance = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        instance = [[self alloc] init];
+    });
+    return instance;
+}
+
++ (NSString *)defaultSocketPath {
+    NSString *supportPath = [[WCPathResolver sharedResolver] applicationSupportDirectoryPath];
+    return [[supportPath stringByAppendingPathComponent:@"WindowControlInjector"]
+            stringByAppendingPathComponent:@"injector.sock"];
+}
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _queue = dispatch_queue_create("com.windowcontrolinjector.daemon", DISPATCH_QUEUE_SERIAL);
+        _running = NO;
+        _listenFD = -1;
+        _listenSource = nil;
+        _connections = [NSMutableSet set];
+        _watchedPaths = [NSMutableSet set];
+        _launchesInFlight = [NSCountedSet set];
+        _protectedProcesses = [NSMutableDictionary dictionary];
+        _unprotectedProcesses = [NSMutableDictionary dictionary];
+        _pendingRelaunchPIDs = [NSMutableSet set];
+    }
+    return self;
+}
+
+- (BOOL)startWithSocketPath:(NSString *)socketPath error:(NSError **)error {
+    __block BOOL started = NO;
+    __block NSError *startError = nil;
+    NSString *path = socketPath.length > 0 ? [socketPath stringByExpandingTildeInPath] : [[self class] defaultSocketPath];
+
+    dispatch_sync(_queue, ^{
+        started = [self startOnQueueWithSocketPath:path error:&startError];
+    });
+
+    if (!started) {
+        if (error) *error = startError;
+        return NO;
+    }
+
+    void (^startObserving)(void) = ^{
+        [self startObservingWorkspace];
+    };
+    if ([NSThread isMainThread]) {
+        startObserving();
+    } else {
+        dispatch_async(dispatch_get_main_queue(), startObserving);
+    }
+
+    WCLogInfo(@"Daemon", @"Listening on %@ with dylib %@", path, _dylibPath);
+    return YES;
+}
+
+- (BOOL)startOnQueueWithSocketPath:(NSString *)socketPath error:(NSError **)error {
+    if (_running) {
+        if (error) *error = WCDaemonError(1, @"Daemon is already running");
+        return NO;
+    }
+
+    // Resolve the dylib once; the custom path short-circuits every later lookup
+    WCPathResolver *resolver = [WCPathResolver sharedResolver];
+    NSString *dylibPath = [resolver resolvePathForDylib];
+    if (!dylibPath) {
+        if (error) *error = WCDaemonError(2, @"Couldn't find injector dylib");
+        return NO;
+    }
+    [resolver setCustomDylibPath:dylibPath];
+
+    // Parse the configuration once up front
+    (void)[WCConfigurationManager sharedManager];
+
+    struct sockaddr_un address;
+    if (!WCDaemonFillSocketAddress(socketPath, &address)) {
+        if (error) *error = WCDaemonError(3, [NSString stringWithFormat:@"Socket path is too long: %@", socketPath]);
+        return NO;
+    }
+
+    NSString *directory = [socketPath stringByDeletingLastPathComponent];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory
+                              withIntermediateDirectories:YES
+                                               attributes:@{NSFilePosixPermissions: @0700}
+                                                    error:NULL];
+
+    // A socket file nobody answers on is left over from a daemon that died
+    int probeFD = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probeFD >= 0) {
+        BOOL live = connect(probeFD, (struct sockaddr *)&address, sizeof(address)) == 0;
+        close(probeFD);
+        if (live) {
+            if (error) *error = WCDaemonError(4, [NSString stringWithFormat:@"Another daemon is listening on %@", socketPath]);
+            return NO;
+        }
+    }
+    unlink(address.sun_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        if (error) *error = WCDaemonError(5, [NSString stringWithFormat:@"socket() failed: %s", strerror(errno)]);
+        return NO;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    // Created owner-only, so nobody can connect between bind() and the chmod
+    mode_t previousMask = umask(0077);
+    int bound = bind(fd, (struct sockaddr *)&address, sizeof(address));
+    umask(previousMask);
+
+    if (bound != 0 ||
+        chmod(address.sun_path, 0600) != 0 ||
+        listen(fd, kWCDaemonListenBacklog) != 0) {
+        NSString *reason = [NSString stringWithFormat:@"Could not listen on %@: %s", socketPath, strerror(errno)];
+        close(fd);
+        unlink(address.sun_path);
+        if (error) *error = WCDaemonError(5, reason);
+        return NO;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    _listenFD = fd;
+    _socketPath = [socketPath copy];
+    _dylibPath = [dylibPath copy];
+    _startTime = [[NSProcessInfo processInfo] systemUptime];
+    _requestCount = 0;
+
+    _listenSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, _queue);
+    dispatch_source_set_event_handler(_listenSource, ^{
+        [self acceptConnections];
+    });
+    dispatch_source_set_cancel_handler(_listenSource, ^{
+        close(fd);
+    });
+    dispatch_resume(_listenSource);
+
+    _running = YES;
+    return YES;
+}
+
+- (void)stop {
+    dispatch_sync(_queue, ^{
+        if (!self->_running) return;
+        self->_running = NO;
+
+        dispatch_source_cancel(self->_listenSource);
+        self->_listenSource = nil;
+        self->_listenFD = -1;
+        unlink(self->_socketPath.fileSystemRepresentation);
+
+        for (WCDaemonConnection *connection in [self->_connections copy]) {
+            [self closeConnection:connection];
+        }
+    });
+
+    void (^stopObserving)(void) = ^{
+        [self stopObservingWorkspace];
+    };
+    if ([NSThread isMainThread]) {
+        stopObserving();
+    } else {
+        dispatch_async(dispatch_get_main_queue(), stopObserving);
+    }
+
+    WCLogInfo(@"Daemon", @"Stopped");
+}
+
+- (BOOL)isRunning {
+    __block BOOL running = NO;
+    dispatch_sync(_queue, ^{
+        running = self->_running;
+    });
+    return running;
+}
+
+#pragma mark - Watched Applications
+
+- (void)watchApplicationAtPath:(NSString *)applicationPath {
+    NSString *path = WCDaemonNormalizePath(applicationPath);
+    if (!path) return;
+
+    dispatch_async(_queue, ^{
+        if (![self->_watchedPaths containsObject:path]) {
+            [self->_watchedPaths addObject:path];
+            WCLogInfo(@"Daemon", @"Watching %@", path);
+        }
+    });
+
+    // Detect and cache the profile now so the injected process starts from the disk cache
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        (void)[WCWindowBridge applicationProfileForPath:path];
+    });
+}
+
+- (void)unwatchApplicationAtPath:(NSString *)applicationPath {
+    NSString *path = WCDaemonNormalizePath(applicationPath);
+    if (!path) return;
+
+    dispatch_async(_queue, ^{
+        [self->_watchedPaths removeObject:path];
+    });
+}
+
+#pragma mark - Workspace Notifications
+
+- (void)startObservingWorkspace {
+    if (_launchObserver) return;
+
+    NSNotificationCenter *center = [[NSWorkspace sharedWorkspace] notificationCenter];
+    _launchObserver = [center addObserverForName:NSWorkspaceDidLaunchApplicationNotification
+                                          object:nil
+                                           queue:nil
+                                      usingBlock:^(NSNotification *notification) {
+        NSRunningApplication *app = notification.userInfo[NSWorkspaceApplicationKey];
+        NSString *path = WCDaemonNormalizePath(app.bundleURL.path);
+        if (!path) return;
+
+        pid_t pid = app.processIdentifier;
+        dispatch_async(self->_queue, ^{
+            [self applicationDidLaunchAtPath:path processIdentifier:pid];
+        });
+    }];
+
+    _terminateObserver = [center addObserverForName:NSWorkspaceDidTerminateApplicationNotification
+                                             object:nil
+                                              queue:nil
+                                         usingBlock:^(NSNotification *notification) {
+        NSRunningApplication *app = notification.userInfo[NSWorkspaceApplicationKey];
+        pid_t pid = app.processIdentifier;
+        dispatch_async(self->_queue, ^{
+            [self applicationDidTerminateWithProcessIdentifier:pid];
+        });
+    }];
+}
+
+- (void)stopObservingWorkspace {
+    NSNotificationCenter *center = [[NSWorkspace sharedWorkspace] notificationCenter];
+    if (_launchObserver) {
+        [center removeObserver:_launchObserver];
+        _launchObserver = nil;
+    }
+    if (_terminateObserver) {
+        [center removeObserver:_terminateObserver];
+        _terminateObserver = nil;
+    }
+}
+
+- (void)applicationDidLaunchAtPath:(NSString *)path processIdentifier:(pid_t)pid {
+    NSNumber *pidKey = @(pid);
+
+    // Ignore unwatched applications and the launches the daemon made itself
+    if (!_running || ![_watchedPaths containsObject:path] ||
+        _protectedProcesses[pidKey] || [_launchesInFlight containsObject:path]) {
+        return;
+    }
+
+    _unprotectedProcesses[pidKey] = path;
+
+    if (!self.relaunchesUnprotectedApplications) {
+        WCLogWarning(@"Daemon", @"%@ (pid %d) was launched without the injector", path, (int)pid);
+        return;
+    }
+
+    // Relaunch with the injector once the unprotected instance has quit
+    WCLogInfo(@"Daemon", @"%@ (pid %d) was launched without the injector, relaunching", path, (int)pid);
+    [_pendingRelaunchPIDs addObject:pidKey];
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [[NSRunningApplication runningApplicationWithProcessIdentifier:pid] terminate];
+    });
+}
+
+- (void)applicationDidTerminateWithProcessIdentifier:(pid_t)pid {
+    NSNumber *pidKey = @(pid);
+    NSString *path = _unprotectedProcesses[pidKey];
+
+    [_protectedProcesses removeObjectForKey:pidKey];
+    [_unprotectedProcesses removeObjectForKey:pidKey];
+
+    if ([_pendingRelaunchPIDs containsObject:pidKey]) {
+        [_pendingRelaunchPIDs removeObject:pidKey];
+        if (_running && path) {
+            [self protectPaths:@[path] completion:nil];
+        }
+    }
+}
+
+#pragma mark - Protection
+
+- (void)protectPaths:(NSArray<NSString *> *)paths completion:(void (^)(NSArray<NSDictionary *> *results))completion {
+    for (NSString *path in paths) {
+        [_launchesInFlight addObject:path];
+    }
+
+    // Launches block for up to the timeout, so keep them off the daemon queue
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        NSArray<WCProtectionResult *> *results = [WCProtector protectApplications:paths
+                                                                          timeout:WCProtectorDefaultLaunchTimeout];
+
+        dispatch_async(self->_queue, ^{
+            NSMutableArray<NSDictionary *> *reports = [NSMutableArray arrayWithCapacity:results.count];
+            NSDate *now = [NSDate date];
+
+            for (WCProtectionResult *result in results) {
+                [self->_launchesInFlight removeObject:result.applicationPath];
+
+                NSMutableDictionary *report = [NSMutableDictionary dictionary];
+                report[@"path"] = result.applicationPath;
+                report[@"ok"] = @(result.successful);
+                report[@"launchDuration"] = @(result.launchDuration);
+                if (result.successful) {
+                    report[@"pid"] = @(result.processIdentifier);
+                    self->_protectedProcesses[@(result.processIdentifier)] = @{
+                        @"path": result.applicationPath,
+                        @"launchedAt": @([now timeIntervalSince1970]),
+                        @"launchDuration": @(result.launchDuration)
+                    };
+                } else if (result.error) {
+                    report[@"error"] = result.error.localizedDescription;
+                }
+                [reports addObject:report];
+            }
+
+            if (completion) completion(reports);
+        });
+    });
+}
+
+#pragma mark - Requests
+
+- (void)handleRequest:(NSDictionary *)request completion:(void (^)(NSDictionary *response))completion {
+    dispatch_async(_queue, ^{
+        [self handleRequestOnQueue:request completion:completion];
+    });
+}
+
+- (void)handleRequestOnQueue:(NSDictionary *)request completion:(void (^)(NSDictionary *response))completion {
+    _requestCount++;
+
+    NSString *command = [request isKindOfClass:[NSDictionary class]] ? request[@"command"] : nil;
+    if (![command isKindOfClass:[NSString class]]) {
+        completion(@{@"ok": @NO, @"error": @"Request has no command"});
+        return;
+    }
+
+    NSMutableArray<NSString *> *paths = [NSMutableArray array];
+    id rawPaths = request[@"paths"];
+    if ([rawPaths isKindOfClass:[NSArray class]]) {
+        for (id rawPath in rawPaths) {
+            NSString *path = WCDaemonNormalizePath(rawPath);
+            if (path) [paths addObject:path];
+        }
+    }
+
+    if ([command isEqualToString:@"status"]) {
+        completion([self statusOnQueue]);
+    } else if ([command isEqualToString:@"metrics"]) {
+        NSMutableDictionary *response = [WCFleetMetricsReport() mutableCopy];
+        response[@"ok"] = @YES;
+        completion(response);
+    } else if ([command isEqualToString:@"protect"]) {
+        if (paths.count == 0) {
+            completion(@{@"ok": @NO, @"error": @"protect requires paths"});
+            return;
+        }
+
+        if ([request[@"watch"] boolValue]) {
+            for (NSString *path in paths) {
+                [self watchApplicationAtPath:path];
+            }
+        }
+
+        [self protectPaths:paths completion:^(NSArray<NSDictionary *> *results) {
+            BOOL allSucceeded = YES;
+            for (NSDictionary *result in results) {
+                allSucceeded = allSucceeded && [result[@"ok"] boolValue];
+            }
+            completion(@{@"ok": @(allSucceeded), @"results": results});
+        }];
+    } else if ([command isEqualToString:@"unprotect"]) {
+        if (paths.count == 0) {
+            completion(@{@"ok": @NO, @"error": @"unprotect requires paths"});
+            return;
+        }
+
+        // Injected code can't be unloaded, so unprotecting stops watching and optionally quits the instances
+        BOOL terminate = [request[@"terminate"] boolValue];
+        NSMutableArray<NSNumber *> *terminated = [NSMutableArray array];
+        for (NSString *path in paths) {
+            [_watchedPaths removeObject:path];
+            if (!terminate) continue;
+
+            [_protectedProcesses enumerateKeysAndObjectsUsingBlock:^(NSNumber *pid, NSDictionary *info, BOOL *stop) {
+                if ([info[@"path"] isEqualToString:path]) {
+                    [terminated addObject:pid];
+                }
+            }];
+        }
+
+        if (terminated.count > 0) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                for (NSNumber *pid in terminated) {
+                    [[NSRunningApplication runningApplicationWithProcessIdentifier:[pid intValue]] terminate];
+                }
+            });
+        }
+
+        completion(@{@"ok": @YES, @"unwatched": paths, @"terminated": terminated});
+    } else {
+        completion(@{@"ok": @NO, @"error": [NSString stringWithFormat:@"Unknown command: %@", command]});
+    }
+}
+
+- (NSDictionary *)statusOnQueue {
+    NSMutableArray *protectedApplications = [NSMutableArray arrayWithCapacity:_protectedProcesses.count];
+    [_protectedProcesses enumerateKeysAndObjectsUsingBlock:^(NSNumber *pid, NSDictionary *info, BOOL *stop) {
+        NSMutableDictionary *entry = [info mutableCopy];
+        entry[@"pid"] = pid;
+        [protectedApplications addObject:entry];
+    }];
+
+    NSMutableArray *unprotectedApplications = [NSMutableArray arrayWithCapacity:_unprotectedProcesses.count];
+    [_unprotectedProcesses enumerateKeysAndObjectsUsingBlock:^(NSNumber *pid, NSString *path, BOOL *stop) {
+        [unprotectedApplications addObject:@{@"pid": pid, @"path": path,
+                                             @"relaunching": @([self->_pendingRelaunchPIDs containsObject:pid])}];
+    }];
+
+    return @{
+        @"ok": @YES,
+        @"pid": @([[NSProcessInfo processInfo] processIdentifier]),
+        @"uptime": @([[NSProcessInfo processInfo] systemUptime] - _startTime),
+        @"socketPath": _socketPath ?: @"",
+        @"dylibPath": _dylibPath ?: @"",
+        @"requests": @(_requestCount),
+        @"connections": @(_connections.count),
+        @"relaunchesUnprotectedApplications": @(self.relaunchesUnprotectedApplications),
+        @"watchedApplications": [[_watchedPaths allObjects] sortedArrayUsingSelector:@selector(compare:)],
+        @"launchesInFlight": [_launchesInFlight allObjects],
+        @"protectedApplications": protectedApplications,
+        @"unprotectedApplications": unprotectedApplications
+    };
+}
+
+#pragma mark - Socket Handling
+
+- (void)acceptConnections {
+    while (_listenFD >= 0) {
+        int fd = accept(_listenFD, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                WCLogWarning(@"Daemon", @"accept() failed: %s", strerror(errno));
+            }
+            return;
+        }
+
+        // Only this user may drive the daemon, whatever the socket's permissions say
+        uid_t peerUID = (uid_t)-1;
+        gid_t peerGID = (gid_t)-1;
+        if (getpeereid(fd, &peerUID, &peerGID) != 0 || peerUID != geteuid()) {
+            WCLogWarning(@"Daemon", @"Rejected connection from uid %d", (int)peerUID);
+            close(fd);
+            continue;
+        }
+
+        // Reads only happen when the source reports data, so the socket can stay blocking
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+        int noSigPipe = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+        WCDaemonSetSocketTimeout(fd, SO_SNDTIMEO, (NSTimeInterval)kWCDaemonWriteTimeout);
+
+        WCDaemonConnection *connection = [[WCDaemonConnection alloc] init];
+        connection.fileDescriptor = fd;
+        connection.buffer = [NSMutableData data];
+
+        dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)fd, 0, _queue);
+        __weak WCDaemonConnection *weakConnection = connection;
+        dispatch_source_set_event_handler(source, ^{
+            WCDaemonConnection *strongConnection = weakConnection;
+            if (strongConnection) [self readFromConnection:strongConnection];
+        });
+        dispatch_source_set_cancel_handler(source, ^{
+            close(fd);
+        });
+        connection.readSource = source;
+
+        [_connections addObject:connection];
+        dispatch_resume(source);
+    }
+}
+
+- (void)readFromConnection:(WCDaemonConnection *)connection {
+    uint8_t chunk[4096];
+    ssize_t count = read(connection.fileDescriptor, chunk, sizeof(chunk));
+
+    if (count < 0 && (errno == EINTR || errno == EAGAIN)) {
+        return;
+    }
+    if (count <= 0) {
+        [self closeConnection:connection];
+        return;
+    }
+
+    [connection.buffer appendBytes:chunk length:(NSUInteger)count];
+
+    // Handle every complete line; a partial line waits for more data
+    while (!connection.closed) {
+        const uint8_t *bytes = connection.buffer.bytes;
+        const uint8_t *newline = memchr(bytes, '\n', connection.buffer.length);
+        if (!newline) break;
+
+        NSUInteger lineLength = (NSUInteger)(newline - bytes);
+        NSData *line = [connection.buffer subdataWithRange:NSMakeRange(0, lineLength)];
+        [connection.buffer replaceBytesInRange:NSMakeRange(0, lineLength + 1) withBytes:NULL length:0];
+
+        if (line.length == 0) continue;
+
+        id request = [NSJSONSerialization JSONObjectWithData:line options:0 error:NULL];
+        if (![request isKindOfClass:[NSDictionary class]]) {
+            [self sendResponse:@{@"ok": @NO, @"error": @"Request is not a JSON object"} onConnection:connection];
+            continue;
+        }
+
+        [self handleRequestOnQueue:request completion:^(NSDictionary *response) {
+            [self sendResponse:response onConnection:connection];
+        }];
+    }
+
+    if (!connection.closed && connection.buffer.length > kWCDaemonMaxRequestLength) {
+        [self sendResponse:@{@"ok": @NO, @"error": @"Request is too long"} onConnection:connection];
+        [self closeConnection:connection];
+    }
+}
+
+- (void)sendResponse:(NSDictionary *)response onConnection:(WCDaemonConnection *)connection {
+    // The client may have gone away while a protection was running
+    if (connection.closed) return;
+
+    if (!WCDaemonWriteLine(connection.fileDescriptor, response)) {
+        [self closeConnection:connection];
+    }
+}
+
+- (void)closeConnection:(WCDaemonConnection *)connection {
+    if (connection.closed) return;
+
+    connection.closed = YES;
+    dispatch_source_cancel(connection.readSource);
+    connection.readSource = nil;
+    [_connections removeObject:connection];
+}
+
+#pragma mark - Client
+
++ (NSDictionary *)sendRequest:(NSDictionary *)request
+                 toSocketPath:(NSString *)socketPath
+                      timeout:(NSTimeInterval)timeout
+                        error:(NSError **)error {
+    NSString *path = socketPath.length > 0 ? [socketPath stringByExpandingTildeInPath] : [self defaultSocketPath];
+
+    struct sockaddr_un address;
+    if (!WCDaemonFillSocketAddress(path, &address)) {
+        if (error) *error = WCDaemonError(3, [NSString stringWithFormat:@"Socket path is too long: %@", path]);
+        return nil;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        if (error) *error = WCDaemonError(5, [NSString stringWithFormat:@"socket() failed: %s", strerror(errno)]);
+        return nil;
+    }
+
+    int noSigPipe = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+    WCDaemonSetSocketTimeout(fd, SO_SNDTIMEO, timeout);
+    WCDaemonSetSocketTimeout(fd, SO_RCVTIMEO, timeout);
+
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        if (error) *error = WCDaemonError(6, [NSString stringWithFormat:@"No daemon is listening on %@", path]);
+        close(fd);
+        return nil;
+    }
+
+    if (!WCDaemonWriteLine(fd, request)) {
+        if (error) *error = WCDaemonError(7, [NSString stringWithFormat:@"Could not send request: %s", strerror(errno)]);
+        close(fd);
+        return nil;
+    }
+
+    NSMutableData *responseData = [NSMutableData data];
+    uint8_t chunk[4096];
+    for (;;) {
+        ssize_t count = read(fd, chunk, sizeof(chunk));
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) break;
+
+        const uint8_t *newline = memchr(chunk, '\n', (size_t)count);
+        [responseData appendBytes:chunk length:newline ? (NSUInteger)(newline - chunk) : (NSUInteger)count];
+        if (newline) break;
+    }
+    close(fd);
+
+    NSDictionary *response = responseData.length > 0 ?
+        [NSJSONSerialization JSONObjectWithData:responseData options:0 error:NULL] : nil;
+    if (![response isKindOfClass:[NSDictionary class]]) {
+        if (error) *error = WCDaemonError(8, @"No valid response from daemon");
+        return nil;
+    }
+    return response;
+}
+
+@end
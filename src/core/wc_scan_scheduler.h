@@ -0,0 +1,91 @@
+/**
+ * @file wc_scan_scheduler.h
+ * @brief Churn-driven scan interval scheduler for WindowControlInjector
+ *
+ * This file defines the policy that picks the periodic scan interval from
+ * how much actually changed on recent ticks rather than from how many
+ * windows exist. Idle ticks back the interval off exponentially towards a
+ * ceiling, and any detected change or application activation snaps it back
+ * to the fast rate.
+ */
+
+#ifndef WC_SCAN_SCHEDULER_H
+#define WC_SCAN_SCHEDULER_H
+
+#import <Foundation/Foundation.h>
+
+/**
+ * @brief Picks scan intervals and timer leeway from observed window churn
+ *
+ * The scheduler only makes decisions; the owner retargets its timer with
+ * the returned values. It is not thread-safe and is owned by WCWindowScanner.
+ */
+@interface WCScanScheduler : NSObject
+
+/**
+ * @brief Fast interval used right after a change, in seconds
+ */
+@property (nonatomic, readonly) NSTimeInterval minimumInterval;
+
+/**
+ * @brief Interval the scheduler backs off to when nothing changes, in seconds
+ */
+@property (nonatomic, readonly) NSTimeInterval maximumInterval;
+
+/**
+ * @brief Interval currently chosen, in seconds
+ */
+@property (nonatomic, readonly) NSTimeInterval currentInterval;
+
+/**
+ * @brief Create a scheduler
+ *
+ * @param minimumInterval The fast interval, usually the profile scan interval
+ * @param maximumInterval The idle ceiling; raised to minimumInterval if lower
+ * @return A scheduler starting at minimumInterval
+ */
+- (instancetype)initWithMinimumInterval:(NSTimeInterval)minimumInterval
+                        maximumInterval:(NSTimeInterval)maximumInterval;
+
+/**
+ * @brief Change the fast interval and start again from it
+ *
+ * @param minimumInterval The new fast interval
+ */
+- (void)resetWithMinimumInterval:(NSTimeInterval)minimumInterval;
+
+/**
+ * @brief Account for one completed tick and pick the next interval
+ *
+ * A tick with changes returns to the fast rate. Idle ticks double the
+ * interval after a short grace period, so a burst of activity that pauses
+ * for one tick is not missed.
+ *
+ * @param changes Windows created or drifted since the previous tick
+ * @return The interval to use until the next tick
+ */
+- (NSTimeInterval)intervalAfterTickWithChanges:(NSUInteger)changes;
+
+/**
+ * @brief Snap back to the fast rate outside a tick
+ *
+ * Used for application activation and window events.
+ *
+ * @return YES if the interval changed and the timer needs retargeting
+ */
+- (BOOL)noteActivity;
+
+/**
+ * @brief Timer leeway for an interval, in seconds
+ *
+ * Leeway grows from 10% at the fast rate to 50% at the idle ceiling so the
+ * system can coalesce idle ticks with other wakeups.
+ *
+ * @param interval The scan interval
+ * @return The leeway to pass to dispatch_source_set_timer
+ */
+- (NSTimeInterval)leewayForInterval:(NSTimeInterval)interval;
+
+@end
+
+#endif /* WC_SCAN_SCHEDULER_H */
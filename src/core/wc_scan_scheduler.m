@@ -0,0 +1,74 @@
+/**
+ * @file wc_scan_scheduler.m
+ * @brief Implementation of the churn-driven scan interval scheduler
+ */
+
+#import "wc_scan_scheduler.h"
+
+// Idle ticks at the fast rate before backing off
+static const NSUInteger kWCScanSchedulerGraceTicks = 2;
+
+// Growth of the interval per idle tick once past the grace period
+static const double kWCScanSchedulerBackoffFactor = 2.0;
+
+// Leeway as a fraction of the interval at the fast rate and at the ceiling
+static const double kWCScanSchedulerMinimumLeeway = 0.1;
+static const double kWCScanSchedulerMaximumLeeway = 0.5;
+
+@implementation WCScanScheduler {
+    NSUInteger _idleTicks;
+}
+
+- (instancetype)initWithMinimumInterval:(NSTimeInterval)minimumInterval
+                        maximumInterval:(NSTimeInterval)maximumInterval {
+    if (self = [super init]) {
+        _minimumInterval = minimumInterval > 0 ? minimumInterval : 1.0;
+        _maximumInterval = MAX(maximumInterval, _minimumInterval);
+        _currentInterval = _minimumInterval;
+        _idleTicks = 0;
+    }
+    return self;
+}
+
+- (void)resetWithMinimumInterval:(NSTimeInterval)minimumInterval {
+    if (minimumInterval > 0) {
+        _minimumInterval = minimumInterval;
+    }
+    _maximumInterval = MAX(_maximumInterval, _minimumInterval);
+    _currentInterval = _minimumInterval;
+    _idleTicks = 0;
+}
+
+- (NSTimeInterval)intervalAfterTickWithChanges:(NSUInteger)changes {
+    if (changes > 0) {
+        _idleTicks = 0;
+        _currentInterval = _minimumInterval;
+        return _currentInterval;
+    }
+
+    _idleTicks++;
+    if (_idleTicks > kWCScanSchedulerGraceTicks) {
+        _currentInterval = MIN(_currentInterval * kWCScanSchedulerBackoffFactor, _maximumInterval);
+    }
+    return _currentInterval;
+}
+
+- (BOOL)noteActivity {
+    _idleTicks = 0;
+    if (_currentInterval == _minimumInterval) return NO;
+
+    _currentInterval = _minimumInterval;
+    return YES;
+}
+
+- (NSTimeInterval)leewayForInterval:(NSTimeInterval)interval {
+    double fraction = kWCScanSchedulerMinimumLeeway;
+    if (_maximumInterval > _minimumInterval) {
+        double progress = (interval - _minimumInterval) / (_maximumInterval - _minimumInterval);
+        progress = MIN(MAX(progress, 0.0), 1.0);
+        fraction += progress * (kWCScanSchedulerMaximumLeeway - kWCScanSchedulerMinimumLeeway);
+    }
+    return interval * fraction;
+}
+
+@end
@@ -0,0 +1,88 @@
+/**
+ * @file wc_suspended_launcher.h
+ * @brief Suspended-start application launches for WindowControlInjector
+ *
+ * This file defines a launch path built on posix_spawn instead of NSTask or
+ * NSWorkspace. The process is created suspended with the injection
+ * environment and the write end of a handshake pipe. While it is suspended
+ * the image it was created from is checked with the injection preflight,
+ * so an executable replaced since the application was checked is
+ * terminated before running rather than coming up without the dylib. The
+ * dylib then reports each stage it reaches (see wc_launch_handshake.h),
+ * which gives a confirmed, measured time-to-protected instead of a fixed
+ * delay.
+ *
+ * A process that does not report being loaded before the timeout did not
+ * get the dylib from dyld and is terminated rather than left running
+ * unprotected.
+ */
+
+#ifndef WC_SUSPENDED_LAUNCHER_H
+#define WC_SUSPENDED_LAUNCHER_H
+
+#import <Foundation/Foundation.h>
+#import "../util/wc_launch_handshake.h"
+
+/**
+ * @brief Outcome of a suspended-start launch
+ */
+@interface WCSuspendedLaunchResult : NSObject
+
+/**
+ * @brief Process identifier of the launched application
+ */
+@property (nonatomic, readonly) pid_t processIdentifier;
+
+/**
+ * @brief Seconds from the spawn until the dylib reported being loaded, or -1
+ */
+@property (nonatomic, readonly) NSTimeInterval timeToLoaded;
+
+/**
+ * @brief Seconds from the spawn until the dylib reported being ready, or -1
+ */
+@property (nonatomic, readonly) NSTimeInterval timeToReady;
+
+/**
+ * @brief Seconds from the spawn until the first window was protected, or -1
+ */
+@property (nonatomic, readonly) NSTimeInterval timeToProtected;
+
+/**
+ * @brief YES if the dylib confirmed that a window is protected
+ *
+ * NO after a successful launch means the application had not shown a
+ * window before the timeout; the injector stays active and protects it
+ * when it does.
+ */
+@property (nonatomic, readonly, getter=isProtectionConfirmed) BOOL protectionConfirmed;
+
+@end
+
+/**
+ * @brief Launches executables suspended and waits for the dylib handshake
+ */
+@interface WCSuspendedLauncher : NSObject
+
+/**
+ * @brief Launch an executable and wait until its first window is protected
+ *
+ * The process is put in its own process group, so signals aimed at the
+ * launcher's terminal do not reach it.
+ *
+ * @param executablePath The executable to run
+ * @param arguments Arguments after the executable path, may be nil
+ * @param environment The complete environment, including DYLD_INSERT_LIBRARIES
+ * @param timeout Seconds to wait for the protected stage
+ * @param error Set if the process could not be spawned, would not load the dylib, exited, or never loaded it
+ * @return The result, or nil if the launch failed
+ */
++ (WCSuspendedLaunchResult *)launchExecutable:(NSString *)executablePath
+                                    arguments:(NSArray<NSString *> *)arguments
+                                  environment:(NSDictionary<NSString *, NSString *> *)environment
+                                      timeout:(NSTimeInterval)timeout
+                                        error:(NSError **)error;
+
+@end
+
+#endif /* WC_SUSPENDED_LAUNCHER_H */
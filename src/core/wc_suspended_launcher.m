@@ -0,0 +1,293 @@
+/**
+ * @file wc_suspended_launcher.m
+ * @brief Implementation of suspended-start application launches
+ */
+
+#import "wc_suspended_launcher.h"
+#import "wc_injection_preflight.h"
+#import "../util/logger.h"
+#import "../util/error_manager.h"
+#import "../util/wc_metrics.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <libproc.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#pragma mark - WCSuspendedLaunchResult
+
+@interface WCSuspendedLaunchResult ()
+@property (nonatomic, readwrite) pid_t processIdentifier;
+@property (nonatomic, readwrite) NSTimeInterval timeToLoaded;
+@property (nonatomic, readwrite) NSTimeInterval timeToReady;
+@property (nonatomic, readwrite) NSTimeInterval timeToProtected;
+@property (nonatomic, readwrite, getter=isProtectionConfirmed) BOOL protectionConfirmed;
+@end
+
+@implementation WCSuspendedLaunchResult
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _timeToLoaded = -1;
+        _timeToReady = -1;
+        _timeToProtected = -1;
+    }
+    return self;
+}
+
+@end
+
+#pragma mark - WCSuspendedLauncher
+
+@implementation WCSuspendedLauncher
+
+static NSError *WCSuspendedLaunchError(NSInteger code, NSString *message) {
+    return [WCError errorWithCategory:WCErrorCategoryLaunch code:code message:message];
+}
+
+/**
+ * Reap the process when it exits, so long-lived launchers do not collect zombies
+ */
+static void WCSuspendedLaunchReapOnExit(pid_t pid) {
+    dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_PROC, (uintptr_t)pid,
+                                                      DISPATCH_PROC_EXIT,
+                                                      dispatch_get_global_queue(QOS_CLASS_UTILITY, 0));
+    if (!source) return;
+
+    // The handler keeps the source alive until it cancels it
+    dispatch_source_set_event_handler(source, ^{
+        waitpid(pid, NULL, WNOHANG);
+        dispatch_source_cancel(source);
+    });
+    dispatch_resume(source);
+
+    // Exited before the source was armed
+    if (waitpid(pid, NULL, WNOHANG) == pid) {
+        dispatch_source_cancel(source);
+    }
+}
+
+/**
+ * Check the image the suspended process was created from against the preflight
+ *
+ * The application was checked before the spawn, but it may have been updated
+ * since; this checks the exact file that was mapped, before it runs.
+ */
+static BOOL WCSuspendedLaunchVerifyImage(pid_t pid, NSDictionary<NSString *, NSString *> *environment,
+                                         NSError **error) {
+    NSString *libraries = environment[@"DYLD_INSERT_LIBRARIES"];
+    if (libraries.length == 0) return YES;
+
+    char path[PROC_PIDPATHINFO_MAXSIZE];
+    if (proc_pidpath(pid, path, sizeof(path)) <= 0) {
+        // Nothing to check against; the handshake still catches a dylib that never loads
+        WCLogWarning(@"Launch", @"Could not get the image of process %d: %s", pid, strerror(errno));
+        return YES;
+    }
+
+    NSString *imagePath = [NSString stringWithUTF8String:path];
+    WCInjectionPreflight *preflight = [WCInjectionPreflight sharedPreflight];
+    for (NSString *dylibPath in [libraries componentsSeparatedByString:@":"]) {
+        if (dylibPath.length == 0) continue;
+        if (![preflight verifyApplication:imagePath dylibPath:dylibPath error:error]) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+/**
+ * Record the stages in a chunk read from the handshake pipe
+ */
+static void WCSuspendedLaunchRecordStages(WCSuspendedLaunchResult *result, const char *bytes, ssize_t count,
+                                          uint64_t spawnTime) {
+    NSTimeInterval elapsed = (WCMetricsNow() - spawnTime) / 1e9;
+    for (ssize_t i = 0; i < count; i++) {
+        switch ((WCLaunchHandshakeStage)bytes[i]) {
+            case WCLaunchHandshakeStageLoaded:
+                if (result.timeToLoaded < 0) result.timeToLoaded = elapsed;
+                break;
+            case WCLaunchHandshakeStageReady:
+                if (result.timeToReady < 0) result.timeToReady = elapsed;
+                break;
+            case WCLaunchHandshakeStageProtected:
+                if (result.timeToProtected < 0) result.timeToProtected = elapsed;
+                result.protectionConfirmed = YES;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
++ (WCSuspendedLaunchResult *)launchExecutable:(NSString *)executablePath
+                                    arguments:(NSArray<NSString *> *)arguments
+                                  environment:(NSDictionary<NSString *, NSString *> *)environment
+                                      timeout:(NSTimeInterval)timeout
+                                        error:(NSError **)error {
+    if (!executablePath) {
+        if (error) {
+            *error = WCSuspendedLaunchError(WCLaunchErrorApplicationPathNil, @"Executable path is required");
+        }
+        return nil;
+    }
+
+    int handshake[2];
+    if (pipe(handshake) != 0) {
+        if (error) {
+            *error = WCSuspendedLaunchError(WCLaunchErrorApplicationLaunchFailed,
+                                            [NSString stringWithFormat:@"Could not create the handshake pipe: %s", strerror(errno)]);
+        }
+        return nil;
+    }
+
+    // Neither end leaks into anything else this process launches; the child inherits the write end explicitly
+    fcntl(handshake[0], F_SETFD, FD_CLOEXEC);
+    fcntl(handshake[1], F_SETFD, FD_CLOEXEC);
+
+    NSMutableDictionary<NSString *, NSString *> *childEnvironment = [NSMutableDictionary dictionaryWithDictionary:environment ?: @{}];
+    childEnvironment[WCLaunchHandshakeEnvironmentKey] = [NSString stringWithFormat:@"%d", handshake[1]];
+
+    // The C strings belong to these objects, which outlive the spawn
+    NSMutableArray<NSString *> *argumentStrings = [NSMutableArray arrayWithObject:executablePath];
+    [argumentStrings addObjectsFromArray:arguments ?: @[]];
+    NSMutableArray<NSString *> *environmentStrings = [NSMutableArray arrayWithCapacity:childEnvironment.count];
+    [childEnvironment enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSString *value, BOOL *stop) {
+        [environmentStrings addObject:[NSString stringWithFormat:@"%@=%@", key, value]];
+    }];
+
+    char **argv = calloc(argumentStrings.count + 1, sizeof(char *));
+    char **envp = calloc(environmentStrings.count + 1, sizeof(char *));
+    for (NSUInteger i = 0; argv && i < argumentStrings.count; i++) {
+        argv[i] = (char *)argumentStrings[i].UTF8String;
+    }
+    for (NSUInteger i = 0; envp && i < environmentStrings.count; i++) {
+        envp[i] = (char *)environmentStrings[i].UTF8String;
+    }
+
+    // Only the standard streams and the handshake pipe cross into the child
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addinherit_np(&actions, STDIN_FILENO);
+    posix_spawn_file_actions_addinherit_np(&actions, STDOUT_FILENO);
+    posix_spawn_file_actions_addinherit_np(&actions, STDERR_FILENO);
+    posix_spawn_file_actions_addinherit_np(&actions, handshake[1]);
+
+    // Start suspended in a process group of its own, with default signal handling
+    sigset_t noSignals, allSignals;
+    sigemptyset(&noSignals);
+    sigfillset(&allSignals);
+    sigdelset(&allSignals, SIGKILL);
+    sigdelset(&allSignals, SIGSTOP);
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_START_SUSPENDED | POSIX_SPAWN_CLOEXEC_DEFAULT |
+                                          POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+    posix_spawnattr_setpgroup(&attributes, 0);
+    posix_spawnattr_setsigmask(&attributes, &noSignals);
+    posix_spawnattr_setsigdefault(&attributes, &allSignals);
+
+    pid_t pid = 0;
+    uint64_t spawnTime = WCMetricsNow();
+    int status = (argv && envp)
+        ? posix_spawn(&pid, executablePath.fileSystemRepresentation, &actions, &attributes, argv, envp)
+        : ENOMEM;
+
+    posix_spawnattr_destroy(&attributes);
+    posix_spawn_file_actions_destroy(&actions);
+    free(argv);
+    free(envp);
+
+    // Only the child may hold the write end, so its exit is seen as end of file
+    close(handshake[1]);
+
+    if (status != 0) {
+        close(handshake[0]);
+        if (error) {
+            *error = WCSuspendedLaunchError(WCLaunchErrorApplicationLaunchFailed,
+                                            [NSString stringWithFormat:@"Failed to launch %@: %s", executablePath, strerror(status)]);
+        }
+        WCLogError(@"Launch", @"posix_spawn of %@ failed: %s", executablePath, strerror(status));
+        return nil;
+    }
+
+    // Nothing has run yet; a process that would come up without the dylib is never resumed
+    if (!WCSuspendedLaunchVerifyImage(pid, childEnvironment, error)) {
+        close(handshake[0]);
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+        WCLogError(@"Launch", @"Process %d would not load the injector, terminated it before it ran", pid);
+        return nil;
+    }
+
+    kill(pid, SIGCONT);
+
+    WCSuspendedLaunchResult *result = [[WCSuspendedLaunchResult alloc] init];
+    result.processIdentifier = pid;
+
+    uint64_t deadline = spawnTime + (uint64_t)(MAX(timeout, 0) * NSEC_PER_SEC);
+    BOOL endOfFile = NO;
+    while (!result.protectionConfirmed) {
+        uint64_t now = WCMetricsNow();
+        if (now >= deadline) break;
+
+        struct pollfd descriptor = { .fd = handshake[0], .events = POLLIN };
+        int ready = poll(&descriptor, 1, (int)((deadline - now + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC));
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) break;
+
+        char bytes[16];
+        ssize_t count = read(handshake[0], bytes, sizeof(bytes));
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) {
+            endOfFile = YES;
+            break;
+        }
+        WCSuspendedLaunchRecordStages(result, bytes, count, spawnTime);
+    }
+    close(handshake[0]);
+
+    int exitStatus = 0;
+    if (endOfFile && !result.protectionConfirmed && waitpid(pid, &exitStatus, WNOHANG) == pid) {
+        if (error) {
+            NSString *message = WIFSIGNALED(exitStatus)
+                ? [NSString stringWithFormat:@"%@ was killed by signal %d during launch", executablePath, WTERMSIG(exitStatus)]
+                : [NSString stringWithFormat:@"%@ exited with status %d during launch", executablePath, WEXITSTATUS(exitStatus)];
+            *error = WCSuspendedLaunchError(WCLaunchErrorApplicationLaunchFailed, message);
+        }
+        WCLogError(@"Launch", @"Process %d exited before its windows were protected", pid);
+        return nil;
+    }
+
+    // dyld ignored DYLD_INSERT_LIBRARIES; running on would expose every window
+    BOOL loaded = result.timeToLoaded >= 0 || result.timeToReady >= 0 || result.protectionConfirmed;
+    if (!loaded) {
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+        if (error) {
+            *error = WCSuspendedLaunchError(WCLaunchErrorLaunchTimeout,
+                                            [NSString stringWithFormat:@"%@ did not load the injector within %.1f seconds and was terminated",
+                                             executablePath, timeout]);
+        }
+        WCLogError(@"Launch", @"Process %d never reported loading the injector, terminated it", pid);
+        return nil;
+    }
+
+    WCSuspendedLaunchReapOnExit(pid);
+
+    if (result.protectionConfirmed) {
+        WCLogInfo(@"Launch", @"Process %d loaded the injector after %.1f ms and was protected after %.1f ms",
+                  pid, result.timeToLoaded * 1e3, result.timeToProtected * 1e3);
+    } else {
+        WCLogWarning(@"Launch", @"Process %d loaded the injector after %.1f ms but showed no window within %.1f seconds",
+                     pid, result.timeToLoaded * 1e3, timeout);
+    }
+    return result;
+}
+
+@end
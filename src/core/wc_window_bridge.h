@@ -21,6 +21,8 @@ typedef NS_ENUM(NSUInteger, WCApplicationType) {
     WCApplicationTypeChrome
 };
 
+@class WCAppProfile;
+
 /**
  * @brief Unified window detection bridge
  *
@@ -44,6 +46,7 @@ typedef NS_ENUM(NSUInteger, WCApplicationType) {
  *
  * This method uses a dual-detection approach to find all windows
  * in the current application, combining both AppKit and CGS methods.
+ * AppKit is only consulted when called on the main thread.
  *
  * @return An array of WCWindowInfo objects for all detected windows
  */
@@ -115,6 +118,18 @@ typedef NS_ENUM(NSUInteger, WCApplicationType) {
  */
 + (WCApplicationType)detectApplicationTypeForPath:(NSString *)bundlePath;
 
+/**
+ * @brief Get the profile for an application
+ *
+ * Returns the cached profile when the bundle has not changed since it was
+ * last seen; otherwise detects the application type and stores the default
+ * profile for it so the next launch can skip detection.
+ *
+ * @param bundlePath The path to the application bundle
+ * @return The application profile
+ */
++ (WCAppProfile *)applicationProfileForPath:(NSString *)bundlePath;
+
 /**
  * @brief Get Electron renderer processes for a given main process
  *
@@ -137,6 +152,15 @@ typedef NS_ENUM(NSUInteger, WCApplicationType) {
  */
 + (NSArray<NSNumber *> *)getChromeRendererProcessesForMainPID:(pid_t)mainPID;
 
+/**
+ * @brief Get the helper processes named by an application profile
+ *
+ * @param mainPID The main process ID
+ * @param profile The profile whose helper name patterns to match
+ * @return An array of helper process IDs
+ */
++ (NSArray<NSNumber *> *)getHelperProcessesForMainPID:(pid_t)mainPID profile:(WCAppProfile *)profile;
+
 /**
  * @brief Find windows with delayed creation
  *
@@ -149,6 +173,22 @@ typedef NS_ENUM(NSUInteger, WCApplicationType) {
  */
 + (NSArray<WCWindowInfo *> *)findDelayedWindowsForPID:(pid_t)pid excludingWindows:(NSArray<WCWindowInfo *> *)existingWindows;
 
+/**
+ * @brief Find windows with delayed creation using a known set of helper processes
+ *
+ * Same as findDelayedWindowsForPID:excludingWindows: but takes the helper
+ * process IDs from the caller, for example from WCProcessWatcher, instead
+ * of walking the process tree.
+ *
+ * @param pid The main process ID to scan for delayed windows
+ * @param helperPIDs Helper process IDs whose windows should also be checked
+ * @param existingWindows Windows that have already been detected
+ * @return An array of newly detected windows
+ */
++ (NSArray<WCWindowInfo *> *)findDelayedWindowsForPID:(pid_t)pid
+                                           helperPIDs:(NSArray<NSNumber *> *)helperPIDs
+                                     excludingWindows:(NSArray<WCWindowInfo *> *)existingWindows;
+
 @end
 
 #endif /* WC_WINDOW_BRIDGE_H */
@@ -4,14 +4,19 @@
  */
 
 #import "wc_window_bridge.h"
+#import "wc_app_profile.h"
+#import "wc_window_snapshot.h"
 #import "../util/logger.h"
+#import "../util/wc_cgs_functions.h"
+#import "../util/wc_metrics.h"
 #import "../util/wc_process_manager.h"
+#import "../util/wc_window_id_set.h"
 #import <AppKit/AppKit.h>
 
 @implementation WCWindowBridge
 
-// Keep track of detected application types
-static NSMutableDictionary<NSString *, NSNumber *> *applicationTypes;
+// Keep track of application profiles by bundle path, guarded by @synchronized(applicationProfiles)
+static NSMutableDictionary<NSString *, WCAppProfile *> *applicationProfiles;
 
 // Application type patterns for detection
 static NSArray<NSDictionary *> *applicationPatterns;
@@ -19,7 +24,7 @@ static NSArray<NSDictionary *> *applicationPatterns;
 // Standard Objective-C runtime initialize method
 + (void)initialize {
     if (self == [WCWindowBridge class]) {
-        applicationTypes = [NSMutableDictionary dictionary];
+        applicationProfiles = [NSMutableDictionary dictionary];
 
         // Initialize application patterns
         applicationPatterns = @[
@@ -49,8 +54,8 @@ static NSArray<NSDictionary *> *applicationPatterns;
                                    format:@"Initializing WCWindowBridge subsystem"];
 
     // Ensure dictionary is initialized
-    if (!applicationTypes) {
-        applicationTypes = [NSMutableDictionary dictionary];
+    if (!applicationProfiles) {
+        applicationProfiles = [NSMutableDictionary dictionary];
     }
 }
 
@@ -59,12 +64,23 @@ static NSArray<NSDictionary *> *applicationPatterns;
 + (NSArray<WCWindowInfo *> *)getAllWindowsForCurrentApplication {
     NSMutableArray<WCWindowInfo *> *allWindows = [NSMutableArray array];
 
+    WCMetricsIncrement(WCMetricCounterWindowEnumerations);
+    os_log_t signpostLog = WCMetricsSignpostLog();
+    os_signpost_id_t signpostID = os_signpost_id_generate(signpostLog);
+    os_signpost_interval_begin(signpostLog, signpostID, "EnumerateWindows");
+
     // 1. Get windows using AppKit API
-    NSArray<NSWindow *> *appKitWindows = [NSApp windows];
+    // Off the main thread only the window list is used; ordered-in AppKit windows appear there too
+    NSArray<NSWindow *> *appKitWindows = [NSThread isMainThread] ? [NSApp windows] : @[];
+
+    WCWindowIDSet seenWindowIDs;
+    WCWindowIDSetInit(&seenWindowIDs, (uint32_t)appKitWindows.count * 2);
+
     for (NSWindow *window in appKitWindows) {
         WCWindowInfo *windowInfo = [[WCWindowInfo alloc] initWithNSWindow:window];
         if (windowInfo) {
             [allWindows addObject:windowInfo];
+            WCWindowIDSetInsert(&seenWindowIDs, windowInfo.windowID);
         }
     }
 
@@ -74,20 +90,16 @@ static NSArray<NSDictionary *> *applicationPatterns;
 
     // Merge the lists, avoiding duplicates
     for (WCWindowInfo *cgWindow in cgWindows) {
-        BOOL isDuplicate = NO;
-
-        for (WCWindowInfo *existingWindow in allWindows) {
-            if (existingWindow.windowID == cgWindow.windowID) {
-                isDuplicate = YES;
-                break;
-            }
-        }
-
-        if (!isDuplicate) {
+        if (WCWindowIDSetInsert(&seenWindowIDs, cgWindow.windowID)) {
             [allWindows addObject:cgWindow];
         }
     }
 
+    WCWindowIDSetDestroy(&seenWindowIDs);
+
+    os_signpost_interval_end(signpostLog, signpostID, "EnumerateWindows",
+                             "%lu windows", (unsigned long)allWindows.count);
+
     [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
                                  category:@"WindowBridge"
                                      file:__FILE__
@@ -101,6 +113,8 @@ static NSArray<NSDictionary *> *applicationPatterns;
 + (NSArray<WCWindowInfo *> *)getAllWindowsForPID:(pid_t)pid {
     NSMutableArray<WCWindowInfo *> *allWindows = [NSMutableArray array];
 
+    WCMetricsIncrement(WCMetricCounterWindowEnumerations);
+
     // Get windows for the main process
     NSArray<WCWindowInfo *> *mainProcessWindows = [self getWindowsForPID:pid];
     [allWindows addObjectsFromArray:mainProcessWindows];
@@ -166,27 +180,14 @@ static NSArray<NSDictionary *> *applicationPatterns;
 + (NSArray<WCWindowInfo *> *)getWindowsForPID:(pid_t)pid {
     NSMutableArray<WCWindowInfo *> *windows = [NSMutableArray array];
 
-    // Get all windows using CoreGraphics
-    CFArrayRef windowList = CGWindowListCopyWindowInfo(
-        kCGWindowListOptionAll, kCGNullWindowID);
-
-    if (windowList) {
-        CFIndex count = CFArrayGetCount(windowList);
+    // Read the process's windows from the tick's shared snapshot, capturing one if none is installed
+    NSArray<NSDictionary *> *windowInfos = [[WCWindowSnapshot activeSnapshot] windowInfosForPID:pid];
 
-        for (CFIndex i = 0; i < count; i++) {
-            NSDictionary *windowInfo = (NSDictionary *)CFArrayGetValueAtIndex(windowList, i);
-
-            // Check if this window belongs to the specified process
-            NSNumber *windowPID = windowInfo[(NSString *)kCGWindowOwnerPID];
-            if (windowPID && [windowPID intValue] == pid) {
-                WCWindowInfo *window = [[WCWindowInfo alloc] initWithCGWindowInfo:windowInfo];
-                if (window) {
-                    [windows addObject:window];
-                }
-            }
+    for (NSDictionary *windowInfo in windowInfos) {
+        WCWindowInfo *window = [[WCWindowInfo alloc] initWithCGWindowInfo:windowInfo];
+        if (window) {
+            [windows addObject:window];
         }
-
-        CFRelease(windowList);
     }
 
     return [windows copy];
@@ -213,22 +214,54 @@ static NSArray<NSDictionary *> *applicationPatterns;
         return NO;
     }
 
-    BOOL allSucceeded = YES;
+    // Apply sharing state, level and tags to every window in one batch
+    NSUInteger windowCount = windows.count;
+    CGSWindowID *windowIDs = calloc(windowCount, sizeof(CGSWindowID));
+    WCCGSBatchResult *results = calloc(windowCount, sizeof(WCCGSBatchResult));
+    if (!windowIDs || !results) {
+        free(windowIDs);
+        free(results);
+        return NO;
+    }
 
-    for (WCWindowInfo *window in windows) {
-        // Make window invisible to screen recording
-        BOOL success = [window makeInvisibleToScreenRecording];
+    for (NSUInteger i = 0; i < windowCount; i++) {
+        windowIDs[i] = windows[i].windowID;
+    }
+
+    [[WCCGSFunctions sharedFunctions] applyOperations:WCCGSBatchOperationSharingState |
+                                                      WCCGSBatchOperationLevel |
+                                                      WCCGSBatchOperationMissionControlTags
+                                          toWindowIDs:windowIDs
+                                                count:windowCount
+                                         sharingState:CGSWindowSharingNone
+                                                level:NSFloatingWindowLevel
+                                              results:results];
+
+    NSUInteger protectedCount = 0;
+
+    for (NSUInteger i = 0; i < windowCount; i++) {
+        WCWindowInfo *window = windows[i];
+
+        // Make window invisible to screen recording, falling back to the per-window path
+        BOOL success = results[i].sharingError == kCGErrorSuccess || [window makeInvisibleToScreenRecording];
 
         // Set proper window level for Mission Control visibility
-        BOOL levelSuccess = [window setLevel:NSNormalWindowLevel]; // This will use the NSNormalWindowLevel internally
+        BOOL levelSuccess;
+        if (results[i].levelError == kCGErrorSuccess) {
+            [window applyMissionControlCollectionBehavior];
+            levelSuccess = YES;
+        } else {
+            levelSuccess = [window setLevel:NSNormalWindowLevel]; // This will use the NSNormalWindowLevel internally
+        }
 
         // Disable status bar
         if ([window respondsToSelector:@selector(disableStatusBar)]) {
             [window disableStatusBar];
         }
 
-        if (!success || !levelSuccess) {
-            allSucceeded = NO;
+        if (success && levelSuccess) {
+            protectedCount++;
+        } else {
             [[WCLogger sharedLogger] logWithLevel:WCLogLevelWarning
                                          category:@"WindowBridge"
                                              file:__FILE__
@@ -239,14 +272,19 @@ static NSArray<NSDictionary *> *applicationPatterns;
         }
     }
 
+    free(windowIDs);
+    free(results);
+
+    BOOL allSucceeded = (protectedCount == windowCount);
+
     [[WCLogger sharedLogger] logWithLevel:allSucceeded ? WCLogLevelInfo : WCLogLevelWarning
                                  category:@"WindowBridge"
                                      file:__FILE__
                                      line:__LINE__
                                  function:__PRETTY_FUNCTION__
                                    format:@"Protected %lu/%lu windows for PID: %d with Mission Control visibility and disabled status bars",
-                                         (unsigned long)(allSucceeded ? windows.count : windows.count - 1),
-                                         (unsigned long)windows.count,
+                                         (unsigned long)protectedCount,
+                                         (unsigned long)windowCount,
                                          (int)pid];
 
     return allSucceeded;
@@ -306,11 +344,47 @@ static NSArray<NSDictionary *> *applicationPatterns;
 #pragma mark - Application Type Detection
 
 + (WCApplicationType)detectApplicationTypeForPath:(NSString *)bundlePath {
-    // Check if we've already determined the type for this app
-    if (applicationTypes[bundlePath]) {
-        return (WCApplicationType)[applicationTypes[bundlePath] unsignedIntegerValue];
+    return [self applicationProfileForPath:bundlePath].applicationType;
+}
+
++ (WCAppProfile *)applicationProfileForPath:(NSString *)bundlePath {
+    if (!bundlePath) {
+        return [WCAppProfile defaultProfileForApplicationType:WCApplicationTypeStandard];
+    }
+
+    // Check if we've already determined the profile for this app
+    @synchronized(applicationProfiles) {
+        WCAppProfile *knownProfile = applicationProfiles[bundlePath];
+        if (knownProfile) {
+            return knownProfile;
+        }
+    }
+
+    // A warm launch of the same build skips detection entirely
+    WCAppProfileCache *cache = [WCAppProfileCache sharedCache];
+    WCAppProfile *profile = [cache profileForBundlePath:bundlePath];
+
+    if (profile) {
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                     category:@"WindowBridge"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Using cached profile for %@: %@", bundlePath, profile];
+    } else {
+        WCApplicationType appType = [self detectApplicationTypeFromBundleAtPath:bundlePath];
+        profile = [WCAppProfile defaultProfileForApplicationType:appType];
+        [cache storeProfile:profile forBundlePath:bundlePath];
     }
 
+    @synchronized(applicationProfiles) {
+        applicationProfiles[bundlePath] = profile;
+    }
+
+    return profile;
+}
+
++ (WCApplicationType)detectApplicationTypeFromBundleAtPath:(NSString *)bundlePath {
     WCApplicationType appType = WCApplicationTypeStandard;
 
     // Load the app's Info.plist to check for identifiers
@@ -407,9 +481,6 @@ static NSArray<NSDictionary *> *applicationPatterns;
     }
 
 patternFound:
-    // Cache the detected type
-    applicationTypes[bundlePath] = @(appType);
-
     [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
                                  category:@"WindowBridge"
                                      file:__FILE__
@@ -429,30 +500,40 @@ patternFound:
     return [WCProcessManager getChromeRendererProcessesForMainPID:mainPID];
 }
 
++ (NSArray<NSNumber *> *)getHelperProcessesForMainPID:(pid_t)mainPID profile:(WCAppProfile *)profile {
+    return [WCProcessManager getHelperProcessesForMainPID:mainPID
+                                             namePatterns:profile.helperNamePatterns
+                                          descendantDepth:profile.helperDescendantDepth];
+}
+
 + (NSString *)getProcessNameForPID:(pid_t)pid {
     return [WCProcessManager getProcessNameForPID:pid];
 }
 
 + (NSArray<WCWindowInfo *> *)findDelayedWindowsForPID:(pid_t)pid excludingWindows:(NSArray<WCWindowInfo *> *)existingWindows {
-    NSMutableArray<WCWindowInfo *> *newWindows = [NSMutableArray array];
-
-    // Get all current windows for the PID
-    NSArray<WCWindowInfo *> *currentWindows = [self getWindowsForPID:pid];
-
-    // Also check child processes based on application type
+    // Check child processes based on application type
     NSString *appPath = [self getApplicationPathForPID:pid];
-    WCApplicationType appType = [self detectApplicationTypeForPath:appPath];
+    WCAppProfile *profile = [self applicationProfileForPath:appPath];
 
     NSArray<NSNumber *> *childPIDs = @[];
 
-    if (appType == WCApplicationTypeElectron) {
-        childPIDs = [self getElectronRendererProcessesForMainPID:pid];
-    } else if (appType == WCApplicationTypeChrome) {
-        childPIDs = [self getChromeRendererProcessesForMainPID:pid];
+    if (profile.helperNamePatterns.count > 0) {
+        childPIDs = [self getHelperProcessesForMainPID:pid profile:profile];
     } else {
         childPIDs = [self getChildProcessesForPID:pid];
     }
 
+    return [self findDelayedWindowsForPID:pid helperPIDs:childPIDs excludingWindows:existingWindows];
+}
+
++ (NSArray<WCWindowInfo *> *)findDelayedWindowsForPID:(pid_t)pid
+                                           helperPIDs:(NSArray<NSNumber *> *)childPIDs
+                                     excludingWindows:(NSArray<WCWindowInfo *> *)existingWindows {
+    NSMutableArray<WCWindowInfo *> *newWindows = [NSMutableArray array];
+
+    // Get all current windows for the PID
+    NSArray<WCWindowInfo *> *currentWindows = [self getWindowsForPID:pid];
+
     // Check windows for each child process
     for (NSNumber *childPID in childPIDs) {
         NSArray<WCWindowInfo *> *childWindows = [self getWindowsForPID:[childPID intValue]];
@@ -460,21 +541,22 @@ patternFound:
     }
 
     // Find windows that weren't in the existing windows list
-    for (WCWindowInfo *window in currentWindows) {
-        BOOL isNewWindow = YES;
+    WCWindowIDSet existingWindowIDs;
+    WCWindowIDSetInit(&existingWindowIDs, (uint32_t)(existingWindows.count + currentWindows.count));
 
-        for (WCWindowInfo *existingWindow in existingWindows) {
-            if (existingWindow.windowID == window.windowID) {
-                isNewWindow = NO;
-                break;
-            }
-        }
+    for (WCWindowInfo *existingWindow in existingWindows) {
+        WCWindowIDSetInsert(&existingWindowIDs, existingWindow.windowID);
+    }
 
-        if (isNewWindow) {
+    for (WCWindowInfo *window in currentWindows) {
+        // Inserting also drops windows reported twice by the main and helper lookups
+        if (WCWindowIDSetInsert(&existingWindowIDs, window.windowID)) {
             [newWindows addObject:window];
         }
     }
 
+    WCWindowIDSetDestroy(&existingWindowIDs);
+
     [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
                                  category:@"WindowBridge"
                                      file:__FILE__
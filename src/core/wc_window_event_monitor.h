@@ -0,0 +1,82 @@
+/**
+ * @file wc_window_event_monitor.h
+ * @brief Event-driven window discovery for WindowControlInjector
+ *
+ * This file defines a monitor that reports window creation, order-in and
+ * destruction as they happen, using AppKit window notifications for NSWindow
+ * instances and window server notification callbacks for all other windows.
+ */
+
+#ifndef WC_WINDOW_EVENT_MONITOR_H
+#define WC_WINDOW_EVENT_MONITOR_H
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+
+/**
+ * @brief Kinds of window events reported by the monitor
+ */
+typedef NS_ENUM(NSInteger, WCWindowEventType) {
+    WCWindowEventTypeCreated = 0,   // A window was created
+    WCWindowEventTypeOrderedIn,     // A window was ordered on screen or changed visibility
+    WCWindowEventTypeDestroyed      // A window was closed or terminated
+};
+
+/**
+ * @brief Handler invoked on the main queue for every window event
+ *
+ * @param eventType The kind of event
+ * @param windowID The window server ID of the window that changed
+ */
+typedef void (^WCWindowEventHandler)(WCWindowEventType eventType, CGWindowID windowID);
+
+/**
+ * @brief Monitor for window lifecycle events
+ *
+ * The monitor combines two sources: NSWindow notifications, which cover
+ * AppKit windows in this process, and CGS/SkyLight notify callbacks, which
+ * cover windows created outside AppKit. Either source may be unavailable;
+ * the monitor runs with whatever could be installed.
+ */
+@interface WCWindowEventMonitor : NSObject
+
+/**
+ * @brief Get the shared monitor instance
+ *
+ * @return Shared singleton instance of WCWindowEventMonitor
+ */
++ (instancetype)sharedMonitor;
+
+/**
+ * @brief Start delivering window events
+ *
+ * @param handler The handler to invoke for each event
+ * @return YES if at least one event source was installed, NO otherwise
+ */
+- (BOOL)startMonitoringWithHandler:(WCWindowEventHandler)handler;
+
+/**
+ * @brief Stop delivering window events and remove all event sources
+ */
+- (void)stopMonitoring;
+
+/**
+ * @brief Check if the monitor is active
+ *
+ * @return YES if monitoring is active, NO otherwise
+ */
+- (BOOL)isMonitoring;
+
+/**
+ * @brief Check if window server callbacks are installed
+ *
+ * When NO, only AppKit windows are reported and the caller should keep
+ * a more frequent sweep for non-AppKit windows.
+ *
+ * @return YES if CGS notifications are active, NO otherwise
+ */
+- (BOOL)hasWindowServerNotifications;
+
+@end
+
+#endif /* WC_WINDOW_EVENT_MONITOR_H */
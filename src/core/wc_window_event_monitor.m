@@ -0,0 +1,248 @@
+/**
+ * @file wc_window_event_monitor.m
+ * @brief Implementation of event-driven window discovery
+ */
+
+#import "wc_window_event_monitor.h"
+#import "../util/logger.h"
+#import "../util/wc_cgs_functions.h"
+#import <AppKit/AppKit.h>
+
+// Window server notifications we subscribe to
+static const CGSNotificationType kWCMonitoredNotifications[] = {
+    kCGSWindowDidCreate,
+    kCGSWindowIsOrderedIn,
+    kCGSWindowIsTerminated
+};
+static const size_t kWCMonitoredNotificationCount =
+    sizeof(kWCMonitoredNotifications) / sizeof(kWCMonitoredNotifications[0]);
+
+@interface WCWindowEventMonitor ()
+- (void)dispatchEvent:(WCWindowEventType)eventType windowID:(CGWindowID)windowID;
+@end
+
+/**
+ * Window server callback; the payload of window notifications starts with the window ID
+ */
+static void WCWindowServerNotifyCallback(CGSNotificationType type, void *data, uint32_t dataLength, void *userData) {
+    if (!data || dataLength < sizeof(CGSWindowID) || !userData) {
+        return;
+    }
+
+    CGSWindowID windowID = 0;
+    memcpy(&windowID, data, sizeof(windowID));
+
+    WCWindowEventType eventType;
+    switch (type) {
+        case kCGSWindowDidCreate:
+            eventType = WCWindowEventTypeCreated;
+            break;
+        case kCGSWindowIsOrderedIn:
+            eventType = WCWindowEventTypeOrderedIn;
+            break;
+        case kCGSWindowIsTerminated:
+            eventType = WCWindowEventTypeDestroyed;
+            break;
+        default:
+            return;
+    }
+
+    WCWindowEventMonitor *monitor = (__bridge WCWindowEventMonitor *)userData;
+    [monitor dispatchEvent:eventType windowID:(CGWindowID)windowID];
+}
+
+@implementation WCWindowEventMonitor {
+    WCWindowEventHandler _handler;
+    BOOL _isMonitoring;
+    BOOL _cgsNotificationsInstalled;
+    NSMutableArray<id> *_notificationObservers;
+}
+
+#pragma mark - Lifecycle
+
++ (instancetype)sharedMonitor {
+    static WCWindowEventMonitor *instance = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        instance = [[self alloc] init];
+    });
+    return instance;
+}
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _handler = nil;
+        _isMonitoring = NO;
+        _cgsNotificationsInstalled = NO;
+        _notificationObservers = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [self stopMonitoring];
+}
+
+#pragma mark - Monitoring Control
+
+- (BOOL)startMonitoringWithHandler:(WCWindowEventHandler)handler {
+    if (!handler) {
+        return NO;
+    }
+
+    if (_isMonitoring) {
+        [self stopMonitoring];
+    }
+
+    _handler = [handler copy];
+
+    [self installAppKitObservers];
+    _cgsNotificationsInstalled = [self installWindowServerCallbacks];
+
+    _isMonitoring = YES;
+
+    [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                 category:@"WindowEvents"
+                                     file:__FILE__
+                                     line:__LINE__
+                                 function:__PRETTY_FUNCTION__
+                                   format:@"Started window event monitoring (AppKit: Yes, WindowServer: %@)",
+                                         _cgsNotificationsInstalled ? @"Yes" : @"No"];
+    return YES;
+}
+
+- (void)stopMonitoring {
+    if (!_isMonitoring) return;
+
+    NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+    for (id observer in _notificationObservers) {
+        [center removeObserver:observer];
+    }
+    [_notificationObservers removeAllObjects];
+
+    if (_cgsNotificationsInstalled) {
+        CGSRemoveNotifyProcPtr removeProc = [WCCGSFunctions sharedFunctions].CGSRemoveNotifyProc;
+        for (size_t i = 0; i < kWCMonitoredNotificationCount; i++) {
+            removeProc(WCWindowServerNotifyCallback, kWCMonitoredNotifications[i], (__bridge void *)self);
+        }
+        _cgsNotificationsInstalled = NO;
+    }
+
+    _handler = nil;
+    _isMonitoring = NO;
+
+    [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                 category:@"WindowEvents"
+                                     file:__FILE__
+                                     line:__LINE__
+                                 function:__PRETTY_FUNCTION__
+                                   format:@"Stopped window event monitoring"];
+}
+
+- (BOOL)isMonitoring {
+    return _isMonitoring;
+}
+
+- (BOOL)hasWindowServerNotifications {
+    return _cgsNotificationsInstalled;
+}
+
+#pragma mark - Event Sources
+
+- (void)installAppKitObservers {
+    NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+    NSOperationQueue *mainQueue = [NSOperationQueue mainQueue];
+
+    // Notifications that indicate a window has become visible or changed visibility
+    NSArray<NSNotificationName> *orderInNotifications = @[
+        NSWindowDidChangeOcclusionStateNotification,
+        NSWindowDidBecomeKeyNotification,
+        NSWindowDidBecomeMainNotification,
+        NSWindowDidExposeNotification,
+        NSWindowDidChangeScreenNotification
+    ];
+
+    __weak typeof(self) weakSelf = self;
+    for (NSNotificationName name in orderInNotifications) {
+        id observer = [center addObserverForName:name
+                                          object:nil
+                                           queue:mainQueue
+                                      usingBlock:^(NSNotification *note) {
+            NSWindow *window = note.object;
+            if ([window isKindOfClass:[NSWindow class]] && window.windowNumber > 0) {
+                [weakSelf dispatchEvent:WCWindowEventTypeOrderedIn windowID:(CGWindowID)window.windowNumber];
+            }
+        }];
+        [_notificationObservers addObject:observer];
+    }
+
+    id closeObserver = [center addObserverForName:NSWindowWillCloseNotification
+                                           object:nil
+                                            queue:mainQueue
+                                       usingBlock:^(NSNotification *note) {
+        NSWindow *window = note.object;
+        if ([window isKindOfClass:[NSWindow class]] && window.windowNumber > 0) {
+            [weakSelf dispatchEvent:WCWindowEventTypeDestroyed windowID:(CGWindowID)window.windowNumber];
+        }
+    }];
+    [_notificationObservers addObject:closeObserver];
+}
+
+- (BOOL)installWindowServerCallbacks {
+    WCCGSFunctions *cgs = [WCCGSFunctions sharedFunctions];
+    if (![cgs canRegisterNotifications]) {
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelWarning
+                                     category:@"WindowEvents"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Window server notifications unavailable, only AppKit windows will be reported"];
+        return NO;
+    }
+
+    CGSRegisterNotifyProcPtr registerProc = cgs.CGSRegisterNotifyProc;
+    CGSRemoveNotifyProcPtr removeProc = cgs.CGSRemoveNotifyProc;
+
+    for (size_t i = 0; i < kWCMonitoredNotificationCount; i++) {
+        CGError error = registerProc(WCWindowServerNotifyCallback, kWCMonitoredNotifications[i], (__bridge void *)self);
+        if (error != kCGErrorSuccess) {
+            [[WCLogger sharedLogger] logWithLevel:WCLogLevelWarning
+                                         category:@"WindowEvents"
+                                             file:__FILE__
+                                             line:__LINE__
+                                         function:__PRETTY_FUNCTION__
+                                           format:@"Failed to register for window notification %u: error %d",
+                                                 kWCMonitoredNotifications[i], (int)error];
+
+            // Roll back the ones that did register so we never leave a partial set behind
+            for (size_t j = 0; j < i; j++) {
+                removeProc(WCWindowServerNotifyCallback, kWCMonitoredNotifications[j], (__bridge void *)self);
+            }
+            return NO;
+        }
+    }
+
+    return YES;
+}
+
+#pragma mark - Event Delivery
+
+- (void)dispatchEvent:(WCWindowEventType)eventType windowID:(CGWindowID)windowID {
+    if (windowID == kCGNullWindowID) return;
+
+    void (^deliver)(void) = ^{
+        WCWindowEventHandler handler = self->_handler;
+        if (handler) {
+            handler(eventType, windowID);
+        }
+    };
+
+    // Window server callbacks normally arrive on the main run loop, but don't rely on it
+    if ([NSThread isMainThread]) {
+        deliver();
+    } else {
+        dispatch_async(dispatch_get_main_queue(), deliver);
+    }
+}
+
+@end
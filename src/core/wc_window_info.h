@@ -12,6 +12,7 @@
 #import <Foundation/Foundation.h>
 #import <AppKit/AppKit.h>
 #import "../util/wc_cgs_types.h"
+#import "wc_window_record.h"
 
 /**
  * @brief Class for abstracting window information
@@ -43,6 +44,18 @@
 - (nullable instancetype)initWithNSWindow:(nonnull NSWindow *)window;
 - (nullable instancetype)initWithCGWindowInfo:(nonnull NSDictionary *)windowInfo;
 
+/**
+ * @brief Create a view of a pooled window record
+ *
+ * Copies the record's fields, so no WindowServer calls are made until the
+ * title or owner name is read. Used by the scanner for the windows it
+ * protects; the record itself stays in the pool.
+ *
+ * @param record The record to copy
+ * @return A window info, or nil if the record has no window ID
+ */
+- (nullable instancetype)initWithWindowRecord:(nonnull const WCWindowRecord *)record;
+
 /**
  * @brief Protection methods
  */
@@ -51,6 +64,16 @@
 - (BOOL)disableStatusBar;
 - (BOOL)setWindowTagsForMissionControlVisibility;
 
+/**
+ * @brief Apply the AppKit side of Mission Control visibility
+ *
+ * Sets the collection behavior and level of the backing NSWindow without any
+ * WindowServer calls, for windows whose tags and level were set in a batch.
+ *
+ * @return YES if the window has an NSWindow and was updated
+ */
+- (BOOL)applyMissionControlCollectionBehavior;
+
 /**
  * @brief Get a dictionary representation of this window info
  *
@@ -4,10 +4,51 @@
  */
 
 #import "wc_window_info.h"
+#import "wc_window_snapshot.h"
 #import "../util/wc_cgs_functions.h"
 #import "../util/logger.h"
+#import "../util/wc_window_list.h"
 #import <AppKit/AppKit.h>
-#import <dlfcn.h>
+
+/**
+ * Look up the window list entry for a window, using the current snapshot when one is installed
+ */
+static NSDictionary *WCWindowListEntryForWindowID(CGWindowID windowID) {
+    WCWindowSnapshot *snapshot = [WCWindowSnapshot currentSnapshot];
+    if (snapshot) {
+        NSDictionary *entry = [snapshot windowInfoForWindowID:windowID];
+        // An on-screen snapshot leaves out windows that still exist
+        if (entry || snapshot.isComplete) {
+            return entry;
+        }
+    }
+
+    NSArray<NSDictionary *> *windowList = CFBridgingRelease(
+        WCWindowListCopy(kCGWindowListOptionIncludingWindow, windowID));
+    return windowList.firstObject;
+}
+
+/**
+ * Find the AppKit window for a window ID, using the current snapshot when one is installed
+ */
+static NSWindow *WCNSWindowForWindowID(CGWindowID windowID) {
+    // AppKit windows can only be looked up on the main thread
+    if (![NSThread isMainThread]) {
+        return nil;
+    }
+
+    WCWindowSnapshot *snapshot = [WCWindowSnapshot currentSnapshot];
+    if (snapshot) {
+        return [snapshot nsWindowForWindowID:windowID];
+    }
+
+    for (NSWindow *window in [NSApp windows]) {
+        if ((CGWindowID)[window windowNumber] == windowID) {
+            return window;
+        }
+    }
+    return nil;
+}
 
 @implementation WCWindowInfo {
     // Private instance variables
@@ -26,6 +67,7 @@
     BOOL _didLoadBasicInfo;
     BOOL _didLoadExtendedInfo;
     BOOL _didCheckProtection;
+    BOOL _didResolveNSWindow;
 }
 
 #pragma mark - Initialization
@@ -37,14 +79,10 @@
         _didLoadBasicInfo = NO;
         _didLoadExtendedInfo = NO;
         _didCheckProtection = NO;
+        _didResolveNSWindow = NO;
 
         // Try to find the NSWindow instance for this window ID
-        for (NSWindow *window in [NSApp windows]) {
-            if ((CGWindowID)[window windowNumber] == windowID) {
-                _nsWindow = window;
-                break;
-            }
-        }
+        [self resolveNSWindowIfNeeded];
 
         // Load basic window information
         [self loadBasicWindowInfo];
@@ -60,6 +98,7 @@
 
         _nsWindow = window;
         _windowID = (CGWindowID)[window windowNumber];
+        _didResolveNSWindow = YES;
         _didLoadBasicInfo = NO;
         _didLoadExtendedInfo = NO;
         _didCheckProtection = NO;
@@ -84,6 +123,7 @@
 
         _windowID = [windowIDNum unsignedIntValue];
         _nsWindow = nil;
+        _didResolveNSWindow = NO;
         _didLoadBasicInfo = YES;  // Info is loaded from the dictionary
         _didLoadExtendedInfo = YES;
         _didCheckProtection = NO;
@@ -119,12 +159,7 @@
         _sharingType = CGSWindowSharingNone;  // Default assumption
 
         // Try to find the NSWindow instance for this window ID
-        for (NSWindow *window in [NSApp windows]) {
-            if ((CGWindowID)[window windowNumber] == _windowID) {
-                _nsWindow = window;
-                break;
-            }
-        }
+        [self resolveNSWindowIfNeeded];
 
         // Check protection status
         [self checkProtectionStatus];
@@ -132,6 +167,35 @@
     return self;
 }
 
+- (instancetype)initWithWindowRecord:(const WCWindowRecord *)record {
+    if (self = [super init]) {
+        if (!record || record->windowID == kCGNullWindowID) {
+            return nil;
+        }
+
+        _windowID = record->windowID;
+        _nsWindow = nil;
+        _didResolveNSWindow = NO;
+
+        // Names are not part of the record and are loaded on first use
+        _title = nil;
+        _ownerName = nil;
+        _ownerPID = record->ownerPID;
+        _frame = record->frame;
+        _isOnScreen = (record->flags & WCWindowRecordFlagOnScreen) != 0;
+        _didLoadBasicInfo = YES;
+
+        _level = record->level;
+        _sharingType = (CGSWindowSharingType)record->sharingType;
+        _didLoadExtendedInfo = (record->flags & WCWindowRecordFlagHasLevel) &&
+                               (record->flags & WCWindowRecordFlagHasSharingState);
+
+        _isProtected = _sharingType == CGSWindowSharingNone;
+        _didCheckProtection = (record->flags & WCWindowRecordFlagHasSharingState) != 0;
+    }
+    return self;
+}
+
 #pragma mark - Property Getters
 
 - (CGWindowID)windowID {
@@ -139,9 +203,23 @@
 }
 
 - (NSWindow *)nsWindow {
+    [self resolveNSWindowIfNeeded];
     return _nsWindow;
 }
 
+/**
+ * Look up the backing NSWindow once, on the main thread
+ *
+ * Window infos created on the scanner queue have no NSWindow until one of the
+ * AppKit-facing methods runs on the main thread.
+ */
+- (void)resolveNSWindowIfNeeded {
+    if (_didResolveNSWindow || ![NSThread isMainThread]) return;
+
+    _didResolveNSWindow = YES;
+    _nsWindow = WCNSWindowForWindowID(_windowID);
+}
+
 - (CGRect)frame {
     [self ensureBasicInfoLoaded];
     return _frame;
@@ -149,6 +227,7 @@
 
 - (NSString *)title {
     [self ensureBasicInfoLoaded];
+    if (!_title) [self loadWindowNames];
     return _title;
 }
 
@@ -159,6 +238,7 @@
 
 - (NSString *)ownerName {
     [self ensureBasicInfoLoaded];
+    if (!_ownerName) [self loadWindowNames];
     return _ownerName;
 }
 
@@ -205,13 +285,10 @@
 - (void)loadBasicWindowInfo {
     if (_didLoadBasicInfo) return;
 
-    // Get window info using Core Graphics
-    CFArrayRef windowList = CGWindowListCopyWindowInfo(
-        kCGWindowListOptionIncludingWindow, _windowID);
-
-    if (windowList && CFArrayGetCount(windowList) > 0) {
-        NSDictionary *windowInfo = (NSDictionary *)CFArrayGetValueAtIndex(windowList, 0);
+    // Get window info from the current snapshot or Core Graphics
+    NSDictionary *windowInfo = WCWindowListEntryForWindowID(_windowID);
 
+    if (windowInfo) {
         // Extract window information
         _title = windowInfo[(NSString *)kCGWindowName];
         if (!_title) _title = @"";
@@ -256,10 +333,16 @@
                                      function:__PRETTY_FUNCTION__
                                        format:@"Failed to load basic info for window ID: %d", (int)_windowID];
     }
+}
 
-    if (windowList) {
-        CFRelease(windowList);
-    }
+- (void)loadWindowNames {
+    NSDictionary *windowInfo = WCWindowListEntryForWindowID(_windowID);
+
+    NSString *title = windowInfo[(NSString *)kCGWindowName];
+    _title = title ? title : @"";
+
+    NSString *ownerName = windowInfo[(NSString *)kCGWindowOwnerName];
+    _ownerName = ownerName ? ownerName : @"";
 }
 
 - (void)loadExtendedWindowInfo {
@@ -294,21 +377,10 @@
             }];
             _level = level;
         } else {
-            // Fall back to window info from CGWindowList
-            CFArrayRef windowList = CGWindowListCopyWindowInfo(
-                kCGWindowListOptionIncludingWindow, _windowID);
-
-            if (windowList && CFArrayGetCount(windowList) > 0) {
-                NSDictionary *windowInfo = (NSDictionary *)CFArrayGetValueAtIndex(windowList, 0);
-                NSNumber *windowLayer = windowInfo[(NSString *)kCGWindowLayer];
-                _level = windowLayer ? [windowLayer intValue] : 0;
-            } else {
-                _level = 0;  // Default
-            }
-
-            if (windowList) {
-                CFRelease(windowList);
-            }
+            // Fall back to window info from the snapshot or CGWindowList
+            NSDictionary *windowInfo = WCWindowListEntryForWindowID(_windowID);
+            NSNumber *windowLayer = windowInfo[(NSString *)kCGWindowLayer];
+            _level = windowLayer ? [windowLayer intValue] : 0;
         }
 
         // Get window sharing type using CGS if available
@@ -391,19 +463,12 @@
     }
 
     // For non-AppKit windows, check if it's in the window list
-    CFArrayRef windowList = CGWindowListCopyWindowInfo(
-        kCGWindowListOptionIncludingWindow, _windowID);
-
-    BOOL exists = (windowList && CFArrayGetCount(windowList) > 0);
-
-    if (windowList) {
-        CFRelease(windowList);
-    }
-
-    return exists;
+    return WCWindowListEntryForWindowID(_windowID) != nil;
 }
 
 - (BOOL)makeInvisibleToScreenRecording {
+    [self resolveNSWindowIfNeeded];
+
     BOOL success = NO;
 
     // First, try to use CGS API
@@ -466,6 +531,8 @@
 }
 
 - (BOOL)setLevel:(NSWindowLevel)level {
+    [self resolveNSWindowIfNeeded];
+
     BOOL success = NO;
 
     // Use NSFloatingWindowLevel for better visibility and Mission Control compatibility
@@ -562,87 +629,72 @@
 - (BOOL)setWindowTagsForMissionControlVisibility {
     BOOL success = NO;
 
-    // First, get CGSSetWindowTags function
-    void *handle = dlopen(NULL, RTLD_LAZY);
-    if (!handle) {
+    WCCGSFunctions *cgs = [WCCGSFunctions sharedFunctions];
+    if (![cgs isAvailable]) {
         return NO;
     }
 
-    typedef CGError (*CGSSetWindowTagsPtr)(CGSConnectionID, CGWindowID, CGSWindowTag*, int);
-    CGSSetWindowTagsPtr setTagsFunc = (CGSSetWindowTagsPtr)dlsym(handle, "CGSSetWindowTags");
-
-    // Get CGSClearWindowTags function
-    typedef CGError (*CGSClearWindowTagsPtr)(CGSConnectionID, CGWindowID, CGSWindowTag*, int);
-    CGSClearWindowTagsPtr clearTagsFunc = (CGSClearWindowTagsPtr)dlsym(handle, "CGSClearWindowTags");
+    // Tags and level go through the batch path so they share one connection lookup
+    // Use NSFloatingWindowLevel to make the window appear at the proper level in Mission Control
+    WCCGSBatchResult result;
+    [cgs applyOperations:WCCGSBatchOperationMissionControlTags | WCCGSBatchOperationLevel
+             toWindowIDs:&_windowID
+                   count:1
+            sharingState:CGSWindowSharingNone
+                   level:NSFloatingWindowLevel
+                 results:&result];
+
+    if (result.tagsError == kCGErrorSuccess) {
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
+                                     category:@"WindowVisibility"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Applied enhanced CGS window tags for Mission Control visibility to window: %@", self];
+        success = YES;
+    }
 
-    if (!setTagsFunc || !clearTagsFunc) {
-        dlclose(handle);
-        return NO;
+    // If we have a NSWindow reference, set proper collection behavior
+    if ([self applyMissionControlCollectionBehavior]) {
+        success = YES;
     }
 
-    WCCGSFunctions *cgs = [WCCGSFunctions sharedFunctions];
-    if ([cgs isAvailable]) {
-        CGSConnectionID cid = [cgs CGSDefaultConnection]();
-        if (cid != 0) {
-            // First, clear any existing tags that might interfere
-            CGSWindowTag tagsToClear[5] = { 3, 4, 5, 6, 7 }; // Clear higher level tags
-            clearTagsFunc(cid, _windowID, tagsToClear, 5);
-
-            // Set tags for proper Mission Control behavior
-            // 1=show in expose, 2=show in window list, 8=allow window to be movable in spaces
-            CGSWindowTag tags[3] = { 1, 2, 8 };
-            CGError error = setTagsFunc(cid, _windowID, tags, 3);
-
-            // Also modify window level to make it appear at proper level in Mission Control
-            // Use kCGDesktopWindowLevel+1 for proper z-ordering
-            [cgs performCGSOperation:@"SetWindowLevel"
-                         withWindowID:_windowID
-                            operation:^CGError(CGSConnectionID cid, CGSWindowID wid) {
-                return cgs.CGSSetWindowLevel(cid, wid, NSFloatingWindowLevel);
-            }];
+    return success;
+}
 
-            if (error == 0) {
-                [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                             category:@"WindowVisibility"
-                                                 file:__FILE__
-                                                 line:__LINE__
-                                             function:__PRETTY_FUNCTION__
-                                               format:@"Applied enhanced CGS window tags for Mission Control visibility to window: %@", self];
-                success = YES;
-            }
+- (BOOL)applyMissionControlCollectionBehavior {
+    [self resolveNSWindowIfNeeded];
 
-            // If we have a NSWindow reference, set proper collection behavior
-            if (_nsWindow && [_nsWindow respondsToSelector:@selector(setCollectionBehavior:)]) {
-                NSWindowCollectionBehavior behavior = NSWindowCollectionBehaviorDefault;
+    if (!_nsWindow || ![_nsWindow respondsToSelector:@selector(setCollectionBehavior:)]) {
+        return NO;
+    }
 
-                // Optimized behavior for Mission Control positioning
-                behavior |= NSWindowCollectionBehaviorManaged;
-                behavior |= NSWindowCollectionBehaviorParticipatesInCycle;
-                behavior |= NSWindowCollectionBehaviorMoveToActiveSpace;
+    NSWindowCollectionBehavior behavior = NSWindowCollectionBehaviorDefault;
 
-                // More aggressive Mission Control behaviors
-                behavior |= NSWindowCollectionBehaviorFullScreenPrimary;
+    // Optimized behavior for Mission Control positioning
+    behavior |= NSWindowCollectionBehaviorManaged;
+    behavior |= NSWindowCollectionBehaviorParticipatesInCycle;
+    behavior |= NSWindowCollectionBehaviorMoveToActiveSpace;
 
-                // Remove behaviors that cause fixed positioning
-                behavior &= ~NSWindowCollectionBehaviorStationary;
-                behavior &= ~NSWindowCollectionBehaviorCanJoinAllSpaces;
+    // More aggressive Mission Control behaviors
+    behavior |= NSWindowCollectionBehaviorFullScreenPrimary;
 
-                [_nsWindow setCollectionBehavior:behavior];
+    // Remove behaviors that cause fixed positioning
+    behavior &= ~NSWindowCollectionBehaviorStationary;
+    behavior &= ~NSWindowCollectionBehaviorCanJoinAllSpaces;
 
-                // Set a standard app window level to force proper positioning
-                [_nsWindow setLevel:NSNormalWindowLevel];
+    [_nsWindow setCollectionBehavior:behavior];
 
-                success = YES;
-            }
-        }
-    }
+    // Set a standard app window level to force proper positioning
+    [_nsWindow setLevel:NSNormalWindowLevel];
 
-    dlclose(handle);
-    return success;
+    return YES;
 }
 
 // Enhanced method to completely disable status bar display - ultra aggressive approach
 - (BOOL)disableStatusBar {
+    [self resolveNSWindowIfNeeded];
+
     BOOL success = NO;
 
     // Try AppKit method first
@@ -778,9 +830,9 @@
     NSMutableDictionary *dict = [NSMutableDictionary dictionary];
 
     dict[@"windowID"] = @(_windowID);
-    dict[@"title"] = _title ? _title : @"";
+    dict[@"title"] = self.title ? self.title : @"";
     dict[@"ownerPID"] = @(_ownerPID);
-    dict[@"ownerName"] = _ownerName ? _ownerName : @"";
+    dict[@"ownerName"] = self.ownerName ? self.ownerName : @"";
     dict[@"isOnScreen"] = @(_isOnScreen);
     dict[@"level"] = @(_level);
     dict[@"isProtected"] = @(_isProtected);
@@ -0,0 +1,88 @@
+/**
+ * @file wc_window_policy.h
+ * @brief Per-window protection rules for WindowControlInjector
+ *
+ * This file defines a small rule engine that decides which protections a
+ * window gets, so tooltips, menus, drag images and other windows nobody
+ * needs to hide can be left alone. Rules are compiled once into a table of
+ * plain structs and each window's decision is cached by window ID, so a
+ * window is only evaluated the first time the scanner wants to protect it.
+ *
+ * A rule is a dictionary. Every key is optional, and a rule matches when
+ * all of the tests it has pass:
+ *   "layer", "minLayer", "maxLayer"   kCGWindowLayer of the window
+ *   "minWidth", "maxWidth"            Width in points
+ *   "minHeight", "maxHeight"          Height in points
+ *   "owner"                           Owning process name, exact match
+ *   "title"                           Regular expression searched in the title
+ *   "action"                          "protect" (default), "hide" or "ignore"
+ * "protect" applies capture protection and the window level, "hide" only
+ * capture protection and "ignore" neither. The first matching rule wins;
+ * windows no rule matches are protected.
+ */
+
+#ifndef WC_WINDOW_POLICY_H
+#define WC_WINDOW_POLICY_H
+
+#import <Foundation/Foundation.h>
+#import "wc_window_info.h"
+#import "wc_window_record.h"
+#import "wc_window_state_cache.h"
+
+/**
+ * @brief Compiled protection rules with a per-window decision cache
+ *
+ * The policy is not thread-safe and is owned by WCWindowScanner.
+ */
+@interface WCWindowPolicy : NSObject
+
+/**
+ * @brief Number of rules that compiled
+ */
+@property (nonatomic, readonly) NSUInteger ruleCount;
+
+/**
+ * @brief Number of windows with a cached decision
+ */
+@property (nonatomic, readonly) NSUInteger cachedWindowCount;
+
+/**
+ * @brief Compile rules
+ *
+ * Rules with unknown actions, keys of the wrong type or invalid title
+ * patterns are skipped with a warning.
+ *
+ * @param rules Rule dictionaries in priority order
+ * @return A policy, protecting every window if no rule compiled
+ */
+- (nonnull instancetype)initWithRules:(nullable NSArray<NSDictionary *> *)rules;
+
+/**
+ * @brief Get the protections a window of the current tick should have
+ *
+ * Layer and size tests read the record; the owner name and title are only
+ * looked up when a rule that could still match tests them.
+ *
+ * @param record The window's record
+ * @return The protections the window may get, cached for its lifetime
+ */
+- (WCWindowDrift)protectionsForWindowRecord:(nonnull const WCWindowRecord *)record;
+
+/**
+ * @brief Get the protections a window should have
+ *
+ * @param window The window to evaluate
+ * @return The protections the window may get, cached for its lifetime
+ */
+- (WCWindowDrift)protectionsForWindow:(nonnull WCWindowInfo *)window;
+
+/**
+ * @brief Forget the cached decision for a window, for example after it is destroyed
+ *
+ * @param windowID The window to forget
+ */
+- (void)forgetWindowID:(CGWindowID)windowID;
+
+@end
+
+#endif /* WC_WINDOW_POLICY_H */
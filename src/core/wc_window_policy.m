@@ -0,0 +1,270 @@
+/**
+ * @file wc_window_policy.m
+ * @brief Implementation of the per-window protection rules
+ */
+
+#import "wc_window_policy.h"
+#import "../util/logger.h"
+#import "../util/wc_window_id_set.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Tests a compiled rule performs
+ */
+typedef enum {
+    WCWindowPolicyTestMinLayer  = 1 << 0,
+    WCWindowPolicyTestMaxLayer  = 1 << 1,
+    WCWindowPolicyTestMinWidth  = 1 << 2,
+    WCWindowPolicyTestMaxWidth  = 1 << 3,
+    WCWindowPolicyTestMinHeight = 1 << 4,
+    WCWindowPolicyTestMaxHeight = 1 << 5,
+    WCWindowPolicyTestOwner     = 1 << 6,
+    WCWindowPolicyTestTitle     = 1 << 7
+} WCWindowPolicyTest;
+
+// Tests that need the owner name or title, which are not in the window record
+static const uint32_t kWCWindowPolicyNameTests = WCWindowPolicyTestOwner | WCWindowPolicyTestTitle;
+
+/**
+ * One row of the decision table
+ */
+typedef struct {
+    uint32_t tests;  // WCWindowPolicyTest
+    int32_t minLayer;
+    int32_t maxLayer;
+    CGFloat minWidth;
+    CGFloat maxWidth;
+    CGFloat minHeight;
+    CGFloat maxHeight;
+    NSUInteger ownerIndex;  // Into _ownerNames
+    NSUInteger titleIndex;  // Into _titlePatterns
+    WCWindowDrift protections;
+} WCWindowPolicyRule;
+
+/**
+ * Fields of the window being evaluated
+ */
+typedef struct {
+    int32_t layer;
+    CGSize size;
+    const WCWindowRecord *record;  // Source of the window info when names are needed, may be NULL
+} WCWindowPolicySubject;
+
+@implementation WCWindowPolicy {
+    WCWindowPolicyRule *_rules;
+    NSUInteger _ruleCount;
+    NSArray<NSString *> *_ownerNames;
+    NSArray<NSRegularExpression *> *_titlePatterns;
+    WCWindowIDMap _decisions;  // Window ID to uint32_t WCWindowDrift
+}
+
+#pragma mark - Compilation
+
+static BOOL WCWindowPolicyReadNumber(NSDictionary *rule, NSString *key, double *value) {
+    id object = rule[key];
+    if (![object isKindOfClass:[NSNumber class]]) return NO;
+
+    *value = [object doubleValue];
+    return YES;
+}
+
+- (instancetype)initWithRules:(NSArray<NSDictionary *> *)rules {
+    if (self = [super init]) {
+        _rules = rules.count > 0 ? calloc(rules.count, sizeof(WCWindowPolicyRule)) : NULL;
+        _ruleCount = 0;
+        WCWindowIDMapInit(&_decisions, sizeof(uint32_t), 0);
+
+        NSMutableArray<NSString *> *ownerNames = [NSMutableArray array];
+        NSMutableArray<NSRegularExpression *> *titlePatterns = [NSMutableArray array];
+
+        for (NSUInteger i = 0; _rules && i < rules.count; i++) {
+            if (![self compileRule:rules[i] into:&_rules[_ruleCount] ownerNames:ownerNames titlePatterns:titlePatterns]) {
+                WCLogWarning(@"WindowPolicy", @"Skipping invalid window rule %lu: %@", (unsigned long)i, rules[i]);
+                continue;
+            }
+            _ruleCount++;
+        }
+
+        _ownerNames = [ownerNames copy];
+        _titlePatterns = [titlePatterns copy];
+
+        if (rules.count > 0) {
+            WCLogInfo(@"WindowPolicy", @"Compiled %lu of %lu window rules",
+                      (unsigned long)_ruleCount, (unsigned long)rules.count);
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free(_rules);
+    WCWindowIDMapDestroy(&_decisions);
+}
+
+- (BOOL)compileRule:(NSDictionary *)rule
+               into:(WCWindowPolicyRule *)compiled
+         ownerNames:(NSMutableArray<NSString *> *)ownerNames
+      titlePatterns:(NSMutableArray<NSRegularExpression *> *)titlePatterns {
+    if (![rule isKindOfClass:[NSDictionary class]]) return NO;
+
+    memset(compiled, 0, sizeof(*compiled));
+
+    id action = rule[@"action"];
+    if (!action || [action isEqual:@"protect"]) {
+        compiled->protections = WCWindowDriftAll;
+    } else if ([action isEqual:@"hide"]) {
+        compiled->protections = WCWindowDriftSharing;
+    } else if ([action isEqual:@"ignore"]) {
+        compiled->protections = WCWindowDriftNone;
+    } else {
+        return NO;
+    }
+
+    double value = 0;
+    if (WCWindowPolicyReadNumber(rule, @"layer", &value)) {
+        compiled->minLayer = compiled->maxLayer = (int32_t)value;
+        compiled->tests |= WCWindowPolicyTestMinLayer | WCWindowPolicyTestMaxLayer;
+    }
+    if (WCWindowPolicyReadNumber(rule, @"minLayer", &value)) {
+        compiled->minLayer = (int32_t)value;
+        compiled->tests |= WCWindowPolicyTestMinLayer;
+    }
+    if (WCWindowPolicyReadNumber(rule, @"maxLayer", &value)) {
+        compiled->maxLayer = (int32_t)value;
+        compiled->tests |= WCWindowPolicyTestMaxLayer;
+    }
+    if (WCWindowPolicyReadNumber(rule, @"minWidth", &value)) {
+        compiled->minWidth = value;
+        compiled->tests |= WCWindowPolicyTestMinWidth;
+    }
+    if (WCWindowPolicyReadNumber(rule, @"maxWidth", &value)) {
+        compiled->maxWidth = value;
+        compiled->tests |= WCWindowPolicyTestMaxWidth;
+    }
+    if (WCWindowPolicyReadNumber(rule, @"minHeight", &value)) {
+        compiled->minHeight = value;
+        compiled->tests |= WCWindowPolicyTestMinHeight;
+    }
+    if (WCWindowPolicyReadNumber(rule, @"maxHeight", &value)) {
+        compiled->maxHeight = value;
+        compiled->tests |= WCWindowPolicyTestMaxHeight;
+    }
+
+    id owner = rule[@"owner"];
+    if (owner) {
+        if (![owner isKindOfClass:[NSString class]]) return NO;
+        compiled->ownerIndex = ownerNames.count;
+        compiled->tests |= WCWindowPolicyTestOwner;
+        [ownerNames addObject:owner];
+    }
+
+    id title = rule[@"title"];
+    if (title) {
+        if (![title isKindOfClass:[NSString class]]) return NO;
+        NSRegularExpression *pattern = [NSRegularExpression regularExpressionWithPattern:title options:0 error:nil];
+        if (!pattern) return NO;
+        compiled->titleIndex = titlePatterns.count;
+        compiled->tests |= WCWindowPolicyTestTitle;
+        [titlePatterns addObject:pattern];
+    }
+
+    // Numeric keys of the wrong type would silently widen the rule
+    for (NSString *key in @[@"layer", @"minLayer", @"maxLayer", @"minWidth", @"maxWidth", @"minHeight", @"maxHeight"]) {
+        if (rule[key] && ![rule[key] isKindOfClass:[NSNumber class]]) return NO;
+    }
+
+    return YES;
+}
+
+#pragma mark - Evaluation
+
+- (NSUInteger)ruleCount {
+    return _ruleCount;
+}
+
+- (NSUInteger)cachedWindowCount {
+    return _decisions.count;
+}
+
+- (BOOL)rule:(const WCWindowPolicyRule *)rule
+matchesSubject:(const WCWindowPolicySubject *)subject
+        window:(WCWindowInfo * __strong *)window {
+    uint32_t tests = rule->tests;
+
+    // Record fields first, so most rules are decided without looking up names
+    if ((tests & WCWindowPolicyTestMinLayer) && subject->layer < rule->minLayer) return NO;
+    if ((tests & WCWindowPolicyTestMaxLayer) && subject->layer > rule->maxLayer) return NO;
+    if ((tests & WCWindowPolicyTestMinWidth) && subject->size.width < rule->minWidth) return NO;
+    if ((tests & WCWindowPolicyTestMaxWidth) && subject->size.width > rule->maxWidth) return NO;
+    if ((tests & WCWindowPolicyTestMinHeight) && subject->size.height < rule->minHeight) return NO;
+    if ((tests & WCWindowPolicyTestMaxHeight) && subject->size.height > rule->maxHeight) return NO;
+    if (!(tests & kWCWindowPolicyNameTests)) return YES;
+
+    // Names are looked up once per evaluation, and only for rules that got this far
+    if (!*window && subject->record) {
+        *window = [[WCWindowInfo alloc] initWithWindowRecord:subject->record];
+    }
+    if (!*window) return NO;
+
+    if ((tests & WCWindowPolicyTestOwner) && ![(*window).ownerName isEqualToString:_ownerNames[rule->ownerIndex]]) {
+        return NO;
+    }
+    if (tests & WCWindowPolicyTestTitle) {
+        NSString *title = (*window).title;
+        NSRegularExpression *pattern = _titlePatterns[rule->titleIndex];
+        if ([pattern rangeOfFirstMatchInString:title options:0 range:NSMakeRange(0, title.length)].location == NSNotFound) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+- (WCWindowDrift)protectionsForWindowID:(CGWindowID)windowID
+                                subject:(const WCWindowPolicySubject *)subject
+                                 window:(WCWindowInfo *)window {
+    if (_ruleCount == 0) return WCWindowDriftAll;
+
+    const uint32_t *cached = WCWindowIDMapGet(&_decisions, windowID);
+    if (cached) return (WCWindowDrift)*cached;
+
+    WCWindowDrift protections = WCWindowDriftAll;
+    for (NSUInteger i = 0; i < _ruleCount; i++) {
+        if ([self rule:&_rules[i] matchesSubject:subject window:&window]) {
+            protections = _rules[i].protections;
+            break;
+        }
+    }
+
+    uint32_t *decision = WCWindowIDMapUpsert(&_decisions, windowID, NULL);
+    if (decision) *decision = (uint32_t)protections;
+
+    if (protections != WCWindowDriftAll) {
+        WCLogDebug(@"WindowPolicy", @"Window ID %u gets protections %lu", windowID, (unsigned long)protections);
+    }
+    return protections;
+}
+
+- (WCWindowDrift)protectionsForWindowRecord:(const WCWindowRecord *)record {
+    WCWindowPolicySubject subject = {
+        .layer = (record->flags & WCWindowRecordFlagHasLevel) ? record->level : 0,
+        .size = record->frame.size,
+        .record = record
+    };
+    return [self protectionsForWindowID:record->windowID subject:&subject window:nil];
+}
+
+- (WCWindowDrift)protectionsForWindow:(WCWindowInfo *)window {
+    WCWindowPolicySubject subject = {
+        .layer = (int32_t)window.level,
+        .size = window.frame.size,
+        .record = NULL
+    };
+    return [self protectionsForWindowID:window.windowID subject:&subject window:window];
+}
+
+- (void)forgetWindowID:(CGWindowID)windowID {
+    WCWindowIDMapRemove(&_decisions, windowID);
+}
+
+@end
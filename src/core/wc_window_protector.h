@@ -50,6 +50,16 @@
  */
 + (void)clearDebounceHistory;
 
+/**
+ * @brief Forget the debounce state of a window
+ *
+ * Called when a window is destroyed or disappears from the window list.
+ * Debounce entries also expire on their own after the debounce interval.
+ *
+ * @param windowID The window to forget
+ */
++ (void)forgetWindowID:(CGWindowID)windowID;
+
 /**
  * @brief Make a window invisible to screen recording
  *
@@ -7,17 +7,25 @@
 #import "wc_window_info.h"
 #import "../util/wc_cgs_functions.h"
 #import "../util/logger.h"
+#import "../util/wc_metrics.h"
+#import "../util/wc_timing_wheel.h"
 #import <AppKit/AppKit.h>
+#include <os/lock.h>
 
-// Static variables for debouncing
-static NSMutableDictionary<NSNumber *, NSDate *> *lastProtectionTimesByWindowID;
+// Debounce windows expire from the wheel on their own, guarded by gDebounceLock
+static WCTimingWheel gDebounceWheel;
+static os_unfair_lock gDebounceLock = OS_UNFAIR_LOCK_INIT;
 static NSTimeInterval debounceInterval;
 
+// 256 slots of 10ms cover the default interval without windows lapping the wheel
+static const uint64_t kWCDebounceWheelResolution = 10 * NSEC_PER_MSEC;
+static const uint32_t kWCDebounceWheelSlots = 256;
+
 @implementation WCWindowProtector
 
 + (void)initialize {
     if (self == [WCWindowProtector class]) {
-        lastProtectionTimesByWindowID = [NSMutableDictionary dictionary];
+        WCTimingWheelInit(&gDebounceWheel, kWCDebounceWheelResolution, kWCDebounceWheelSlots, WCMetricsNow());
         debounceInterval = 0.3; // Default to 300ms to prevent flickering
     }
 }
@@ -47,32 +55,44 @@ static NSTimeInterval debounceInterval;
  * Clear the debounce history
  */
 + (void)clearDebounceHistory {
-    [lastProtectionTimesByWindowID removeAllObjects];
+    os_unfair_lock_lock(&gDebounceLock);
+    WCTimingWheelClear(&gDebounceWheel);
+    os_unfair_lock_unlock(&gDebounceLock);
+}
+
+/**
+ * Forget the debounce state of a window that no longer exists
+ */
++ (void)forgetWindowID:(CGWindowID)windowID {
+    os_unfair_lock_lock(&gDebounceLock);
+    WCTimingWheelRemove(&gDebounceWheel, windowID);
+    os_unfair_lock_unlock(&gDebounceLock);
 }
 
 #pragma mark - Screen Recording Protection Methods
 
 + (BOOL)makeWindowInvisibleToScreenRecording:(CGWindowID)windowID {
-    // Check if we should debounce this window
-    NSNumber *windowIDNumber = @(windowID);
-    NSDate *lastProtectionTime = lastProtectionTimesByWindowID[windowIDNumber];
-
-    if (lastProtectionTime) {
-        NSTimeInterval timeSinceLastProtection = [[NSDate date] timeIntervalSinceDate:lastProtectionTime];
-        if (timeSinceLastProtection < debounceInterval) {
-            [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                         category:@"WindowProtection"
-                                             file:__FILE__
-                                             line:__LINE__
-                                         function:__PRETTY_FUNCTION__
-                                           format:@"Skipping window ID %d protection due to debounce (%.2fs < %.2fs)",
-                                                  (int)windowID, timeSinceLastProtection, debounceInterval];
-            return YES; // Return success to avoid triggering fallbacks
-        }
+    // Check if we should debounce this window, recording the attempt if not
+    uint64_t now = WCMetricsNow();
+    uint64_t remaining = 0;
+
+    os_unfair_lock_lock(&gDebounceLock);
+    BOOL debounced = WCTimingWheelIsPending(&gDebounceWheel, windowID, now, &remaining);
+    if (!debounced) {
+        WCTimingWheelSchedule(&gDebounceWheel, windowID, now + (uint64_t)(debounceInterval * NSEC_PER_SEC), now);
     }
+    os_unfair_lock_unlock(&gDebounceLock);
 
-    // Record this protection attempt
-    lastProtectionTimesByWindowID[windowIDNumber] = [NSDate date];
+    if (debounced) {
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
+                                     category:@"WindowProtection"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Skipping window ID %d protection due to debounce (%.2fs remaining)",
+                                              (int)windowID, (double)remaining / NSEC_PER_SEC];
+        return YES; // Return success to avoid triggering fallbacks
+    }
 
     WCCGSFunctions *cgs = [WCCGSFunctions sharedFunctions];
 
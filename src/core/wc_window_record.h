@@ -0,0 +1,116 @@
+/**
+ * @file wc_window_record.h
+ * @brief Pooled plain-struct window records for WindowControlInjector
+ *
+ * This file defines a compact value-type record of the window list fields
+ * the scanner needs and a pool that keeps one record per window across scan
+ * ticks. Records are updated in place from each snapshot, so a steady-state
+ * scan does not allocate per window; WCWindowInfo objects are only created
+ * for windows that actually need protecting.
+ */
+
+#ifndef WC_WINDOW_RECORD_H
+#define WC_WINDOW_RECORD_H
+
+#include <CoreGraphics/CoreGraphics.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#import "../util/wc_window_id_set.h"
+
+/**
+ * @brief Which optional fields of a record were present in the window list
+ */
+typedef enum {
+    WCWindowRecordFlagOnScreen        = 1 << 0,  // kCGWindowIsOnscreen was true
+    WCWindowRecordFlagHasSharingState = 1 << 1,  // sharingType is valid
+    WCWindowRecordFlagHasLevel        = 1 << 2   // level is valid
+} WCWindowRecordFlags;
+
+/**
+ * @brief Window list fields of one window
+ */
+typedef struct {
+    CGWindowID windowID;
+    pid_t ownerPID;
+    CGRect frame;
+    int32_t level;        // kCGWindowLayer
+    int32_t sharingType;  // kCGWindowSharingState, a CGWindowSharingType
+    uint32_t flags;       // WCWindowRecordFlags
+    uint32_t lastSeenTick;
+} WCWindowRecord;
+
+/**
+ * @brief Dense array of records indexed by window ID
+ *
+ * Storage only grows, so after the first few ticks updating the pool does
+ * not allocate. Records of windows missing from a tick are dropped when
+ * the tick ends. Pointers into the pool are invalidated by the next
+ * update or end of tick. The pool is not thread-safe; each owner guards
+ * it the same way it guards its other state.
+ */
+typedef struct {
+    WCWindowRecord *records;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t tick;         // Current tick, starting at 1
+    WCWindowIDMap index;   // Window ID to uint32_t position in records
+} WCWindowRecordPool;
+
+/**
+ * @brief Initialize an empty pool
+ *
+ * @param pool The pool to initialize
+ * @param expectedCount Number of windows the pool should hold without growing
+ */
+void WCWindowRecordPoolInit(WCWindowRecordPool *pool, uint32_t expectedCount);
+
+/**
+ * @brief Release the storage of a pool
+ *
+ * @param pool The pool to destroy; it may be re-initialized afterwards
+ */
+void WCWindowRecordPoolDestroy(WCWindowRecordPool *pool);
+
+/**
+ * @brief Start a new tick
+ *
+ * @param pool The pool to update
+ */
+void WCWindowRecordPoolBeginTick(WCWindowRecordPool *pool);
+
+/**
+ * @brief Get the record for a window, adding one if absent, and mark it seen this tick
+ *
+ * @param pool The pool to update
+ * @param windowID The window to look up
+ * @param created Set to true if the record was added; may be NULL
+ * @return The record, or NULL if the ID is invalid or allocation failed
+ */
+WCWindowRecord *WCWindowRecordPoolUpdate(WCWindowRecordPool *pool, CGWindowID windowID, bool *created);
+
+/**
+ * @brief Drop the records of windows that were not seen this tick
+ *
+ * The visitor lets the owner evict its own per-window state for windows
+ * that left the window list. It must not update the pool.
+ *
+ * @param pool The pool to update
+ * @param visitor Function called with each dropped window ID and the context pointer; may be NULL
+ * @param context Caller data passed through to the visitor
+ * @return Number of records dropped
+ */
+uint32_t WCWindowRecordPoolEndTick(WCWindowRecordPool *pool,
+                                   void (*visitor)(CGWindowID windowID, void *context),
+                                   void *context);
+
+/**
+ * @brief Look up the record for a window
+ *
+ * @param pool The pool to search
+ * @param windowID The window to look up
+ * @return The record, or NULL if the window has none
+ */
+const WCWindowRecord *WCWindowRecordPoolGet(const WCWindowRecordPool *pool, CGWindowID windowID);
+
+#endif /* WC_WINDOW_RECORD_H */
@@ -0,0 +1,113 @@
+/**
+ * @file wc_window_record.m
+ * @brief Implementation of the pooled window records
+ */
+
+#import "wc_window_record.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Smallest record array allocated on first insert
+static const uint32_t kWCMinimumRecordCapacity = 16;
+
+static bool WCWindowRecordPoolReserve(WCWindowRecordPool *pool, uint32_t capacity) {
+    if (capacity <= pool->capacity) return true;
+
+    uint32_t newCapacity = pool->capacity > 0 ? pool->capacity : kWCMinimumRecordCapacity;
+    while (newCapacity < capacity && newCapacity < (1u << 30)) {
+        newCapacity <<= 1;
+    }
+
+    WCWindowRecord *records = realloc(pool->records, (size_t)newCapacity * sizeof(WCWindowRecord));
+    if (!records) return false;
+
+    pool->records = records;
+    pool->capacity = newCapacity;
+    return true;
+}
+
+void WCWindowRecordPoolInit(WCWindowRecordPool *pool, uint32_t expectedCount) {
+    pool->records = NULL;
+    pool->count = 0;
+    pool->capacity = 0;
+    pool->tick = 0;
+    WCWindowIDMapInit(&pool->index, sizeof(uint32_t), expectedCount);
+
+    if (expectedCount > 0) {
+        WCWindowRecordPoolReserve(pool, expectedCount);
+    }
+}
+
+void WCWindowRecordPoolDestroy(WCWindowRecordPool *pool) {
+    free(pool->records);
+    pool->records = NULL;
+    pool->count = 0;
+    pool->capacity = 0;
+    WCWindowIDMapDestroy(&pool->index);
+}
+
+void WCWindowRecordPoolBeginTick(WCWindowRecordPool *pool) {
+    // Tick 0 is never current, so records zeroed on insert start out unseen
+    pool->tick++;
+    if (pool->tick == 0) pool->tick = 1;
+}
+
+WCWindowRecord *WCWindowRecordPoolUpdate(WCWindowRecordPool *pool, CGWindowID windowID, bool *created) {
+    if (created) *created = false;
+
+    uint32_t *position = WCWindowIDMapGet(&pool->index, windowID);
+    if (position) {
+        WCWindowRecord *record = &pool->records[*position];
+        record->lastSeenTick = pool->tick;
+        return record;
+    }
+
+    if (!WCWindowRecordPoolReserve(pool, pool->count + 1)) return NULL;
+
+    position = WCWindowIDMapUpsert(&pool->index, windowID, NULL);
+    if (!position) return NULL;
+
+    *position = pool->count;
+    WCWindowRecord *record = &pool->records[pool->count++];
+    memset(record, 0, sizeof(*record));
+    record->windowID = windowID;
+    record->lastSeenTick = pool->tick;
+
+    if (created) *created = true;
+    return record;
+}
+
+uint32_t WCWindowRecordPoolEndTick(WCWindowRecordPool *pool,
+                                   void (*visitor)(CGWindowID windowID, void *context),
+                                   void *context) {
+    uint32_t dropped = 0;
+    uint32_t i = 0;
+
+    while (i < pool->count) {
+        WCWindowRecord *record = &pool->records[i];
+        if (record->lastSeenTick == pool->tick) {
+            i++;
+            continue;
+        }
+
+        if (visitor) visitor(record->windowID, context);
+
+        // Move the last record into the gap so the array stays dense
+        WCWindowIDMapRemove(&pool->index, record->windowID);
+        uint32_t last = pool->count - 1;
+        if (i != last) {
+            pool->records[i] = pool->records[last];
+            uint32_t *position = WCWindowIDMapGet(&pool->index, pool->records[i].windowID);
+            if (position) *position = i;
+        }
+        pool->count--;
+        dropped++;
+    }
+
+    return dropped;
+}
+
+const WCWindowRecord *WCWindowRecordPoolGet(const WCWindowRecordPool *pool, CGWindowID windowID) {
+    const uint32_t *position = WCWindowIDMapGet(&pool->index, windowID);
+    return position ? &pool->records[*position] : NULL;
+}
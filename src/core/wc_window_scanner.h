@@ -1,10 +1,11 @@
 /**
  * @file wc_window_scanner.h
- * @brief Periodic window scanning and protection for WindowControlInjector
+ * @brief Window scanning and protection for WindowControlInjector
  *
- * This file defines a class that periodically scans for and protects windows
- * to ensure consistent window state, handling new windows that appear after
- * initialization.
+ * This file defines a class that scans for and protects windows to ensure
+ * consistent window state, handling new windows that appear after
+ * initialization either as they are reported by window events or through
+ * periodic scans.
  */
 
 #ifndef WC_WINDOW_SCANNER_H
@@ -12,13 +13,18 @@
 
 #import <Foundation/Foundation.h>
 #import "wc_window_bridge.h"
+#import "wc_window_policy.h"
 
 /**
  * @brief Class for periodic window scanning and protection
  *
  * This class provides a mechanism to periodically scan for windows and
  * apply protections to them, with configurable scan intervals and
- * adaptive scanning based on performance metrics.
+ * adaptive scanning based on how many windows change between scans.
+ *
+ * Scans, window events and CGS calls run on a private serial queue and
+ * only AppKit fallbacks hop to the main thread. Methods may be called from
+ * any thread; configuration changes are applied asynchronously in order.
  */
 @interface WCWindowScanner : NSObject
 
@@ -36,6 +42,26 @@
  */
 - (void)startScanningWithInterval:(NSTimeInterval)interval;
 
+/**
+ * @brief Start event-driven scanning with a low-frequency safety sweep
+ *
+ * Windows are protected as soon as they are created or ordered in, using
+ * WCWindowEventMonitor. The periodic scan only runs every sweepInterval
+ * seconds to catch anything the event sources missed. If window server
+ * notifications are unavailable, the regular scan interval is kept so
+ * non-AppKit windows are still discovered promptly.
+ *
+ * @param sweepInterval The time interval in seconds between safety sweeps
+ */
+- (void)startEventDrivenScanningWithSweepInterval:(NSTimeInterval)sweepInterval;
+
+/**
+ * @brief Check if event-driven scanning is active
+ *
+ * @return YES if windows are discovered through events, NO if only polling is used
+ */
+- (BOOL)isEventDriven;
+
 /**
  * @brief Stop scanning
  */
@@ -51,8 +77,12 @@
 /**
  * @brief Set whether to use adaptive scanning
  *
- * When adaptive scanning is enabled, the scanner will adjust its
- * scan interval based on window count and system performance.
+ * When adaptive scanning is enabled, periodic scanning backs off
+ * exponentially from the configured interval while no windows are created
+ * or drift, and returns to it after a change or when the application
+ * becomes active. The running timer is retargeted rather than recreated,
+ * and idle ticks get more leeway so they can be coalesced. Event-driven
+ * safety sweeps keep their fixed interval.
  *
  * @param adaptive Whether to use adaptive scanning
  */
@@ -61,10 +91,79 @@
 /**
  * @brief Get the current scan interval
  *
- * @return The current scan interval in seconds
+ * @return The interval the timer currently fires at, in seconds
  */
 - (NSTimeInterval)currentScanInterval;
 
+/**
+ * @brief Set whether windows of helper processes are scanned from this process
+ *
+ * Multi-process profiles (Electron, Chrome) scan and watch their helper
+ * processes by default. Turn this off when helpers load the dylib
+ * themselves, so each process only protects its own windows.
+ *
+ * @param scansHelpers Whether to include helper process windows
+ */
+- (void)setScansHelperProcesses:(BOOL)scansHelpers;
+
+/**
+ * @brief Set whether helpers that loaded the dylib themselves are skipped
+ *
+ * A helper is skipped once it publishes its metrics page, so helpers that
+ * ignore DYLD_INSERT_LIBRARIES keep being scanned from this process. Use
+ * this with helper propagation instead of turning helper scanning off.
+ *
+ * @param skips Whether to leave self-protecting helpers to themselves
+ */
+- (void)setSkipsSelfProtectingHelpers:(BOOL)skips;
+
+/**
+ * @brief Set the rules deciding which protections each window gets
+ *
+ * Windows the rules ignore are never protected, and windows that are only
+ * hidden keep their level. Decisions are cached per window until it is
+ * destroyed, so changed rules only apply to windows seen afterwards.
+ *
+ * @param policy The compiled rules; a policy without rules protects every window
+ */
+- (void)setWindowPolicy:(WCWindowPolicy *)policy;
+
+/**
+ * @brief Set whether routine scan ticks list only on-screen windows
+ *
+ * Listing every window on every Space and display returns many entries
+ * that belong to other applications. In on-screen mode routine ticks only
+ * list on-screen windows, and every window is swept when the active Space
+ * changes, the display layout changes, an application becomes active,
+ * helpers appear or the shared configuration changes, as well as every
+ * few dozen ticks. Windows missing from an on-screen tick keep their state
+ * until a sweep shows whether they are gone.
+ *
+ * @param onScreen Whether routine ticks list only on-screen windows
+ */
+- (void)setOnScreenScanning:(BOOL)onScreen;
+
+/**
+ * @brief Set how many workers parse the window list on each scan
+ *
+ * Long window lists are parsed in chunks on several threads and merged in
+ * list order, so the result is the same as a serial pass. Reconciling and
+ * protecting windows stays on the scanner's queue.
+ *
+ * @param workerCount Maximum number of workers, 1 to parse serially, 0 for automatic
+ */
+- (void)setCollectionWorkerCount:(NSUInteger)workerCount;
+
+/**
+ * @brief Pick up shared configuration published by a controller
+ *
+ * Called when the shared configuration notification arrives. If the window
+ * level or capture protection changed, every known window is brought to the
+ * new settings right away; otherwise nothing happens. Scan ticks also check
+ * for new configuration, so a missed notification only delays the change.
+ */
+- (void)reloadSharedConfiguration;
+
 /**
  * @brief Perform an immediate scan
  *
@@ -73,6 +172,15 @@
  */
 - (void)scanNow;
 
+/**
+ * @brief Perform an immediate scan and wait for it to finish
+ *
+ * Same as scanNow but returns once the scan has run on the scanner's queue.
+ * AppKit follow-ups for newly protected windows still run later on the main
+ * thread. Used by the benchmark harness to time scans.
+ */
+- (void)scanNowAndWait;
+
 /**
  * @brief Enable debouncing of window protection operations
  *
@@ -94,6 +202,17 @@
  */
 - (void)configureForApplicationType:(WCApplicationType)appType;
 
+/**
+ * @brief Configure the scanner from an application profile
+ *
+ * Applies the profile's scan and debounce intervals and tracks helper
+ * processes matching its name patterns. configureForApplicationType: is
+ * equivalent to passing the default profile for the type.
+ *
+ * @param profile The application profile, typically from WCWindowBridge applicationProfileForPath:
+ */
+- (void)configureWithApplicationProfile:(WCAppProfile *)profile;
+
 /**
  * @brief Enable advanced multi-process window handling
  *
@@ -1,35 +1,127 @@
 /**
  * @file wc_window_scanner.m
- * @brief Implementation of the window scanner for periodic window protection
+ * @brief Implementation of the window scanner for event-driven and periodic window protection
  */
 
 #import "wc_window_scanner.h"
 #import "wc_window_bridge.h"
+#import "wc_app_profile.h"
+#import "wc_scan_scheduler.h"
+#import "wc_window_record.h"
+#import "wc_window_event_monitor.h"
+#import "wc_window_policy.h"
+#import "wc_window_protector.h"
+#import "wc_window_snapshot.h"
+#import "../util/configuration_manager.h"
 #import "../util/logger.h"
+#import "../util/wc_cgs_functions.h"
+#import "../util/wc_event_trace.h"
+#import "../util/wc_fleet_metrics.h"
+#import "../util/wc_metrics.h"
+#import "../util/wc_process_watcher.h"
+#import "../util/wc_shared_config.h"
+#import "../util/wc_window_id_set.h"
+#import "../util/wc_window_list.h"
+#import "wc_window_state_cache.h"
+#import <AppKit/AppKit.h>
+
+// Marks the scanner work queue so internal calls already on it run inline
+static const void *const kWCScannerWorkQueueKey = &kWCScannerWorkQueueKey;
+
+// Adaptive scanning backs off to this interval when nothing changes
+static const NSTimeInterval kWCScannerIdleMaximumInterval = 5.0;
+
+// Window list of routine ticks in on-screen mode
+static const CGWindowListOption kWCScannerOnScreenListOptions =
+    kCGWindowListOptionOnScreenOnly | kCGWindowListExcludeDesktopElements;
+
+// On-screen mode still sweeps every window after this many ticks without a trigger
+static const NSUInteger kWCScannerFullSweepTickInterval = 30;
+
+// How often helpers not yet known to protect themselves are checked again
+static const NSTimeInterval kWCScannerSelfProtectionCheckInterval = 2.0;
+
+/**
+ * Protection outcome of a window that needs AppKit work on the main thread
+ */
+typedef struct {
+    WCWindowDrift drift;
+    bool sharingApplied;
+    bool levelApplied;
+} WCMainThreadFollowUp;
+
+@interface WCWindowScanner ()
+- (void)forgetWindowID:(CGWindowID)windowID;
+- (void)displaysDidReconfigure;
+@end
+
+/**
+ * Record pool visitor for windows that disappeared from the window list
+ */
+static void WCScannerWindowDropped(CGWindowID windowID, void *context) {
+    WCEventTraceRecord(WCEventTraceKindWindowDestroyed, windowID, 0, 0, 0);
+    [(__bridge WCWindowScanner *)context forgetWindowID:windowID];
+}
+
+static void WCScannerDisplaysReconfigured(CGDirectDisplayID display, CGDisplayChangeSummaryFlags flags, void *context);
 
 @implementation WCWindowScanner {
+    // All other state is only touched on _workQueue
+    dispatch_queue_t _workQueue;
+
     dispatch_source_t _timer;
     BOOL _isScanning;
     NSTimeInterval _currentInterval;
     BOOL _adaptiveScanning;
-    NSDate *_lastScanTime;
-    NSUInteger _lastWindowCount;
+    uint64_t _lastScanTime;  // WCMetricsNow() at the end of the last scan, 0 before the first
+
+    // Adaptive scheduling from observed churn
+    WCScanScheduler *_scheduler;
+    NSTimeInterval _timerInterval;
+    NSUInteger _changesSinceLastTick;
+    id _activationObserver;
+
+    // On-screen listing with full sweeps on Space, display and activation changes
+    BOOL _onScreenListing;
+    BOOL _fullSweepPending;
+    NSUInteger _ticksSinceFullSweep;
+    id _sweepActivationObserver;
+    id _activeSpaceObserver;
+    BOOL _observingDisplays;
 
     // Variables for debounce handling
     BOOL _debounceEnabled;
     NSTimeInterval _debounceInterval;
     dispatch_source_t _debounceTimer;
     NSMutableArray<WCWindowInfo *> *_pendingProtectionWindows;
+    WCWindowIDSet _pendingProtectionIDs;
 
     // Application-specific configuration
     WCApplicationType _appType;
-    NSArray<WCWindowInfo *> *_knownWindows;
+    WCAppProfile *_profile;
     BOOL _isElectronApp;
     BOOL _isChromeApp;
 
     // Window tracking
-    NSMutableSet<NSNumber *> *_protectedWindowIDs;
-    NSDate *_lastProtectionAttemptTime;
+    WCWindowStateCache *_stateCache;
+    WCWindowPolicy *_policy;
+    WCWindowRecordPool _windowRecords;
+    pid_t *_scanOwnerPIDs;
+    NSUInteger _scanOwnerPIDCapacity;
+    NSUInteger _collectionWorkerCount;
+
+    // Event-driven discovery
+    BOOL _eventDriven;
+    BOOL _scansHelperProcesses;
+    NSMutableSet<NSNumber *> *_knownOwnerPIDs;
+
+    // Helpers that loaded the dylib themselves, left to protect their own windows
+    BOOL _skipsSelfProtectingHelpers;
+    NSMutableSet<NSNumber *> *_selfProtectingPIDs;
+    uint64_t _lastSelfProtectionCheck;
+
+    // Generation of the shared configuration last applied
+    uint64_t _sharedConfigGeneration;
 }
 
 #pragma mark - Lifecycle
@@ -45,67 +137,117 @@
 
 - (instancetype)init {
     if (self = [super init]) {
+        // Discovery, diffing and CGS calls run here so the host's main thread stays free
+        dispatch_queue_attr_t attributes =
+            dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0);
+        _workQueue = dispatch_queue_create("com.windowcontrolinjector.scanner", attributes);
+        dispatch_queue_set_specific(_workQueue, kWCScannerWorkQueueKey, (void *)kWCScannerWorkQueueKey, NULL);
+
         _isScanning = NO;
         _timer = nil;
         _currentInterval = 1.0; // Default interval of 1 second
         _adaptiveScanning = YES; // Enable adaptive scanning by default
-        _lastScanTime = nil;
-        _lastWindowCount = 0;
+        _lastScanTime = 0;
+        _scheduler = [[WCScanScheduler alloc] initWithMinimumInterval:_currentInterval
+                                                      maximumInterval:kWCScannerIdleMaximumInterval];
+        _timerInterval = 0;
+        _changesSinceLastTick = 0;
+        _activationObserver = nil;
+
+        _onScreenListing = NO;
+        _fullSweepPending = NO;
+        _ticksSinceFullSweep = 0;
+        _sweepActivationObserver = nil;
+        _activeSpaceObserver = nil;
+        _observingDisplays = NO;
 
         // Initialize debouncing
         _debounceEnabled = NO;
         _debounceInterval = 0.5; // Default to 500ms
         _debounceTimer = nil;
         _pendingProtectionWindows = [NSMutableArray array];
+        WCWindowIDSetInit(&_pendingProtectionIDs, 0);
 
         // Initialize application-specific settings
         _appType = WCApplicationTypeUnknown;
-        _knownWindows = @[];
+        _profile = [WCAppProfile defaultProfileForApplicationType:WCApplicationTypeUnknown];
         _isElectronApp = NO;
         _isChromeApp = NO;
 
         // Initialize window tracking
-        _protectedWindowIDs = [NSMutableSet set];
-        _lastProtectionAttemptTime = nil;
+        _stateCache = [[WCWindowStateCache alloc] init];
+        _policy = nil;
+        WCWindowRecordPoolInit(&_windowRecords, 64);
+        _scanOwnerPIDs = NULL;
+        _scanOwnerPIDCapacity = 0;
+        _collectionWorkerCount = 0; // Let the snapshot pick the worker count
+
+        // Initialize event-driven discovery
+        _eventDriven = NO;
+        _scansHelperProcesses = YES;
+        _knownOwnerPIDs = [NSMutableSet setWithObject:@([[NSProcessInfo processInfo] processIdentifier])];
+        _skipsSelfProtectingHelpers = NO;
+        _selfProtectingPIDs = [NSMutableSet set];
+        _lastSelfProtectionCheck = 0;
+
+        // Nothing applied yet; any published configuration is newer
+        _sharedConfigGeneration = 0;
     }
     return self;
 }
 
 - (void)dealloc {
-    [self stopScanning];
+    // Blocks on the work queue keep the scanner alive, so nothing can be pending here
+    if (_timer) {
+        dispatch_source_cancel(_timer);
+    }
+    if (_debounceTimer) {
+        dispatch_source_cancel(_debounceTimer);
+    }
+    if (_activationObserver) {
+        [[NSNotificationCenter defaultCenter] removeObserver:_activationObserver];
+    }
+    [self stopObservingFullSweepTriggers];
+    WCWindowRecordPoolDestroy(&_windowRecords);
+    WCWindowIDSetDestroy(&_pendingProtectionIDs);
+    free(_scanOwnerPIDs);
 }
 
-#pragma mark - Scanning Control
+#pragma mark - Work Queue
 
-- (void)startScanningWithInterval:(NSTimeInterval)interval {
-    if (_isScanning) {
-        [self stopScanning];
+- (void)performOnWorkQueue:(dispatch_block_t)block {
+    if (dispatch_get_specific(kWCScannerWorkQueueKey)) {
+        block();
+    } else {
+        dispatch_async(_workQueue, block);
     }
+}
 
-    _currentInterval = interval;
-
-    // Create a timer using GCD
-    _timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+- (void)performOnWorkQueueAndWait:(dispatch_block_t)block {
+    if (dispatch_get_specific(kWCScannerWorkQueueKey)) {
+        block();
+    } else {
+        dispatch_sync(_workQueue, block);
+    }
+}
 
-    uint64_t intervalNanoseconds = (uint64_t)(interval * NSEC_PER_SEC);
-    dispatch_source_set_timer(_timer,
-                             dispatch_time(DISPATCH_TIME_NOW, 0),
-                             intervalNanoseconds,
-                             intervalNanoseconds / 10);
+#pragma mark - Scanning Control
 
-    // Using a strong reference since the project uses manual reference counting
-    typeof(self) selfRef = self;
-    dispatch_source_set_event_handler(_timer, ^{
-        [selfRef scanAndProtectWindows];
+- (void)startScanningWithInterval:(NSTimeInterval)interval {
+    [self performOnWorkQueue:^{
+        [self startPeriodicScanningWithInterval:interval];
+    }];
+}
 
-        // Adjust interval if adaptive scanning is enabled
-        if (selfRef->_adaptiveScanning) {
-            [selfRef adjustScanInterval];
-        }
-    });
+- (void)startPeriodicScanningWithInterval:(NSTimeInterval)interval {
+    if (_isScanning) {
+        [self stopScanningOnWorkQueue];
+    }
 
-    dispatch_resume(_timer);
+    [self startTimerWithInterval:interval];
     _isScanning = YES;
+    [self startObservingActivation];
+    [self startObservingFullSweepTriggers];
 
     [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
                                  category:@"WindowScanner"
@@ -115,14 +257,83 @@
                                    format:@"Started window scanning with interval: %.2f seconds", interval];
 }
 
-- (void)stopScanning {
-    if (!_isScanning) return;
+- (void)startEventDrivenScanningWithSweepInterval:(NSTimeInterval)sweepInterval {
+    // The monitor is driven from the calling thread; only event handling moves to the work queue
+    typeof(self) selfRef = self;
+    WCWindowEventMonitor *monitor = [WCWindowEventMonitor sharedMonitor];
+    BOOL monitoring = [monitor startMonitoringWithHandler:^(WCWindowEventType eventType, CGWindowID windowID) {
+        dispatch_async(selfRef->_workQueue, ^{
+            [selfRef handleWindowEvent:eventType windowID:windowID];
+        });
+    }];
+    BOOL hasWindowServerNotifications = [monitor hasWindowServerNotifications];
 
-    if (_timer) {
-        dispatch_source_cancel(_timer);
-        _timer = nil;
+    [self performOnWorkQueue:^{
+        if (selfRef->_isScanning) {
+            [selfRef stopTimer];
+            selfRef->_isScanning = NO;
+        }
+
+        if (!monitoring) {
+            [[WCLogger sharedLogger] logWithLevel:WCLogLevelWarning
+                                         category:@"WindowScanner"
+                                             file:__FILE__
+                                             line:__LINE__
+                                         function:__PRETTY_FUNCTION__
+                                           format:@"Window events unavailable, falling back to periodic scanning"];
+            selfRef->_eventDriven = NO;
+            [selfRef startPeriodicScanningWithInterval:selfRef->_currentInterval];
+            return;
+        }
+
+        selfRef->_eventDriven = YES;
+
+        // Without window server notifications non-AppKit windows are only found by the sweep,
+        // so keep the regular interval rather than the low-frequency one
+        NSTimeInterval interval = hasWindowServerNotifications ?
+            sweepInterval : MIN(sweepInterval, selfRef->_currentInterval);
+        selfRef->_currentInterval = interval;
+
+        [selfRef startTimerWithInterval:interval];
+        selfRef->_isScanning = YES;
+        [selfRef startObservingFullSweepTriggers];
+
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                     category:@"WindowScanner"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Started event-driven window scanning with sweep interval: %.2f seconds", interval];
+    }];
+}
+
+- (BOOL)isEventDriven {
+    __block BOOL eventDriven = NO;
+    [self performOnWorkQueueAndWait:^{
+        eventDriven = self->_eventDriven;
+    }];
+    return eventDriven;
+}
+
+- (void)stopScanning {
+    WCWindowEventMonitor *monitor = [WCWindowEventMonitor sharedMonitor];
+    if ([monitor isMonitoring]) {
+        [monitor stopMonitoring];
     }
 
+    [self performOnWorkQueue:^{
+        [self stopScanningOnWorkQueue];
+    }];
+}
+
+- (void)stopScanningOnWorkQueue {
+    _eventDriven = NO;
+
+    if (!_isScanning) return;
+
+    [self stopTimer];
+    [self stopObservingActivation];
+    [self stopObservingFullSweepTriggers];
     _isScanning = NO;
 
     [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
@@ -134,40 +345,535 @@
 }
 
 - (BOOL)isScanning {
-    return _isScanning;
+    __block BOOL scanning = NO;
+    [self performOnWorkQueueAndWait:^{
+        scanning = self->_isScanning;
+    }];
+    return scanning;
 }
 
 - (void)setAdaptiveScanning:(BOOL)adaptive {
-    _adaptiveScanning = adaptive;
+    [self performOnWorkQueue:^{
+        self->_adaptiveScanning = adaptive;
 
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
-                                 category:@"WindowScanner"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Adaptive scanning %@", adaptive ? @"enabled" : @"disabled"];
+        // Go back to the configured rate; adaptive scheduling starts from it again
+        [self->_scheduler resetWithMinimumInterval:self->_currentInterval];
+        if (self->_timer && !self->_eventDriven && self->_timerInterval != self->_currentInterval) {
+            [self retargetTimerWithInterval:self->_currentInterval];
+        }
+
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                     category:@"WindowScanner"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Adaptive scanning %@", adaptive ? @"enabled" : @"disabled"];
+    }];
+}
+
+- (void)setScansHelperProcesses:(BOOL)scansHelpers {
+    [self performOnWorkQueue:^{
+        if (self->_scansHelperProcesses == scansHelpers) return;
+
+        self->_scansHelperProcesses = scansHelpers;
+        [self configureHelperProcessWatchingForProfile:self->_profile];
+
+        WCLogInfo(@"WindowScanner", @"Helper process scanning %@", scansHelpers ? @"enabled" : @"disabled");
+    }];
+}
+
+- (void)setSkipsSelfProtectingHelpers:(BOOL)skips {
+    [self performOnWorkQueue:^{
+        if (self->_skipsSelfProtectingHelpers == skips) return;
+
+        self->_skipsSelfProtectingHelpers = skips;
+        [self->_selfProtectingPIDs removeAllObjects];
+        self->_lastSelfProtectionCheck = 0;
+
+        WCLogInfo(@"WindowScanner", @"Skipping self-protecting helpers %@", skips ? @"enabled" : @"disabled");
+    }];
+}
+
+- (void)setWindowPolicy:(WCWindowPolicy *)policy {
+    [self performOnWorkQueue:^{
+        self->_policy = policy.ruleCount > 0 ? policy : nil;
+        self->_fullSweepPending = YES;
+
+        WCLogInfo(@"WindowScanner", @"Using %lu window rules", (unsigned long)policy.ruleCount);
+    }];
+}
+
+- (void)setOnScreenScanning:(BOOL)onScreen {
+    [self performOnWorkQueue:^{
+        if (self->_onScreenListing == onScreen) return;
+
+        self->_onScreenListing = onScreen;
+        self->_fullSweepPending = YES;
+        if (!self->_isScanning) return;
+
+        if (onScreen) {
+            [self startObservingFullSweepTriggers];
+        } else {
+            [self stopObservingFullSweepTriggers];
+        }
+
+        WCLogInfo(@"WindowScanner", @"Routine scans list %@", onScreen ? @"on-screen windows" : @"all windows");
+    }];
+}
+
+- (void)setCollectionWorkerCount:(NSUInteger)workerCount {
+    [self performOnWorkQueue:^{
+        self->_collectionWorkerCount = workerCount;
+
+        WCLogInfo(@"WindowScanner", @"Window list parsed by %@",
+                  workerCount == 0 ? @"automatic workers" : [NSString stringWithFormat:@"up to %lu workers", (unsigned long)workerCount]);
+    }];
 }
 
 - (NSTimeInterval)currentScanInterval {
-    return _currentInterval;
+    __block NSTimeInterval interval = 0;
+    [self performOnWorkQueueAndWait:^{
+        interval = self->_timer ? self->_timerInterval : self->_currentInterval;
+    }];
+    return interval;
+}
+
+- (void)scanNowAndWait {
+    [self performOnWorkQueueAndWait:^{
+        [self scanAndProtectWindows];
+    }];
+}
+
+- (void)reloadSharedConfiguration {
+    [self performOnWorkQueue:^{
+        if ([self applySharedConfigurationIfChanged]) {
+            [self scanAndProtectWindows];
+        }
+    }];
 }
 
 - (void)scanNow {
-    [self scanAndProtectWindows];
+    [self performOnWorkQueue:^{
+        self->_fullSweepPending = YES;
+        [self scanAndProtectWindows];
 
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
-                                 category:@"WindowScanner"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Manual scan triggered"];
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                     category:@"WindowScanner"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Manual scan triggered"];
+    }];
 }
 
 #pragma mark - Internal Methods
 
+- (BOOL)applySharedConfigurationIfChanged {
+    WCSharedConfigValues values;
+    if (!WCSharedConfigCopyIfChanged(&_sharedConfigGeneration, &values)) {
+        return NO;
+    }
+
+    int64_t previousLevel = WCSharedConfigActiveWindowLevel();
+    int32_t previousSharing = WCSharedConfigActiveSharingType();
+    WCSharedConfigActivate(&values);
+
+    // The configuration manager is not thread-safe; everything else reads it on the main thread
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [[WCConfigurationManager sharedManager] applySharedConfigurationValues:&values];
+    });
+
+    BOOL changed = previousLevel != WCSharedConfigActiveWindowLevel() ||
+                   previousSharing != WCSharedConfigActiveSharingType();
+    if (changed) {
+        // Every window has to be brought to the new target, not just the ones that drifted
+        _stateCache.expectedSharingState = WCSharedConfigActiveSharingType();
+        [_stateCache invalidateAppliedProtections];
+        _fullSweepPending = YES;
+    }
+
+    WCLogInfo(@"WindowScanner", @"Shared configuration generation %llu: level %lld, sharing %d%@",
+              _sharedConfigGeneration, WCSharedConfigActiveWindowLevel(), WCSharedConfigActiveSharingType(),
+              changed ? @", reapplying protections" : @"");
+    return changed;
+}
+
+- (void)startTimerWithInterval:(NSTimeInterval)interval {
+    [self stopTimer];
+
+    _currentInterval = interval;
+    _timerInterval = interval;
+    _changesSinceLastTick = 0;
+    [_scheduler resetWithMinimumInterval:interval];
+
+    // Create a timer using GCD
+    _timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _workQueue);
+
+    uint64_t intervalNanoseconds = (uint64_t)(interval * NSEC_PER_SEC);
+    dispatch_source_set_timer(_timer,
+                             dispatch_time(DISPATCH_TIME_NOW, 0),
+                             intervalNanoseconds,
+                             (uint64_t)([_scheduler leewayForInterval:interval] * NSEC_PER_SEC));
+
+    // Using a strong reference since the project uses manual reference counting
+    typeof(self) selfRef = self;
+    dispatch_source_set_event_handler(_timer, ^{
+        [selfRef scanAndProtectWindows];
+
+        // Pick the next interval from what changed; the safety sweep keeps a fixed interval
+        NSUInteger changes = selfRef->_changesSinceLastTick;
+        selfRef->_changesSinceLastTick = 0;
+        if (selfRef->_adaptiveScanning && !selfRef->_eventDriven) {
+            [selfRef scheduleNextTickAfterChanges:changes];
+        }
+    });
+
+    dispatch_resume(_timer);
+}
+
+- (void)stopTimer {
+    if (_timer) {
+        dispatch_source_cancel(_timer);
+        _timer = nil;
+    }
+}
+
+- (void)restartTimerWithInterval:(NSTimeInterval)interval {
+    if (!_isScanning || !_timer) return;
+
+    // Retarget the running source rather than recreating it
+    [_scheduler resetWithMinimumInterval:interval];
+    [self retargetTimerWithInterval:interval];
+}
+
+- (void)retargetTimerWithInterval:(NSTimeInterval)interval {
+    _timerInterval = interval;
+
+    uint64_t intervalNanoseconds = (uint64_t)(interval * NSEC_PER_SEC);
+    dispatch_source_set_timer(_timer,
+                             dispatch_time(DISPATCH_TIME_NOW, (int64_t)intervalNanoseconds),
+                             intervalNanoseconds,
+                             (uint64_t)([_scheduler leewayForInterval:interval] * NSEC_PER_SEC));
+}
+
+- (void)scheduleNextTickAfterChanges:(NSUInteger)changes {
+    NSTimeInterval nextInterval = [_scheduler intervalAfterTickWithChanges:changes];
+    if (nextInterval == _timerInterval) return;
+
+    WCLogDebug(@"WindowScanner", @"Scan interval %.2f -> %.2f seconds after %lu changes",
+               _timerInterval, nextInterval, (unsigned long)changes);
+    [self retargetTimerWithInterval:nextInterval];
+}
+
+- (void)snapToFastScanRate {
+    if (!_timer || !_adaptiveScanning || _eventDriven) return;
+
+    if ([_scheduler noteActivity]) {
+        WCLogDebug(@"WindowScanner", @"Activity detected, scanning every %.2f seconds", _scheduler.currentInterval);
+        [self retargetTimerWithInterval:_scheduler.currentInterval];
+    }
+}
+
+- (void)startObservingActivation {
+    if (_activationObserver) return;
+
+    // A newly active application is the most likely to open or reorder windows
+    typeof(self) selfRef = self;
+    _activationObserver = [[NSNotificationCenter defaultCenter] addObserverForName:NSApplicationDidBecomeActiveNotification
+                                                                            object:nil
+                                                                             queue:nil
+                                                                        usingBlock:^(NSNotification *notification) {
+        [selfRef performOnWorkQueue:^{
+            [selfRef snapToFastScanRate];
+        }];
+    }];
+}
+
+- (void)stopObservingActivation {
+    if (!_activationObserver) return;
+
+    [[NSNotificationCenter defaultCenter] removeObserver:_activationObserver];
+    _activationObserver = nil;
+}
+
+- (void)requestFullSweep {
+    if (_fullSweepPending) return;
+    _fullSweepPending = YES;
+
+    // Runs after whatever is queued, so a burst of triggers costs one sweep
+    typeof(self) selfRef = self;
+    dispatch_async(_workQueue, ^{
+        if (selfRef->_isScanning && selfRef->_fullSweepPending) {
+            [selfRef scanAndProtectWindows];
+        }
+    });
+}
+
+- (void)startObservingFullSweepTriggers {
+    if (!_onScreenListing || _activeSpaceObserver) return;
+
+    // Windows can appear on or leave the screen without being created or ordered
+    typeof(self) selfRef = self;
+    void (^trigger)(NSNotification *) = ^(NSNotification *notification) {
+        [selfRef performOnWorkQueue:^{
+            [selfRef requestFullSweep];
+        }];
+    };
+
+    _activeSpaceObserver = [[[NSWorkspace sharedWorkspace] notificationCenter]
+        addObserverForName:NSWorkspaceActiveSpaceDidChangeNotification object:nil queue:nil usingBlock:trigger];
+    _sweepActivationObserver = [[NSNotificationCenter defaultCenter]
+        addObserverForName:NSApplicationDidBecomeActiveNotification object:nil queue:nil usingBlock:trigger];
+
+    // The scanner is a singleton that outlives the registration, so it is passed unretained
+    _observingDisplays = CGDisplayRegisterReconfigurationCallback(WCScannerDisplaysReconfigured,
+                                                                  (__bridge void *)self) == kCGErrorSuccess;
+}
+
+- (void)stopObservingFullSweepTriggers {
+    if (_activeSpaceObserver) {
+        [[[NSWorkspace sharedWorkspace] notificationCenter] removeObserver:_activeSpaceObserver];
+        _activeSpaceObserver = nil;
+    }
+    if (_sweepActivationObserver) {
+        [[NSNotificationCenter defaultCenter] removeObserver:_sweepActivationObserver];
+        _sweepActivationObserver = nil;
+    }
+    if (_observingDisplays) {
+        CGDisplayRemoveReconfigurationCallback(WCScannerDisplaysReconfigured, (__bridge void *)self);
+        _observingDisplays = NO;
+    }
+}
+
+- (void)displaysDidReconfigure {
+    [self performOnWorkQueue:^{
+        [self requestFullSweep];
+    }];
+}
+
+- (void)configureHelperProcessWatchingForProfile:(WCAppProfile *)profile {
+    WCProcessWatcher *watcher = [WCProcessWatcher sharedWatcher];
+
+    WCProcessSetProvider provider = nil;
+    if (_scansHelperProcesses && profile.helperNamePatterns.count > 0) {
+        provider = ^NSArray<NSNumber *> *(pid_t rootPID) {
+            return [WCWindowBridge getHelperProcessesForMainPID:rootPID profile:profile];
+        };
+    }
+
+    if (!provider) {
+        [watcher stopWatching];
+        watcher.changeHandler = nil;
+        return;
+    }
+
+    typeof(self) selfRef = self;
+    watcher.changeHandlerQueue = _workQueue;
+    watcher.changeHandler = ^(NSArray<NSNumber *> *processIDs) {
+        [selfRef helperProcessesDidChange:processIDs];
+    };
+
+    pid_t currentPID = [[NSProcessInfo processInfo] processIdentifier];
+    if ([watcher startWatchingRootPID:currentPID provider:provider]) {
+        [self replaceKnownHelperPIDs:[watcher currentProcesses]];
+    }
+}
+
+/**
+ * Make the known owners this process plus exactly the given helpers
+ *
+ * Exited helpers are dropped, so the set stays bounded and a PID reused by
+ * an unrelated process no longer passes the window event ownership check.
+ *
+ * @return YES if a helper that was not known before is in the list
+ */
+- (BOOL)replaceKnownHelperPIDs:(NSArray<NSNumber *> *)helperPIDs {
+    NSNumber *currentPID = @([[NSProcessInfo processInfo] processIdentifier]);
+    NSMutableSet<NSNumber *> *owners = [NSMutableSet setWithArray:helperPIDs];
+    [owners addObject:currentPID];
+
+    BOOL added = ![owners isSubsetOfSet:_knownOwnerPIDs];
+    _knownOwnerPIDs = owners;
+    return added;
+}
+
+- (void)helperProcessesDidChange:(NSArray<NSNumber *> *)processIDs {
+    // The watcher reports the complete current set
+    BOOL added = [self replaceKnownHelperPIDs:processIDs];
+
+    // Scan right away when a new helper appears so its windows don't wait for the next tick
+    if (_isScanning && added) {
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                     category:@"WindowScanner"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"New helper processes detected, scanning immediately"];
+        _fullSweepPending = YES;
+        [self scanAndProtectWindows];
+    }
+}
+
+- (NSArray<NSNumber *> *)helperProcessIDsForMainPID:(pid_t)mainPID {
+    WCProcessWatcher *watcher = [WCProcessWatcher sharedWatcher];
+    if ([watcher isWatching]) {
+        return [watcher currentProcesses];
+    }
+
+    return [WCWindowBridge getHelperProcessesForMainPID:mainPID profile:_profile];
+}
+
+/**
+ * Update which helpers protect their own windows
+ *
+ * A helper counts once it publishes its metrics page, which only a process
+ * that loaded the dylib does. Helpers that never do, such as hardened ones
+ * that strip DYLD_INSERT_LIBRARIES, stay covered by this process. Unconfirmed
+ * helpers are checked at most every kWCScannerSelfProtectionCheckInterval.
+ */
+- (void)updateSelfProtectingHelpers:(NSArray<NSNumber *> *)helperPIDs {
+    // Exited helpers are dropped, so a reused PID has to show it loaded the dylib again
+    if (_selfProtectingPIDs.count > 0) {
+        NSSet<NSNumber *> *current = [NSSet setWithArray:helperPIDs];
+        [_selfProtectingPIDs intersectSet:current];
+    }
+
+    uint64_t now = WCMetricsNow();
+    if (_lastSelfProtectionCheck != 0 &&
+        now - _lastSelfProtectionCheck < (uint64_t)(kWCScannerSelfProtectionCheckInterval * NSEC_PER_SEC)) {
+        return;
+    }
+    _lastSelfProtectionCheck = now;
+
+    for (NSNumber *helperPID in helperPIDs) {
+        if ([_selfProtectingPIDs containsObject:helperPID]) continue;
+        if (WCFleetMetricsIsPublishedByProcess([helperPID intValue])) {
+            [_selfProtectingPIDs addObject:helperPID];
+            WCLogInfo(@"WindowScanner", @"Helper %d loaded the injector, leaving its windows to it", [helperPID intValue]);
+        }
+    }
+}
+
+/**
+ * Fill _scanOwnerPIDs with the processes whose windows this tick covers
+ *
+ * Standard applications only cover their own windows; Electron and Chrome
+ * also cover their helper processes unless those protect themselves. The
+ * buffer is reused across ticks.
+ */
+- (NSUInteger)collectScanOwnerPIDs {
+    pid_t currentPID = [[NSProcessInfo processInfo] processIdentifier];
+
+    NSArray<NSNumber *> *helperPIDs = nil;
+    if (_scansHelperProcesses && (_isElectronApp || _isChromeApp)) {
+        helperPIDs = [self helperProcessIDsForMainPID:currentPID];
+
+        // The watcher keeps the known owners current; without it they are pruned on full sweeps
+        if (![[WCProcessWatcher sharedWatcher] isWatching]) {
+            [_knownOwnerPIDs addObjectsFromArray:helperPIDs];
+        }
+        if (_skipsSelfProtectingHelpers) {
+            [self updateSelfProtectingHelpers:helperPIDs];
+        }
+    }
+
+    NSUInteger needed = 1 + helperPIDs.count;
+    if (needed > _scanOwnerPIDCapacity) {
+        NSUInteger capacity = MAX(needed, _scanOwnerPIDCapacity * 2);
+        pid_t *buffer = realloc(_scanOwnerPIDs, capacity * sizeof(pid_t));
+        if (!buffer) {
+            needed = MIN(needed, _scanOwnerPIDCapacity);
+        } else {
+            _scanOwnerPIDs = buffer;
+            _scanOwnerPIDCapacity = capacity;
+        }
+    }
+    if (needed == 0) return 0;
+
+    NSUInteger count = 0;
+    _scanOwnerPIDs[count++] = currentPID;
+    for (NSNumber *helperPID in helperPIDs) {
+        if (count >= needed) break;
+        if ([_selfProtectingPIDs containsObject:helperPID]) continue;
+        _scanOwnerPIDs[count++] = [helperPID intValue];
+    }
+    return count;
+}
+
+/**
+ * Drop all per-window state of a window that was destroyed or left the window list
+ */
+- (void)forgetWindowID:(CGWindowID)windowID {
+    [_stateCache removeWindowID:windowID];
+    [_policy forgetWindowID:windowID];
+    [WCWindowProtector forgetWindowID:windowID];
+
+    if (WCWindowIDSetRemove(&_pendingProtectionIDs, windowID)) {
+        for (NSUInteger i = _pendingProtectionWindows.count; i > 0; i--) {
+            if (_pendingProtectionWindows[i - 1].windowID == windowID) {
+                [_pendingProtectionWindows removeObjectAtIndex:i - 1];
+            }
+        }
+    }
+}
+
+- (void)handleWindowEvent:(WCWindowEventType)eventType windowID:(CGWindowID)windowID {
+    WCMetricsIncrement(WCMetricCounterWindowEvents);
+
+    if (eventType == WCWindowEventTypeDestroyed) {
+        WCEventTraceRecord(WCEventTraceKindWindowDestroyed, windowID, 0, 0, 0);
+        [self forgetWindowID:windowID];
+        return;
+    }
+
+    // A window that is already protected only needs attention when it is ordered in again
+    if (eventType == WCWindowEventTypeCreated && [_stateCache containsWindowID:windowID]) {
+        return;
+    }
+
+    WCWindowInfo *window = [[WCWindowInfo alloc] initWithWindowID:windowID];
+    if (!window) return;
+
+    // Only protect windows owned by this application or its known helper processes
+    if (![_knownOwnerPIDs containsObject:@(window.ownerPID)] ||
+        [_selfProtectingPIDs containsObject:@(window.ownerPID)]) {
+        return;
+    }
+    if (eventType == WCWindowEventTypeCreated) {
+        WCEventTraceRecord(WCEventTraceKindWindowCreated, windowID, window.ownerPID,
+                           (int32_t)window.level, (uint8_t)window.sharingType);
+    }
+
+    WCWindowDrift allowed = _policy ? [_policy protectionsForWindow:window] : WCWindowDriftAll;
+    if (allowed == WCWindowDriftNone) {
+        return;
+    }
+
+    // An ordered-in window may still be protected; only touch it if its state drifted
+    NSArray<NSDictionary *> *windowList = CFBridgingRelease(
+        WCWindowListCopy(kCGWindowListOptionIncludingWindow, windowID));
+    WCWindowDrift drift = [_stateCache reconcileWindowID:windowID observedInfo:windowList.firstObject] & allowed;
+    if (drift == WCWindowDriftNone) {
+        return;
+    }
+    [_stateCache addPendingDrift:drift forWindowID:windowID];
+    _changesSinceLastTick++;
+
+    WCLogDebug(@"WindowScanner", @"Window event %ld for window ID %u, applying protection",
+               (long)eventType, windowID);
+
+    [self applyProtectionToWindows:@[window]];
+}
+
 #pragma mark - Protection Configuration
 
 - (void)setProtectionDebounce:(BOOL)debounceEnabled withInterval:(NSTimeInterval)interval {
+    [self performOnWorkQueue:^{
+        [self setProtectionDebounceOnWorkQueue:debounceEnabled withInterval:interval];
+    }];
+}
+
+- (void)setProtectionDebounceOnWorkQueue:(BOOL)debounceEnabled withInterval:(NSTimeInterval)interval {
     _debounceEnabled = debounceEnabled;
     _debounceInterval = interval;
 
@@ -187,21 +893,41 @@
 
     // Clear any pending operations
     [_pendingProtectionWindows removeAllObjects];
+    WCWindowIDSetClear(&_pendingProtectionIDs);
 }
 
 - (void)configureForApplicationType:(WCApplicationType)appType {
+    [self configureWithApplicationProfile:[WCAppProfile defaultProfileForApplicationType:appType]];
+}
+
+- (void)configureWithApplicationProfile:(WCAppProfile *)profile {
+    if (!profile) return;
+
+    [self performOnWorkQueue:^{
+        [self configureWithApplicationProfileOnWorkQueue:profile];
+    }];
+}
+
+- (void)configureWithApplicationProfileOnWorkQueue:(WCAppProfile *)profile {
+    WCApplicationType appType = profile.applicationType;
     _appType = appType;
+    _profile = profile;
+    WCEventTraceRecord(WCEventTraceKindConfigured, 0, [[NSProcessInfo processInfo] processIdentifier],
+                       (int32_t)appType, 0);
 
     // Reset app-specific flags
     _isElectronApp = NO;
     _isChromeApp = NO;
 
+    // Multi-process apps track their helpers incrementally instead of walking the tree each tick
+    [self configureHelperProcessWatchingForProfile:profile];
+
     switch (appType) {
         case WCApplicationTypeElectron:
             // Use advanced multi-process handling for Electron apps
-            [self enableAdvancedMultiProcessHandling:@{
-                @"debounceInterval": @0.2,
-                @"scanInterval": @0.7,
+            [self enableAdvancedMultiProcessHandlingOnWorkQueue:@{
+                @"debounceInterval": @(profile.debounceInterval),
+                @"scanInterval": @(profile.scanInterval),
                 @"aggressiveScanning": @YES
             }];
 
@@ -217,9 +943,9 @@
             _isChromeApp = YES;
 
             // Use advanced multi-process handling for Chrome with different settings
-            [self enableAdvancedMultiProcessHandling:@{
-                @"debounceInterval": @0.15,
-                @"scanInterval": @0.5,
+            [self enableAdvancedMultiProcessHandlingOnWorkQueue:@{
+                @"debounceInterval": @(profile.debounceInterval),
+                @"scanInterval": @(profile.scanInterval),
                 @"aggressiveScanning": @YES
             }];
 
@@ -233,8 +959,8 @@
 
         default:
             // Default configuration for standard applications
-            _currentInterval = 1.0;
-            [self setProtectionDebounce:NO withInterval:0.5];
+            _currentInterval = profile.scanInterval;
+            [self setProtectionDebounceOnWorkQueue:profile.debounceEnabled withInterval:profile.debounceInterval];
 
             [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
                                          category:@"WindowScanner"
@@ -244,15 +970,20 @@
                                            format:@"Configured for standard app with interval: %.2f seconds", _currentInterval];
 
             // Restart scanning with new configuration
-            if (_isScanning) {
-                [self stopScanning];
-                [self startScanningWithInterval:_currentInterval];
+            if (_isScanning && !_eventDriven) {
+                [self restartTimerWithInterval:_currentInterval];
             }
             break;
     }
 }
 
 - (void)enableAdvancedMultiProcessHandling:(NSDictionary *)options {
+    [self performOnWorkQueue:^{
+        [self enableAdvancedMultiProcessHandlingOnWorkQueue:options];
+    }];
+}
+
+- (void)enableAdvancedMultiProcessHandlingOnWorkQueue:(NSDictionary *)options {
     // Default options
     NSTimeInterval debounceInterval = 0.3;
     BOOL aggressiveScanning = YES;
@@ -277,7 +1008,7 @@
     }
 
     // Enable aggressive debouncing to prevent flickering
-    [self setProtectionDebounce:YES withInterval:debounceInterval];
+    [self setProtectionDebounceOnWorkQueue:YES withInterval:debounceInterval];
 
     // Set scanning interval for multi-process apps
     _currentInterval = scanInterval;
@@ -285,10 +1016,9 @@
     // Mark this app for special handling
     _isElectronApp = YES;
 
-    if (aggressiveScanning && _isScanning) {
+    if (aggressiveScanning && _isScanning && !_eventDriven) {
         // Restart scanning with new settings
-        [self stopScanning];
-        [self startScanningWithInterval:_currentInterval];
+        [self restartTimerWithInterval:_currentInterval];
     }
 
     [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
@@ -304,8 +1034,12 @@
 
 - (void)applyProtectionToWindows:(NSArray<WCWindowInfo *> *)windows {
     if (_debounceEnabled) {
-        // Store windows for delayed protection
-        [_pendingProtectionWindows addObjectsFromArray:windows];
+        // Store windows for delayed protection, once each
+        for (WCWindowInfo *window in windows) {
+            if (WCWindowIDSetInsert(&_pendingProtectionIDs, window.windowID)) {
+                [_pendingProtectionWindows addObject:window];
+            }
+        }
 
         // If debounce timer is already running, let it handle these windows
         if (_debounceTimer) {
@@ -313,7 +1047,7 @@
         }
 
         // Create a new debounce timer
-        _debounceTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+        _debounceTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _workQueue);
 
         uint64_t debounceIntervalNanoseconds = (uint64_t)(_debounceInterval * NSEC_PER_SEC);
         dispatch_source_set_timer(_debounceTimer,
@@ -329,20 +1063,17 @@
         dispatch_resume(_debounceTimer);
     } else {
         // No debounce, apply protection immediately
-        for (WCWindowInfo *window in windows) {
-            [self protectWindowWithoutFlickering:window];
-        }
+        [self protectWindowsWithoutFlickering:windows];
     }
 }
 
 - (void)processDebouncedWindows {
     // Apply protection to all pending windows
-    for (WCWindowInfo *window in _pendingProtectionWindows) {
-        [self protectWindowWithoutFlickering:window];
-    }
+    [self protectWindowsWithoutFlickering:_pendingProtectionWindows];
 
     // Clear pending windows
     [_pendingProtectionWindows removeAllObjects];
+    WCWindowIDSetClear(&_pendingProtectionIDs);
 
     // Clean up timer
     if (_debounceTimer) {
@@ -350,132 +1081,321 @@
         _debounceTimer = nil;
     }
 
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"WindowScanner"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Processed debounced window protection"];
+    WCLogDebug(@"WindowScanner", @"Processed debounced window protection");
 }
 
-- (void)protectWindowWithoutFlickering:(WCWindowInfo *)window {
-    // Check if we've already protected this window recently
-    NSNumber *windowIDNumber = @(window.windowID);
-    BOOL alreadyProtected = [_protectedWindowIDs containsObject:windowIDNumber];
+- (void)protectWindowsWithoutFlickering:(NSArray<WCWindowInfo *> *)windows {
+    NSUInteger windowCount = windows.count;
+    if (windowCount == 0) return;
+
+    // Only reapply the protections that drifted; reapplying unchanged state causes flicker
+    WCWindowDrift *drifts = calloc(windowCount, sizeof(WCWindowDrift));
+    CGSWindowID *sharingIDs = calloc(windowCount, sizeof(CGSWindowID));
+    CGSWindowID *levelIDs = calloc(windowCount, sizeof(CGSWindowID));
+    WCCGSBatchResult *sharingResults = calloc(windowCount, sizeof(WCCGSBatchResult));
+    WCCGSBatchResult *levelResults = calloc(windowCount, sizeof(WCCGSBatchResult));
+    NSUInteger *sharingIndex = calloc(windowCount, sizeof(NSUInteger));
+    NSUInteger *levelIndex = calloc(windowCount, sizeof(NSUInteger));
+
+    if (!drifts || !sharingIDs || !levelIDs || !sharingResults || !levelResults || !sharingIndex || !levelIndex) {
+        free(drifts);
+        free(sharingIDs);
+        free(levelIDs);
+        free(sharingResults);
+        free(levelResults);
+        free(sharingIndex);
+        free(levelIndex);
+        return;
+    }
 
-    // Don't reapply protection too frequently to avoid flickering
-    if (alreadyProtected && _lastProtectionAttemptTime) {
-        NSTimeInterval timeSinceLastProtection = [[NSDate date] timeIntervalSinceDate:_lastProtectionAttemptTime];
+    // Pending lists can name a window more than once; only its first entry is applied
+    WCWindowIDSet seen;
+    WCWindowIDSetInit(&seen, (uint32_t)windowCount);
 
-        // If we protected this window very recently, skip to avoid flickering
-        if (timeSinceLastProtection < 1.0) {
-            return;
+    NSUInteger sharingCount = 0;
+    NSUInteger levelCount = 0;
+
+    for (NSUInteger i = 0; i < windowCount; i++) {
+        CGWindowID windowID = windows[i].windowID;
+        if (!WCWindowIDSetInsert(&seen, windowID)) continue;
+
+        drifts[i] = [_stateCache takePendingDriftForWindowID:windowID];
+        if (drifts[i] & WCWindowDriftSharing) {
+            sharingIndex[i] = sharingCount;
+            sharingIDs[sharingCount++] = windowID;
+        }
+        if (drifts[i] & WCWindowDriftLevel) {
+            levelIndex[i] = levelCount;
+            levelIDs[levelCount++] = windowID;
         }
     }
 
-    // Apply screen recording protection
-    BOOL screenProtectionSuccess = [window makeInvisibleToScreenRecording];
+    WCWindowIDSetDestroy(&seen);
+
+    os_log_t signpostLog = WCMetricsSignpostLog();
+    os_signpost_id_t signpostID = os_signpost_id_generate(signpostLog);
+    os_signpost_interval_begin(signpostLog, signpostID, "ProtectionPass",
+                               "sharing %lu, level %lu", (unsigned long)sharingCount, (unsigned long)levelCount);
+    uint64_t cgsCallsBefore = WCMetricsCounterValue(WCMetricCounterCGSCalls);
+
+    // Targets follow the shared configuration, which defaults to no sharing at the floating level
+    CGSWindowSharingType targetSharing = (CGSWindowSharingType)WCSharedConfigActiveSharingType();
+    NSWindowLevel targetLevel = (NSWindowLevel)WCSharedConfigActiveWindowLevel();
+
+    // One batch per protection kind instead of a CGS round trip per window and operation
+    WCCGSFunctions *cgs = [WCCGSFunctions sharedFunctions];
+    if (sharingCount > 0) {
+        [cgs applyOperations:WCCGSBatchOperationSharingState
+                 toWindowIDs:sharingIDs
+                       count:sharingCount
+                sharingState:targetSharing
+                       level:0
+                     results:sharingResults];
+    }
+    if (levelCount > 0) {
+        // Same level and tags that -[WCWindowInfo setLevel:] ends up applying
+        [cgs applyOperations:WCCGSBatchOperationLevel | WCCGSBatchOperationMissionControlTags
+                 toWindowIDs:levelIDs
+                       count:levelCount
+                sharingState:targetSharing
+                       level:targetLevel
+                     results:levelResults];
+    }
 
-    // Set window to always on top (NSStatusWindowLevel is higher than NSFloatingWindowLevel)
-    // NSStatusWindowLevel is 25, which makes the window appear above almost all other windows
-    BOOL levelSuccess = [window setLevel:NSStatusWindowLevel];
+    // Other threads may issue CGS calls meanwhile, so this is an upper bound for the pass
+    if (sharingCount > 0 || levelCount > 0) {
+        WCMetricsIncrement(WCMetricCounterProtectionPasses);
+        WCMetricsRecord(WCMetricHistogramCGSCallsPerPass,
+                        WCMetricsCounterValue(WCMetricCounterCGSCalls) - cgsCallsBefore);
+    }
+    os_signpost_interval_end(signpostLog, signpostID, "ProtectionPass");
+
+    // AppKit may only be touched on the main thread; collect the windows that still need it
+    pid_t currentPID = [[NSProcessInfo processInfo] processIdentifier];
+    NSMutableArray<WCWindowInfo *> *followUpWindows = [NSMutableArray array];
+    WCMainThreadFollowUp *followUps = NULL;
+
+    for (NSUInteger i = 0; i < windowCount; i++) {
+        WCWindowDrift drift = drifts[i];
+        if (drift == WCWindowDriftNone) continue;
+
+        WCWindowInfo *window = windows[i];
+        BOOL sharingApplied = !(drift & WCWindowDriftSharing) ||
+                              sharingResults[sharingIndex[i]].sharingError == kCGErrorSuccess;
+        // The level batch also sets the Mission Control tags; a failed tag write is retried too
+        BOOL levelApplied = !(drift & WCWindowDriftLevel) ||
+                            WCCGSBatchResultSucceeded(&levelResults[levelIndex[i]]);
+
+        // Record the batch outcome now; the main-thread fallbacks update it when they finish
+        [_stateCache recordAppliedDrift:drift
+                         sharingApplied:sharingApplied
+                           levelApplied:levelApplied
+                            forWindowID:window.windowID];
+
+        // Failed windows need the AppKit fallbacks; windows of this process may be NSWindows
+        // whose collection behavior has to follow a level change
+        BOOL needsAppKit = !sharingApplied || !levelApplied ||
+                           ((drift & WCWindowDriftLevel) && window.ownerPID == currentPID);
+        if (!needsAppKit) continue;
+
+        if (!followUps) {
+            followUps = calloc(windowCount, sizeof(WCMainThreadFollowUp));
+            if (!followUps) break;
+        }
 
-    // Consider the operation successful if either protection method worked
-    BOOL success = screenProtectionSuccess || levelSuccess;
+        WCMainThreadFollowUp *followUp = &followUps[followUpWindows.count];
+        followUp->drift = drift;
+        followUp->sharingApplied = sharingApplied;
+        followUp->levelApplied = levelApplied;
+        [followUpWindows addObject:window];
+    }
 
-    if (success) {
-        // Record that we protected this window
-        [_protectedWindowIDs addObject:windowIDNumber];
+    free(drifts);
+    free(sharingIDs);
+    free(levelIDs);
+    free(sharingResults);
+    free(levelResults);
+    free(sharingIndex);
+    free(levelIndex);
+
+    if (sharingCount > 0 || levelCount > 0) {
+        WCLogDebug(@"WindowProtection", @"Window protection reconciled - Screen: %lu, Level: %lu, AppKit follow-ups: %lu",
+                   (unsigned long)sharingCount, (unsigned long)levelCount,
+                   (unsigned long)followUpWindows.count);
+    }
 
-        [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                     category:@"WindowProtection"
-                                         file:__FILE__
-                                         line:__LINE__
-                                     function:__PRETTY_FUNCTION__
-                                       format:@"Window protection applied - Screen: %@, Level: %@",
-                                              screenProtectionSuccess ? @"Yes" : @"No",
-                                              levelSuccess ? @"Yes" : @"No"];
+    if (followUpWindows.count > 0) {
+        [self applyMainThreadFollowUps:followUps toWindows:followUpWindows];
+    } else {
+        free(followUps);
     }
 }
 
+- (void)applyMainThreadFollowUps:(WCMainThreadFollowUp *)followUps toWindows:(NSArray<WCWindowInfo *> *)windows {
+    typeof(self) selfRef = self;
+
+    // Takes ownership of followUps, which is freed once the outcomes are recorded
+    dispatch_async(dispatch_get_main_queue(), ^{
+        NSUInteger failures = 0;
+        NSWindowLevel targetLevel = (NSWindowLevel)WCSharedConfigActiveWindowLevel();
+        BOOL hidesFromCapture = WCSharedConfigActiveSharingType() == NSWindowSharingNone;
+
+        for (NSUInteger i = 0; i < windows.count; i++) {
+            WCWindowInfo *window = windows[i];
+            WCMainThreadFollowUp *followUp = &followUps[i];
+
+            // Windows the batch could not update go through the per-window path and its AppKit fallback;
+            // there is none for lifting capture protection, so those stay failed until the next pass
+            if ((followUp->drift & WCWindowDriftSharing) && !followUp->sharingApplied && hidesFromCapture) {
+                followUp->sharingApplied = [window makeInvisibleToScreenRecording];
+            }
+
+            // Set window to always on top (NSStatusWindowLevel is higher than NSFloatingWindowLevel)
+            // NSStatusWindowLevel is 25, which makes the window appear above almost all other windows.
+            // A level published through the shared configuration is used as is
+            if (followUp->drift & WCWindowDriftLevel) {
+                if (followUp->levelApplied) {
+                    [window applyMissionControlCollectionBehavior];
+                } else {
+                    followUp->levelApplied = [window setLevel:targetLevel == NSFloatingWindowLevel ?
+                                                              NSStatusWindowLevel : targetLevel];
+                }
+            }
+
+            if (!followUp->sharingApplied || !followUp->levelApplied) {
+                failures++;
+            }
+        }
+
+        dispatch_async(selfRef->_workQueue, ^{
+            for (NSUInteger i = 0; i < windows.count; i++) {
+                [selfRef->_stateCache updateAppliedDrift:followUps[i].drift
+                                          sharingApplied:followUps[i].sharingApplied
+                                            levelApplied:followUps[i].levelApplied
+                                             forWindowID:windows[i].windowID];
+            }
+            free(followUps);
+
+            if (failures > 0) {
+                [[WCLogger sharedLogger] logWithLevel:WCLogLevelWarning
+                                             category:@"WindowProtection"
+                                                 file:__FILE__
+                                                 line:__LINE__
+                                             function:__PRETTY_FUNCTION__
+                                               format:@"Failed to protect %lu of %lu windows after AppKit fallbacks",
+                                                     (unsigned long)failures, (unsigned long)windows.count];
+            }
+        });
+    });
+}
+
 - (void)scanAndProtectWindows {
+    uint64_t scanStart = WCMetricsNow();
+    os_log_t signpostLog = WCMetricsSignpostLog();
+    os_signpost_id_t signpostID = os_signpost_id_generate(signpostLog);
+    os_signpost_interval_begin(signpostLog, signpostID, "ScanTick");
+
     @try {
-        [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                     category:@"WindowScanner"
-                                         file:__FILE__
-                                         line:__LINE__
-                                     function:__PRETTY_FUNCTION__
-                                       format:@"Scanning for windows to protect"];
-
-        // Get the current PID
-        pid_t currentPID = [[NSProcessInfo processInfo] processIdentifier];
-
-        NSArray<WCWindowInfo *> *windows;
-        NSArray<WCWindowInfo *> *newWindows = @[];
-
-        // Use app-specific scanning technique if needed
-        if (_isElectronApp) {
-            // For Electron apps, use specialized window detection
-            windows = [WCWindowBridge getAllWindowsForCurrentApplication];
-
-            // Also check for delayed windows that were created after initial scan
-            if (_knownWindows.count > 0) {
-                newWindows = [WCWindowBridge findDelayedWindowsForPID:currentPID
-                                                      excludingWindows:_knownWindows];
-
-                if (newWindows.count > 0) {
-                    [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
-                                                category:@"WindowScanner"
-                                                    file:__FILE__
-                                                    line:__LINE__
-                                                function:__PRETTY_FUNCTION__
-                                                  format:@"Found %lu new Electron windows to protect",
-                                                        (unsigned long)newWindows.count];
-
-                    // Add new windows to the list
-                    NSMutableArray *allWindows = [NSMutableArray arrayWithArray:windows];
-                    [allWindows addObjectsFromArray:newWindows];
-                    windows = [allWindows copy];
+        WCLogDebug(@"WindowScanner", @"Scanning for windows to protect");
+
+        // One atomic load when nothing was published since the last tick
+        [self applySharedConfigurationIfChanged];
+
+        // Routine on-screen ticks skip the windows of other Spaces and displays; a sweep lists them all
+        BOOL fullSweep = !_onScreenListing || _fullSweepPending ||
+                         _ticksSinceFullSweep >= kWCScannerFullSweepTickInterval;
+
+        // Capture the window list once; the bridge and WCWindowInfo read from it for the rest of the tick
+        os_signpost_interval_begin(signpostLog, signpostID, "CaptureSnapshot");
+        [WCWindowSnapshot captureCurrentSnapshotWithListOptions:fullSweep ? kCGWindowListOptionAll
+                                                                          : kWCScannerOnScreenListOptions];
+        os_signpost_interval_end(signpostLog, signpostID, "CaptureSnapshot");
+
+        // Records of the windows owned by this application are updated in place from the snapshot
+        os_signpost_interval_begin(signpostLog, signpostID, "Enumerate");
+        WCMetricsIncrement(WCMetricCounterWindowEnumerations);
+        NSUInteger ownerCount = [self collectScanOwnerPIDs];
+        NSUInteger newWindowCount = 0;
+
+        WCWindowRecordPoolBeginTick(&_windowRecords);
+        NSUInteger windowCount = [[WCWindowSnapshot currentSnapshot] updateRecords:&_windowRecords
+                                                                       ownedByPIDs:_scanOwnerPIDs
+                                                                             count:ownerCount
+                                                                           workers:_collectionWorkerCount
+                                                                      createdCount:&newWindowCount];
+
+        // Only a full list shows which windows are gone; off-screen windows keep their records until then
+        if (fullSweep) {
+            WCWindowRecordPoolEndTick(&_windowRecords, WCScannerWindowDropped, (__bridge void *)self);
+            _fullSweepPending = NO;
+            _ticksSinceFullSweep = 0;
+
+            // Without the watcher, helpers that exited are only noticed here
+            if (![[WCProcessWatcher sharedWatcher] isWatching]) {
+                [_knownOwnerPIDs removeAllObjects];
+                [_knownOwnerPIDs addObject:@([[NSProcessInfo processInfo] processIdentifier])];
+                for (NSUInteger i = 0; i < ownerCount; i++) {
+                    [_knownOwnerPIDs addObject:@(_scanOwnerPIDs[i])];
                 }
             }
-        } else if (_isChromeApp) {
-            // Chrome needs special process tracking due to its multi-process architecture
-            NSArray<NSNumber *> *rendererPIDs = [WCWindowBridge getChromeRendererProcessesForMainPID:currentPID];
+        } else {
+            _ticksSinceFullSweep++;
+        }
+        os_signpost_interval_end(signpostLog, signpostID, "Enumerate");
 
-            NSMutableArray *allWindows = [NSMutableArray array];
+        if (newWindowCount > 0 && _isElectronApp) {
+            [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                        category:@"WindowScanner"
+                                            file:__FILE__
+                                            line:__LINE__
+                                        function:__PRETTY_FUNCTION__
+                                          format:@"Found %lu new Electron windows to protect",
+                                                (unsigned long)newWindowCount];
+        }
+
+        // Compare each window against its last applied state; steady-state scans issue no set calls
+        os_signpost_interval_begin(signpostLog, signpostID, "Reconcile");
+        NSMutableArray<WCWindowInfo *> *driftedWindows = nil;
+
+        for (uint32_t i = 0; i < _windowRecords.count; i++) {
+            const WCWindowRecord *record = &_windowRecords.records[i];
+            if (record->lastSeenTick != _windowRecords.tick) continue;
 
-            // Get windows for main Chrome process and all renderer processes
-            NSArray<WCWindowInfo *> *mainProcessWindows = [WCWindowBridge getAllWindowsForPID:currentPID];
-            [allWindows addObjectsFromArray:mainProcessWindows];
+            WCWindowDrift drift = [_stateCache reconcileWindowRecord:record];
+            if (drift == WCWindowDriftNone) continue;
 
-            // Get windows for each renderer process
-            for (NSNumber *rendererPID in rendererPIDs) {
-                NSArray<WCWindowInfo *> *rendererWindows = [WCWindowBridge getAllWindowsForPID:[rendererPID intValue]];
-                [allWindows addObjectsFromArray:rendererWindows];
+            // Windows the rules leave alone are answered from the policy's cache
+            if (_policy) {
+                drift &= [_policy protectionsForWindowRecord:record];
+                if (drift == WCWindowDriftNone) continue;
             }
 
-            windows = [allWindows copy];
-        } else {
-            // Standard window scanning for normal apps
-            windows = [WCWindowBridge getAllWindowsForCurrentApplication];
+            // Only windows that need protecting get an object
+            WCWindowInfo *window = [[WCWindowInfo alloc] initWithWindowRecord:record];
+            if (!window) continue;
+
+            [_stateCache addPendingDrift:drift forWindowID:record->windowID];
+            if (!driftedWindows) {
+                driftedWindows = [NSMutableArray array];
+            }
+            [driftedWindows addObject:window];
         }
+        os_signpost_interval_end(signpostLog, signpostID, "Reconcile",
+                                 "%lu windows, %lu drifted",
+                                 (unsigned long)windowCount, (unsigned long)driftedWindows.count);
 
-        _lastWindowCount = windows.count;
-        _knownWindows = windows; // Update known windows list
+        _changesSinceLastTick += driftedWindows.count;
 
         // Use better protection mechanism to reduce flickering
-        [self applyProtectionToWindows:windows];
+        if (driftedWindows) {
+            [self applyProtectionToWindows:driftedWindows];
+        }
 
-        _lastScanTime = [NSDate date];
-        _lastProtectionAttemptTime = [NSDate date];
+        _lastScanTime = WCMetricsNow();
 
-        [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                     category:@"WindowScanner"
-                                         file:__FILE__
-                                         line:__LINE__
-                                     function:__PRETTY_FUNCTION__
-                                       format:@"Scan completed, found %lu windows (including %lu new windows)",
-                                             (unsigned long)windows.count, (unsigned long)newWindows.count];
+        WCLogDebug(@"WindowScanner", @"Scan completed, found %lu windows (including %lu new windows), %lu need protection",
+                   (unsigned long)windowCount, (unsigned long)newWindowCount,
+                   (unsigned long)driftedWindows.count);
     } @catch (NSException *exception) {
         [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
                                      category:@"WindowScanner"
@@ -483,53 +1403,21 @@
                                          line:__LINE__
                                      function:__PRETTY_FUNCTION__
                                        format:@"Exception during window scanning: %@", exception.reason];
-    }
-}
-
-- (void)adjustScanInterval {
-    // Skip if we haven't scanned yet
-    if (!_lastScanTime) return;
+    } @finally {
+        [WCWindowSnapshot invalidateCurrentSnapshot];
 
-    // Calculate ideal scan interval based on window count
-    NSTimeInterval newInterval;
-
-    if (_lastWindowCount == 0) {
-        // No windows, can scan less frequently
-        newInterval = 2.0;
-    } else if (_lastWindowCount < 5) {
-        // Few windows, standard scanning
-        newInterval = 1.0;
-    } else if (_lastWindowCount < 15) {
-        // More windows, increase frequency
-        newInterval = 0.7;
-    } else {
-        // Many windows, scan more frequently
-        newInterval = 0.5;
+        WCMetricsIncrement(WCMetricCounterScanTicks);
+        WCMetricsRecord(WCMetricHistogramScanDuration, WCMetricsNow() - scanStart);
+        os_signpost_interval_end(signpostLog, signpostID, "ScanTick");
     }
+}
 
-    // Don't adjust if the change is minor
-    if (fabs(newInterval - _currentInterval) < 0.2) return;
-
-    // Only log if we're actually changing the interval
-    if (newInterval != _currentInterval) {
-        [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
-                                     category:@"WindowScanner"
-                                         file:__FILE__
-                                         line:__LINE__
-                                     function:__PRETTY_FUNCTION__
-                                       format:@"Adjusting scan interval from %.2f to %.2f seconds based on %lu windows",
-                                             _currentInterval, newInterval, (unsigned long)_lastWindowCount];
-    }
+@end
 
-    // Update the interval if it changed
-    if (newInterval != _currentInterval) {
-        // Save the new interval
-        _currentInterval = newInterval;
+static void WCScannerDisplaysReconfigured(CGDirectDisplayID display, CGDisplayChangeSummaryFlags flags, void *context) {
+    (void)display;
 
-        // Restart timer with new interval
-        [self stopScanning];
-        [self startScanningWithInterval:newInterval];
-    }
+    // Called once per display before and after a change; only the settled layout matters
+    if (flags & kCGDisplayBeginConfigurationFlag) return;
+    [(__bridge WCWindowScanner *)context displaysDidReconfigure];
 }
-
-@end
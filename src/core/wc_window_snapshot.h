@@ -0,0 +1,175 @@
+/**
+ * @file wc_window_snapshot.h
+ * @brief Shared window list snapshot for WindowControlInjector
+ *
+ * This file defines a class that captures the system-wide window list once
+ * and indexes it by owner PID and window ID on first lookup, so that a scan
+ * tick needs a single WindowServer round-trip no matter how many processes
+ * and windows it inspects.
+ */
+
+#ifndef WC_WINDOW_SNAPSHOT_H
+#define WC_WINDOW_SNAPSHOT_H
+
+#import <Foundation/Foundation.h>
+#import <AppKit/AppKit.h>
+#import "wc_window_record.h"
+
+/**
+ * @brief Immutable, indexed copy of the window list
+ *
+ * A snapshot can be installed as the current snapshot for the duration of a
+ * scan tick. While one is installed, WCWindowBridge and WCWindowInfo read
+ * window information from it instead of querying the WindowServer.
+ * The current snapshot is installed per thread, so it is only visible to
+ * code running on the thread that captured it.
+ */
+@interface WCWindowSnapshot : NSObject
+
+/**
+ * @brief Time at which the window list was captured
+ */
+@property (nonatomic, readonly, nonnull) NSDate *captureTime;
+
+/**
+ * @brief Number of windows in the snapshot
+ */
+@property (nonatomic, readonly) NSUInteger windowCount;
+
+/**
+ * @brief Whether the snapshot lists every window in the session
+ *
+ * NO for on-screen snapshots, which leave out windows on other Spaces,
+ * minimized windows and windows that are ordered out.
+ */
+@property (nonatomic, readonly, getter=isComplete) BOOL complete;
+
+/**
+ * @brief Capture a new snapshot of all windows in the session
+ *
+ * @return A new snapshot
+ */
+- (nonnull instancetype)init;
+
+/**
+ * @brief Capture a new snapshot of the windows selected by list options
+ *
+ * @param listOptions kCGWindowListOptionAll, or kCGWindowListOptionOnScreenOnly
+ *        optionally combined with kCGWindowListExcludeDesktopElements
+ * @return A new snapshot
+ */
+- (nonnull instancetype)initWithListOptions:(CGWindowListOption)listOptions;
+
+/**
+ * @brief Capture a snapshot and install it as the current snapshot for this thread
+ *
+ * @return The newly installed snapshot
+ */
++ (nonnull instancetype)captureCurrentSnapshot;
+
+/**
+ * @brief Capture a snapshot with list options and install it as the current snapshot
+ *
+ * @param listOptions Options passed to CGWindowListCopyWindowInfo
+ * @return The newly installed snapshot
+ */
++ (nonnull instancetype)captureCurrentSnapshotWithListOptions:(CGWindowListOption)listOptions;
+
+/**
+ * @brief Remove the current snapshot
+ *
+ * Readers go back to querying the WindowServer directly.
+ */
++ (void)invalidateCurrentSnapshot;
+
+/**
+ * @brief Get the current snapshot
+ *
+ * @return The installed snapshot, or nil if none is installed
+ */
++ (nullable instancetype)currentSnapshot;
+
+/**
+ * @brief Get the current snapshot, or capture an uninstalled one
+ *
+ * Useful for callers that need the whole window list and may run
+ * outside a scan tick. An installed on-screen snapshot is not used,
+ * since it leaves windows out.
+ *
+ * @return The current complete snapshot or a freshly captured one
+ */
++ (nonnull instancetype)activeSnapshot;
+
+/**
+ * @brief Get the window list entry for a window
+ *
+ * For incomplete snapshots nil does not mean the window is gone; callers
+ * that need a definite answer query the WindowServer instead.
+ *
+ * @param windowID The window ID to look up
+ * @return The CGWindowList dictionary, or nil if the window is not in the snapshot
+ */
+- (nullable NSDictionary *)windowInfoForWindowID:(CGWindowID)windowID;
+
+/**
+ * @brief Get all window list entries owned by a process
+ *
+ * @param pid The owner process ID
+ * @return Array of CGWindowList dictionaries, empty if the process has no windows
+ */
+- (nonnull NSArray<NSDictionary *> *)windowInfosForPID:(pid_t)pid;
+
+/**
+ * @brief Update pooled records from the windows owned by a set of processes
+ *
+ * Walks the captured list once and reads each entry through CoreFoundation,
+ * so no objects are created per window and the lookup indexes are not built.
+ * The caller begins and ends the pool's tick.
+ *
+ * @param pool The records to update
+ * @param ownerPIDs Processes whose windows to include
+ * @param ownerCount Number of entries in ownerPIDs
+ * @param createdCount Receives the number of records added, may be NULL
+ * @return Number of records updated or added
+ */
+- (NSUInteger)updateRecords:(nonnull WCWindowRecordPool *)pool
+                ownedByPIDs:(nonnull const pid_t *)ownerPIDs
+                      count:(NSUInteger)ownerCount
+               createdCount:(nullable NSUInteger *)createdCount;
+
+/**
+ * @brief Update pooled records, parsing the list on several workers
+ *
+ * Long lists are split into chunks that up to workerCount workers claim
+ * from a shared counter. Each chunk is parsed into its own slice of a
+ * scratch buffer, so the workers share no mutable state, and the slices
+ * are merged into the pool in list order on the calling thread. Short
+ * lists and a workerCount of 1 are parsed on the calling thread.
+ *
+ * @param pool The records to update
+ * @param ownerPIDs Processes whose windows to include
+ * @param ownerCount Number of entries in ownerPIDs
+ * @param workerCount Maximum number of concurrent workers, 0 to pick one from the active processors
+ * @param createdCount Receives the number of records added, may be NULL
+ * @return Number of records updated or added
+ */
+- (NSUInteger)updateRecords:(nonnull WCWindowRecordPool *)pool
+                ownedByPIDs:(nonnull const pid_t *)ownerPIDs
+                      count:(NSUInteger)ownerCount
+                    workers:(NSUInteger)workerCount
+               createdCount:(nullable NSUInteger *)createdCount;
+
+/**
+ * @brief Get the AppKit window for a window ID
+ *
+ * The AppKit index is built on first use from [NSApp windows]. AppKit is
+ * only consulted on the main thread; other threads always get nil.
+ *
+ * @param windowID The window ID to look up
+ * @return The NSWindow, or nil if the window is not an AppKit window of this process
+ */
+- (nullable NSWindow *)nsWindowForWindowID:(CGWindowID)windowID;
+
+@end
+
+#endif /* WC_WINDOW_SNAPSHOT_H */
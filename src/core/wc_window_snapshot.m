@@ -0,0 +1,368 @@
+/**
+ * @file wc_window_snapshot.m
+ * @brief Implementation of the shared window list snapshot
+ */
+
+#import "wc_window_snapshot.h"
+#import "../util/logger.h"
+#import "../util/wc_event_trace.h"
+#import "../util/wc_window_list.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Thread dictionary key of the snapshot installed for the current scan tick
+static NSString *const kWCCurrentSnapshotKey = @"WCCurrentWindowSnapshot";
+
+// Lists shorter than this are parsed on the calling thread; fanning out would cost more than it saves
+static const NSUInteger kWCSnapshotParallelMinimumEntries = 256;
+
+// Entries a worker parses per claim
+static const NSUInteger kWCSnapshotChunkSize = 64;
+
+// Workers used when the caller leaves the count to the snapshot; more only contend for the list
+static const NSUInteger kWCSnapshotAutomaticWorkers = 4;
+
+@implementation WCWindowSnapshot {
+    NSDate *_captureTime;
+    BOOL _complete;
+    NSArray<NSDictionary *> *_windowList;
+    NSDictionary<NSNumber *, NSDictionary *> *_windowsByID;
+    NSDictionary<NSNumber *, NSArray<NSDictionary *> *> *_windowsByPID;
+    NSDictionary<NSNumber *, NSWindow *> *_nsWindowsByID;
+}
+
+#pragma mark - Initialization
+
+- (instancetype)init {
+    return [self initWithListOptions:kCGWindowListOptionAll];
+}
+
+- (instancetype)initWithListOptions:(CGWindowListOption)listOptions {
+    if (self = [super init]) {
+        _captureTime = [NSDate date];
+        _complete = listOptions == kCGWindowListOptionAll;
+        _windowsByID = nil;
+        _windowsByPID = nil;
+        _nsWindowsByID = nil;
+
+        // Indexes are built on first lookup; record updates walk the list directly
+        _windowList = CFBridgingRelease(WCWindowListCopy(listOptions, kCGNullWindowID));
+        if (!_windowList) _windowList = @[];
+
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
+                                     category:@"WindowSnapshot"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Captured %@ window snapshot with %lu windows",
+                                             _complete ? @"full" : @"on-screen",
+                                             (unsigned long)_windowList.count];
+    }
+    return self;
+}
+
+- (void)buildIndexesIfNeeded {
+    if (_windowsByID) return;
+
+    NSMutableDictionary<NSNumber *, NSDictionary *> *windowsByID =
+        [NSMutableDictionary dictionaryWithCapacity:_windowList.count];
+    NSMutableDictionary<NSNumber *, NSMutableArray<NSDictionary *> *> *windowsByPID =
+        [NSMutableDictionary dictionary];
+
+    for (NSDictionary *windowInfo in _windowList) {
+        NSNumber *windowID = windowInfo[(NSString *)kCGWindowNumber];
+        NSNumber *ownerPID = windowInfo[(NSString *)kCGWindowOwnerPID];
+        if (!windowID) continue;
+
+        windowsByID[windowID] = windowInfo;
+
+        if (ownerPID) {
+            NSMutableArray<NSDictionary *> *pidWindows = windowsByPID[ownerPID];
+            if (!pidWindows) {
+                pidWindows = [NSMutableArray array];
+                windowsByPID[ownerPID] = pidWindows;
+            }
+            [pidWindows addObject:windowInfo];
+        }
+    }
+
+    _windowsByID = [windowsByID copy];
+    _windowsByPID = [windowsByPID copy];
+}
+
+#pragma mark - Current Snapshot
+
+// The snapshot is per thread so a tick on the scanner queue never leaks into main-thread callers
++ (instancetype)captureCurrentSnapshot {
+    return [self captureCurrentSnapshotWithListOptions:kCGWindowListOptionAll];
+}
+
++ (instancetype)captureCurrentSnapshotWithListOptions:(CGWindowListOption)listOptions {
+    WCWindowSnapshot *snapshot = [[self alloc] initWithListOptions:listOptions];
+    [NSThread currentThread].threadDictionary[kWCCurrentSnapshotKey] = snapshot;
+    return snapshot;
+}
+
++ (void)invalidateCurrentSnapshot {
+    [[NSThread currentThread].threadDictionary removeObjectForKey:kWCCurrentSnapshotKey];
+}
+
++ (instancetype)currentSnapshot {
+    return [NSThread currentThread].threadDictionary[kWCCurrentSnapshotKey];
+}
+
++ (instancetype)activeSnapshot {
+    WCWindowSnapshot *snapshot = [self currentSnapshot];
+    return snapshot.isComplete ? snapshot : [[self alloc] init];
+}
+
+#pragma mark - Queries
+
+- (NSDate *)captureTime {
+    return _captureTime;
+}
+
+- (BOOL)isComplete {
+    return _complete;
+}
+
+- (NSUInteger)windowCount {
+    return _windowList.count;
+}
+
+- (NSDictionary *)windowInfoForWindowID:(CGWindowID)windowID {
+    [self buildIndexesIfNeeded];
+    return _windowsByID[@(windowID)];
+}
+
+- (NSArray<NSDictionary *> *)windowInfosForPID:(pid_t)pid {
+    [self buildIndexesIfNeeded];
+    NSArray<NSDictionary *> *windows = _windowsByPID[@(pid)];
+    return windows ? windows : @[];
+}
+
+- (NSUInteger)updateRecords:(WCWindowRecordPool *)pool
+                ownedByPIDs:(const pid_t *)ownerPIDs
+                      count:(NSUInteger)ownerCount
+               createdCount:(NSUInteger *)createdCount {
+    return [self updateRecords:pool ownedByPIDs:ownerPIDs count:ownerCount workers:1 createdCount:createdCount];
+}
+
+static int WCSnapshotComparePIDs(const void *first, const void *second) {
+    pid_t a = *(const pid_t *)first;
+    pid_t b = *(const pid_t *)second;
+    return (a > b) - (a < b);
+}
+
+static BOOL WCSnapshotIsOwnedPID(const pid_t *sortedPIDs, NSUInteger count, pid_t pid) {
+    NSUInteger low = 0;
+    NSUInteger high = count;
+    while (low < high) {
+        NSUInteger middle = low + (high - low) / 2;
+        if (sortedPIDs[middle] == pid) return YES;
+        if (sortedPIDs[middle] < pid) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return NO;
+}
+
+/**
+ * Parse one window list entry into a record if one of the processes owns it
+ *
+ * Reads through CoreFoundation only, so it is safe on any thread.
+ */
+static BOOL WCSnapshotParseEntry(CFDictionaryRef entry, const pid_t *sortedPIDs, NSUInteger ownerCount,
+                                 WCWindowRecord *record) {
+    int ownerPID = 0;
+    CFNumberRef ownerNumber = CFDictionaryGetValue(entry, kCGWindowOwnerPID);
+    if (!ownerNumber || !CFNumberGetValue(ownerNumber, kCFNumberIntType, &ownerPID)) return NO;
+    if (!WCSnapshotIsOwnedPID(sortedPIDs, ownerCount, ownerPID)) return NO;
+
+    int64_t windowNumber = 0;
+    CFNumberRef windowIDNumber = CFDictionaryGetValue(entry, kCGWindowNumber);
+    if (!windowIDNumber || !CFNumberGetValue(windowIDNumber, kCFNumberSInt64Type, &windowNumber)) return NO;
+
+    record->windowID = (CGWindowID)windowNumber;
+    record->ownerPID = ownerPID;
+    record->flags = 0;
+    record->level = 0;
+    record->sharingType = 0;
+
+    CFBooleanRef onScreen = CFDictionaryGetValue(entry, kCGWindowIsOnscreen);
+    if (onScreen && CFBooleanGetValue(onScreen)) {
+        record->flags |= WCWindowRecordFlagOnScreen;
+    }
+
+    int32_t value = 0;
+    CFNumberRef layer = CFDictionaryGetValue(entry, kCGWindowLayer);
+    if (layer && CFNumberGetValue(layer, kCFNumberSInt32Type, &value)) {
+        record->level = value;
+        record->flags |= WCWindowRecordFlagHasLevel;
+    }
+
+    CFNumberRef sharingState = CFDictionaryGetValue(entry, kCGWindowSharingState);
+    if (sharingState && CFNumberGetValue(sharingState, kCFNumberSInt32Type, &value)) {
+        record->sharingType = value;
+        record->flags |= WCWindowRecordFlagHasSharingState;
+    }
+
+    CFDictionaryRef bounds = CFDictionaryGetValue(entry, kCGWindowBounds);
+    if (!bounds || !CGRectMakeWithDictionaryRepresentation(bounds, &record->frame)) {
+        record->frame = CGRectZero;
+    }
+    return YES;
+}
+
+/**
+ * Record what changed about a window since the previous tick in the event trace
+ */
+static void WCSnapshotTraceRecord(const WCWindowRecord *previous, const WCWindowRecord *parsed, bool isNew) {
+    if (isNew) {
+        // A window whose sharing state isn't listed has the window server's default
+        int32_t level = (parsed->flags & WCWindowRecordFlagHasLevel) ? parsed->level : 0;
+        int32_t sharingType = (parsed->flags & WCWindowRecordFlagHasSharingState) ?
+                              parsed->sharingType : kCGWindowSharingReadOnly;
+        WCEventTraceRecord(WCEventTraceKindWindowCreated, parsed->windowID, parsed->ownerPID,
+                           level, (uint8_t)sharingType);
+        return;
+    }
+    if ((parsed->flags & WCWindowRecordFlagHasLevel) && parsed->level != previous->level) {
+        WCEventTraceRecord(WCEventTraceKindWindowLevel, parsed->windowID, parsed->ownerPID, parsed->level, 0);
+    }
+    if ((parsed->flags & WCWindowRecordFlagHasSharingState) && parsed->sharingType != previous->sharingType) {
+        WCEventTraceRecord(WCEventTraceKindWindowSharing, parsed->windowID, parsed->ownerPID, parsed->sharingType, 0);
+    }
+}
+
+/**
+ * Copy a parsed record into the pool, keeping the pool's tick bookkeeping
+ */
+static void WCSnapshotMergeRecord(WCWindowRecordPool *pool, const WCWindowRecord *parsed,
+                                  NSUInteger *updated, NSUInteger *created) {
+    bool isNew = false;
+    WCWindowRecord *record = WCWindowRecordPoolUpdate(pool, parsed->windowID, &isNew);
+    if (!record) return;
+
+    if (WCEventTraceIsRecording()) {
+        WCSnapshotTraceRecord(record, parsed, isNew);
+    }
+
+    record->ownerPID = parsed->ownerPID;
+    record->flags = parsed->flags;
+    if (parsed->flags & WCWindowRecordFlagHasLevel) record->level = parsed->level;
+    if (parsed->flags & WCWindowRecordFlagHasSharingState) record->sharingType = parsed->sharingType;
+    record->frame = parsed->frame;
+
+    (*updated)++;
+    if (isNew) (*created)++;
+}
+
+- (NSUInteger)updateRecords:(WCWindowRecordPool *)pool
+                ownedByPIDs:(const pid_t *)ownerPIDs
+                      count:(NSUInteger)ownerCount
+                    workers:(NSUInteger)workerCount
+               createdCount:(NSUInteger *)createdCount {
+    NSUInteger updated = 0;
+    NSUInteger created = 0;
+    if (createdCount) *createdCount = 0;
+    if (ownerCount == 0) return 0;
+
+    // Browsers have dozens of owners, so membership is a binary search rather than a scan per entry
+    pid_t stackPIDs[64];
+    pid_t *sortedPIDs = ownerCount <= 64 ? stackPIDs : malloc(ownerCount * sizeof(pid_t));
+    if (!sortedPIDs) return 0;
+    memcpy(sortedPIDs, ownerPIDs, ownerCount * sizeof(pid_t));
+    qsort(sortedPIDs, ownerCount, sizeof(pid_t), WCSnapshotComparePIDs);
+
+    CFArrayRef list = (__bridge CFArrayRef)_windowList;
+    NSUInteger entryCount = (NSUInteger)CFArrayGetCount(list);
+    NSUInteger chunkCount = (entryCount + kWCSnapshotChunkSize - 1) / kWCSnapshotChunkSize;
+
+    if (workerCount == 0) {
+        workerCount = MIN([[NSProcessInfo processInfo] activeProcessorCount], kWCSnapshotAutomaticWorkers);
+    }
+    workerCount = MIN(workerCount, chunkCount);
+
+    // Each chunk owns a slice of the scratch buffer, so workers never write to the same memory
+    WCWindowRecord *parsed = NULL;
+    NSUInteger *chunkCounts = NULL;
+    if (workerCount > 1 && entryCount >= kWCSnapshotParallelMinimumEntries) {
+        parsed = malloc(entryCount * sizeof(WCWindowRecord));
+        chunkCounts = calloc(chunkCount, sizeof(NSUInteger));
+    }
+
+    if (parsed && chunkCounts) {
+        _Atomic(NSUInteger) nextChunk = 0;
+        _Atomic(NSUInteger) *nextChunkSlot = &nextChunk;
+        const pid_t *owners = sortedPIDs;
+
+        // Idle workers claim the next chunk, so one slow chunk doesn't hold the others back
+        dispatch_apply(workerCount, DISPATCH_APPLY_AUTO, ^(size_t worker) {
+            for (;;) {
+                NSUInteger chunk = atomic_fetch_add_explicit(nextChunkSlot, 1, memory_order_relaxed);
+                if (chunk >= chunkCount) break;
+
+                NSUInteger first = chunk * kWCSnapshotChunkSize;
+                NSUInteger last = MIN(first + kWCSnapshotChunkSize, entryCount);
+                WCWindowRecord *slice = &parsed[first];
+                NSUInteger count = 0;
+                for (NSUInteger i = first; i < last; i++) {
+                    CFDictionaryRef entry = CFArrayGetValueAtIndex(list, (CFIndex)i);
+                    if (WCSnapshotParseEntry(entry, owners, ownerCount, &slice[count])) count++;
+                }
+                chunkCounts[chunk] = count;
+            }
+        });
+
+        // dispatch_apply returns after every worker finished, so the slices are complete
+        for (NSUInteger chunk = 0; chunk < chunkCount; chunk++) {
+            const WCWindowRecord *slice = &parsed[chunk * kWCSnapshotChunkSize];
+            for (NSUInteger i = 0; i < chunkCounts[chunk]; i++) {
+                WCSnapshotMergeRecord(pool, &slice[i], &updated, &created);
+            }
+        }
+    } else {
+        for (NSUInteger i = 0; i < entryCount; i++) {
+            WCWindowRecord record;
+            if (WCSnapshotParseEntry(CFArrayGetValueAtIndex(list, (CFIndex)i), sortedPIDs, ownerCount, &record)) {
+                WCSnapshotMergeRecord(pool, &record, &updated, &created);
+            }
+        }
+    }
+
+    free(parsed);
+    free(chunkCounts);
+    if (sortedPIDs != stackPIDs) free(sortedPIDs);
+
+    if (createdCount) *createdCount = created;
+    return updated;
+}
+
+- (NSWindow *)nsWindowForWindowID:(CGWindowID)windowID {
+    // [NSApp windows] may only be read on the main thread
+    if (![NSThread isMainThread]) {
+        return nil;
+    }
+
+    if (!_nsWindowsByID) {
+        NSArray<NSWindow *> *appKitWindows = [NSApp windows];
+        NSMutableDictionary<NSNumber *, NSWindow *> *nsWindowsByID =
+            [NSMutableDictionary dictionaryWithCapacity:appKitWindows.count];
+
+        for (NSWindow *window in appKitWindows) {
+            if (window.windowNumber > 0) {
+                nsWindowsByID[@((CGWindowID)window.windowNumber)] = window;
+            }
+        }
+
+        _nsWindowsByID = [nsWindowsByID copy];
+    }
+
+    return _nsWindowsByID[@(windowID)];
+}
+
+@end
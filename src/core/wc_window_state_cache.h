@@ -0,0 +1,153 @@
+/**
+ * @file wc_window_state_cache.h
+ * @brief Per-window protection state cache for WindowControlInjector
+ *
+ * This file defines a cache that remembers which protections were last
+ * applied to each window and compares that against the state observed in
+ * the window list, so scans only issue WindowServer set calls for windows
+ * whose sharing state or level actually drifted.
+ */
+
+#ifndef WC_WINDOW_STATE_CACHE_H
+#define WC_WINDOW_STATE_CACHE_H
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+#import "wc_window_record.h"
+
+/**
+ * @brief Protections that need to be (re)applied to a window
+ */
+typedef NS_OPTIONS(NSUInteger, WCWindowDrift) {
+    WCWindowDriftNone    = 0,
+    WCWindowDriftSharing = 1 << 0,  // Sharing state is not kCGWindowSharingNone
+    WCWindowDriftLevel   = 1 << 1,  // Level or Mission Control tags need reapplying
+    WCWindowDriftAll     = WCWindowDriftSharing | WCWindowDriftLevel
+};
+
+/**
+ * @brief Cache of the protection state last applied to each window
+ *
+ * The level a window ends up at after protection depends on whether it is
+ * an AppKit window, so instead of a fixed target the cache records the
+ * level observed on the first scan after protection and reports drift when
+ * it changes. Tags cannot be read back cheaply and are tracked as applied.
+ * The time from a window's first pending drift to its first full protection
+ * is recorded as the protection latency metric.
+ * The cache is not thread-safe and is owned by WCWindowScanner.
+ */
+@interface WCWindowStateCache : NSObject
+
+/**
+ * @brief Number of windows with cached state
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ * @brief Sharing state protected windows should report, as a CGWindowSharingType
+ *
+ * Defaults to kCGWindowSharingNone; changed when capture protection is
+ * toggled through the shared configuration.
+ */
+@property (nonatomic, assign) int expectedSharingState;
+
+/**
+ * @brief Compare observed state against the last applied state
+ *
+ * Also records the observation as the level baseline when the window was
+ * protected since the previous observation.
+ *
+ * @param windowID The window to check
+ * @param windowInfo The window's CGWindowList entry, or nil if not observed
+ * @return The protections that need to be applied
+ */
+- (WCWindowDrift)reconcileWindowID:(CGWindowID)windowID observedInfo:(nullable NSDictionary *)windowInfo;
+
+/**
+ * @brief Compare a pooled window record against the last applied state
+ *
+ * Same as reconcileWindowID:observedInfo: without boxing the observed values.
+ *
+ * @param record The window's record from the current tick
+ * @return The protections that need to be applied
+ */
+- (WCWindowDrift)reconcileWindowRecord:(nonnull const WCWindowRecord *)record;
+
+/**
+ * @brief Remember protections that are scheduled but not yet applied
+ *
+ * @param drift The protections to apply
+ * @param windowID The window they apply to
+ */
+- (void)addPendingDrift:(WCWindowDrift)drift forWindowID:(CGWindowID)windowID;
+
+/**
+ * @brief Take the protections scheduled for a window
+ *
+ * @param windowID The window to apply protections to
+ * @return The scheduled protections; WCWindowDriftAll if the window is unknown
+ */
+- (WCWindowDrift)takePendingDriftForWindowID:(CGWindowID)windowID;
+
+/**
+ * @brief Record the outcome of applying protections
+ *
+ * @param drift The protections that were attempted
+ * @param sharingApplied YES if the sharing state was set successfully
+ * @param levelApplied YES if the level and tags were set successfully
+ * @param windowID The window that was protected
+ */
+- (void)recordAppliedDrift:(WCWindowDrift)drift
+            sharingApplied:(BOOL)sharingApplied
+              levelApplied:(BOOL)levelApplied
+               forWindowID:(CGWindowID)windowID;
+
+/**
+ * @brief Record the outcome of protections that finished after the pass
+ *
+ * Same as recordAppliedDrift:sharingApplied:levelApplied:forWindowID:, but
+ * does nothing if the window was removed since the pass, so late results
+ * don't keep state for windows that are gone.
+ *
+ * @param drift The protections that were attempted
+ * @param sharingApplied YES if the sharing state was set successfully
+ * @param levelApplied YES if the level and tags were set successfully
+ * @param windowID The window that was protected
+ */
+- (void)updateAppliedDrift:(WCWindowDrift)drift
+            sharingApplied:(BOOL)sharingApplied
+              levelApplied:(BOOL)levelApplied
+               forWindowID:(CGWindowID)windowID;
+
+/**
+ * @brief Check if any protection has been applied to a window
+ *
+ * @param windowID The window to check
+ * @return YES if the window has cached state
+ */
+- (BOOL)containsWindowID:(CGWindowID)windowID;
+
+/**
+ * @brief Forget a window, for example after it is destroyed
+ *
+ * @param windowID The window to forget
+ */
+- (void)removeWindowID:(CGWindowID)windowID;
+
+/**
+ * @brief Forget all windows
+ */
+- (void)removeAllWindows;
+
+/**
+ * @brief Mark every known window as needing all protections again
+ *
+ * Used when the protection targets change. Unlike removeAllWindows this
+ * keeps the windows known, so reapplying them does not count as protecting
+ * new windows in the latency metrics.
+ */
+- (void)invalidateAppliedProtections;
+
+@end
+
+#endif /* WC_WINDOW_STATE_CACHE_H */
@@ -0,0 +1,206 @@
+/**
+ * @file wc_window_state_cache.m
+ * @brief Implementation of the per-window protection state cache
+ */
+
+#import "wc_window_state_cache.h"
+#import "../util/wc_launch_handshake.h"
+#import "../util/wc_metrics.h"
+#import "../util/wc_window_id_set.h"
+
+/**
+ * Cached state for one window, stored inline in the window ID map
+ */
+typedef struct {
+    uint64_t firstSeenTime;  // WCMetricsNow() when the window was first scheduled, 0 once protected
+    int32_t baselineLevel;   // Level observed on the first scan after protection
+    uint8_t hasBaseline;     // baselineLevel is valid
+    uint8_t sharingApplied;  // Sharing state was set to none
+    uint8_t levelApplied;    // Level and Mission Control tags were set
+    uint8_t pendingDrift;    // WCWindowDrift scheduled but not yet applied
+} WCWindowProtectionState;
+
+@implementation WCWindowStateCache {
+    WCWindowIDMap _states;
+}
+
+#pragma mark - Lifecycle
+
+- (instancetype)init {
+    if (self = [super init]) {
+        WCWindowIDMapInit(&_states, sizeof(WCWindowProtectionState), 64);
+        _expectedSharingState = kCGWindowSharingNone;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    WCWindowIDMapDestroy(&_states);
+}
+
+#pragma mark - Reconciliation
+
+- (NSUInteger)count {
+    return _states.count;
+}
+
+- (WCWindowDrift)reconcileWindowID:(CGWindowID)windowID observedInfo:(NSDictionary *)windowInfo {
+    NSNumber *sharingState = windowInfo[(NSString *)kCGWindowSharingState];
+    NSNumber *layer = windowInfo[(NSString *)kCGWindowLayer];
+
+    return [self reconcileWindowID:windowID
+                   hasSharingState:sharingState != nil
+                      sharingState:[sharingState intValue]
+                          hasLevel:layer != nil
+                             level:[layer intValue]];
+}
+
+- (WCWindowDrift)reconcileWindowRecord:(const WCWindowRecord *)record {
+    return [self reconcileWindowID:record->windowID
+                   hasSharingState:(record->flags & WCWindowRecordFlagHasSharingState) != 0
+                      sharingState:record->sharingType
+                          hasLevel:(record->flags & WCWindowRecordFlagHasLevel) != 0
+                             level:record->level];
+}
+
+- (WCWindowDrift)reconcileWindowID:(CGWindowID)windowID
+                   hasSharingState:(BOOL)hasSharingState
+                      sharingState:(int)sharingState
+                          hasLevel:(BOOL)hasLevel
+                             level:(int)level {
+    WCWindowProtectionState *state = WCWindowIDMapGet(&_states, windowID);
+    if (!state) {
+        return WCWindowDriftAll;
+    }
+
+    WCWindowDrift drift = WCWindowDriftNone;
+
+    if (!state->sharingApplied) {
+        drift |= WCWindowDriftSharing;
+    }
+    if (!state->levelApplied) {
+        drift |= WCWindowDriftLevel;
+    }
+
+    if (hasSharingState && sharingState != _expectedSharingState) {
+        drift |= WCWindowDriftSharing;
+    }
+
+    if (hasLevel && state->levelApplied) {
+        if (!state->hasBaseline) {
+            state->baselineLevel = level;
+            state->hasBaseline = 1;
+        } else if (level != state->baselineLevel) {
+            drift |= WCWindowDriftLevel;
+        }
+    }
+
+    return drift;
+}
+
+- (void)addPendingDrift:(WCWindowDrift)drift forWindowID:(CGWindowID)windowID {
+    bool created = false;
+    WCWindowProtectionState *state = WCWindowIDMapUpsert(&_states, windowID, &created);
+    if (state) {
+        // Start the protection latency clock at the first sighting, from an event or a scan
+        if (created) {
+            state->firstSeenTime = WCMetricsNow();
+        } else if (drift != WCWindowDriftNone && state->pendingDrift == 0 &&
+                   state->sharingApplied && state->levelApplied) {
+            // A protected window drifted and has to be protected again
+            WCMetricsIncrement(WCMetricCounterWindowsReprotected);
+        }
+        state->pendingDrift |= (uint8_t)drift;
+    }
+}
+
+- (WCWindowDrift)takePendingDriftForWindowID:(CGWindowID)windowID {
+    WCWindowProtectionState *state = WCWindowIDMapGet(&_states, windowID);
+    if (!state) {
+        return WCWindowDriftAll;
+    }
+
+    WCWindowDrift drift = state->pendingDrift;
+    state->pendingDrift = 0;
+
+    // Never scheduled through a scan (e.g. a window event), so bring it fully up to date
+    if (drift == WCWindowDriftNone && (!state->sharingApplied || !state->levelApplied)) {
+        drift = WCWindowDriftAll;
+    }
+    return drift;
+}
+
+/**
+ * Apply a protection outcome to a window's state
+ */
+static void WCWindowStateRecordApplied(WCWindowProtectionState *state, WCWindowDrift drift,
+                                       BOOL sharingApplied, BOOL levelApplied) {
+    if (drift & WCWindowDriftSharing) {
+        state->sharingApplied = sharingApplied ? 1 : 0;
+    }
+    if (drift & WCWindowDriftLevel) {
+        state->levelApplied = levelApplied ? 1 : 0;
+
+        // The level settles after protection; take a new baseline on the next observation
+        state->hasBaseline = 0;
+    }
+
+    // Only the first time a window becomes fully protected counts towards latency
+    if (state->firstSeenTime != 0 && state->sharingApplied && state->levelApplied) {
+        WCMetricsIncrement(WCMetricCounterWindowsProtected);
+        WCMetricsRecord(WCMetricHistogramProtectionLatency, WCMetricsNow() - state->firstSeenTime);
+        WCMetricsRecordFirstProtection();
+        WCLaunchHandshakeSignal(WCLaunchHandshakeStageProtected);
+        state->firstSeenTime = 0;
+    }
+}
+
+- (void)recordAppliedDrift:(WCWindowDrift)drift
+            sharingApplied:(BOOL)sharingApplied
+              levelApplied:(BOOL)levelApplied
+               forWindowID:(CGWindowID)windowID {
+    WCWindowProtectionState *state = WCWindowIDMapUpsert(&_states, windowID, NULL);
+    if (!state) return;
+
+    WCWindowStateRecordApplied(state, drift, sharingApplied, levelApplied);
+}
+
+- (void)updateAppliedDrift:(WCWindowDrift)drift
+            sharingApplied:(BOOL)sharingApplied
+              levelApplied:(BOOL)levelApplied
+               forWindowID:(CGWindowID)windowID {
+    // The window may have been forgotten meanwhile; don't bring its state back
+    WCWindowProtectionState *state = WCWindowIDMapGet(&_states, windowID);
+    if (!state) return;
+
+    WCWindowStateRecordApplied(state, drift, sharingApplied, levelApplied);
+}
+
+- (BOOL)containsWindowID:(CGWindowID)windowID {
+    WCWindowProtectionState *state = WCWindowIDMapGet(&_states, windowID);
+    return state && (state->sharingApplied || state->levelApplied);
+}
+
+- (void)removeWindowID:(CGWindowID)windowID {
+    WCWindowIDMapRemove(&_states, windowID);
+}
+
+- (void)removeAllWindows {
+    WCWindowIDMapClear(&_states);
+}
+
+static void WCWindowStateInvalidate(CGWindowID windowID, void *value, void *context) {
+    (void)windowID;
+    (void)context;
+
+    WCWindowProtectionState *state = value;
+    state->sharingApplied = 0;
+    state->levelApplied = 0;
+    state->hasBaseline = 0;
+}
+
+- (void)invalidateAppliedProtections {
+    WCWindowIDMapForEach(&_states, WCWindowStateInvalidate, NULL);
+}
+
+@end
@@ -11,6 +11,7 @@
 #define INTERCEPTOR_PROTOCOL_H
 
 #import <Foundation/Foundation.h>
+#import "../util/configuration_manager.h"
 
 /**
  * @brief Protocol that defines the standard interface for interceptors
@@ -106,6 +107,29 @@
  */
 + (NSArray<Class> *)dependencies;
 
+/**
+ * @brief Get the configuration options this interceptor serves
+ *
+ * In on-demand installation the registry skips interceptors whose options
+ * are all disabled. Interceptors that do not implement this method, or
+ * return WCConfigurationOptionNone, are always installed.
+ *
+ * @return Bitwise OR of WCConfigurationOptions
+ */
++ (WCConfigurationOptions)requiredConfigurationOptions;
+
+/**
+ * @brief Install only the hooks the given configuration options need
+ *
+ * Used by on-demand installation instead of +install. Hooks that serve
+ * none of the options, such as pass-through getters, are not swizzled.
+ * Calling it again with more options adds the missing hooks.
+ *
+ * @param options Bitwise OR of the enabled WCConfigurationOptions
+ * @return YES if installation was successful, NO otherwise
+ */
++ (BOOL)installForConfigurationOptions:(WCConfigurationOptions)options;
+
 @end
 
 #endif /* INTERCEPTOR_PROTOCOL_H */
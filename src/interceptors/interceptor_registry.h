@@ -69,6 +69,17 @@ typedef NS_OPTIONS(NSUInteger, WCInterceptorOptions) {
  */
 - (BOOL)installInterceptorsWithOptions:(WCInterceptorOptions)options;
 
+/**
+ * @brief Install only the hooks the given configuration options need
+ *
+ * Interceptors whose required options are all disabled are skipped, and
+ * the rest swizzle just the selectors those options depend on.
+ *
+ * @param options Bitwise OR of the enabled WCConfigurationOptions
+ * @return YES if the needed interceptors were installed successfully, NO otherwise
+ */
+- (BOOL)installInterceptorsForConfigurationOptions:(WCConfigurationOptions)options;
+
 /**
  * @brief Install a specific interceptor
  *
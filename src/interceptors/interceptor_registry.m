@@ -4,6 +4,7 @@
  */
 
 #import "interceptor_registry.h"
+#import <AppKit/AppKit.h>
 #import "../util/logger.h"
 #import "../util/error_manager.h"
 #import "nswindow_interceptor.h"
@@ -260,6 +261,67 @@
     return success;
 }
 
+- (BOOL)installInterceptorsForConfigurationOptions:(WCConfigurationOptions)options {
+    [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                 category:@"Interception"
+                                     file:__FILE__
+                                     line:__LINE__
+                                 function:__PRETTY_FUNCTION__
+                                   format:@"Installing interceptors for configuration options: %lu", (unsigned long)options];
+
+    BOOL success = YES;
+    NSMutableArray<Class<WCInterceptor>> *interceptorsToInstall = [NSMutableArray array];
+
+    // Skip interceptors that serve none of the enabled options
+    for (Class<WCInterceptor> interceptorClass in self.registeredInterceptors) {
+        WCConfigurationOptions requiredOptions = WCConfigurationOptionNone;
+        if ([interceptorClass respondsToSelector:@selector(requiredConfigurationOptions)]) {
+            requiredOptions = [interceptorClass requiredConfigurationOptions];
+        }
+
+        if (requiredOptions == WCConfigurationOptionNone || (requiredOptions & options)) {
+            [interceptorsToInstall addObject:interceptorClass];
+        } else {
+            [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
+                                         category:@"Interception"
+                                             file:__FILE__
+                                             line:__LINE__
+                                         function:__PRETTY_FUNCTION__
+                                           format:@"Skipping interceptor %@, none of its options are enabled",
+                                                  [interceptorClass interceptorName]];
+        }
+    }
+
+    // Dependencies that were kept come first; dropped ones are not needed by these options
+    interceptorsToInstall = [self sortInterceptorsForInstallation:interceptorsToInstall];
+
+    for (Class<WCInterceptor> interceptorClass in interceptorsToInstall) {
+        BOOL installed;
+        if ([interceptorClass respondsToSelector:@selector(installForConfigurationOptions:)]) {
+            installed = [interceptorClass installForConfigurationOptions:options];
+        } else {
+            installed = [interceptorClass install];
+        }
+
+        if (installed) {
+            if (![self.installedInterceptors containsObject:interceptorClass]) {
+                [self.installedInterceptors addObject:interceptorClass];
+            }
+        } else {
+            success = NO;
+            [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
+                                         category:@"Interception"
+                                             file:__FILE__
+                                             line:__LINE__
+                                         function:__PRETTY_FUNCTION__
+                                           format:@"Failed to install interceptor: %@",
+                                                  [interceptorClass interceptorName]];
+        }
+    }
+
+    return success;
+}
+
 - (BOOL)installInterceptor:(Class<WCInterceptor>)interceptorClass {
     if (!interceptorClass) {
         [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
@@ -26,14 +26,48 @@ static void wc_hide(id self, SEL _cmd, id sender);
 static void wc_unhide(id self, SEL _cmd, id sender);
 static void wc_becomeActiveApplication(id self, SEL _cmd);
 
+// Original implementations, filled in by the swizzler before each swap takes effect
+static WCIMPSlot gOriginalSetActivationPolicy;
+static WCIMPSlot gOriginalSetPresentationOptions;
+static WCIMPSlot gOriginalIsHidden;
+static WCIMPSlot gOriginalSetHidden;
+static WCIMPSlot gOriginalOrderFrontStandardAboutPanel;
+static WCIMPSlot gOriginalHide;
+static WCIMPSlot gOriginalUnhide;
+
 // Application state tracking
 static BOOL gAppFullyLoaded = NO;
 static os_unfair_lock gAppSettingsLock = OS_UNFAIR_LOCK_INIT;
 static uint64_t gLastSettingsTime = 0;
 
+// Groups of hooks that are swizzled and unswizzled together
+typedef NS_OPTIONS(NSUInteger, WCApplicationHookGroup) {
+    WCApplicationHookGroupNone         = 0,
+    WCApplicationHookGroupPolicy       = 1 << 0,  // activationPolicy, setActivationPolicy:
+    WCApplicationHookGroupPresentation = 1 << 1,  // presentationOptions, setPresentationOptions:
+    WCApplicationHookGroupActivation   = 1 << 2,  // isActive, activateIgnoringOtherApps:, becomeActiveApplication
+    WCApplicationHookGroupPassThrough  = 1 << 3,  // isHidden, setHidden:, hide:, unhide:, orderFrontStandardAboutPanel:
+    WCApplicationHookGroupAll          = (1 << 4) - 1
+};
+
+// Hook groups needed by a set of configuration options; pass-through hooks serve none
+static WCApplicationHookGroup WCApplicationHookGroupsForOptions(WCConfigurationOptions options) {
+    WCApplicationHookGroup groups = WCApplicationHookGroupNone;
+    if (options & (WCConfigurationOptionHideDock | WCConfigurationOptionHideFromSwitcher)) {
+        // Accessory applications must also never activate themselves
+        groups |= WCApplicationHookGroupPolicy | WCApplicationHookGroupActivation;
+    }
+    if (options & (WCConfigurationOptionHideDock | WCConfigurationOptionDisableForceQuit)) {
+        groups |= WCApplicationHookGroupPresentation;
+    }
+    return groups;
+}
+
 @implementation WCNSApplicationInterceptor {
     // Private instance variables
     BOOL _installed;
+    BOOL _hookMethodsAdded;
+    WCApplicationHookGroup _installedHookGroups;
     dispatch_source_t _appSettingsRefreshTimer;
 }
 
@@ -80,6 +114,10 @@ static uint64_t gLastSettingsTime = 0;
     return @[[WCNSWindowInterceptor class]];
 }
 
++ (WCConfigurationOptions)requiredConfigurationOptions {
+    return WCConfigurationOptionHideDock | WCConfigurationOptionHideFromSwitcher | WCConfigurationOptionDisableForceQuit;
+}
+
 #pragma mark - Initialization and Singleton Pattern
 
 + (instancetype)sharedInterceptor {
@@ -94,6 +132,8 @@ static uint64_t gLastSettingsTime = 0;
 - (instancetype)init {
     if (self = [super init]) {
         _installed = NO;
+        _hookMethodsAdded = NO;
+        _installedHookGroups = WCApplicationHookGroupNone;
         _appSettingsRefreshTimer = nil;
     }
     return self;
@@ -105,6 +145,10 @@ static uint64_t gLastSettingsTime = 0;
     return [[self sharedInterceptor] installInterceptor];
 }
 
++ (BOOL)installForConfigurationOptions:(WCConfigurationOptions)options {
+    return [[self sharedInterceptor] installHookGroups:WCApplicationHookGroupsForOptions(options)];
+}
+
 + (BOOL)uninstall {
     return [[self sharedInterceptor] uninstallInterceptor];
 }
@@ -118,8 +162,15 @@ static uint64_t gLastSettingsTime = 0;
 }
 
 - (BOOL)installInterceptor {
+    return [self installHookGroups:WCApplicationHookGroupAll];
+}
+
+// Swizzle the hook groups that are not installed yet
+- (BOOL)installHookGroups:(WCApplicationHookGroup)groups {
+    WCApplicationHookGroup missingGroups = groups & ~_installedHookGroups;
+
     // Don't install more than once
-    if (_installed) {
+    if (_installed && missingGroups == WCApplicationHookGroupNone) {
         [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
                                      category:@"Interception"
                                          file:__FILE__
@@ -134,67 +185,69 @@ static uint64_t gLastSettingsTime = 0;
                                      file:__FILE__
                                      line:__LINE__
                                  function:__PRETTY_FUNCTION__
-                                   format:@"Installing NSApplication interceptor"];
+                                   format:@"Installing NSApplication interceptor hook groups: %lu", (unsigned long)missingGroups];
 
     BOOL success = YES;
     Class nsApplicationClass = [NSApplication class];
 
-    // Apply settings immediately to NSApp
-    [self applyProtectionsToApplication];
-
-    // Set up a timer to periodically refresh application settings
-    if (_appSettingsRefreshTimer == nil) {
-        // Create timer on a separate high-priority queue to avoid main thread delays
-        dispatch_queue_t timerQueue = dispatch_queue_create("com.windowcontrolinjector.appTimer",
-                                                          DISPATCH_QUEUE_SERIAL);
-
-        _appSettingsRefreshTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER,
-                                                       0, 0, timerQueue);
-        if (_appSettingsRefreshTimer) {
-            // Apply settings every 1 second to ensure they stay applied
-            dispatch_source_set_timer(_appSettingsRefreshTimer,
-                                   dispatch_time(DISPATCH_TIME_NOW, 1 * NSEC_PER_SEC),
-                                   1 * NSEC_PER_SEC,
-                                   0.1 * NSEC_PER_SEC);
-
-            dispatch_source_set_event_handler(_appSettingsRefreshTimer, ^{
-                @autoreleasepool {
-                    // Run on main thread to safely interact with UI classes
-                    dispatch_async(dispatch_get_main_queue(), ^{
-                        @try {
-                            NSApplication *app = [NSApplication sharedApplication];
-                            if (app) {
-                                [self applyProtectionsToApplication];
+    if (!_installed) {
+        // Apply settings immediately to NSApp
+        [self applyProtectionsToApplication];
+
+        // Set up a timer to periodically refresh application settings
+        if (_appSettingsRefreshTimer == nil) {
+            // Create timer on a separate high-priority queue to avoid main thread delays
+            dispatch_queue_t timerQueue = dispatch_queue_create("com.windowcontrolinjector.appTimer",
+                                                              DISPATCH_QUEUE_SERIAL);
+
+            _appSettingsRefreshTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER,
+                                                           0, 0, timerQueue);
+            if (_appSettingsRefreshTimer) {
+                // Apply settings every 1 second to ensure they stay applied
+                dispatch_source_set_timer(_appSettingsRefreshTimer,
+                                       dispatch_time(DISPATCH_TIME_NOW, 1 * NSEC_PER_SEC),
+                                       1 * NSEC_PER_SEC,
+                                       0.1 * NSEC_PER_SEC);
+
+                dispatch_source_set_event_handler(_appSettingsRefreshTimer, ^{
+                    @autoreleasepool {
+                        // Run on main thread to safely interact with UI classes
+                        dispatch_async(dispatch_get_main_queue(), ^{
+                            @try {
+                                NSApplication *app = [NSApplication sharedApplication];
+                                if (app) {
+                                    [self applyProtectionsToApplication];
+                                }
+                            } @catch (NSException *exception) {
+                                [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
+                                                            category:@"Application"
+                                                                file:__FILE__
+                                                                line:__LINE__
+                                                            function:__PRETTY_FUNCTION__
+                                                              format:@"Exception in timer handler: %@", exception.reason];
                             }
-                        } @catch (NSException *exception) {
-                            [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
-                                                        category:@"Application"
-                                                            file:__FILE__
-                                                            line:__LINE__
-                                                        function:__PRETTY_FUNCTION__
-                                                          format:@"Exception in timer handler: %@", exception.reason];
-                        }
-                    });
-                }
-            });
-
-            // Handle cancellation to prevent crashes
-            dispatch_source_set_cancel_handler(_appSettingsRefreshTimer, ^{
+                        });
+                    }
+                });
+
+                // Handle cancellation to prevent crashes
+                dispatch_source_set_cancel_handler(_appSettingsRefreshTimer, ^{
+                    [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                                category:@"Application"
+                                                    file:__FILE__
+                                                    line:__LINE__
+                                                function:__PRETTY_FUNCTION__
+                                                  format:@"Application settings refresh timer cancelled"];
+                });
+
+                dispatch_resume(_appSettingsRefreshTimer);
                 [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
                                             category:@"Application"
                                                 file:__FILE__
                                                 line:__LINE__
                                             function:__PRETTY_FUNCTION__
-                                              format:@"Application settings refresh timer cancelled"];
-            });
-
-            dispatch_resume(_appSettingsRefreshTimer);
-            [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
-                                        category:@"Application"
-                                            file:__FILE__
-                                            line:__LINE__
-                                        function:__PRETTY_FUNCTION__
-                                          format:@"Started application settings refresh timer"];
+                                              format:@"Started application settings refresh timer"];
+            }
         }
     }
 
@@ -210,76 +263,80 @@ static uint64_t gLastSettingsTime = 0;
     const char *voidType = "v@:";
     const char *voidWithSenderType = "v@:@";
 
-    // Add methods with prefix "wc_" to the NSApplication class
-    [WCMethodSwizzler addMethodToClass:nsApplicationClass
-                              selector:@selector(wc_activationPolicy)
-                         implementation:(IMP)wc_activationPolicy
-                          typeEncoding:activationPolicyType];
-
-    [WCMethodSwizzler addMethodToClass:nsApplicationClass
-                              selector:@selector(wc_setActivationPolicy:)
-                         implementation:(IMP)wc_setActivationPolicy
-                          typeEncoding:setActivationPolicyType];
-
-    [WCMethodSwizzler addMethodToClass:nsApplicationClass
-                              selector:@selector(wc_presentationOptions)
-                         implementation:(IMP)wc_presentationOptions
-                          typeEncoding:presentationOptionsType];
-
-    [WCMethodSwizzler addMethodToClass:nsApplicationClass
-                              selector:@selector(wc_setPresentationOptions:)
-                         implementation:(IMP)wc_setPresentationOptions
-                          typeEncoding:setPresentationOptionsType];
-
-    [WCMethodSwizzler addMethodToClass:nsApplicationClass
-                              selector:@selector(wc_isHidden)
-                         implementation:(IMP)wc_isHidden
-                          typeEncoding:boolType];
-
-    [WCMethodSwizzler addMethodToClass:nsApplicationClass
-                              selector:@selector(wc_setHidden:)
-                         implementation:(IMP)wc_setHidden
-                          typeEncoding:setBoolType];
-
-    [WCMethodSwizzler addMethodToClass:nsApplicationClass
-                              selector:@selector(wc_isActive)
-                         implementation:(IMP)wc_isActive
-                          typeEncoding:boolType];
-
-    [WCMethodSwizzler addMethodToClass:nsApplicationClass
-                              selector:@selector(wc_activateIgnoringOtherApps:)
-                         implementation:(IMP)wc_activateIgnoringOtherApps
-                          typeEncoding:setBoolType];
-
-    [WCMethodSwizzler addMethodToClass:nsApplicationClass
-                              selector:@selector(wc_orderFrontStandardAboutPanel:)
-                         implementation:(IMP)wc_orderFrontStandardAboutPanel
-                          typeEncoding:voidWithSenderType];
-
-    [WCMethodSwizzler addMethodToClass:nsApplicationClass
-                              selector:@selector(wc_hide:)
-                         implementation:(IMP)wc_hide
-                          typeEncoding:voidWithSenderType];
-
-    [WCMethodSwizzler addMethodToClass:nsApplicationClass
-                              selector:@selector(wc_unhide:)
-                         implementation:(IMP)wc_unhide
-                          typeEncoding:voidWithSenderType];
-
-    [WCMethodSwizzler addMethodToClass:nsApplicationClass
-                              selector:@selector(wc_becomeActiveApplication)
-                         implementation:(IMP)wc_becomeActiveApplication
-                          typeEncoding:voidType];
+    // Add methods with prefix "wc_" to the NSApplication class, once for all hook groups
+    if (!_hookMethodsAdded) {
+        [WCMethodSwizzler addMethodToClass:nsApplicationClass
+                                  selector:@selector(wc_activationPolicy)
+                             implementation:(IMP)wc_activationPolicy
+                              typeEncoding:activationPolicyType];
+
+        [WCMethodSwizzler addMethodToClass:nsApplicationClass
+                                  selector:@selector(wc_setActivationPolicy:)
+                             implementation:(IMP)wc_setActivationPolicy
+                              typeEncoding:setActivationPolicyType];
+
+        [WCMethodSwizzler addMethodToClass:nsApplicationClass
+                                  selector:@selector(wc_presentationOptions)
+                             implementation:(IMP)wc_presentationOptions
+                              typeEncoding:presentationOptionsType];
+
+        [WCMethodSwizzler addMethodToClass:nsApplicationClass
+                                  selector:@selector(wc_setPresentationOptions:)
+                             implementation:(IMP)wc_setPresentationOptions
+                              typeEncoding:setPresentationOptionsType];
+
+        [WCMethodSwizzler addMethodToClass:nsApplicationClass
+                                  selector:@selector(wc_isHidden)
+                             implementation:(IMP)wc_isHidden
+                              typeEncoding:boolType];
+
+        [WCMethodSwizzler addMethodToClass:nsApplicationClass
+                                  selector:@selector(wc_setHidden:)
+                             implementation:(IMP)wc_setHidden
+                              typeEncoding:setBoolType];
+
+        [WCMethodSwizzler addMethodToClass:nsApplicationClass
+                                  selector:@selector(wc_isActive)
+                             implementation:(IMP)wc_isActive
+                              typeEncoding:boolType];
+
+        [WCMethodSwizzler addMethodToClass:nsApplicationClass
+                                  selector:@selector(wc_activateIgnoringOtherApps:)
+                             implementation:(IMP)wc_activateIgnoringOtherApps
+                              typeEncoding:setBoolType];
+
+        [WCMethodSwizzler addMethodToClass:nsApplicationClass
+                                  selector:@selector(wc_orderFrontStandardAboutPanel:)
+                             implementation:(IMP)wc_orderFrontStandardAboutPanel
+                              typeEncoding:voidWithSenderType];
+
+        [WCMethodSwizzler addMethodToClass:nsApplicationClass
+                                  selector:@selector(wc_hide:)
+                             implementation:(IMP)wc_hide
+                              typeEncoding:voidWithSenderType];
+
+        [WCMethodSwizzler addMethodToClass:nsApplicationClass
+                                  selector:@selector(wc_unhide:)
+                             implementation:(IMP)wc_unhide
+                              typeEncoding:voidWithSenderType];
+
+        [WCMethodSwizzler addMethodToClass:nsApplicationClass
+                                  selector:@selector(wc_becomeActiveApplication)
+                             implementation:(IMP)wc_becomeActiveApplication
+                              typeEncoding:voidType];
+        _hookMethodsAdded = YES;
+    }
 
     // Then swizzle the original methods with our custom implementations
 
     // Helper macro to safely swizzle methods only if they exist
-    #define SAFE_SWIZZLE(origSel, newSel, type) \
+    #define SAFE_SWIZZLE(origSel, newSel, type, slot) \
         if ([WCMethodSwizzler class:nsApplicationClass implementsSelector:origSel ofType:type]) { \
             if (![WCMethodSwizzler swizzleClass:nsApplicationClass \
                                 originalSelector:origSel \
                              replacementSelector:newSel \
-                              implementationType:type]) { \
+                              implementationType:type \
+                                 originalIMPSlot:slot]) { \
                 [[WCLogger sharedLogger] logWithLevel:WCLogLevelWarning \
                                              category:@"Interception" \
                                                  file:__FILE__ \
@@ -304,19 +361,27 @@ static uint64_t gLastSettingsTime = 0;
                                            format:@"Method %@ not found in NSApplication, skipping swizzle", NSStringFromSelector(origSel)]; \
         }
 
-    // Swizzle methods that exist
-    SAFE_SWIZZLE(@selector(activationPolicy), @selector(wc_activationPolicy), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(setActivationPolicy:), @selector(wc_setActivationPolicy:), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(presentationOptions), @selector(wc_presentationOptions), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(setPresentationOptions:), @selector(wc_setPresentationOptions:), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(isHidden), @selector(wc_isHidden), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(setHidden:), @selector(wc_setHidden:), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(isActive), @selector(wc_isActive), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(activateIgnoringOtherApps:), @selector(wc_activateIgnoringOtherApps:), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(orderFrontStandardAboutPanel:), @selector(wc_orderFrontStandardAboutPanel:), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(hide:), @selector(wc_hide:), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(unhide:), @selector(wc_unhide:), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(becomeActiveApplication), @selector(wc_becomeActiveApplication), WCImplementationTypeMethod);
+    // Swizzle methods that exist, only for the requested hook groups
+    if (missingGroups & WCApplicationHookGroupPolicy) {
+        SAFE_SWIZZLE(@selector(activationPolicy), @selector(wc_activationPolicy), WCImplementationTypeMethod, NULL);
+        SAFE_SWIZZLE(@selector(setActivationPolicy:), @selector(wc_setActivationPolicy:), WCImplementationTypeMethod, &gOriginalSetActivationPolicy);
+    }
+    if (missingGroups & WCApplicationHookGroupPresentation) {
+        SAFE_SWIZZLE(@selector(presentationOptions), @selector(wc_presentationOptions), WCImplementationTypeMethod, NULL);
+        SAFE_SWIZZLE(@selector(setPresentationOptions:), @selector(wc_setPresentationOptions:), WCImplementationTypeMethod, &gOriginalSetPresentationOptions);
+    }
+    if (missingGroups & WCApplicationHookGroupPassThrough) {
+        SAFE_SWIZZLE(@selector(isHidden), @selector(wc_isHidden), WCImplementationTypeMethod, &gOriginalIsHidden);
+        SAFE_SWIZZLE(@selector(setHidden:), @selector(wc_setHidden:), WCImplementationTypeMethod, &gOriginalSetHidden);
+        SAFE_SWIZZLE(@selector(orderFrontStandardAboutPanel:), @selector(wc_orderFrontStandardAboutPanel:), WCImplementationTypeMethod, &gOriginalOrderFrontStandardAboutPanel);
+        SAFE_SWIZZLE(@selector(hide:), @selector(wc_hide:), WCImplementationTypeMethod, &gOriginalHide);
+        SAFE_SWIZZLE(@selector(unhide:), @selector(wc_unhide:), WCImplementationTypeMethod, &gOriginalUnhide);
+    }
+    if (missingGroups & WCApplicationHookGroupActivation) {
+        SAFE_SWIZZLE(@selector(isActive), @selector(wc_isActive), WCImplementationTypeMethod, NULL);
+        SAFE_SWIZZLE(@selector(activateIgnoringOtherApps:), @selector(wc_activateIgnoringOtherApps:), WCImplementationTypeMethod, NULL);
+        SAFE_SWIZZLE(@selector(becomeActiveApplication), @selector(wc_becomeActiveApplication), WCImplementationTypeMethod, NULL);
+    }
 
     #undef SAFE_SWIZZLE
 
@@ -327,6 +392,7 @@ static uint64_t gLastSettingsTime = 0;
                                          line:__LINE__
                                      function:__PRETTY_FUNCTION__
                                        format:@"NSApplication interceptor installed successfully"];
+        _installedHookGroups |= missingGroups;
         _installed = YES;
     } else {
         [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
@@ -400,19 +466,27 @@ static uint64_t gLastSettingsTime = 0;
             } \
         }
 
-    // Unswizzle all methods we swizzled
-    SAFE_UNSWIZZLE(@selector(activationPolicy), @selector(wc_activationPolicy), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(setActivationPolicy:), @selector(wc_setActivationPolicy:), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(presentationOptions), @selector(wc_presentationOptions), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(setPresentationOptions:), @selector(wc_setPresentationOptions:), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(isHidden), @selector(wc_isHidden), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(setHidden:), @selector(wc_setHidden:), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(isActive), @selector(wc_isActive), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(activateIgnoringOtherApps:), @selector(wc_activateIgnoringOtherApps:), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(orderFrontStandardAboutPanel:), @selector(wc_orderFrontStandardAboutPanel:), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(hide:), @selector(wc_hide:), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(unhide:), @selector(wc_unhide:), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(becomeActiveApplication), @selector(wc_becomeActiveApplication), WCImplementationTypeMethod);
+    // Unswizzle only the hook groups we swizzled
+    if (_installedHookGroups & WCApplicationHookGroupPolicy) {
+        SAFE_UNSWIZZLE(@selector(activationPolicy), @selector(wc_activationPolicy), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(setActivationPolicy:), @selector(wc_setActivationPolicy:), WCImplementationTypeMethod);
+    }
+    if (_installedHookGroups & WCApplicationHookGroupPresentation) {
+        SAFE_UNSWIZZLE(@selector(presentationOptions), @selector(wc_presentationOptions), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(setPresentationOptions:), @selector(wc_setPresentationOptions:), WCImplementationTypeMethod);
+    }
+    if (_installedHookGroups & WCApplicationHookGroupPassThrough) {
+        SAFE_UNSWIZZLE(@selector(isHidden), @selector(wc_isHidden), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(setHidden:), @selector(wc_setHidden:), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(orderFrontStandardAboutPanel:), @selector(wc_orderFrontStandardAboutPanel:), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(hide:), @selector(wc_hide:), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(unhide:), @selector(wc_unhide:), WCImplementationTypeMethod);
+    }
+    if (_installedHookGroups & WCApplicationHookGroupActivation) {
+        SAFE_UNSWIZZLE(@selector(isActive), @selector(wc_isActive), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(activateIgnoringOtherApps:), @selector(wc_activateIgnoringOtherApps:), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(becomeActiveApplication), @selector(wc_becomeActiveApplication), WCImplementationTypeMethod);
+    }
 
     #undef SAFE_UNSWIZZLE
 
@@ -423,6 +497,7 @@ static uint64_t gLastSettingsTime = 0;
                                          line:__LINE__
                                      function:__PRETTY_FUNCTION__
                                        format:@"NSApplication interceptor uninstalled successfully"];
+        _installedHookGroups = WCApplicationHookGroupNone;
         _installed = NO;
     } else {
         [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
@@ -563,12 +638,7 @@ static uint64_t gLastSettingsTime = 0;
 // Swizzled activationPolicy getter
 static NSApplicationActivationPolicy wc_activationPolicy(id self, SEL _cmd) {
     // Override: Use accessory policy to hide from Dock while still allowing init
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Application"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Intercepted activationPolicy call, forcing NSApplicationActivationPolicyAccessory"];
+    WCLogDebug(@"Application", @"Intercepted activationPolicy call, forcing NSApplicationActivationPolicyAccessory");
     return NSApplicationActivationPolicyAccessory;
 }
 
@@ -576,17 +646,10 @@ static NSApplicationActivationPolicy wc_activationPolicy(id self, SEL _cmd) {
 static BOOL wc_setActivationPolicy(id self, SEL _cmd, NSApplicationActivationPolicy activationPolicy) {
     // Override: Always set to accessory policy to hide from Dock
     activationPolicy = NSApplicationActivationPolicyAccessory;
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Application"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Forcing activation policy to NSApplicationActivationPolicyAccessory"];
+    WCLogDebug(@"Application", @"Forcing activation policy to NSApplicationActivationPolicyAccessory");
 
     // Call original implementation
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(setActivationPolicy:)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalSetActivationPolicy);
     if (originalImp) {
         return ((BOOL (*)(id, SEL, NSApplicationActivationPolicy))originalImp)(self, _cmd, activationPolicy);
     }
@@ -600,13 +663,8 @@ static NSApplicationPresentationOptions wc_presentationOptions(id self, SEL _cmd
     NSApplicationPresentationOptions options = NSApplicationPresentationHideDock |
                                                NSApplicationPresentationDisableForceQuit;
 
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Application"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Modified presentation options: %lu (hide dock + disable force quit)",
-                                          (unsigned long)options];
+    WCLogDebug(@"Application", @"Modified presentation options: %lu (hide dock + disable force quit)",
+               (unsigned long)options);
     return options;
 }
 
@@ -616,17 +674,10 @@ static void wc_setPresentationOptions(id self, SEL _cmd, NSApplicationPresentati
     NSApplicationPresentationOptions enforcedOptions = NSApplicationPresentationHideDock |
                                                        NSApplicationPresentationDisableForceQuit;
 
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Application"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Forcing presentation options: %lu", (unsigned long)enforcedOptions];
+    WCLogDebug(@"Application", @"Forcing presentation options: %lu", (unsigned long)enforcedOptions);
 
     // Call original implementation with our options
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(setPresentationOptions:)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalSetPresentationOptions);
     if (originalImp) {
         ((void (*)(id, SEL, NSApplicationPresentationOptions))originalImp)(self, _cmd, enforcedOptions);
     }
@@ -635,9 +686,7 @@ static void wc_setPresentationOptions(id self, SEL _cmd, NSApplicationPresentati
 // Swizzled isHidden getter
 static BOOL wc_isHidden(id self, SEL _cmd) {
     // Call original implementation
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(isHidden)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalIsHidden);
     if (originalImp) {
         return ((BOOL (*)(id, SEL))originalImp)(self, _cmd);
     }
@@ -647,9 +696,7 @@ static BOOL wc_isHidden(id self, SEL _cmd) {
 // Swizzled setHidden: setter
 static void wc_setHidden(id self, SEL _cmd, BOOL hidden) {
     // Call original implementation
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(setHidden:)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalSetHidden);
     if (originalImp) {
         ((void (*)(id, SEL, BOOL))originalImp)(self, _cmd, hidden);
     }
@@ -659,24 +706,14 @@ static void wc_setHidden(id self, SEL _cmd, BOOL hidden) {
 static BOOL wc_isActive(id self, SEL _cmd) {
     // Always report as active so the app thinks it's running normally
     // but don't actually make it active at the system level
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Application"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Intercepted isActive, returning YES without stealing focus"];
+    WCLogDebug(@"Application", @"Intercepted isActive, returning YES without stealing focus");
     return YES;
 }
 
 // Swizzled activateIgnoringOtherApps: method
 static void wc_activateIgnoringOtherApps(id self, SEL _cmd, BOOL flag) {
     // Don't activate the app - this prevents stealing focus
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Application"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Blocked activateIgnoringOtherApps: to prevent focus stealing"];
+    WCLogDebug(@"Application", @"Blocked activateIgnoringOtherApps: to prevent focus stealing");
 
     // Don't call original implementation to avoid activation
     // This prevents our app from stealing focus from text editors or other apps
@@ -685,9 +722,7 @@ static void wc_activateIgnoringOtherApps(id self, SEL _cmd, BOOL flag) {
 // Swizzled orderFrontStandardAboutPanel: method
 static void wc_orderFrontStandardAboutPanel(id self, SEL _cmd, id sender) {
     // Call original implementation
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(orderFrontStandardAboutPanel:)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalOrderFrontStandardAboutPanel);
     if (originalImp) {
         ((void (*)(id, SEL, id))originalImp)(self, _cmd, sender);
     }
@@ -696,9 +731,7 @@ static void wc_orderFrontStandardAboutPanel(id self, SEL _cmd, id sender) {
 // Swizzled hide: method
 static void wc_hide(id self, SEL _cmd, id sender) {
     // Call original implementation
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(hide:)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalHide);
     if (originalImp) {
         ((void (*)(id, SEL, id))originalImp)(self, _cmd, sender);
     }
@@ -707,9 +740,7 @@ static void wc_hide(id self, SEL _cmd, id sender) {
 // Swizzled unhide: method
 static void wc_unhide(id self, SEL _cmd, id sender) {
     // Call original implementation
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(unhide:)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalUnhide);
     if (originalImp) {
         ((void (*)(id, SEL, id))originalImp)(self, _cmd, sender);
     }
@@ -718,12 +749,7 @@ static void wc_unhide(id self, SEL _cmd, id sender) {
 // Additional override for becomeActiveApplication
 static void wc_becomeActiveApplication(id self, SEL _cmd) {
     // Block becoming the active application to avoid stealing focus
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Application"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Blocked becomeActiveApplication to prevent focus stealing"];
+    WCLogDebug(@"Application", @"Blocked becomeActiveApplication to prevent focus stealing");
 
     // Don't call the original implementation as this would make our app active
     // We want to avoid stealing focus from text editors or other apps
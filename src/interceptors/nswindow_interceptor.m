@@ -9,6 +9,7 @@
 #import "../util/error_manager.h"
 #import "../util/wc_cgs_types.h"
 #import "../util/wc_cgs_functions.h"
+#import "../util/wc_shared_config.h"
 #import "interceptor_registry.h"
 #import "../core/wc_window_info.h"
 #import <dlfcn.h>
@@ -33,9 +34,48 @@ static void wc_setStyleMask(id self, SEL _cmd, NSWindowStyleMask mask);
 static BOOL wc_acceptsMouseMovedEvents(id self, SEL _cmd);
 static void wc_setAcceptsMouseMovedEvents(id self, SEL _cmd, BOOL acceptsMouseMovedEvents);
 
+// Original implementations, filled in by the swizzler before each swap takes effect
+static WCIMPSlot gOriginalSetSharingType;
+static WCIMPSlot gOriginalIgnoresMouseEvents;
+static WCIMPSlot gOriginalSetIgnoresMouseEvents;
+static WCIMPSlot gOriginalHasShadow;
+static WCIMPSlot gOriginalSetHasShadow;
+static WCIMPSlot gOriginalAlphaValue;
+static WCIMPSlot gOriginalSetAlphaValue;
+static WCIMPSlot gOriginalSetLevel;
+static WCIMPSlot gOriginalSetCollectionBehavior;
+static WCIMPSlot gOriginalSetStyleMask;
+static WCIMPSlot gOriginalSetAcceptsMouseMovedEvents;
+
+// Groups of hooks that are swizzled and unswizzled together
+typedef NS_OPTIONS(NSUInteger, WCWindowHookGroup) {
+    WCWindowHookGroupNone        = 0,
+    WCWindowHookGroupSharing     = 1 << 0,  // sharingType, setSharingType:
+    WCWindowHookGroupLevel       = 1 << 1,  // level, setLevel:, collectionBehavior, setCollectionBehavior:
+    WCWindowHookGroupFocus       = 1 << 2,  // canBecomeKey, canBecomeMain
+    WCWindowHookGroupChrome      = 1 << 3,  // styleMask, acceptsMouseMovedEvents and their setters
+    WCWindowHookGroupPassThrough = 1 << 4,  // ignoresMouseEvents, hasShadow, alphaValue and their setters
+    WCWindowHookGroupAll         = (1 << 5) - 1
+};
+
+// Hook groups needed by a set of configuration options; chrome and pass-through hooks serve none
+static WCWindowHookGroup WCWindowHookGroupsForOptions(WCConfigurationOptions options) {
+    WCWindowHookGroup groups = WCWindowHookGroupNone;
+    if (options & WCConfigurationOptionPreventScreenCapture) {
+        groups |= WCWindowHookGroupSharing;
+    }
+    if (options & WCConfigurationOptionMakeAlwaysOnTop) {
+        // Floating windows must not take focus from the application underneath
+        groups |= WCWindowHookGroupLevel | WCWindowHookGroupFocus;
+    }
+    return groups;
+}
+
 @implementation WCNSWindowInterceptor {
     // Private instance variables
     BOOL _installed;
+    BOOL _hookMethodsAdded;
+    WCWindowHookGroup _installedHookGroups;
     dispatch_source_t _windowPropertyRefreshTimer;
 }
 
@@ -77,6 +117,10 @@ static void wc_setAcceptsMouseMovedEvents(id self, SEL _cmd, BOOL acceptsMouseMo
     return 50;
 }
 
++ (WCConfigurationOptions)requiredConfigurationOptions {
+    return WCConfigurationOptionPreventScreenCapture | WCConfigurationOptionMakeAlwaysOnTop;
+}
+
 #pragma mark - Initialization and Singleton Pattern
 
 + (instancetype)sharedInterceptor {
@@ -91,6 +135,8 @@ static void wc_setAcceptsMouseMovedEvents(id self, SEL _cmd, BOOL acceptsMouseMo
 - (instancetype)init {
     if (self = [super init]) {
         _installed = NO;
+        _hookMethodsAdded = NO;
+        _installedHookGroups = WCWindowHookGroupNone;
         _windowPropertyRefreshTimer = nil;
     }
     return self;
@@ -102,6 +148,10 @@ static void wc_setAcceptsMouseMovedEvents(id self, SEL _cmd, BOOL acceptsMouseMo
     return [[self sharedInterceptor] installInterceptor];
 }
 
++ (BOOL)installForConfigurationOptions:(WCConfigurationOptions)options {
+    return [[self sharedInterceptor] installHookGroups:WCWindowHookGroupsForOptions(options)];
+}
+
 + (BOOL)uninstall {
     return [[self sharedInterceptor] uninstallInterceptor];
 }
@@ -115,8 +165,15 @@ static void wc_setAcceptsMouseMovedEvents(id self, SEL _cmd, BOOL acceptsMouseMo
 }
 
 - (BOOL)installInterceptor {
+    return [self installHookGroups:WCWindowHookGroupAll];
+}
+
+// Swizzle the hook groups that are not installed yet
+- (BOOL)installHookGroups:(WCWindowHookGroup)groups {
+    WCWindowHookGroup missingGroups = groups & ~_installedHookGroups;
+
     // Don't install more than once
-    if (_installed) {
+    if (_installed && missingGroups == WCWindowHookGroupNone) {
         [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
                                      category:@"Interception"
                                          file:__FILE__
@@ -131,82 +188,84 @@ static void wc_setAcceptsMouseMovedEvents(id self, SEL _cmd, BOOL acceptsMouseMo
                                      file:__FILE__
                                      line:__LINE__
                                  function:__PRETTY_FUNCTION__
-                                   format:@"Installing NSWindow interceptor"];
+                                   format:@"Installing NSWindow interceptor hook groups: %lu", (unsigned long)missingGroups];
 
     BOOL success = YES;
     Class nsWindowClass = [NSWindow class];
 
-    // Set up notification observers for windows
-    [[NSNotificationCenter defaultCenter] addObserver:self
-                                             selector:@selector(windowDidBecomeVisible:)
-                                                 name:NSWindowDidExposeNotification
-                                               object:nil];
-
-    [[NSNotificationCenter defaultCenter] addObserver:self
-                                             selector:@selector(windowDidBecomeKey:)
-                                                 name:NSWindowDidBecomeKeyNotification
-                                               object:nil];
-
-    [[NSNotificationCenter defaultCenter] addObserver:self
-                                             selector:@selector(windowDidBecomeMain:)
-                                                 name:NSWindowDidBecomeMainNotification
-                                               object:nil];
-
-    // Process any existing windows right away
-    for (NSWindow *window in [NSApp windows]) {
-        [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                     category:@"Window"
-                                         file:__FILE__
-                                         line:__LINE__
-                                     function:__PRETTY_FUNCTION__
-                                       format:@"Applying protections to existing window: %@", window];
-        [self applyProtectionsToWindow:window];
-    }
-
-    // Set up a timer to periodically refresh properties
-    if (_windowPropertyRefreshTimer == nil) {
-        _windowPropertyRefreshTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER,
-                                                           0, 0, dispatch_get_main_queue());
-        if (_windowPropertyRefreshTimer) {
-            // Refresh every 1 second
-            dispatch_source_set_timer(_windowPropertyRefreshTimer,
-                                    dispatch_time(DISPATCH_TIME_NOW, 0),
-                                    1 * NSEC_PER_SEC,
-                                    0.1 * NSEC_PER_SEC);
-
-            dispatch_source_set_event_handler(_windowPropertyRefreshTimer, ^{
-                @try {
-                    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                                 category:@"Window"
-                                                     file:__FILE__
-                                                     line:__LINE__
-                                                 function:__PRETTY_FUNCTION__
-                                                   format:@"Running periodic window property refresh"];
-                    // Make a copy of the windows array to avoid mutation during enumeration
-                    NSArray *windows = [[NSApp windows] copy];
-                    for (NSWindow *window in windows) {
-                        // Extra safety check for each window
-                        if (window && [window isKindOfClass:[NSWindow class]]) {
-                            [self applyProtectionsToWindow:window];
-                        }
-                    }
-                } @catch (NSException *exception) {
-                    [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
-                                                 category:@"Window"
-                                                     file:__FILE__
-                                                     line:__LINE__
-                                                 function:__PRETTY_FUNCTION__
-                                                   format:@"Exception in timer handler: %@", exception.reason];
-                }
-            });
-
-            dispatch_resume(_windowPropertyRefreshTimer);
-            [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+    if (!_installed) {
+        // Set up notification observers for windows
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(windowDidBecomeVisible:)
+                                                     name:NSWindowDidExposeNotification
+                                                   object:nil];
+
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(windowDidBecomeKey:)
+                                                     name:NSWindowDidBecomeKeyNotification
+                                                   object:nil];
+
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(windowDidBecomeMain:)
+                                                     name:NSWindowDidBecomeMainNotification
+                                                   object:nil];
+
+        // Process any existing windows right away
+        for (NSWindow *window in [NSApp windows]) {
+            [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
                                          category:@"Window"
                                              file:__FILE__
                                              line:__LINE__
                                          function:__PRETTY_FUNCTION__
-                                           format:@"Started window property refresh timer"];
+                                           format:@"Applying protections to existing window: %@", window];
+            [self applyProtectionsToWindow:window];
+        }
+
+        // Set up a timer to periodically refresh properties
+        if (_windowPropertyRefreshTimer == nil) {
+            _windowPropertyRefreshTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER,
+                                                               0, 0, dispatch_get_main_queue());
+            if (_windowPropertyRefreshTimer) {
+                // Refresh every 1 second
+                dispatch_source_set_timer(_windowPropertyRefreshTimer,
+                                        dispatch_time(DISPATCH_TIME_NOW, 0),
+                                        1 * NSEC_PER_SEC,
+                                        0.1 * NSEC_PER_SEC);
+
+                dispatch_source_set_event_handler(_windowPropertyRefreshTimer, ^{
+                    @try {
+                        [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
+                                                     category:@"Window"
+                                                         file:__FILE__
+                                                         line:__LINE__
+                                                     function:__PRETTY_FUNCTION__
+                                                       format:@"Running periodic window property refresh"];
+                        // Make a copy of the windows array to avoid mutation during enumeration
+                        NSArray *windows = [[NSApp windows] copy];
+                        for (NSWindow *window in windows) {
+                            // Extra safety check for each window
+                            if (window && [window isKindOfClass:[NSWindow class]]) {
+                                [self applyProtectionsToWindow:window];
+                            }
+                        }
+                    } @catch (NSException *exception) {
+                        [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
+                                                     category:@"Window"
+                                                         file:__FILE__
+                                                         line:__LINE__
+                                                     function:__PRETTY_FUNCTION__
+                                                       format:@"Exception in timer handler: %@", exception.reason];
+                    }
+                });
+
+                dispatch_resume(_windowPropertyRefreshTimer);
+                [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                             category:@"Window"
+                                                 file:__FILE__
+                                                 line:__LINE__
+                                             function:__PRETTY_FUNCTION__
+                                               format:@"Started window property refresh timer"];
+            }
         }
     }
 
@@ -226,106 +285,110 @@ static void wc_setAcceptsMouseMovedEvents(id self, SEL _cmd, BOOL acceptsMouseMo
     const char *styleMaskType = "Q@:";
     const char *setStyleMaskType = "v@:Q";
 
-    // Add methods with prefix "wc_" to the NSWindow class
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_sharingType)
-                         implementation:(IMP)wc_sharingType
-                          typeEncoding:sharingTypeType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_setSharingType:)
-                         implementation:(IMP)wc_setSharingType
-                          typeEncoding:setSharingTypeType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_canBecomeKey)
-                         implementation:(IMP)wc_canBecomeKey
-                          typeEncoding:boolType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_canBecomeMain)
-                         implementation:(IMP)wc_canBecomeMain
-                          typeEncoding:boolType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_ignoresMouseEvents)
-                         implementation:(IMP)wc_ignoresMouseEvents
-                          typeEncoding:boolType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_setIgnoresMouseEvents:)
-                         implementation:(IMP)wc_setIgnoresMouseEvents
-                          typeEncoding:setBoolType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_hasShadow)
-                         implementation:(IMP)wc_hasShadow
-                          typeEncoding:boolType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_setHasShadow:)
-                         implementation:(IMP)wc_setHasShadow
-                          typeEncoding:setBoolType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_alphaValue)
-                         implementation:(IMP)wc_alphaValue
-                          typeEncoding:floatType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_setAlphaValue:)
-                         implementation:(IMP)wc_setAlphaValue
-                          typeEncoding:setFloatType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_level)
-                         implementation:(IMP)wc_level
-                          typeEncoding:levelType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_setLevel:)
-                         implementation:(IMP)wc_setLevel
-                          typeEncoding:setLevelType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_collectionBehavior)
-                         implementation:(IMP)wc_collectionBehavior
-                          typeEncoding:behaviorType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_setCollectionBehavior:)
-                         implementation:(IMP)wc_setCollectionBehavior
-                          typeEncoding:setBehaviorType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_styleMask)
-                         implementation:(IMP)wc_styleMask
-                          typeEncoding:styleMaskType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_setStyleMask:)
-                         implementation:(IMP)wc_setStyleMask
-                          typeEncoding:setStyleMaskType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_acceptsMouseMovedEvents)
-                         implementation:(IMP)wc_acceptsMouseMovedEvents
-                          typeEncoding:boolType];
-
-    [WCMethodSwizzler addMethodToClass:nsWindowClass
-                              selector:@selector(wc_setAcceptsMouseMovedEvents:)
-                         implementation:(IMP)wc_setAcceptsMouseMovedEvents
-                          typeEncoding:setBoolType];
+    // Add methods with prefix "wc_" to the NSWindow class, once for all hook groups
+    if (!_hookMethodsAdded) {
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_sharingType)
+                             implementation:(IMP)wc_sharingType
+                              typeEncoding:sharingTypeType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_setSharingType:)
+                             implementation:(IMP)wc_setSharingType
+                              typeEncoding:setSharingTypeType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_canBecomeKey)
+                             implementation:(IMP)wc_canBecomeKey
+                              typeEncoding:boolType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_canBecomeMain)
+                             implementation:(IMP)wc_canBecomeMain
+                              typeEncoding:boolType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_ignoresMouseEvents)
+                             implementation:(IMP)wc_ignoresMouseEvents
+                              typeEncoding:boolType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_setIgnoresMouseEvents:)
+                             implementation:(IMP)wc_setIgnoresMouseEvents
+                              typeEncoding:setBoolType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_hasShadow)
+                             implementation:(IMP)wc_hasShadow
+                              typeEncoding:boolType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_setHasShadow:)
+                             implementation:(IMP)wc_setHasShadow
+                              typeEncoding:setBoolType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_alphaValue)
+                             implementation:(IMP)wc_alphaValue
+                              typeEncoding:floatType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_setAlphaValue:)
+                             implementation:(IMP)wc_setAlphaValue
+                              typeEncoding:setFloatType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_level)
+                             implementation:(IMP)wc_level
+                              typeEncoding:levelType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_setLevel:)
+                             implementation:(IMP)wc_setLevel
+                              typeEncoding:setLevelType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_collectionBehavior)
+                             implementation:(IMP)wc_collectionBehavior
+                              typeEncoding:behaviorType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_setCollectionBehavior:)
+                             implementation:(IMP)wc_setCollectionBehavior
+                              typeEncoding:setBehaviorType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_styleMask)
+                             implementation:(IMP)wc_styleMask
+                              typeEncoding:styleMaskType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_setStyleMask:)
+                             implementation:(IMP)wc_setStyleMask
+                              typeEncoding:setStyleMaskType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_acceptsMouseMovedEvents)
+                             implementation:(IMP)wc_acceptsMouseMovedEvents
+                              typeEncoding:boolType];
+
+        [WCMethodSwizzler addMethodToClass:nsWindowClass
+                                  selector:@selector(wc_setAcceptsMouseMovedEvents:)
+                             implementation:(IMP)wc_setAcceptsMouseMovedEvents
+                              typeEncoding:setBoolType];
+        _hookMethodsAdded = YES;
+    }
 
     // Then swizzle the original methods with our custom implementations
 
     // Helper macro to safely swizzle methods only if they exist
-    #define SAFE_SWIZZLE(origSel, newSel, type) \
+    #define SAFE_SWIZZLE(origSel, newSel, type, slot) \
         if ([WCMethodSwizzler class:nsWindowClass implementsSelector:origSel ofType:type]) { \
             if (![WCMethodSwizzler swizzleClass:nsWindowClass \
                                 originalSelector:origSel \
                              replacementSelector:newSel \
-                              implementationType:type]) { \
+                              implementationType:type \
+                                 originalIMPSlot:slot]) { \
                 [[WCLogger sharedLogger] logWithLevel:WCLogLevelWarning \
                                              category:@"Interception" \
                                                  file:__FILE__ \
@@ -350,25 +413,35 @@ static void wc_setAcceptsMouseMovedEvents(id self, SEL _cmd, BOOL acceptsMouseMo
                                            format:@"Method %@ not found in NSWindow, skipping swizzle", NSStringFromSelector(origSel)]; \
         }
 
-    // Swizzle methods that exist
-    SAFE_SWIZZLE(@selector(sharingType), @selector(wc_sharingType), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(setSharingType:), @selector(wc_setSharingType:), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(canBecomeKey), @selector(wc_canBecomeKey), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(canBecomeMain), @selector(wc_canBecomeMain), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(ignoresMouseEvents), @selector(wc_ignoresMouseEvents), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(setIgnoresMouseEvents:), @selector(wc_setIgnoresMouseEvents:), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(hasShadow), @selector(wc_hasShadow), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(setHasShadow:), @selector(wc_setHasShadow:), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(alphaValue), @selector(wc_alphaValue), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(setAlphaValue:), @selector(wc_setAlphaValue:), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(level), @selector(wc_level), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(setLevel:), @selector(wc_setLevel:), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(collectionBehavior), @selector(wc_collectionBehavior), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(setCollectionBehavior:), @selector(wc_setCollectionBehavior:), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(styleMask), @selector(wc_styleMask), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(setStyleMask:), @selector(wc_setStyleMask:), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(acceptsMouseMovedEvents), @selector(wc_acceptsMouseMovedEvents), WCImplementationTypeMethod);
-    SAFE_SWIZZLE(@selector(setAcceptsMouseMovedEvents:), @selector(wc_setAcceptsMouseMovedEvents:), WCImplementationTypeMethod);
+    // Swizzle methods that exist, only for the requested hook groups
+    if (missingGroups & WCWindowHookGroupSharing) {
+        SAFE_SWIZZLE(@selector(sharingType), @selector(wc_sharingType), WCImplementationTypeMethod, NULL);
+        SAFE_SWIZZLE(@selector(setSharingType:), @selector(wc_setSharingType:), WCImplementationTypeMethod, &gOriginalSetSharingType);
+    }
+    if (missingGroups & WCWindowHookGroupFocus) {
+        SAFE_SWIZZLE(@selector(canBecomeKey), @selector(wc_canBecomeKey), WCImplementationTypeMethod, NULL);
+        SAFE_SWIZZLE(@selector(canBecomeMain), @selector(wc_canBecomeMain), WCImplementationTypeMethod, NULL);
+    }
+    if (missingGroups & WCWindowHookGroupPassThrough) {
+        SAFE_SWIZZLE(@selector(ignoresMouseEvents), @selector(wc_ignoresMouseEvents), WCImplementationTypeMethod, &gOriginalIgnoresMouseEvents);
+        SAFE_SWIZZLE(@selector(setIgnoresMouseEvents:), @selector(wc_setIgnoresMouseEvents:), WCImplementationTypeMethod, &gOriginalSetIgnoresMouseEvents);
+        SAFE_SWIZZLE(@selector(hasShadow), @selector(wc_hasShadow), WCImplementationTypeMethod, &gOriginalHasShadow);
+        SAFE_SWIZZLE(@selector(setHasShadow:), @selector(wc_setHasShadow:), WCImplementationTypeMethod, &gOriginalSetHasShadow);
+        SAFE_SWIZZLE(@selector(alphaValue), @selector(wc_alphaValue), WCImplementationTypeMethod, &gOriginalAlphaValue);
+        SAFE_SWIZZLE(@selector(setAlphaValue:), @selector(wc_setAlphaValue:), WCImplementationTypeMethod, &gOriginalSetAlphaValue);
+    }
+    if (missingGroups & WCWindowHookGroupLevel) {
+        SAFE_SWIZZLE(@selector(level), @selector(wc_level), WCImplementationTypeMethod, NULL);
+        SAFE_SWIZZLE(@selector(setLevel:), @selector(wc_setLevel:), WCImplementationTypeMethod, &gOriginalSetLevel);
+        SAFE_SWIZZLE(@selector(collectionBehavior), @selector(wc_collectionBehavior), WCImplementationTypeMethod, NULL);
+        SAFE_SWIZZLE(@selector(setCollectionBehavior:), @selector(wc_setCollectionBehavior:), WCImplementationTypeMethod, &gOriginalSetCollectionBehavior);
+    }
+    if (missingGroups & WCWindowHookGroupChrome) {
+        SAFE_SWIZZLE(@selector(styleMask), @selector(wc_styleMask), WCImplementationTypeMethod, NULL);
+        SAFE_SWIZZLE(@selector(setStyleMask:), @selector(wc_setStyleMask:), WCImplementationTypeMethod, &gOriginalSetStyleMask);
+        SAFE_SWIZZLE(@selector(acceptsMouseMovedEvents), @selector(wc_acceptsMouseMovedEvents), WCImplementationTypeMethod, NULL);
+        SAFE_SWIZZLE(@selector(setAcceptsMouseMovedEvents:), @selector(wc_setAcceptsMouseMovedEvents:), WCImplementationTypeMethod, &gOriginalSetAcceptsMouseMovedEvents);
+    }
 
     #undef SAFE_SWIZZLE
 
@@ -379,6 +452,7 @@ static void wc_setAcceptsMouseMovedEvents(id self, SEL _cmd, BOOL acceptsMouseMo
                                      line:__LINE__
                                  function:__PRETTY_FUNCTION__
                                    format:@"NSWindow interceptor installed successfully"];
+        _installedHookGroups |= missingGroups;
         _installed = YES;
     } else {
         [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
@@ -458,25 +532,35 @@ static void wc_setAcceptsMouseMovedEvents(id self, SEL _cmd, BOOL acceptsMouseMo
             } \
         }
 
-    // Unswizzle all methods we swizzled
-    SAFE_UNSWIZZLE(@selector(sharingType), @selector(wc_sharingType), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(setSharingType:), @selector(wc_setSharingType:), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(canBecomeKey), @selector(wc_canBecomeKey), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(canBecomeMain), @selector(wc_canBecomeMain), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(ignoresMouseEvents), @selector(wc_ignoresMouseEvents), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(setIgnoresMouseEvents:), @selector(wc_setIgnoresMouseEvents:), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(hasShadow), @selector(wc_hasShadow), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(setHasShadow:), @selector(wc_setHasShadow:), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(alphaValue), @selector(wc_alphaValue), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(setAlphaValue:), @selector(wc_setAlphaValue:), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(level), @selector(wc_level), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(setLevel:), @selector(wc_setLevel:), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(collectionBehavior), @selector(wc_collectionBehavior), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(setCollectionBehavior:), @selector(wc_setCollectionBehavior:), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(styleMask), @selector(wc_styleMask), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(setStyleMask:), @selector(wc_setStyleMask:), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(acceptsMouseMovedEvents), @selector(wc_acceptsMouseMovedEvents), WCImplementationTypeMethod);
-    SAFE_UNSWIZZLE(@selector(setAcceptsMouseMovedEvents:), @selector(wc_setAcceptsMouseMovedEvents:), WCImplementationTypeMethod);
+    // Unswizzle only the hook groups we swizzled
+    if (_installedHookGroups & WCWindowHookGroupSharing) {
+        SAFE_UNSWIZZLE(@selector(sharingType), @selector(wc_sharingType), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(setSharingType:), @selector(wc_setSharingType:), WCImplementationTypeMethod);
+    }
+    if (_installedHookGroups & WCWindowHookGroupFocus) {
+        SAFE_UNSWIZZLE(@selector(canBecomeKey), @selector(wc_canBecomeKey), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(canBecomeMain), @selector(wc_canBecomeMain), WCImplementationTypeMethod);
+    }
+    if (_installedHookGroups & WCWindowHookGroupPassThrough) {
+        SAFE_UNSWIZZLE(@selector(ignoresMouseEvents), @selector(wc_ignoresMouseEvents), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(setIgnoresMouseEvents:), @selector(wc_setIgnoresMouseEvents:), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(hasShadow), @selector(wc_hasShadow), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(setHasShadow:), @selector(wc_setHasShadow:), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(alphaValue), @selector(wc_alphaValue), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(setAlphaValue:), @selector(wc_setAlphaValue:), WCImplementationTypeMethod);
+    }
+    if (_installedHookGroups & WCWindowHookGroupLevel) {
+        SAFE_UNSWIZZLE(@selector(level), @selector(wc_level), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(setLevel:), @selector(wc_setLevel:), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(collectionBehavior), @selector(wc_collectionBehavior), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(setCollectionBehavior:), @selector(wc_setCollectionBehavior:), WCImplementationTypeMethod);
+    }
+    if (_installedHookGroups & WCWindowHookGroupChrome) {
+        SAFE_UNSWIZZLE(@selector(styleMask), @selector(wc_styleMask), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(setStyleMask:), @selector(wc_setStyleMask:), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(acceptsMouseMovedEvents), @selector(wc_acceptsMouseMovedEvents), WCImplementationTypeMethod);
+        SAFE_UNSWIZZLE(@selector(setAcceptsMouseMovedEvents:), @selector(wc_setAcceptsMouseMovedEvents:), WCImplementationTypeMethod);
+    }
 
     #undef SAFE_UNSWIZZLE
 
@@ -487,6 +571,7 @@ static void wc_setAcceptsMouseMovedEvents(id self, SEL _cmd, BOOL acceptsMouseMo
                                          line:__LINE__
                                      function:__PRETTY_FUNCTION__
                                        format:@"NSWindow interceptor uninstalled successfully"];
+        _installedHookGroups = WCWindowHookGroupNone;
         _installed = NO;
     } else {
         [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
@@ -573,8 +658,10 @@ static void wc_setAcceptsMouseMovedEvents(id self, SEL _cmd, BOOL acceptsMouseMo
 
         // Apply all protections using the standardized methods in WCWindowInfo
         // This consolidates the window protection logic in one place
-        [windowInfo makeInvisibleToScreenRecording];
-        [windowInfo setLevel:NSFloatingWindowLevel];
+        if (WCSharedConfigActiveSharingType() == NSWindowSharingNone) {
+            [windowInfo makeInvisibleToScreenRecording];
+        }
+        [windowInfo setLevel:(NSWindowLevel)WCSharedConfigActiveWindowLevel()];
         [windowInfo setWindowTagsForMissionControlVisibility];
         [windowInfo disableStatusBar];
 
@@ -623,31 +710,20 @@ static void wc_setAcceptsMouseMovedEvents(id self, SEL _cmd, BOOL acceptsMouseMo
 
 // Swizzled sharingType getter
 static NSWindowSharingType wc_sharingType(id self, SEL _cmd) {
-    // Override: Make windows invisible to screen recording
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Window"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Intercepted sharingType call, forcing NSWindowSharingNone"];
-    return NSWindowSharingNone;
+    // Override: Make windows invisible to screen recording unless the shared configuration lifted it
+    NSWindowSharingType sharingType = (NSWindowSharingType)WCSharedConfigActiveSharingType();
+    WCLogDebug(@"Window", @"Intercepted sharingType call, forcing %ld", (long)sharingType);
+    return sharingType;
 }
 
 // Swizzled sharingType setter
 static void wc_setSharingType(id self, SEL _cmd, NSWindowSharingType sharingType) {
-    // Override: Always set to NSWindowSharingNone to make windows invisible to screen recording
-    sharingType = NSWindowSharingNone;
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Window"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Forcing window sharing type to NSWindowSharingNone"];
+    // Override: Always set the configured sharing type, NSWindowSharingNone by default
+    sharingType = (NSWindowSharingType)WCSharedConfigActiveSharingType();
+    WCLogDebug(@"Window", @"Forcing window sharing type to %ld", (long)sharingType);
 
-    // Call original implementation (stored by our method swizzler)
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(setSharingType:)
-                                                    implementationType:WCImplementationTypeMethod];
+    // Call original implementation (published to its slot by our method swizzler)
+    IMP originalImp = WCIMPSlotLoad(&gOriginalSetSharingType);
     if (originalImp) {
         ((void (*)(id, SEL, NSWindowSharingType))originalImp)(self, _cmd, sharingType);
     }
@@ -656,33 +732,21 @@ static void wc_setSharingType(id self, SEL _cmd, NSWindowSharingType sharingType
 // Swizzled canBecomeKey getter
 static BOOL wc_canBecomeKey(id self, SEL _cmd) {
     // Prevent windows from becoming key windows to avoid stealing focus
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Window"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Intercepted canBecomeKey, returning NO to prevent focus stealing"];
+    WCLogDebug(@"Window", @"Intercepted canBecomeKey, returning NO to prevent focus stealing");
     return NO;
 }
 
 // Swizzled canBecomeMain getter
 static BOOL wc_canBecomeMain(id self, SEL _cmd) {
     // Prevent windows from becoming main windows to avoid focus stealing
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Window"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Intercepted canBecomeMain, returning NO to prevent focus stealing"];
+    WCLogDebug(@"Window", @"Intercepted canBecomeMain, returning NO to prevent focus stealing");
     return NO;
 }
 
 // Swizzled ignoresMouseEvents getter
 static BOOL wc_ignoresMouseEvents(id self, SEL _cmd) {
     // By default, don't ignore mouse events
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(ignoresMouseEvents)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalIgnoresMouseEvents);
     if (originalImp) {
         return ((BOOL (*)(id, SEL))originalImp)(self, _cmd);
     }
@@ -692,9 +756,7 @@ static BOOL wc_ignoresMouseEvents(id self, SEL _cmd) {
 // Swizzled ignoresMouseEvents setter
 static void wc_setIgnoresMouseEvents(id self, SEL _cmd, BOOL ignoresMouseEvents) {
     // Call original implementation
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(setIgnoresMouseEvents:)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalSetIgnoresMouseEvents);
     if (originalImp) {
         ((void (*)(id, SEL, BOOL))originalImp)(self, _cmd, ignoresMouseEvents);
     }
@@ -703,9 +765,7 @@ static void wc_setIgnoresMouseEvents(id self, SEL _cmd, BOOL ignoresMouseEvents)
 // Swizzled hasShadow getter
 static BOOL wc_hasShadow(id self, SEL _cmd) {
     // Call original implementation
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(hasShadow)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalHasShadow);
     if (originalImp) {
         return ((BOOL (*)(id, SEL))originalImp)(self, _cmd);
     }
@@ -715,9 +775,7 @@ static BOOL wc_hasShadow(id self, SEL _cmd) {
 // Swizzled hasShadow setter
 static void wc_setHasShadow(id self, SEL _cmd, BOOL hasShadow) {
     // Call original implementation
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(setHasShadow:)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalSetHasShadow);
     if (originalImp) {
         ((void (*)(id, SEL, BOOL))originalImp)(self, _cmd, hasShadow);
     }
@@ -726,9 +784,7 @@ static void wc_setHasShadow(id self, SEL _cmd, BOOL hasShadow) {
 // Swizzled alphaValue getter
 static CGFloat wc_alphaValue(id self, SEL _cmd) {
     // Call original implementation
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(alphaValue)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalAlphaValue);
     if (originalImp) {
         return ((CGFloat (*)(id, SEL))originalImp)(self, _cmd);
     }
@@ -738,9 +794,7 @@ static CGFloat wc_alphaValue(id self, SEL _cmd) {
 // Swizzled alphaValue setter
 static void wc_setAlphaValue(id self, SEL _cmd, CGFloat alphaValue) {
     // Call original implementation
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(setAlphaValue:)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalSetAlphaValue);
     if (originalImp) {
         ((void (*)(id, SEL, CGFloat))originalImp)(self, _cmd, alphaValue);
     }
@@ -748,33 +802,21 @@ static void wc_setAlphaValue(id self, SEL _cmd, CGFloat alphaValue) {
 
 // Swizzled level getter
 static NSWindowLevel wc_level(id self, SEL _cmd) {
-    // Use NSFloatingWindowLevel for optimal visibility and Mission Control compatibility
-    NSWindowLevel levelForVisibility = NSFloatingWindowLevel;
+    // Use the configured level, NSFloatingWindowLevel by default for visibility and Mission Control compatibility
+    NSWindowLevel levelForVisibility = (NSWindowLevel)WCSharedConfigActiveWindowLevel();
 
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Window"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Intercepted level call, using NSFloatingWindowLevel for better visibility and Mission Control compatibility"];
+    WCLogDebug(@"Window", @"Intercepted level call, using level %ld", (long)levelForVisibility);
     return levelForVisibility;
 }
 
 // Swizzled level setter
 static void wc_setLevel(id self, SEL _cmd, NSWindowLevel level) {
-    // Force NSFloatingWindowLevel for optimal visibility and Mission Control compatibility
-    level = NSFloatingWindowLevel;
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Window"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Setting window level to NSFloatingWindowLevel for better visibility and Mission Control compatibility"];
+    // Force the configured level, NSFloatingWindowLevel by default for visibility and Mission Control compatibility
+    level = (NSWindowLevel)WCSharedConfigActiveWindowLevel();
+    WCLogDebug(@"Window", @"Setting window level to %ld", (long)level);
 
     // Call original implementation with our forced level
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(setLevel:)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalSetLevel);
     if (originalImp) {
         ((void (*)(id, SEL, NSWindowLevel))originalImp)(self, _cmd, level);
     }
@@ -791,8 +833,8 @@ static void wc_setLevel(id self, SEL _cmd, NSWindowLevel level) {
                     [cgs performCGSOperation:@"SetWindowLevel"
                                withWindowID:windowID
                                   operation:^CGError(CGSConnectionID cid, CGSWindowID wid) {
-                        // Use NSFloatingWindowLevel for consistent window level across all APIs
-                        return cgs.CGSSetWindowLevel(cid, wid, NSFloatingWindowLevel);
+                        // Use the same level at the CGS level for consistency across all APIs
+                        return cgs.CGSSetWindowLevel(cid, wid, (CGWindowLevel)level);
                     }];
                 }
             }
@@ -817,12 +859,7 @@ static NSWindowCollectionBehavior wc_collectionBehavior(id self, SEL _cmd) {
     behavior &= ~NSWindowCollectionBehaviorIgnoresCycle;
     behavior &= ~NSWindowCollectionBehaviorTransient;
 
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Window"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Intercepted collectionBehavior, returning optimized value for Mission Control: %lu", (unsigned long)behavior];
+    WCLogDebug(@"Window", @"Intercepted collectionBehavior, returning optimized value for Mission Control: %lu", (unsigned long)behavior);
     return behavior;
 }
 
@@ -843,24 +880,17 @@ static void wc_setCollectionBehavior(id self, SEL _cmd, NSWindowCollectionBehavi
     behavior &= ~NSWindowCollectionBehaviorIgnoresCycle;
     behavior &= ~NSWindowCollectionBehaviorTransient;
 
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Window"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Setting optimized collectionBehavior for Mission Control: %lu", (unsigned long)behavior];
+    WCLogDebug(@"Window", @"Setting optimized collectionBehavior for Mission Control: %lu", (unsigned long)behavior);
 
     // Call original implementation with our optimized behavior
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(setCollectionBehavior:)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalSetCollectionBehavior);
     if (originalImp) {
         ((void (*)(id, SEL, NSWindowCollectionBehavior))originalImp)(self, _cmd, behavior);
     }
 
     // Set window level to ensure consistent behavior
     if ([self respondsToSelector:@selector(setLevel:)]) {
-        [(NSWindow*)self setLevel:NSFloatingWindowLevel];
+        [(NSWindow*)self setLevel:(NSWindowLevel)WCSharedConfigActiveWindowLevel()];
     }
 }
 
@@ -880,12 +910,7 @@ static NSWindowStyleMask wc_styleMask(id self, SEL _cmd) {
     mask &= ~NSWindowStyleMaskClosable;
     mask &= ~NSWindowStyleMaskMiniaturizable;
 
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Window"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Intercepted styleMask, returning ultra-minimal style mask with no status/title bar"];
+    WCLogDebug(@"Window", @"Intercepted styleMask, returning ultra-minimal style mask with no status/title bar");
 
     // Call additional methods to ensure title bar is completely disabled
     // Force-hide title bar via these methods
@@ -919,17 +944,10 @@ static void wc_setStyleMask(id self, SEL _cmd, NSWindowStyleMask mask) {
     mask &= ~NSWindowStyleMaskClosable;
     mask &= ~NSWindowStyleMaskMiniaturizable;
 
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Window"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Ultra-aggressively modifying window style mask to disable title/status bar"];
+    WCLogDebug(@"Window", @"Ultra-aggressively modifying window style mask to disable title/status bar");
 
     // Call original implementation
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(setStyleMask:)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalSetStyleMask);
     if (originalImp) {
         ((void (*)(id, SEL, NSWindowStyleMask))originalImp)(self, _cmd, mask);
     }
@@ -975,12 +993,7 @@ static void wc_setStyleMask(id self, SEL _cmd, NSWindowStyleMask mask) {
             [invocation setArgument:&height atIndex:2];
             [invocation invoke];
 
-            [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                         category:@"Window"
-                                             file:__FILE__
-                                             line:__LINE__
-                                         function:__PRETTY_FUNCTION__
-                                           format:@"Applied zero titlebar height using private API"];
+            WCLogDebug(@"Window", @"Applied zero titlebar height using private API");
         }
     }
 }
@@ -988,12 +1001,7 @@ static void wc_setStyleMask(id self, SEL _cmd, NSWindowStyleMask mask) {
 // Swizzled acceptsMouseMovedEvents getter
 static BOOL wc_acceptsMouseMovedEvents(id self, SEL _cmd) {
     // Always accept mouse moved events to ensure we can track the mouse
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Window"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Intercepted acceptsMouseMovedEvents, returning YES"];
+    WCLogDebug(@"Window", @"Intercepted acceptsMouseMovedEvents, returning YES");
     return YES;
 }
 
@@ -1002,17 +1010,10 @@ static void wc_setAcceptsMouseMovedEvents(id self, SEL _cmd, BOOL acceptsMouseMo
     // Always force to YES
     acceptsMouseMovedEvents = YES;
 
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
-                                 category:@"Window"
-                                     file:__FILE__
-                                     line:__LINE__
-                                 function:__PRETTY_FUNCTION__
-                                   format:@"Forcing acceptsMouseMovedEvents to YES"];
+    WCLogDebug(@"Window", @"Forcing acceptsMouseMovedEvents to YES");
 
     // Call original implementation with our forced value
-    IMP originalImp = [WCMethodSwizzler originalImplementationForClass:[self class]
-                                                              selector:@selector(setAcceptsMouseMovedEvents:)
-                                                    implementationType:WCImplementationTypeMethod];
+    IMP originalImp = WCIMPSlotLoad(&gOriginalSetAcceptsMouseMovedEvents);
     if (originalImp) {
         ((void (*)(id, SEL, BOOL))originalImp)(self, _cmd, acceptsMouseMovedEvents);
     }
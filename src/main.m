@@ -5,12 +5,24 @@
 
 #import <Foundation/Foundation.h>
 #import <AppKit/AppKit.h>
+#import <signal.h>
 #import "../src/core/protector.h"
+#import "../src/core/wc_injector_daemon.h"
+#import "../src/util/configuration_manager.h"
 #import "../src/util/logger.h"
+#import "../src/util/wc_fleet_metrics.h"
+#import "../src/util/wc_log_ring.h"
+#import "../src/util/wc_shared_config.h"
 
 // Function prototypes
 void printUsage(void);
 NSString *resolveApplicationPath(NSString *path, BOOL debugMode);
+NSArray<NSString *> *readManifestFile(NSString *manifestPath);
+int protectApplicationsInBatch(NSArray<NSString *> *applicationPaths, NSTimeInterval timeout);
+int runDaemon(NSString *socketPath, NSArray<NSString *> *watchedPaths, BOOL relaunch);
+int sendDaemonRequest(NSString *socketPath, NSString *command, NSArray<NSString *> *applicationPaths, NSTimeInterval timeout);
+int publishSharedConfiguration(NSNumber *windowLevel, NSNumber *captureProtection);
+int printFleetMetrics(NSString *format);
 
 /**
  * Main entry point for the WindowControlInjector command-line tool
@@ -20,7 +32,16 @@ int main(int argc, const char * argv[]) {
         // Default log level
         [WCProtector setLogLevel:WCLogLevelWarning];
 
-        NSString *applicationPath = nil;
+        NSMutableArray<NSString *> *applicationPaths = [NSMutableArray array];
+        BOOL batchMode = NO;
+        NSTimeInterval launchTimeout = WCProtectorDefaultLaunchTimeout;
+        BOOL daemonMode = NO;
+        BOOL relaunchUnprotected = NO;
+        BOOL spawnSuspended = NO;
+        NSString *daemonCommand = nil;
+        NSString *socketPath = nil;
+        NSNumber *sharedWindowLevel = nil;
+        NSNumber *sharedCaptureProtection = nil;
 
         // Skip the program name (argv[0])
         for (int i = 1; i < argc; i++) {
@@ -33,6 +54,116 @@ int main(int argc, const char * argv[]) {
                     return 0;
                 } else if ([arg isEqualToString:@"-v"] || [arg isEqualToString:@"--verbose"]) {
                     [WCProtector setLogLevel:WCLogLevelDebug];
+                } else if ([arg isEqualToString:@"--decode-log"]) {
+                    if (i + 1 >= argc) {
+                        [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
+                                                     category:@"General"
+                                                         file:__FILE__
+                                                         line:__LINE__
+                                                     function:__PRETTY_FUNCTION__
+                                                       format:@"--decode-log requires a log file path"];
+                        printUsage();
+                        return 1;
+                    }
+
+                    // Decode a binary log written by WCSetBinaryLogFilePath and exit
+                    if (!WCLogDecodeBinaryFile(argv[i + 1], stdout)) {
+                        fprintf(stderr, "[WindowControlInjector] ERROR: Could not decode binary log: %s\n", argv[i + 1]);
+                        return 1;
+                    }
+                    return 0;
+                } else if ([arg isEqualToString:@"-m"] || [arg isEqualToString:@"--manifest"]) {
+                    if (i + 1 >= argc) {
+                        [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
+                                                     category:@"General"
+                                                         file:__FILE__
+                                                         line:__LINE__
+                                                     function:__PRETTY_FUNCTION__
+                                                       format:@"--manifest requires a file path"];
+                        printUsage();
+                        return 1;
+                    }
+
+                    NSArray<NSString *> *manifestPaths = readManifestFile([NSString stringWithUTF8String:argv[++i]]);
+                    if (manifestPaths == nil) {
+                        return 1;
+                    }
+                    [applicationPaths addObjectsFromArray:manifestPaths];
+                    batchMode = YES;
+                } else if ([arg isEqualToString:@"--daemon"]) {
+                    daemonMode = YES;
+                } else if ([arg isEqualToString:@"--relaunch"]) {
+                    relaunchUnprotected = YES;
+                } else if ([arg isEqualToString:@"--spawn"]) {
+                    spawnSuspended = YES;
+                } else if ([arg isEqualToString:@"--status"]) {
+                    daemonCommand = @"status";
+                } else if ([arg isEqualToString:@"--via-daemon"]) {
+                    daemonCommand = @"protect";
+                } else if ([arg isEqualToString:@"--unprotect"]) {
+                    daemonCommand = @"unprotect";
+                } else if ([arg isEqualToString:@"--socket"]) {
+                    if (i + 1 >= argc) {
+                        [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
+                                                     category:@"General"
+                                                         file:__FILE__
+                                                         line:__LINE__
+                                                     function:__PRETTY_FUNCTION__
+                                                       format:@"--socket requires a socket path"];
+                        printUsage();
+                        return 1;
+                    }
+                    socketPath = [NSString stringWithUTF8String:argv[++i]];
+                } else if ([arg isEqualToString:@"--metrics"]) {
+                    NSString *format = i + 1 < argc ? [NSString stringWithUTF8String:argv[++i]] : nil;
+                    if (![format isEqualToString:@"json"] && ![format isEqualToString:@"statsd"]) {
+                        [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
+                                                     category:@"General"
+                                                         file:__FILE__
+                                                         line:__LINE__
+                                                     function:__PRETTY_FUNCTION__
+                                                       format:@"--metrics requires json or statsd"];
+                        printUsage();
+                        return 1;
+                    }
+                    return printFleetMetrics(format);
+                } else if ([arg isEqualToString:@"--set-level"]) {
+                    if (i + 1 >= argc) {
+                        [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
+                                                     category:@"General"
+                                                         file:__FILE__
+                                                         line:__LINE__
+                                                     function:__PRETTY_FUNCTION__
+                                                       format:@"--set-level requires a window level"];
+                        printUsage();
+                        return 1;
+                    }
+                    sharedWindowLevel = @(atol(argv[++i]));
+                } else if ([arg isEqualToString:@"--capture-protection"]) {
+                    NSString *value = i + 1 < argc ? [NSString stringWithUTF8String:argv[++i]] : nil;
+                    if (![value isEqualToString:@"on"] && ![value isEqualToString:@"off"]) {
+                        [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
+                                                     category:@"General"
+                                                         file:__FILE__
+                                                         line:__LINE__
+                                                     function:__PRETTY_FUNCTION__
+                                                       format:@"--capture-protection requires on or off"];
+                        printUsage();
+                        return 1;
+                    }
+                    sharedCaptureProtection = @([value isEqualToString:@"on"]);
+                } else if ([arg isEqualToString:@"--timeout"]) {
+                    launchTimeout = i + 1 < argc ? atof(argv[++i]) : 0.0;
+                    if (launchTimeout <= 0.0) {
+                        [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
+                                                     category:@"General"
+                                                         file:__FILE__
+                                                         line:__LINE__
+                                                     function:__PRETTY_FUNCTION__
+                                                       format:@"--timeout requires a positive number of seconds"];
+                        printUsage();
+                        return 1;
+                    }
                 } else {
                     [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
                                                  category:@"General"
@@ -44,24 +175,26 @@ int main(int argc, const char * argv[]) {
                     return 1;
                 }
             } else {
-                // Non-option argument is the application path
-                if (applicationPath == nil) {
-                    applicationPath = arg;
-                } else {
-                    [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
-                                                 category:@"General"
-                                                     file:__FILE__
-                                                     line:__LINE__
-                                                 function:__PRETTY_FUNCTION__
-                                                   format:@"Multiple application paths specified"];
-                    printUsage();
-                    return 1;
-                }
+                // Non-option arguments are application paths; more than one selects batch mode
+                [applicationPaths addObject:arg];
             }
         }
 
+        // Live reconfiguration of every protected process
+        if (sharedWindowLevel || sharedCaptureProtection) {
+            return publishSharedConfiguration(sharedWindowLevel, sharedCaptureProtection);
+        }
+
+        // Daemon modes talk to or become the resident daemon instead of launching directly
+        if (daemonMode) {
+            return runDaemon(socketPath, applicationPaths, relaunchUnprotected);
+        }
+        if (daemonCommand) {
+            return sendDaemonRequest(socketPath, daemonCommand, applicationPaths, launchTimeout);
+        }
+
         // Validate arguments
-        if (applicationPath == nil) {
+        if (applicationPaths.count == 0) {
             [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
                                          category:@"General"
                                              file:__FILE__
@@ -72,6 +205,24 @@ int main(int argc, const char * argv[]) {
             return 1;
         }
 
+        if (batchMode || applicationPaths.count > 1) {
+            // Each suspended launch waits for its own handshake; there is no batch form of it
+            if (spawnSuspended) {
+                printf("[WindowControlInjector] ERROR: --spawn protects a single application, but %lu were given\n",
+                       (unsigned long)applicationPaths.count);
+                [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
+                                             category:@"General"
+                                                 file:__FILE__
+                                                 line:__LINE__
+                                             function:__PRETTY_FUNCTION__
+                                               format:@"--spawn cannot be used with several applications or a manifest"];
+                return 1;
+            }
+            return protectApplicationsInBatch(applicationPaths, launchTimeout);
+        }
+
+        NSString *applicationPath = applicationPaths.firstObject;
+
         // Verify application path exists and executable can be found
         printf("[WindowControlInjector] Resolving application path: %s\n", [applicationPath UTF8String]);
         NSString *executablePath = resolveApplicationPath(applicationPath, YES); // Force debug mode for path resolution
@@ -112,7 +263,9 @@ int main(int argc, const char * argv[]) {
         // Apply protection with all features enabled by default
         printf("[WindowControlInjector] Applying protection to application...\n");
         NSError *error = nil;
-        BOOL success = WCProtectApplication(applicationPath, &error);
+        BOOL success = spawnSuspended
+            ? [WCProtector protectApplicationBySpawning:applicationPath timeout:launchTimeout error:&error]
+            : WCProtectApplication(applicationPath, &error);
 
         if (!success) {
             if (error) {
@@ -177,14 +330,131 @@ int main(int argc, const char * argv[]) {
  * Print the usage information
  */
 void printUsage(void) {
-    printf("Usage: injector [options] <application-path>\n\n");
+    printf("Usage: injector [options] <application-path> [<application-path> ...]\n\n");
     printf("Options:\n");
-    printf("  -v, --verbose      Enable verbose logging\n");
-    printf("  -h, --help         Show this help message\n\n");
+    printf("  -v, --verbose        Enable verbose logging\n");
+    printf("  -m, --manifest PATH  Protect the applications listed in PATH, one per line\n");
+    printf("  --timeout SECONDS    Time to wait for launches to complete (default %.0f)\n", WCProtectorDefaultLaunchTimeout);
+    printf("  --spawn              Start the application suspended and wait until its first window is protected (one application only)\n");
+    printf("  --daemon             Run resident, protecting the given applications whenever they launch\n");
+    printf("  --relaunch           With --daemon, relaunch watched applications started without the injector\n");
+    printf("  --via-daemon         Ask the running daemon to protect the given applications\n");
+    printf("  --unprotect          Ask the running daemon to stop watching the given applications\n");
+    printf("  --status             Print the running daemon's status as JSON\n");
+    printf("  --socket PATH        Daemon socket (default ~/Library/Application Support/WindowControlInjector/injector.sock)\n");
+    printf("  --set-level LEVEL    Change the window level of every protected application\n");
+    printf("  --capture-protection on|off\n");
+    printf("                       Toggle screen capture protection of every protected application\n");
+    printf("  --metrics json|statsd\n");
+    printf("                       Print the metrics of every protected process and exit\n");
+    printf("  --decode-log PATH    Print a binary log file as text and exit\n");
+    printf("  -h, --help           Show this help message\n\n");
+
+    printf("Several application paths, or a manifest, launch all applications concurrently.\n\n");
 
     printf("Examples:\n");
     printf("  ./build/injector /Applications/TextEdit.app\n");
     printf("  ./build/injector -v /Applications/Calculator.app\n");
+    printf("  ./build/injector --spawn /Applications/TextEdit.app\n");
+    printf("  ./build/injector /Applications/TextEdit.app /Applications/Notes.app\n");
+    printf("  ./build/injector --manifest ~/.config/wci/login-apps.txt\n");
+    printf("  ./build/injector --daemon --manifest ~/.config/wci/login-apps.txt\n");
+    printf("  ./build/injector --via-daemon /Applications/TextEdit.app\n");
+    printf("  ./build/injector --capture-protection off\n");
+    printf("  ./build/injector --metrics statsd | nc -u -w1 localhost 8125\n");
+}
+
+/**
+ * Read application paths from a manifest file
+ *
+ * The manifest lists one application path per line. Blank lines and lines
+ * starting with '#' are ignored, and a leading '~' is expanded.
+ *
+ * @param manifestPath Path to the manifest file
+ * @return The listed application paths, or nil if the manifest could not be read
+ */
+NSArray<NSString *> *readManifestFile(NSString *manifestPath) {
+    NSError *error = nil;
+    NSString *contents = [NSString stringWithContentsOfFile:[manifestPath stringByExpandingTildeInPath]
+                                                   encoding:NSUTF8StringEncoding
+                                                      error:&error];
+    if (contents == nil) {
+        printf("[WindowControlInjector] ERROR: Could not read manifest: %s\n", [manifestPath UTF8String]);
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
+                                     category:@"General"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Could not read manifest %@: %@", manifestPath, [error localizedDescription]];
+        return nil;
+    }
+
+    NSMutableArray<NSString *> *paths = [NSMutableArray array];
+    NSCharacterSet *whitespace = [NSCharacterSet whitespaceCharacterSet];
+
+    for (NSString *line in [contents componentsSeparatedByCharactersInSet:[NSCharacterSet newlineCharacterSet]]) {
+        NSString *entry = [line stringByTrimmingCharactersInSet:whitespace];
+        if (entry.length == 0 || [entry hasPrefix:@"#"]) {
+            continue;
+        }
+        [paths addObject:[entry stringByExpandingTildeInPath]];
+    }
+
+    return paths;
+}
+
+/**
+ * Protect several applications at once and report the result of each
+ *
+ * Every path is resolved once up front; applications that resolve are then
+ * launched together so the batch takes about as long as the slowest launch.
+ *
+ * @param applicationPaths The application paths to protect
+ * @param timeout Seconds to wait for all launches to complete
+ * @return 0 if every application was protected, 1 otherwise
+ */
+int protectApplicationsInBatch(NSArray<NSString *> *applicationPaths, NSTimeInterval timeout) {
+    printf("[WindowControlInjector] Protecting %lu applications\n", (unsigned long)applicationPaths.count);
+
+    NSMutableArray<NSString *> *launchablePaths = [NSMutableArray arrayWithCapacity:applicationPaths.count];
+    NSMutableArray<NSString *> *unresolvedPaths = [NSMutableArray array];
+
+    for (NSString *applicationPath in applicationPaths) {
+        if (resolveApplicationPath(applicationPath, NO) != nil) {
+            [launchablePaths addObject:applicationPath];
+        } else {
+            [unresolvedPaths addObject:applicationPath];
+        }
+    }
+
+    if (launchablePaths.count > 0 && !WCProtectorInitialize()) {
+        printf("[WindowControlInjector] ERROR: Failed to initialize WindowControlInjector\n");
+        return 1;
+    }
+
+    NSTimeInterval startTime = [[NSProcessInfo processInfo] systemUptime];
+    NSArray<WCProtectionResult *> *results = launchablePaths.count > 0 ? WCProtectApplications(launchablePaths, timeout) : @[];
+    NSTimeInterval elapsed = [[NSProcessInfo processInfo] systemUptime] - startTime;
+
+    NSUInteger succeeded = 0;
+    for (WCProtectionResult *result in results) {
+        if (result.successful) {
+            succeeded++;
+            printf("[WindowControlInjector]   OK      %s (pid %d, %.2f s)\n",
+                   [result.applicationPath UTF8String], (int)result.processIdentifier, result.launchDuration);
+        } else {
+            printf("[WindowControlInjector]   FAILED  %s (%.2f s): %s\n",
+                   [result.applicationPath UTF8String], result.launchDuration,
+                   result.error ? [[result.error localizedDescription] UTF8String] : "Unknown error");
+        }
+    }
+    for (NSString *applicationPath in unresolvedPaths) {
+        printf("[WindowControlInjector]   FAILED  %s: Could not resolve executable path\n", [applicationPath UTF8String]);
+    }
+
+    printf("[WindowControlInjector] Protected %lu of %lu applications in %.2f s\n",
+           (unsigned long)succeeded, (unsigned long)applicationPaths.count, elapsed);
+    return succeeded == applicationPaths.count ? 0 : 1;
 }
 
 /**
@@ -521,3 +791,149 @@ NSString *resolveApplicationPath(NSString *path, BOOL debugMode) {
         }
     }
 }
+
+
+/**
+ * Run the resident daemon until SIGINT or SIGTERM
+ *
+ * @param socketPath The socket to listen on, or nil for the default
+ * @param watchedPaths Applications to protect whenever they launch
+ * @param relaunch Whether to relaunch watched applications started without the injector
+ * @return Exit status
+ */
+int runDaemon(NSString *socketPath, NSArray<NSString *> *watchedPaths, BOOL relaunch) {
+    WCInjectorDaemon *daemon = [WCInjectorDaemon sharedDaemon];
+    daemon.relaunchesUnprotectedApplications = relaunch;
+
+    NSError *error = nil;
+    if (![daemon startWithSocketPath:socketPath error:&error]) {
+        printf("[WindowControlInjector] ERROR: Could not start daemon: %s\n", [[error localizedDescription] UTF8String]);
+        return 1;
+    }
+
+    for (NSString *applicationPath in watchedPaths) {
+        [daemon watchApplicationAtPath:applicationPath];
+    }
+
+    printf("[WindowControlInjector] Daemon running, watching %lu applications\n", (unsigned long)watchedPaths.count);
+
+    // Remove the socket on the way out
+    static dispatch_source_t signalSources[2];
+    int signals[2] = { SIGINT, SIGTERM };
+    for (int i = 0; i < 2; i++) {
+        signal(signals[i], SIG_IGN);
+        signalSources[i] = dispatch_source_create(DISPATCH_SOURCE_TYPE_SIGNAL, (uintptr_t)signals[i], 0,
+                                                  dispatch_get_main_queue());
+        dispatch_source_set_event_handler(signalSources[i], ^{
+            [daemon stop];
+            exit(0);
+        });
+        dispatch_resume(signalSources[i]);
+    }
+
+    // Workspace notifications are delivered on the main run loop
+    [[NSRunLoop mainRunLoop] run];
+    return 0;
+}
+
+/**
+ * Send one request to the running daemon and print the response
+ *
+ * @param socketPath The daemon socket, or nil for the default
+ * @param command The request command
+ * @param applicationPaths Paths for protect and unprotect requests
+ * @param timeout Seconds to wait for the response, on top of the daemon's launch timeout
+ * @return 0 if the daemon reported success, 1 otherwise
+ */
+int sendDaemonRequest(NSString *socketPath, NSString *command, NSArray<NSString *> *applicationPaths, NSTimeInterval timeout) {
+    NSMutableArray<NSString *> *absolutePaths = [NSMutableArray arrayWithCapacity:applicationPaths.count];
+    NSString *workingDirectory = [[NSFileManager defaultManager] currentDirectoryPath];
+    for (NSString *applicationPath in applicationPaths) {
+        NSString *expanded = [applicationPath stringByExpandingTildeInPath];
+        [absolutePaths addObject:[expanded isAbsolutePath] ? expanded :
+                                 [workingDirectory stringByAppendingPathComponent:expanded]];
+    }
+
+    NSDictionary *request = @{@"command": command, @"paths": absolutePaths};
+    NSError *error = nil;
+    NSDictionary *response = [WCInjectorDaemon sendRequest:request
+                                              toSocketPath:socketPath
+                                                   timeout:timeout + WCProtectorDefaultLaunchTimeout
+                                                     error:&error];
+    if (!response) {
+        printf("[WindowControlInjector] ERROR: %s\n", [[error localizedDescription] UTF8String]);
+        return 1;
+    }
+
+    NSData *json = [NSJSONSerialization dataWithJSONObject:response
+                                                   options:NSJSONWritingPrettyPrinted | NSJSONWritingSortedKeys
+                                                     error:NULL];
+    if (json) {
+        fwrite(json.bytes, 1, json.length, stdout);
+        fputc('\n', stdout);
+    }
+    return [response[@"ok"] boolValue] ? 0 : 1;
+}
+
+/**
+ * Publish new settings to every protected process through the shared configuration
+ *
+ * Settings that are not given keep their published value, or the default if
+ * nothing was published yet.
+ *
+ * @param windowLevel The new window level, or nil to keep it
+ * @param captureProtection The new capture protection state, or nil to keep it
+ * @return 0 if the settings were published, 1 otherwise
+ */
+int publishSharedConfiguration(NSNumber *windowLevel, NSNumber *captureProtection) {
+    WCSharedConfigValues values;
+    if (!WCSharedConfigRead(&values, NULL)) {
+        [[WCConfigurationManager defaultConfiguration] getSharedConfigurationValues:&values];
+    }
+
+    if (windowLevel) {
+        values.windowLevel = [windowLevel longLongValue];
+    }
+    if (captureProtection) {
+        if ([captureProtection boolValue]) {
+            values.options |= WCConfigurationOptionPreventScreenCapture;
+        } else {
+            values.options &= ~(uint64_t)WCConfigurationOptionPreventScreenCapture;
+        }
+    }
+
+    uint64_t generation = 0;
+    if (!WCSharedConfigPublish(&values, &generation)) {
+        printf("[WindowControlInjector] ERROR: Could not publish configuration to %s\n", [WCSharedConfigPath() UTF8String]);
+        return 1;
+    }
+
+    printf("[WindowControlInjector] Published configuration generation %llu: level %lld, capture protection %s\n",
+           generation, values.windowLevel,
+           (values.options & WCConfigurationOptionPreventScreenCapture) ? "on" : "off");
+    return 0;
+}
+
+/**
+ * Print the aggregated metrics of every protected process
+ */
+int printFleetMetrics(NSString *format) {
+    NSDictionary *report = WCFleetMetricsReport();
+
+    if ([format isEqualToString:@"statsd"]) {
+        printf("%s", [WCFleetMetricsStatsDLines(report, @"wci") UTF8String]);
+    } else {
+        NSData *json = [NSJSONSerialization dataWithJSONObject:report
+                                                       options:NSJSONWritingPrettyPrinted | NSJSONWritingSortedKeys
+                                                         error:NULL];
+        if (!json) {
+            printf("[WindowControlInjector] ERROR: Could not encode metrics\n");
+            return 1;
+        }
+        fwrite(json.bytes, 1, json.length, stdout);
+        printf("\n");
+    }
+
+    // Runaway scanners make the exit status non-zero, for use in health checks
+    return [report[@"runaway"] count] > 0 ? 2 : 0;
+}
@@ -11,6 +11,7 @@
 
 #import <Foundation/Foundation.h>
 #import <AppKit/AppKit.h>
+#import "wc_shared_config.h"
 
 /**
  * @brief Configuration options for WindowControlInjector
@@ -30,6 +31,22 @@ typedef NS_OPTIONS(NSUInteger, WCConfigurationOptions) {
                                    WCConfigurationOptionMakeAlwaysOnTop
 };
 
+/**
+ * @brief When and how interceptors are installed
+ */
+typedef NS_ENUM(NSInteger, WCInterceptorInstallMode) {
+    WCInterceptorInstallModeEager    = 0,  // Swizzle every hook of every interceptor up front
+    WCInterceptorInstallModeOnDemand = 1   // Swizzle only the hooks the options need
+};
+
+/**
+ * @brief Which windows routine scan ticks list
+ */
+typedef NS_ENUM(NSInteger, WCWindowListMode) {
+    WCWindowListModeAll      = 0,  // Every tick lists all windows on all Spaces and displays
+    WCWindowListModeOnScreen = 1   // Ticks list on-screen windows; Space, display and activation changes trigger a full sweep
+};
+
 /**
  * @brief Centralized configuration manager for WindowControlInjector
  *
@@ -157,6 +174,63 @@ typedef NS_OPTIONS(NSUInteger, WCConfigurationOptions) {
  */
 @property (nonatomic, assign) NSUInteger enabledInterceptors;
 
+/**
+ * @brief How enabled interceptors are installed
+ *
+ * Default is WCInterceptorInstallModeEager
+ */
+@property (nonatomic, assign) WCInterceptorInstallMode interceptorInstallMode;
+
+/**
+ * @brief Which windows routine scan ticks list
+ *
+ * Default is WCWindowListModeAll
+ */
+@property (nonatomic, assign) WCWindowListMode windowListMode;
+
+/**
+ * @brief Rules deciding which protections each window gets
+ *
+ * Rule dictionaries in priority order, as described in wc_window_policy.h.
+ * Windows no rule matches are fully protected. Default is nil, which
+ * protects every window
+ */
+@property (nonatomic, copy) NSArray<NSDictionary *> *windowRules;
+
+/**
+ * @brief Load the dylib into helper processes launched from the application bundle
+ *
+ * When YES, helpers spawned by the protected application are launched with
+ * the dylib and protect their own windows, and the main process stops
+ * scanning helper windows across processes. Default is NO
+ */
+@property (nonatomic, assign) BOOL propagatesToHelperProcesses;
+
+/**
+ * @brief Publish this process's metrics for fleet-wide aggregation
+ *
+ * When YES, the counters and histograms live in a per-process page under
+ * the fleet metrics directory, where `injector --metrics` reads them.
+ * Default is YES
+ */
+@property (nonatomic, assign) BOOL publishesFleetMetrics;
+
+/**
+ * @brief Maximum number of workers that parse the window list on each scan
+ *
+ * 1 parses on the scanner's queue only; 0 picks a count from the active
+ * processors. Default is 0
+ */
+@property (nonatomic, assign) NSUInteger scanWorkerCount;
+
+/**
+ * @brief File or directory to record window and process events to
+ *
+ * The trace can be replayed with `make replay`, see wc_event_trace.h.
+ * Default is nil, which records nothing
+ */
+@property (nonatomic, copy) NSString *traceFilePath;
+
 /**
  * @brief Configuration options
  *
@@ -214,6 +288,23 @@ typedef NS_OPTIONS(NSUInteger, WCConfigurationOptions) {
  */
 - (void)resetToDefaults;
 
+/**
+ * @brief Copy the live-reconfigurable settings into shared configuration values
+ *
+ * @param values Receives the window level and options
+ */
+- (void)getSharedConfigurationValues:(WCSharedConfigValues *)values;
+
+/**
+ * @brief Apply shared configuration values published by a controller
+ *
+ * The options are applied through applyOptions first, then the published
+ * window level overrides the level they imply.
+ *
+ * @param values The values to apply
+ */
+- (void)applySharedConfigurationValues:(const WCSharedConfigValues *)values;
+
 @end
 
 #endif /* CONFIGURATION_MANAGER_H */
@@ -15,6 +15,13 @@ static NSString *const kWCEnvPreventScreenCapture = @"WCI_PREVENT_SCREEN_CAPTURE
 static NSString *const kWCEnvWindowLevel = @"WCI_WINDOW_LEVEL";
 static NSString *const kWCEnvActivationPolicy = @"WCI_ACTIVATION_POLICY";
 static NSString *const kWCEnvConfigPath = @"WCI_CONFIG_PATH";
+static NSString *const kWCEnvInterceptorInstall = @"WCI_INTERCEPTOR_INSTALL";
+static NSString *const kWCEnvPropagateToHelpers = @"WCI_PROPAGATE_TO_HELPERS";
+static NSString *const kWCEnvWindowList = @"WCI_WINDOW_LIST";
+static NSString *const kWCEnvWindowRules = @"WCI_WINDOW_RULES";
+static NSString *const kWCEnvFleetMetrics = @"WCI_FLEET_METRICS";
+static NSString *const kWCEnvScanWorkers = @"WCI_SCAN_WORKERS";
+static NSString *const kWCEnvTracePath = @"WCI_TRACE_PATH";
 
 // JSON keys for serialization
 static NSString *const kWCJsonWindowLevel = @"windowLevel";
@@ -32,6 +39,13 @@ static NSString *const kWCJsonWindowAcceptsMouseMovedEvents = @"windowAcceptsMou
 static NSString *const kWCJsonLogFilePath = @"logFilePath";
 static NSString *const kWCJsonLogLevel = @"logLevel";
 static NSString *const kWCJsonEnabledInterceptors = @"enabledInterceptors";
+static NSString *const kWCJsonInterceptorInstallMode = @"interceptorInstallMode";
+static NSString *const kWCJsonPropagateToHelpers = @"propagateToHelpers";
+static NSString *const kWCJsonWindowListMode = @"windowListMode";
+static NSString *const kWCJsonWindowRules = @"windowRules";
+static NSString *const kWCJsonFleetMetrics = @"fleetMetrics";
+static NSString *const kWCJsonScanWorkers = @"scanWorkers";
+static NSString *const kWCJsonTraceFile = @"traceFile";
 static NSString *const kWCJsonOptions = @"options";
 
 @implementation WCConfigurationManager
@@ -202,6 +216,55 @@ static NSString *const kWCJsonOptions = @"options";
         self.applicationActivationPolicy = [activationPolicyStr integerValue];
     }
 
+    NSString *interceptorInstallStr = env[kWCEnvInterceptorInstall];
+    if (interceptorInstallStr) {
+        self.interceptorInstallMode = [interceptorInstallStr isEqualToString:@"on-demand"] ?
+            WCInterceptorInstallModeOnDemand : WCInterceptorInstallModeEager;
+    }
+
+    NSString *propagateToHelpersStr = env[kWCEnvPropagateToHelpers];
+    if (propagateToHelpersStr) {
+        self.propagatesToHelperProcesses = [propagateToHelpersStr boolValue];
+    }
+
+    NSString *fleetMetricsStr = env[kWCEnvFleetMetrics];
+    if (fleetMetricsStr) {
+        self.publishesFleetMetrics = [fleetMetricsStr boolValue];
+    }
+
+    NSString *scanWorkersStr = env[kWCEnvScanWorkers];
+    if (scanWorkersStr) {
+        self.scanWorkerCount = (NSUInteger)MAX([scanWorkersStr integerValue], 0);
+    }
+
+    NSString *tracePathStr = env[kWCEnvTracePath];
+    if (tracePathStr.length > 0) {
+        self.traceFilePath = tracePathStr;
+    }
+
+    NSString *windowListStr = env[kWCEnvWindowList];
+    if (windowListStr) {
+        self.windowListMode = [windowListStr isEqualToString:@"on-screen"] ?
+            WCWindowListModeOnScreen : WCWindowListModeAll;
+    }
+
+    // Rules are passed as a JSON array
+    NSString *windowRulesStr = env[kWCEnvWindowRules];
+    if (windowRulesStr) {
+        NSData *rulesData = [windowRulesStr dataUsingEncoding:NSUTF8StringEncoding];
+        id rules = rulesData ? [NSJSONSerialization JSONObjectWithData:rulesData options:0 error:nil] : nil;
+        if ([rules isKindOfClass:[NSArray class]]) {
+            self.windowRules = rules;
+        } else {
+            [[WCLogger sharedLogger] logWithLevel:WCLogLevelWarning
+                                         category:WCLogCategoryConfiguration
+                                             file:__FILE__
+                                             line:__LINE__
+                                         function:__PRETTY_FUNCTION__
+                                           format:@"Ignoring %@, which is not a JSON array", kWCEnvWindowRules];
+        }
+    }
+
     [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
                                  category:WCLogCategoryConfiguration
                                      file:__FILE__
@@ -229,6 +292,15 @@ static NSString *const kWCJsonOptions = @"options";
     config[kWCJsonLogFilePath] = self.logFilePath;
     config[kWCJsonLogLevel] = @(self.logLevel);
     config[kWCJsonEnabledInterceptors] = @(self.enabledInterceptors);
+    config[kWCJsonInterceptorInstallMode] = @(self.interceptorInstallMode);
+    config[kWCJsonPropagateToHelpers] = @(self.propagatesToHelperProcesses);
+    config[kWCJsonFleetMetrics] = @(self.publishesFleetMetrics);
+    config[kWCJsonScanWorkers] = @(self.scanWorkerCount);
+    if (self.traceFilePath) {
+        config[kWCJsonTraceFile] = self.traceFilePath;
+    }
+    config[kWCJsonWindowListMode] = @(self.windowListMode);
+    config[kWCJsonWindowRules] = self.windowRules;
     config[kWCJsonOptions] = @(self.options);
 
     // Convert to JSON data
@@ -377,6 +449,34 @@ static NSString *const kWCJsonOptions = @"options";
         self.enabledInterceptors = [config[kWCJsonEnabledInterceptors] unsignedIntegerValue];
     }
 
+    if (config[kWCJsonInterceptorInstallMode]) {
+        self.interceptorInstallMode = [config[kWCJsonInterceptorInstallMode] integerValue];
+    }
+
+    if (config[kWCJsonPropagateToHelpers]) {
+        self.propagatesToHelperProcesses = [config[kWCJsonPropagateToHelpers] boolValue];
+    }
+
+    if (config[kWCJsonFleetMetrics]) {
+        self.publishesFleetMetrics = [config[kWCJsonFleetMetrics] boolValue];
+    }
+
+    if (config[kWCJsonScanWorkers]) {
+        self.scanWorkerCount = (NSUInteger)MAX([config[kWCJsonScanWorkers] integerValue], 0);
+    }
+
+    if ([config[kWCJsonTraceFile] isKindOfClass:[NSString class]]) {
+        self.traceFilePath = config[kWCJsonTraceFile];
+    }
+
+    if (config[kWCJsonWindowListMode]) {
+        self.windowListMode = [config[kWCJsonWindowListMode] integerValue];
+    }
+
+    if ([config[kWCJsonWindowRules] isKindOfClass:[NSArray class]]) {
+        self.windowRules = config[kWCJsonWindowRules];
+    }
+
     if (config[kWCJsonOptions]) {
         self.options = [config[kWCJsonOptions] unsignedIntegerValue];
     }
@@ -409,6 +509,13 @@ static NSString *const kWCJsonOptions = @"options";
     self.logFilePath = [[WCPathResolver sharedResolver] logFilePath];
     self.logLevel = WCLogLevelInfo;
     self.enabledInterceptors = UINT_MAX; // All interceptors enabled by default
+    self.interceptorInstallMode = WCInterceptorInstallModeEager;
+    self.propagatesToHelperProcesses = NO;
+    self.publishesFleetMetrics = YES;
+    self.scanWorkerCount = 0;
+    self.traceFilePath = nil;
+    self.windowListMode = WCWindowListModeAll;
+    self.windowRules = nil;
     self.options = WCConfigurationOptionDefault;
 
     [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
@@ -419,4 +526,29 @@ static NSString *const kWCJsonOptions = @"options";
                                    format:@"Reset configuration to defaults"];
 }
 
+#pragma mark - Shared Configuration
+
+- (void)getSharedConfigurationValues:(WCSharedConfigValues *)values {
+    if (!values) return;
+
+    values->windowLevel = self.windowLevel;
+    values->options = self.options;
+}
+
+- (void)applySharedConfigurationValues:(const WCSharedConfigValues *)values {
+    if (!values) return;
+
+    _options = (WCConfigurationOptions)values->options;
+    [self applyOptions];
+    self.windowLevel = (NSWindowLevel)values->windowLevel;
+
+    [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                 category:WCLogCategoryConfiguration
+                                     file:__FILE__
+                                     line:__LINE__
+                                 function:__PRETTY_FUNCTION__
+                                   format:@"Applied shared configuration: level %ld, options %lu",
+                                          (long)self.windowLevel, (unsigned long)self.options];
+}
+
 @end
@@ -44,7 +44,8 @@ typedef NS_ENUM(NSInteger, WCInjectionErrorCode) {
     WCInjectionErrorDylibLoadFailed = 2002,
     WCInjectionErrorDylibIsInvalid = 2003,
     WCInjectionErrorInjectionFailed = 2004,
-    WCInjectionErrorPermissionDenied = 2005
+    WCInjectionErrorPermissionDenied = 2005,
+    WCInjectionErrorTargetUnsupported = 2006
 };
 
 // Configuration error codes (3000-3999)
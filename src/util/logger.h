@@ -10,6 +10,12 @@
 #define LOGGER_H
 
 #import <Foundation/Foundation.h>
+#include <stdatomic.h>
+
+// Build with -DWC_LOG_STRIP_DEBUG=1 to compile debug logging out entirely (done by `make release`)
+#ifndef WC_LOG_STRIP_DEBUG
+#define WC_LOG_STRIP_DEBUG 0
+#endif
 
 // Log levels
 typedef NS_ENUM(NSInteger, WCLogLevel) {
@@ -123,6 +129,42 @@ typedef NS_ENUM(NSInteger, WCLogLevel) {
  */
 - (BOOL)configureWithOptions:(NSDictionary *)options;
 
+/**
+ * @brief Handle a log message from its raw fields
+ *
+ * When implemented, the logger calls this instead of handleLogMessage: and
+ * skips building a WCLogMessage. file and function are the string constants
+ * passed to the logger (normally __FILE__ and __PRETTY_FUNCTION__) and may be
+ * kept by pointer.
+ *
+ * @param level The log level
+ * @param category The log category, or nil
+ * @param message The formatted message text
+ * @param file The source file, or NULL
+ * @param line The line number
+ * @param function The function name, or NULL
+ * @param contextData Additional context data, or nil
+ */
+- (void)handleLogWithLevel:(WCLogLevel)level
+                  category:(NSString *)category
+                   message:(NSString *)message
+                      file:(const char *)file
+                      line:(NSInteger)line
+                  function:(const char *)function
+               contextData:(NSDictionary *)contextData;
+
+/**
+ * @brief Write out any buffered messages before returning
+ */
+- (void)flush;
+
+/**
+ * @brief Number of messages the handler had to drop
+ *
+ * @return Total drops since the handler was created
+ */
+- (uint64_t)droppedMessageCount;
+
 @end
 
 /**
@@ -221,6 +263,32 @@ typedef NS_ENUM(NSInteger, WCLogLevel) {
  */
 - (BOOL)setLogFilePath:(NSString *)path;
 
+/**
+ * @brief Set the path for binary file logging
+ *
+ * Messages are written as compact binary records instead of text, which
+ * keeps the background writer cheap when debug logging is on. Decode the
+ * file with `injector --decode-log <path>`. Replaces any text log file.
+ *
+ * @param path The path to log to
+ * @return YES if the log file was set up successfully, NO otherwise
+ */
+- (BOOL)setBinaryLogFilePath:(NSString *)path;
+
+/**
+ * @brief Write out messages buffered by any handler
+ *
+ * Called automatically at exit.
+ */
+- (void)flush;
+
+/**
+ * @brief Number of messages dropped by handlers that could not keep up
+ *
+ * @return Total drops across all handlers
+ */
+- (uint64_t)droppedMessageCount;
+
 /**
  * @brief Log a message
  *
@@ -254,9 +322,9 @@ typedef NS_ENUM(NSInteger, WCLogLevel) {
  *
  * @param level The log level
  * @param category The log category
- * @param file The source file
+ * @param file The source file; must be a string constant such as __FILE__
  * @param line The line number
- * @param function The function name
+ * @param function The function name; must be a string constant such as __PRETTY_FUNCTION__
  * @param format The format string
  * @param ... The format arguments
  */
@@ -272,9 +340,9 @@ typedef NS_ENUM(NSInteger, WCLogLevel) {
  *
  * @param level The log level
  * @param category The log category
- * @param file The source file
+ * @param file The source file; must be a string constant such as __FILE__
  * @param line The line number
- * @param function The function name
+ * @param function The function name; must be a string constant such as __PRETTY_FUNCTION__
  * @param contextData Additional context data
  * @param format The format string
  * @param ... The format arguments
@@ -306,81 +374,68 @@ extern NSString * const WCLogCategoryApplication;
 extern NSString * const WCLogCategoryWindow;
 extern NSString * const WCLogCategoryLaunch;
 
-// Simple macros for direct logging without do-while wrapping
-// These match the exact format used in the existing codebase
-#define WCLogError(category, fmt, ...) \
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelError \
-                                 category:category \
-                                     file:__FILE__ \
-                                     line:__LINE__ \
-                                 function:__PRETTY_FUNCTION__ \
-                                   format:fmt, ##__VA_ARGS__]
-
-#define WCLogWarning(category, fmt, ...) \
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelWarning \
-                                 category:category \
-                                     file:__FILE__ \
-                                     line:__LINE__ \
-                                 function:__PRETTY_FUNCTION__ \
-                                   format:fmt, ##__VA_ARGS__]
-
-#define WCLogInfo(category, fmt, ...) \
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo \
-                                 category:category \
-                                     file:__FILE__ \
-                                     line:__LINE__ \
-                                 function:__PRETTY_FUNCTION__ \
-                                   format:fmt, ##__VA_ARGS__]
-
-#define WCLogDebug(category, fmt, ...) \
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug \
-                                 category:category \
-                                     file:__FILE__ \
-                                     line:__LINE__ \
-                                 function:__PRETTY_FUNCTION__ \
-                                   format:fmt, ##__VA_ARGS__]
+/**
+ * @brief Highest level enabled for any category, or -1 if logging is off
+ *
+ * Updated by WCLogger whenever a setting changes so call sites can skip a
+ * message without calling into the logger. Read it through the macros.
+ */
+extern _Atomic(NSInteger) WCLogActiveLevel;
+
+/**
+ * @brief Check if a level could be logged for some category, without locking
+ */
+#define WCLogLevelMayBeEnabled(level) \
+    ((NSInteger)(level) <= atomic_load_explicit(&WCLogActiveLevel, memory_order_relaxed))
+
+// Logging macros; the level is checked before the logger is touched or any argument is evaluated
+#define WCLogWithLevel(level, category, fmt, ...) \
+    (WCLogLevelMayBeEnabled(level) ? \
+        (void)[[WCLogger sharedLogger] logWithLevel:level \
+                                           category:category \
+                                               file:__FILE__ \
+                                               line:__LINE__ \
+                                           function:__PRETTY_FUNCTION__ \
+                                             format:fmt, ##__VA_ARGS__] : \
+        (void)0)
+
+#define WCLogWithLevelAndContext(level, category, context, fmt, ...) \
+    (WCLogLevelMayBeEnabled(level) ? \
+        (void)[[WCLogger sharedLogger] logWithLevel:level \
+                                           category:category \
+                                               file:__FILE__ \
+                                               line:__LINE__ \
+                                           function:__PRETTY_FUNCTION__ \
+                                        contextData:context \
+                                             format:fmt, ##__VA_ARGS__] : \
+        (void)0)
+
+#define WCLogError(category, fmt, ...) WCLogWithLevel(WCLogLevelError, category, fmt, ##__VA_ARGS__)
+#define WCLogWarning(category, fmt, ...) WCLogWithLevel(WCLogLevelWarning, category, fmt, ##__VA_ARGS__)
+#define WCLogInfo(category, fmt, ...) WCLogWithLevel(WCLogLevelInfo, category, fmt, ##__VA_ARGS__)
 
 // Context data macros
 #define WCLogErrorWithContext(category, context, fmt, ...) \
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelError \
-                                 category:category \
-                                     file:__FILE__ \
-                                     line:__LINE__ \
-                                 function:__PRETTY_FUNCTION__ \
-                              contextData:context \
-                                   format:fmt, ##__VA_ARGS__]
-
+    WCLogWithLevelAndContext(WCLogLevelError, category, context, fmt, ##__VA_ARGS__)
 #define WCLogWarningWithContext(category, context, fmt, ...) \
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelWarning \
-                                 category:category \
-                                     file:__FILE__ \
-                                     line:__LINE__ \
-                                 function:__PRETTY_FUNCTION__ \
-                              contextData:context \
-                                   format:fmt, ##__VA_ARGS__]
-
+    WCLogWithLevelAndContext(WCLogLevelWarning, category, context, fmt, ##__VA_ARGS__)
 #define WCLogInfoWithContext(category, context, fmt, ...) \
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo \
-                                 category:category \
-                                     file:__FILE__ \
-                                     line:__LINE__ \
-                                 function:__PRETTY_FUNCTION__ \
-                              contextData:context \
-                                   format:fmt, ##__VA_ARGS__]
+    WCLogWithLevelAndContext(WCLogLevelInfo, category, context, fmt, ##__VA_ARGS__)
 
+#if WC_LOG_STRIP_DEBUG
+#define WCLogDebug(category, fmt, ...) ((void)0)
+#define WCLogDebugWithContext(category, context, fmt, ...) ((void)0)
+#else
+#define WCLogDebug(category, fmt, ...) WCLogWithLevel(WCLogLevelDebug, category, fmt, ##__VA_ARGS__)
 #define WCLogDebugWithContext(category, context, fmt, ...) \
-    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug \
-                                 category:category \
-                                     file:__FILE__ \
-                                     line:__LINE__ \
-                                 function:__PRETTY_FUNCTION__ \
-                              contextData:context \
-                                   format:fmt, ##__VA_ARGS__]
+    WCLogWithLevelAndContext(WCLogLevelDebug, category, context, fmt, ##__VA_ARGS__)
+#endif
 
 // C function wrappers for the public API
 void WCSetLoggingEnabled(BOOL enabled);
 void WCSetLogLevel(NSInteger level);
 BOOL WCSetLogFilePath(NSString *path);
+BOOL WCSetBinaryLogFilePath(NSString *path);
 void WCSetLoggingEnabledForCategory(BOOL enabled, NSString *category);
 void WCSetLogLevelForCategory(NSInteger level, NSString *category);
 
@@ -4,8 +4,18 @@
  */
 
 #import "logger.h"
+#import "wc_log_ring.h"
 #import <os/log.h>
 #import <pthread.h>
+#import <stdlib.h>
+#import <errno.h>
+#import <fcntl.h>
+#import <sys/stat.h>
+#import <time.h>
+#import <unistd.h>
+
+// Highest level any category logs at; starts at the default global level
+_Atomic(NSInteger) WCLogActiveLevel = WCLogLevelInfo;
 
 // Define the default log categories
 NSString * const WCLogCategoryGeneral = @"General";
@@ -44,9 +54,13 @@ NSString * const WCLogCategoryLaunch = @"Launch";
 - (NSString *)formattedMessage {
     NSMutableString *formatted = [NSMutableString string];
 
-    // Add timestamp in standard format
-    NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
-    [formatter setDateFormat:@"yyyy-MM-dd HH:mm:ss.SSS"];
+    // Add timestamp in standard format; formatters are expensive to create and safe to share
+    static NSDateFormatter *formatter = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        formatter = [[NSDateFormatter alloc] init];
+        [formatter setDateFormat:@"yyyy-MM-dd HH:mm:ss.SSS"];
+    });
     [formatted appendFormat:@"[%@] ", [formatter stringFromDate:_timestamp]];
 
     // Add level
@@ -173,33 +187,151 @@ NSString * const WCLogCategoryLaunch = @"Launch";
 
 #pragma mark - File Log Handler
 
+// Records buffered between drains; at 512 bytes each this is 1 MB
+static const uint32_t kWCFileLogRingCapacity = 2048;
+
+// Bytes collected before each write to the log file
+static const size_t kWCFileLogBufferSize = 64 * 1024;
+
+// How often the drainer wakes up, and how late it may be
+static const uint64_t kWCFileLogDrainInterval = 250 * NSEC_PER_MSEC;
+static const uint64_t kWCFileLogDrainLeeway = 100 * NSEC_PER_MSEC;
+
+/**
+ * Output state owned by the file handler's queue
+ */
+typedef struct {
+    int fd;
+    char *buffer;
+    size_t used;
+    BOOL binary;
+    BOOL appendNewLine;
+    BOOL reportedWriteError;
+    uint16_t definedCategories;   // Categories already written to a binary log
+    uint64_t reportedDrops;       // Ring drops already noted in the log
+} WCFileLogWriter;
+
+static void WCFileLogWriterFlush(WCFileLogWriter *writer) {
+    size_t offset = 0;
+    while (offset < writer->used) {
+        ssize_t written = write(writer->fd, writer->buffer + offset, writer->used - offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (!writer->reportedWriteError) {
+                fprintf(stderr, "[WindowControlInjector] Error writing to log file: %s\n", strerror(errno));
+                writer->reportedWriteError = YES;
+            }
+            break;
+        }
+        offset += (size_t)written;
+    }
+    writer->used = 0;
+}
+
+static void WCFileLogWriterAppend(WCFileLogWriter *writer, const void *bytes, size_t length) {
+    if (writer->used + length > kWCFileLogBufferSize) {
+        WCFileLogWriterFlush(writer);
+    }
+    if (length > kWCFileLogBufferSize) {
+        length = kWCFileLogBufferSize;
+    }
+    memcpy(writer->buffer + writer->used, bytes, length);
+    writer->used += length;
+}
+
+static void WCFileLogWriterWriteRecord(const WCLogRecord *record, void *context) {
+    WCFileLogWriter *writer = context;
+
+    if (writer->binary) {
+        uint8_t entry[WCLogBinaryEntryMaxSize];
+
+        // Define categories before their first use so the log decodes on its own
+        if (record->categoryID != WCLogCategoryIDUnknown && record->categoryID >= writer->definedCategories) {
+            uint16_t categoryCount = WCLogCategoryIDCount();
+            while (writer->definedCategories < categoryCount) {
+                WCFileLogWriterAppend(writer, entry, WCLogBinaryEncodeCategory(writer->definedCategories++, entry));
+            }
+        }
+
+        WCFileLogWriterAppend(writer, entry, WCLogBinaryEncodeRecord(record, entry));
+    } else {
+        char line[WCLogRecordTextCapacity + 1024];
+        size_t length = WCLogFormatLine(line, sizeof(line), record->timestamp, record->level,
+                                        WCLogCategoryNameForID(record->categoryID),
+                                        record->text, record->textLength,
+                                        record->file, record->line, record->function);
+        if (!writer->appendNewLine && length > 0) {
+            length--;
+        }
+        WCFileLogWriterAppend(writer, line, length);
+    }
+}
+
+static void WCFileLogWriterWriteDrops(WCFileLogWriter *writer, uint64_t timestamp, uint64_t count) {
+    if (writer->binary) {
+        uint8_t entry[WCLogBinaryEntryMaxSize];
+        WCFileLogWriterAppend(writer, entry, WCLogBinaryEncodeDropped(timestamp, count, entry));
+    } else {
+        char line[256];
+        WCFileLogWriterAppend(writer, line, WCLogFormatDroppedLine(line, sizeof(line), timestamp, count));
+    }
+}
+
 /**
  * Log handler that outputs to a file
+ *
+ * Producers only copy the message into a lock-free ring buffer; a timer on
+ * the handler's queue drains it, formats the records as text or binary
+ * entries and writes them to the file in large batches.
  */
 @interface WCFileLogHandler : NSObject <WCLogHandler>
-@property (nonatomic, strong) NSFileHandle *fileHandle;
 @property (nonatomic, strong) NSString *filePath;
-@property (nonatomic) BOOL appendNewLine;
+@property (nonatomic, readonly) BOOL binary;
 @property (nonatomic, strong) dispatch_queue_t fileQueue;
 @end
 
-@implementation WCFileLogHandler
+@implementation WCFileLogHandler {
+    WCLogRing *_ring;
+    WCFileLogWriter _writer;
+    dispatch_source_t _drainTimer;
+}
 
-- (instancetype)initWithPath:(NSString *)path {
+- (instancetype)initWithPath:(NSString *)path binary:(BOOL)binary {
     self = [super init];
     if (self) {
         _filePath = [path copy];
-        _appendNewLine = YES;
+        _binary = binary;
         _fileQueue = dispatch_queue_create("com.windowcontrolinjector.filelogger", DISPATCH_QUEUE_SERIAL);
 
-        if (![self setupFileHandle]) {
+        _writer.fd = -1;
+        _writer.binary = binary;
+        _writer.appendNewLine = YES;
+        _writer.buffer = malloc(kWCFileLogBufferSize);
+        _ring = WCLogRingCreate(kWCFileLogRingCapacity);
+
+        if (!_writer.buffer || !_ring || ![self setupFileDescriptor]) {
             return nil;
         }
+
+        __weak typeof(self) weakSelf = self;
+        _drainTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _fileQueue);
+        dispatch_source_set_timer(_drainTimer,
+                                  dispatch_time(DISPATCH_TIME_NOW, kWCFileLogDrainInterval),
+                                  kWCFileLogDrainInterval,
+                                  kWCFileLogDrainLeeway);
+        dispatch_source_set_event_handler(_drainTimer, ^{
+            [weakSelf drainRing];
+        });
+        dispatch_resume(_drainTimer);
     }
     return self;
 }
 
-- (BOOL)setupFileHandle {
+- (instancetype)initWithPath:(NSString *)path {
+    return [self initWithPath:path binary:NO];
+}
+
+- (BOOL)setupFileDescriptor {
     NSFileManager *fileManager = [NSFileManager defaultManager];
 
     // Create parent directories if needed
@@ -216,78 +348,219 @@ NSString * const WCLogCategoryLaunch = @"Launch";
         }
     }
 
-    // Create or open the file
-    if (![fileManager fileExistsAtPath:_filePath]) {
-        if (![fileManager createFileAtPath:_filePath contents:nil attributes:nil]) {
-            fprintf(stderr, "[WindowControlInjector] Error creating log file: %s\n", [_filePath UTF8String]);
-            return NO;
-        }
-    }
-
-    // Open file for writing
-    NSError *error = nil;
-    _fileHandle = [NSFileHandle fileHandleForWritingToURL:[NSURL fileURLWithPath:_filePath]
-                                                    error:&error];
-    if (!_fileHandle) {
-        fprintf(stderr, "[WindowControlInjector] Error opening log file: %s\n",
-                [error.localizedDescription UTF8String]);
+    // Create or open the file for appending
+    _writer.fd = open([_filePath fileSystemRepresentation], O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (_writer.fd < 0) {
+        fprintf(stderr, "[WindowControlInjector] Error opening log file %s: %s\n",
+                [_filePath UTF8String], strerror(errno));
         return NO;
     }
 
-    // Move to end of file
-    [_fileHandle seekToEndOfFile];
+    // A new binary log starts with its header; later sessions append after it
+    struct stat fileInfo;
+    if (_binary && fstat(_writer.fd, &fileInfo) == 0 && fileInfo.st_size == 0) {
+        WCLogBinaryFileHeader header = { .version = WCLogBinaryVersion, .headerSize = sizeof(WCLogBinaryFileHeader) };
+        memcpy(header.magic, WCLogBinaryMagic, sizeof(header.magic));
+        WCFileLogWriterAppend(&_writer, &header, sizeof(header));
+        WCFileLogWriterFlush(&_writer);
+    }
 
     return YES;
 }
 
-- (void)handleLogMessage:(WCLogMessage *)message {
-    // Format the log entry
-    NSString *formattedMessage = [message formattedMessage];
-    if (_appendNewLine) {
-        formattedMessage = [formattedMessage stringByAppendingString:@"\n"];
+- (void)handleLogWithLevel:(WCLogLevel)level
+                  category:(NSString *)category
+                   message:(NSString *)message
+                      file:(const char *)file
+                      line:(NSInteger)line
+                  function:(const char *)function
+               contextData:(NSDictionary *)contextData {
+    // Everything that might lock happens before a slot is claimed
+    uint16_t categoryID = WCLogCategoryIDForName((__bridge CFStringRef)category);
+    uint64_t timestamp = clock_gettime_nsec_np(CLOCK_REALTIME);
+    uint64_t threadID = 0;
+    pthread_threadid_np(NULL, &threadID);
+
+    WCLogRecord *record = WCLogRingReserve(_ring);
+    if (!record) {
+        // Counted by the ring and reported by the drainer
+        return;
     }
 
-    // Write to file on a background queue
-    NSData *data = [formattedMessage dataUsingEncoding:NSUTF8StringEncoding];
-    dispatch_async(_fileQueue, ^{
-        @try {
-            [self.fileHandle writeData:data];
-        }
-        @catch (NSException *exception) {
-            fprintf(stderr, "[WindowControlInjector] Error writing to log file: %s\n",
-                    [exception.reason UTF8String]);
-
-            // Try to reopen the file handle
-            [self.fileHandle closeFile];
-            self.fileHandle = nil;
-            if ([self setupFileHandle]) {
-                [self.fileHandle writeData:data];
+    record->timestamp = timestamp;
+    record->threadID = threadID;
+    record->file = file;
+    record->function = function;
+    record->line = line > 0 ? (uint32_t)line : 0;
+    record->categoryID = categoryID;
+    record->level = (uint8_t)level;
+    record->flags = 0;
+
+    CFStringRef text = (__bridge CFStringRef)(message ?: @"");
+    CFIndex length = CFStringGetLength(text);
+    CFIndex used = 0;
+    CFIndex converted = CFStringGetBytes(text, CFRangeMake(0, length), kCFStringEncodingUTF8, '?', false,
+                                         (UInt8 *)record->text, WCLogRecordTextCapacity, &used);
+    if (converted < length) {
+        record->flags |= WCLogRecordFlagTruncated;
+    }
+
+    // Context is rare, so it is flattened into the text rather than given its own encoding
+    if (contextData.count > 0 && [NSJSONSerialization isValidJSONObject:contextData]) {
+        NSData *json = [NSJSONSerialization dataWithJSONObject:contextData options:0 error:NULL];
+        static const char contextPrefix[] = " Context: ";
+        size_t room = WCLogRecordTextCapacity - (size_t)used;
+        if (json && room > sizeof(contextPrefix) - 1) {
+            memcpy(record->text + used, contextPrefix, sizeof(contextPrefix) - 1);
+            used += sizeof(contextPrefix) - 1;
+            room -= sizeof(contextPrefix) - 1;
+
+            size_t jsonLength = json.length;
+            if (jsonLength > room) {
+                jsonLength = room;
+                record->flags |= WCLogRecordFlagTruncated;
             }
+            memcpy(record->text + used, json.bytes, jsonLength);
+            used += (CFIndex)jsonLength;
         }
+    }
+
+    record->textLength = (uint16_t)used;
+    WCLogRingCommit(_ring, record);
+}
+
+- (void)handleLogMessage:(WCLogMessage *)message {
+    // Only reached when called directly; source strings of a message object can't be kept by pointer
+    [self handleLogWithLevel:message.level
+                    category:message.category
+                     message:message.message
+                        file:NULL
+                        line:message.lineNumber
+                    function:NULL
+                 contextData:message.contextData];
+}
+
+- (void)drainRing {
+    // A few ring's worth per wakeup keeps up with bursts without letting a flood pin the queue
+    for (int pass = 0; pass < 4; pass++) {
+        if (WCLogRingDrain(_ring, WCFileLogWriterWriteRecord, &_writer) == 0) {
+            break;
+        }
+    }
+
+    uint64_t dropped = WCLogRingDroppedCount(_ring);
+    if (dropped > _writer.reportedDrops) {
+        WCFileLogWriterWriteDrops(&_writer, clock_gettime_nsec_np(CLOCK_REALTIME), dropped - _writer.reportedDrops);
+        _writer.reportedDrops = dropped;
+    }
+
+    WCFileLogWriterFlush(&_writer);
+}
+
+- (void)flush {
+    dispatch_sync(_fileQueue, ^{
+        [self drainRing];
     });
 }
 
+- (uint64_t)droppedMessageCount {
+    return WCLogRingDroppedCount(_ring);
+}
+
 - (BOOL)configureWithOptions:(NSDictionary *)options {
     NSNumber *appendNewLine = options[@"appendNewLine"];
     if (appendNewLine) {
-        _appendNewLine = [appendNewLine boolValue];
+        BOOL value = [appendNewLine boolValue];
+        dispatch_sync(_fileQueue, ^{
+            self->_writer.appendNewLine = value;
+        });
     }
 
     return YES;
 }
 
 - (void)dealloc {
-    [_fileHandle closeFile];
+    if (_drainTimer) {
+        dispatch_source_cancel(_drainTimer);
+    }
+
+    // Nothing can produce into the ring any more, so drain what is left in place
+    if (_ring && _writer.buffer && _writer.fd >= 0) {
+        [self drainRing];
+    }
+    if (_writer.fd >= 0) {
+        close(_writer.fd);
+    }
+    WCLogRingDestroy(_ring);
+    free(_writer.buffer);
 }
 
 @end
 
+#pragma mark - Category Level Table
+
+/**
+ * Effective settings for one category
+ */
+typedef struct {
+    CFStringRef category;
+    CFHashCode hash;
+    BOOL enabled;
+    WCLogLevel level;
+} WCLogCategoryEntry;
+
+/**
+ * Immutable table of effective category settings, read without locking
+ *
+ * A new table is published whenever a setting changes. Replaced tables are
+ * chained through retired and never freed, because readers hold no reference
+ * to them; settings only change during configuration so the chain stays short.
+ */
+typedef struct WCLogCategoryTable {
+    struct WCLogCategoryTable *retired;
+    BOOL defaultEnabled;
+    WCLogLevel defaultLevel;
+    NSUInteger count;
+    WCLogCategoryEntry entries[];
+} WCLogCategoryTable;
+
+static const WCLogCategoryEntry *WCLogCategoryTableLookup(const WCLogCategoryTable *table, NSString *category) {
+    CFStringRef key = (__bridge CFStringRef)category;
+
+    // Categories are almost always string constants, so try identity before hashing
+    for (NSUInteger i = 0; i < table->count; i++) {
+        if (table->entries[i].category == key) {
+            return &table->entries[i];
+        }
+    }
+
+    if (table->count == 0) {
+        return NULL;
+    }
+
+    CFHashCode hash = CFHash(key);
+    for (NSUInteger i = 0; i < table->count; i++) {
+        if (table->entries[i].hash == hash && CFEqual(table->entries[i].category, key)) {
+            return &table->entries[i];
+        }
+    }
+
+    return NULL;
+}
+
 #pragma mark - WCLogger Implementation
 
+static void WCLoggerFlushAtExit(void) {
+    [[WCLogger sharedLogger] flush];
+}
+
 @implementation WCLogger {
     // Thread safety
     pthread_mutex_t _mutex;
 
+    // Effective settings for the logging fast path
+    _Atomic(WCLogCategoryTable *) _categoryTable;
+
     // Global settings
     BOOL _loggingEnabled;
     WCLogLevel _logLevel;
@@ -328,8 +601,17 @@ NSString * const WCLogCategoryLaunch = @"Launch";
         // Initialize handlers
         _logHandlers = [NSMutableDictionary dictionary];
 
+        // Publish the initial effective settings
+        atomic_init(&_categoryTable, NULL);
+        pthread_mutex_lock(&_mutex);
+        [self rebuildCategoryTableLocked];
+        pthread_mutex_unlock(&_mutex);
+
         // Add console handler by default
         [self addLogHandler:[[WCConsoleLogHandler alloc] init] withIdentifier:@"console"];
+
+        // Buffered handlers would otherwise lose their last messages when the process exits
+        atexit(WCLoggerFlushAtExit);
     }
     return self;
 }
@@ -337,6 +619,7 @@ NSString * const WCLogCategoryLaunch = @"Launch";
 - (void)setLoggingEnabled:(BOOL)enabled {
     pthread_mutex_lock(&_mutex);
     _loggingEnabled = enabled;
+    [self rebuildCategoryTableLocked];
     pthread_mutex_unlock(&_mutex);
 }
 
@@ -351,6 +634,7 @@ NSString * const WCLogCategoryLaunch = @"Launch";
 - (void)setLogLevel:(WCLogLevel)level {
     pthread_mutex_lock(&_mutex);
     _logLevel = level;
+    [self rebuildCategoryTableLocked];
     pthread_mutex_unlock(&_mutex);
 }
 
@@ -367,6 +651,7 @@ NSString * const WCLogCategoryLaunch = @"Launch";
 
     pthread_mutex_lock(&_mutex);
     _categoryEnabled[category] = @(enabled);
+    [self rebuildCategoryTableLocked];
     pthread_mutex_unlock(&_mutex);
 }
 
@@ -386,6 +671,7 @@ NSString * const WCLogCategoryLaunch = @"Launch";
 
     pthread_mutex_lock(&_mutex);
     _categoryLogLevels[category] = @(level);
+    [self rebuildCategoryTableLocked];
     pthread_mutex_unlock(&_mutex);
 }
 
@@ -420,10 +706,18 @@ NSString * const WCLogCategoryLaunch = @"Launch";
 }
 
 - (BOOL)setLogFilePath:(NSString *)path {
+    return [self setLogFilePath:path binary:NO];
+}
+
+- (BOOL)setBinaryLogFilePath:(NSString *)path {
+    return [self setLogFilePath:path binary:YES];
+}
+
+- (BOOL)setLogFilePath:(NSString *)path binary:(BOOL)binary {
     if (!path) return NO;
 
     // Create a file handler
-    WCFileLogHandler *fileHandler = [[WCFileLogHandler alloc] initWithPath:path];
+    WCFileLogHandler *fileHandler = [[WCFileLogHandler alloc] initWithPath:path binary:binary];
     if (!fileHandler) {
         return NO;
     }
@@ -433,6 +727,34 @@ NSString * const WCLogCategoryLaunch = @"Launch";
     return YES;
 }
 
+- (void)flush {
+    NSArray *handlers;
+    pthread_mutex_lock(&_mutex);
+    handlers = [_logHandlers.allValues copy];
+    pthread_mutex_unlock(&_mutex);
+
+    for (id<WCLogHandler> handler in handlers) {
+        if ([handler respondsToSelector:@selector(flush)]) {
+            [handler flush];
+        }
+    }
+}
+
+- (uint64_t)droppedMessageCount {
+    NSArray *handlers;
+    pthread_mutex_lock(&_mutex);
+    handlers = [_logHandlers.allValues copy];
+    pthread_mutex_unlock(&_mutex);
+
+    uint64_t dropped = 0;
+    for (id<WCLogHandler> handler in handlers) {
+        if ([handler respondsToSelector:@selector(droppedMessageCount)]) {
+            dropped += [handler droppedMessageCount];
+        }
+    }
+    return dropped;
+}
+
 #pragma mark - Logging Methods
 
 - (void)logWithLevel:(WCLogLevel)level
@@ -449,16 +771,14 @@ NSString * const WCLogCategoryLaunch = @"Launch";
     NSString *message = [[NSString alloc] initWithFormat:format arguments:args];
     va_end(args);
 
-    // Create log message and dispatch to handlers
-    WCLogMessage *logMessage = [WCLogMessage messageWithLevel:level
-                                                    category:category
-                                                     message:message
-                                                        file:nil
-                                                        line:0
-                                                    function:nil
-                                                 contextData:nil];
-
-    [self dispatchLogMessage:logMessage];
+    // Dispatch to handlers
+    [self dispatchLogWithLevel:level
+                      category:category
+                       message:message
+                          file:NULL
+                          line:0
+                      function:NULL
+                   contextData:nil];
 }
 
 - (void)logWithLevel:(WCLogLevel)level
@@ -476,16 +796,14 @@ NSString * const WCLogCategoryLaunch = @"Launch";
     NSString *message = [[NSString alloc] initWithFormat:format arguments:args];
     va_end(args);
 
-    // Create log message and dispatch to handlers
-    WCLogMessage *logMessage = [WCLogMessage messageWithLevel:level
-                                                    category:category
-                                                     message:message
-                                                        file:nil
-                                                        line:0
-                                                    function:nil
-                                                 contextData:contextData];
-
-    [self dispatchLogMessage:logMessage];
+    // Dispatch to handlers
+    [self dispatchLogWithLevel:level
+                      category:category
+                       message:message
+                          file:NULL
+                          line:0
+                      function:NULL
+                   contextData:contextData];
 }
 
 - (void)logWithLevel:(WCLogLevel)level
@@ -505,19 +823,14 @@ NSString * const WCLogCategoryLaunch = @"Launch";
     NSString *message = [[NSString alloc] initWithFormat:format arguments:args];
     va_end(args);
 
-    // Create log message and dispatch to handlers
-    NSString *sourceFile = file ? @(file) : nil;
-    NSString *functionName = function ? @(function) : nil;
-
-    WCLogMessage *logMessage = [WCLogMessage messageWithLevel:level
-                                                    category:category
-                                                     message:message
-                                                        file:sourceFile
-                                                        line:line
-                                                    function:functionName
-                                                 contextData:nil];
-
-    [self dispatchLogMessage:logMessage];
+    // Dispatch to handlers
+    [self dispatchLogWithLevel:level
+                      category:category
+                       message:message
+                          file:file
+                          line:line
+                      function:function
+                   contextData:nil];
 }
 
 - (void)logWithLevel:(WCLogLevel)level
@@ -538,47 +851,109 @@ NSString * const WCLogCategoryLaunch = @"Launch";
     NSString *message = [[NSString alloc] initWithFormat:format arguments:args];
     va_end(args);
 
-    // Create log message and dispatch to handlers
-    NSString *sourceFile = file ? @(file) : nil;
-    NSString *functionName = function ? @(function) : nil;
-
-    WCLogMessage *logMessage = [WCLogMessage messageWithLevel:level
-                                                    category:category
-                                                     message:message
-                                                        file:sourceFile
-                                                        line:line
-                                                    function:functionName
-                                                 contextData:contextData];
-
-    [self dispatchLogMessage:logMessage];
+    // Dispatch to handlers
+    [self dispatchLogWithLevel:level
+                      category:category
+                       message:message
+                          file:file
+                          line:line
+                      function:function
+                   contextData:contextData];
 }
 
 #pragma mark - Helper Methods
 
+- (void)rebuildCategoryTableLocked {
+    NSMutableSet<NSString *> *categories = [NSMutableSet setWithArray:_categoryEnabled.allKeys];
+    [categories addObjectsFromArray:_categoryLogLevels.allKeys];
+
+    WCLogCategoryTable *table = calloc(1, sizeof(WCLogCategoryTable) + categories.count * sizeof(WCLogCategoryEntry));
+    if (!table) return;
+
+    table->defaultEnabled = _loggingEnabled;
+    table->defaultLevel = _logLevel;
+
+    NSInteger activeLevel = _loggingEnabled ? _logLevel : -1;
+
+    for (NSString *category in categories) {
+        NSNumber *enabled = _categoryEnabled[category];
+        NSNumber *level = _categoryLogLevels[category];
+
+        WCLogCategoryEntry *entry = &table->entries[table->count++];
+        entry->category = (CFStringRef)CFBridgingRetain([category copy]);
+        entry->hash = CFHash(entry->category);
+        entry->enabled = enabled ? [enabled boolValue] : _loggingEnabled;
+        entry->level = level ? [level integerValue] : _logLevel;
+
+        if (entry->enabled && entry->level > activeLevel) {
+            activeLevel = entry->level;
+        }
+    }
+
+    table->retired = atomic_load_explicit(&_categoryTable, memory_order_relaxed);
+    atomic_store_explicit(&_categoryTable, table, memory_order_release);
+    atomic_store_explicit(&WCLogActiveLevel, activeLevel, memory_order_relaxed);
+}
+
 - (BOOL)shouldLogWithLevel:(WCLogLevel)level category:(NSString *)category {
+    // Nothing logs at this level, whatever the category
+    if (!WCLogLevelMayBeEnabled(level)) {
+        return NO;
+    }
+
     if (!category) {
         category = WCLogCategoryGeneral;
     }
 
-    // Check if logging is enabled for this category
-    if (![self isLoggingEnabledForCategory:category]) {
+    const WCLogCategoryTable *table = atomic_load_explicit(&_categoryTable, memory_order_acquire);
+    if (!table) {
         return NO;
     }
 
-    // Check if the log level is enabled for this category
-    WCLogLevel categoryLevel = [self logLevelForCategory:category];
-    return level <= categoryLevel;
+    const WCLogCategoryEntry *entry = WCLogCategoryTableLookup(table, category);
+    BOOL enabled = entry ? entry->enabled : table->defaultEnabled;
+    WCLogLevel categoryLevel = entry ? entry->level : table->defaultLevel;
+
+    return enabled && level <= categoryLevel;
 }
 
-- (void)dispatchLogMessage:(WCLogMessage *)logMessage {
+- (void)dispatchLogWithLevel:(WCLogLevel)level
+                    category:(NSString *)category
+                     message:(NSString *)message
+                        file:(const char *)file
+                        line:(NSInteger)line
+                    function:(const char *)function
+                 contextData:(NSDictionary *)contextData {
     // Make a copy of handlers to avoid holding the lock during dispatch
     NSArray *handlers;
     pthread_mutex_lock(&_mutex);
     handlers = [_logHandlers.allValues copy];
     pthread_mutex_unlock(&_mutex);
 
-    // Dispatch to each handler
+    // Only build a message object if some handler needs one
+    WCLogMessage *logMessage = nil;
+
     for (id<WCLogHandler> handler in handlers) {
+        if ([handler respondsToSelector:@selector(handleLogWithLevel:category:message:file:line:function:contextData:)]) {
+            [handler handleLogWithLevel:level
+                               category:category
+                                message:message
+                                   file:file
+                                   line:line
+                               function:function
+                            contextData:contextData];
+            continue;
+        }
+
+        if (!logMessage) {
+            logMessage = [WCLogMessage messageWithLevel:level
+                                               category:category
+                                                message:message
+                                                   file:file ? @(file) : nil
+                                                   line:line
+                                               function:function ? @(function) : nil
+                                            contextData:contextData];
+        }
         [handler handleLogMessage:logMessage];
     }
 }
@@ -649,6 +1024,10 @@ BOOL WCSetLogFilePath(NSString *path) {
     return [[WCLogger sharedLogger] setLogFilePath:path];
 }
 
+BOOL WCSetBinaryLogFilePath(NSString *path) {
+    return [[WCLogger sharedLogger] setBinaryLogFilePath:path];
+}
+
 void WCSetLoggingEnabledForCategory(BOOL enabled, NSString *category) {
     [[WCLogger sharedLogger] setLoggingEnabled:enabled forCategory:category];
 }
@@ -11,6 +11,7 @@
 
 #import <Foundation/Foundation.h>
 #import <objc/runtime.h>
+#include <stdatomic.h>
 
 /**
  * Types of implementations that can be swizzled
@@ -33,6 +34,27 @@ typedef NS_ENUM(NSInteger, WCSwizzlingStrategy) {
     WCSwizzlingStrategyInstead        // Call custom code instead of original, but allow calling original
 };
 
+/**
+ * @brief Storage for the original implementation of one swizzled method
+ *
+ * Replacement implementations are called on every message send, so instead
+ * of looking the original up by class and selector they keep it in a static
+ * slot that the swizzler fills in before the swap takes effect and clears
+ * after it is undone. Calling through is then a single load and an
+ * indirect call.
+ */
+typedef _Atomic(IMP) WCIMPSlot;
+
+/**
+ * @brief Read the original implementation stored in a slot
+ *
+ * @param slot The slot passed to the swizzler at install time
+ * @return The original implementation, or NULL if the method is not swizzled
+ */
+static inline IMP WCIMPSlotLoad(WCIMPSlot *slot) {
+    return atomic_load_explicit(slot, memory_order_acquire);
+}
+
 /**
  * @brief Modern method swizzling class for WindowControlInjector
  *
@@ -71,6 +93,26 @@ typedef NS_ENUM(NSInteger, WCSwizzlingStrategy) {
   implementationType:(WCImplementationType)implementationType
             strategy:(WCSwizzlingStrategy)strategy;
 
+/**
+ * @brief Swizzle a method and publish its original implementation to a slot
+ *
+ * The slot is written before the implementations are exchanged, so the
+ * replacement can call through from its very first invocation. It is
+ * cleared again by unswizzleClass:... and clearStoredImplementations.
+ *
+ * @param cls The class to swizzle
+ * @param originalSelector The original selector
+ * @param replacementSelector The replacement selector
+ * @param implementationType The type of implementation to swizzle
+ * @param slot Static storage that receives the original implementation; may be NULL
+ * @return YES if swizzling was successful, NO otherwise
+ */
++ (BOOL)swizzleClass:(Class)cls
+    originalSelector:(SEL)originalSelector
+ replacementSelector:(SEL)replacementSelector
+  implementationType:(WCImplementationType)implementationType
+     originalIMPSlot:(WCIMPSlot *)slot;
+
 /**
  * @brief Add a method to a class
  *
@@ -164,6 +206,9 @@ implementsSelector:(SEL)selector
 /**
  * @brief Retrieve a previously stored original implementation
  *
+ * This takes a lock and builds a lookup key; replacement implementations
+ * should read the slot registered at install time with WCIMPSlotLoad instead.
+ *
  * @param cls The class the method belongs to
  * @param selector The method selector
  * @param implementationType The type of implementation
@@ -176,7 +221,8 @@ implementsSelector:(SEL)selector
 /**
  * @brief Cleanup all stored implementations
  *
- * This removes all stored original implementations.
+ * This removes all stored original implementations and clears any
+ * registered original implementation slots.
  */
 + (void)clearStoredImplementations;
 
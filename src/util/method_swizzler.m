@@ -10,6 +10,9 @@
 // Dictionary to store original implementations for unswizzling
 static NSMutableDictionary *originalImplementations = nil;
 
+// Slots registered at swizzle time, keyed like originalImplementations and guarded by its lock
+static NSMutableDictionary *originalImplementationSlots = nil;
+
 // Key generation for implementation storage
 static NSString *WCImplementationKeyForMethod(Class cls, SEL selector, WCImplementationType type) {
     return [NSString stringWithFormat:@"%@_%@_%ld",
@@ -26,6 +29,7 @@ static NSString *WCImplementationKeyForMethod(Class cls, SEL selector, WCImpleme
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
         originalImplementations = [NSMutableDictionary dictionary];
+        originalImplementationSlots = [NSMutableDictionary dictionary];
     });
 }
 
@@ -49,6 +53,35 @@ static NSString *WCImplementationKeyForMethod(Class cls, SEL selector, WCImpleme
   implementationType:(WCImplementationType)implementationType
             strategy:(WCSwizzlingStrategy)strategy {
 
+    return [self swizzleClass:cls
+              originalSelector:originalSelector
+           replacementSelector:replacementSelector
+            implementationType:implementationType
+                      strategy:strategy
+               originalIMPSlot:NULL];
+}
+
++ (BOOL)swizzleClass:(Class)cls
+    originalSelector:(SEL)originalSelector
+ replacementSelector:(SEL)replacementSelector
+  implementationType:(WCImplementationType)implementationType
+     originalIMPSlot:(WCIMPSlot *)slot {
+
+    return [self swizzleClass:cls
+              originalSelector:originalSelector
+           replacementSelector:replacementSelector
+            implementationType:implementationType
+                      strategy:WCSwizzlingStrategyExchange
+               originalIMPSlot:slot];
+}
+
++ (BOOL)swizzleClass:(Class)cls
+    originalSelector:(SEL)originalSelector
+ replacementSelector:(SEL)replacementSelector
+  implementationType:(WCImplementationType)implementationType
+            strategy:(WCSwizzlingStrategy)strategy
+     originalIMPSlot:(WCIMPSlot *)slot {
+
     // Input validation
     if (!cls || !originalSelector || !replacementSelector) {
         [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
@@ -111,6 +144,15 @@ static NSString *WCImplementationKeyForMethod(Class cls, SEL selector, WCImpleme
                              selector:originalSelector
                    implementationType:implementationType];
 
+    // Publish to the slot before the swap so the replacement can call through immediately
+    if (slot) {
+        [self registerOriginalImplementation:originalImplementation
+                                      inSlot:slot
+                                    forClass:targetClass
+                                    selector:originalSelector
+                          implementationType:implementationType];
+    }
+
     // Perform swizzling based on strategy
     BOOL success = NO;
 
@@ -149,6 +191,12 @@ static NSString *WCImplementationKeyForMethod(Class cls, SEL selector, WCImpleme
                                               NSStringFromSelector(replacementSelector),
                                               NSStringFromClass(targetClass)];
     } else {
+        if (slot) {
+            [self unregisterSlotForClass:targetClass
+                                selector:originalSelector
+                      implementationType:implementationType];
+        }
+
         [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
                                      category:WCLogCategoryInterception
                                          file:__FILE__
@@ -368,6 +416,11 @@ static NSString *WCImplementationKeyForMethod(Class cls, SEL selector, WCImpleme
     // Restore the original implementation
     method_setImplementation(originalMethod, originalImplementation);
 
+    // Only clear the slot once the replacement is no longer reachable through the original selector
+    [self unregisterSlotForClass:targetClass
+                        selector:originalSelector
+              implementationType:implementationType];
+
     [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
                                  category:WCLogCategoryInterception
                                      file:__FILE__
@@ -470,6 +523,12 @@ implementsSelector:(SEL)selector
 + (void)clearStoredImplementations {
     @synchronized(originalImplementations) {
         [originalImplementations removeAllObjects];
+
+        for (NSValue *slotValue in [originalImplementationSlots allValues]) {
+            atomic_store_explicit((WCIMPSlot *)[slotValue pointerValue], (IMP)NULL, memory_order_release);
+        }
+        [originalImplementationSlots removeAllObjects];
+
         [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
                                      category:WCLogCategoryInterception
                                          file:__FILE__
@@ -481,6 +540,33 @@ implementsSelector:(SEL)selector
 
 #pragma mark - Private Methods
 
++ (void)registerOriginalImplementation:(IMP)implementation
+                                inSlot:(WCIMPSlot *)slot
+                              forClass:(Class)cls
+                              selector:(SEL)selector
+                    implementationType:(WCImplementationType)implementationType {
+
+    @synchronized(originalImplementations) {
+        NSString *key = WCImplementationKeyForMethod(cls, selector, implementationType);
+        originalImplementationSlots[key] = [NSValue valueWithPointer:slot];
+        atomic_store_explicit(slot, implementation, memory_order_release);
+    }
+}
+
++ (void)unregisterSlotForClass:(Class)cls
+                      selector:(SEL)selector
+            implementationType:(WCImplementationType)implementationType {
+
+    @synchronized(originalImplementations) {
+        NSString *key = WCImplementationKeyForMethod(cls, selector, implementationType);
+        NSValue *slotValue = originalImplementationSlots[key];
+        if (slotValue) {
+            atomic_store_explicit((WCIMPSlot *)[slotValue pointerValue], (IMP)NULL, memory_order_release);
+            [originalImplementationSlots removeObjectForKey:key];
+        }
+    }
+}
+
 + (BOOL)exchangeImplementations:(Method)originalMethod replacementMethod:(Method)replacementMethod {
     if (!originalMethod || !replacementMethod) {
         return NO;
@@ -12,6 +12,59 @@
 #import <Foundation/Foundation.h>
 #import "wc_cgs_types.h"
 
+/**
+ * @brief Operations that can be applied by a batch call
+ */
+typedef NS_OPTIONS(NSUInteger, WCCGSBatchOperations) {
+    WCCGSBatchOperationSharingState       = 1 << 0,  // Set the window sharing state
+    WCCGSBatchOperationLevel              = 1 << 1,  // Set the window level
+    WCCGSBatchOperationMissionControlTags = 1 << 2   // Apply the Mission Control visibility tags
+};
+
+/**
+ * @brief Per-window outcome of a batch call
+ *
+ * Errors are kCGErrorSuccess for operations that succeeded or were not requested.
+ */
+typedef struct {
+    CGSWindowID windowID;
+    CGError sharingError;
+    CGError levelError;
+    CGError tagsError;
+} WCCGSBatchResult;
+
+/**
+ * @brief Check if every requested operation in a batch result succeeded
+ */
+static inline BOOL WCCGSBatchResultSucceeded(const WCCGSBatchResult *result) {
+    return result->sharingError == kCGErrorSuccess &&
+           result->levelError == kCGErrorSuccess &&
+           result->tagsError == kCGErrorSuccess;
+}
+
+/**
+ * @brief Replacement implementations of every CGS function in use
+ *
+ * Functions left NULL are treated as unavailable, the same as symbols
+ * that could not be resolved.
+ */
+typedef struct {
+    CGSDefaultConnectionPtr defaultConnection;
+    CGSSetWindowSharingStatePtr setWindowSharingState;
+    CGSGetWindowSharingStatePtr getWindowSharingState;
+    CGSSetWindowLevelPtr setWindowLevel;
+    CGSGetWindowLevelPtr getWindowLevel;
+    CGSRegisterNotifyProcPtr registerNotifyProc;
+    CGSRemoveNotifyProcPtr removeNotifyProc;
+    CGSSetWindowTagsPtr setWindowTags;
+    CGSClearWindowTagsPtr clearWindowTags;
+    CGSDisableUpdatePtr disableUpdate;
+    CGSReenableUpdatePtr reenableUpdate;
+    CGSTransactionCreatePtr transactionCreate;
+    CGSTransactionSetWindowLevelPtr transactionSetWindowLevel;
+    CGSTransactionCommitPtr transactionCommit;
+} WCCGSFunctionTable;
+
 /**
  * @brief Manager class for CGS function pointers
  *
@@ -37,12 +90,22 @@
 @property (nonatomic, readonly) CGSSetWindowLevelPtr CGSSetWindowLevel;
 @property (nonatomic, readonly) CGSGetWindowLevelPtr CGSGetWindowLevel;
 
+/**
+ * @brief Window server notification function pointers
+ *
+ * Resolved from CoreGraphics, falling back to the SkyLight equivalents
+ * on systems where the CGS names are no longer exported.
+ */
+@property (nonatomic, readonly) CGSRegisterNotifyProcPtr CGSRegisterNotifyProc;
+@property (nonatomic, readonly) CGSRemoveNotifyProcPtr CGSRemoveNotifyProc;
+
 /**
  * @brief Availability checks
  */
 - (BOOL)isAvailable;
 - (BOOL)canSetWindowSharingState;
 - (BOOL)canSetWindowLevel;
+- (BOOL)canRegisterNotifications;
 
 /**
  * @brief Function resolution
@@ -51,6 +114,40 @@
  */
 - (BOOL)resolveAllFunctions;
 
+/**
+ * @brief Use the given functions instead of the window server's
+ *
+ * Nothing is resolved with dlsym afterwards. The trace replay driver uses
+ * this to run the scanner against a mock window server. Install the table
+ * before anything calls into CGS.
+ *
+ * @param table The replacement functions
+ */
+- (void)installFunctionTable:(const WCCGSFunctionTable *)table;
+
+/**
+ * @brief Apply sharing state, level and tags to many windows in one pass
+ *
+ * The connection is resolved once for the whole batch. Level changes are
+ * grouped into a single window server transaction when the transaction
+ * functions are available; otherwise screen updates are suspended while the
+ * windows are changed one by one. Nothing is logged per window.
+ *
+ * @param operations The operations to apply to every window
+ * @param windowIDs The windows to change
+ * @param count Number of entries in windowIDs
+ * @param sharingState The sharing state to set (WCCGSBatchOperationSharingState)
+ * @param level The level to set (WCCGSBatchOperationLevel)
+ * @param results Caller-owned array of count entries for per-window errors; may be NULL
+ * @return Number of windows for which every requested operation succeeded
+ */
+- (NSUInteger)applyOperations:(WCCGSBatchOperations)operations
+                  toWindowIDs:(const CGSWindowID *)windowIDs
+                        count:(NSUInteger)count
+                 sharingState:(CGSWindowSharingType)sharingState
+                        level:(CGWindowLevel)level
+                      results:(WCCGSBatchResult *)results;
+
 /**
  * @brief Perform a CGS operation with proper error handling
  *
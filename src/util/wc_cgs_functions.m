@@ -5,6 +5,7 @@
 
 #import "wc_cgs_functions.h"
 #import "logger.h"
+#import "wc_metrics.h"
 #import <dlfcn.h>
 
 @implementation WCCGSFunctions {
@@ -18,6 +19,18 @@
     CGSGetWindowSharingStatePtr _cgsGetWindowSharingState;
     CGSSetWindowLevelPtr _cgsSetWindowLevel;
     CGSGetWindowLevelPtr _cgsGetWindowLevel;
+    CGSRegisterNotifyProcPtr _cgsRegisterNotifyProc;
+    CGSRemoveNotifyProcPtr _cgsRemoveNotifyProc;
+
+    // Batch operation function pointers
+    void *_skyLightHandle;
+    CGSSetWindowTagsPtr _cgsSetWindowTags;
+    CGSClearWindowTagsPtr _cgsClearWindowTags;
+    CGSDisableUpdatePtr _cgsDisableUpdate;
+    CGSReenableUpdatePtr _cgsReenableUpdate;
+    CGSTransactionCreatePtr _cgsTransactionCreate;
+    CGSTransactionSetWindowLevelPtr _cgsTransactionSetWindowLevel;
+    CGSTransactionCommitPtr _cgsTransactionCommit;
 
     // Track which functions we've attempted to resolve
     BOOL _triedToResolveDefaultConnection;
@@ -25,6 +38,11 @@
     BOOL _triedToResolveGetWindowSharingState;
     BOOL _triedToResolveSetWindowLevel;
     BOOL _triedToResolveGetWindowLevel;
+    BOOL _triedToResolveNotifyProcs;
+    BOOL _triedToResolveBatchFunctions;
+
+    // Set when a replacement function table is in use
+    BOOL _functionTableInstalled;
 }
 
 #pragma mark - Initialization and Singleton Pattern
@@ -49,6 +67,16 @@
         _cgsGetWindowSharingState = NULL;
         _cgsSetWindowLevel = NULL;
         _cgsGetWindowLevel = NULL;
+        _cgsRegisterNotifyProc = NULL;
+        _cgsRemoveNotifyProc = NULL;
+        _skyLightHandle = NULL;
+        _cgsSetWindowTags = NULL;
+        _cgsClearWindowTags = NULL;
+        _cgsDisableUpdate = NULL;
+        _cgsReenableUpdate = NULL;
+        _cgsTransactionCreate = NULL;
+        _cgsTransactionSetWindowLevel = NULL;
+        _cgsTransactionCommit = NULL;
 
         // Initialize resolution tracking
         _triedToResolveDefaultConnection = NO;
@@ -56,6 +84,9 @@
         _triedToResolveGetWindowSharingState = NO;
         _triedToResolveSetWindowLevel = NO;
         _triedToResolveGetWindowLevel = NO;
+        _triedToResolveNotifyProcs = NO;
+        _triedToResolveBatchFunctions = NO;
+        _functionTableInstalled = NO;
 
         // Attempt to resolve functions at initialization
         [self resolveAllFunctions];
@@ -131,7 +162,7 @@
                                      category:@"CGS"
                                          file:__FILE__
                                          line:__LINE__
-                                     function:@"resolveAllFunctions"
+                                     function:__PRETTY_FUNCTION__
                                        format:@"Successfully resolved CGSGetWindowSharingState"];
     }
 
@@ -171,10 +202,13 @@
                                      category:@"CGS"
                                          file:__FILE__
                                          line:__LINE__
-                                     function:@"resolveAllFunctions"
+                                     function:__PRETTY_FUNCTION__
                                        format:@"Successfully resolved CGSGetWindowLevel"];
     }
 
+    // Resolve the notification registration functions used for event-driven discovery
+    [self resolveNotifyProcs];
+
     // We consider initialization successful if at minimum we have the DefaultConnection function
     _functionsResolved = (_cgsDefaultConnection != NULL);
 
@@ -197,6 +231,50 @@
     return _functionsResolved;
 }
 
+- (void)installFunctionTable:(const WCCGSFunctionTable *)table {
+    if (!table) return;
+
+    @synchronized(self) {
+        _cgsDefaultConnection = table->defaultConnection;
+        _cgsSetWindowSharingState = table->setWindowSharingState;
+        _cgsGetWindowSharingState = table->getWindowSharingState;
+        _cgsSetWindowLevel = table->setWindowLevel;
+        _cgsGetWindowLevel = table->getWindowLevel;
+        _cgsSetWindowTags = table->setWindowTags;
+        _cgsClearWindowTags = table->clearWindowTags;
+        _cgsDisableUpdate = table->disableUpdate;
+        _cgsReenableUpdate = table->reenableUpdate;
+
+        // Both halves of a pair or neither, as after resolution
+        BOOL hasNotifyProcs = table->registerNotifyProc && table->removeNotifyProc;
+        _cgsRegisterNotifyProc = hasNotifyProcs ? table->registerNotifyProc : NULL;
+        _cgsRemoveNotifyProc = hasNotifyProcs ? table->removeNotifyProc : NULL;
+
+        BOOL hasTransactions = table->transactionCreate && table->transactionSetWindowLevel && table->transactionCommit;
+        _cgsTransactionCreate = hasTransactions ? table->transactionCreate : NULL;
+        _cgsTransactionSetWindowLevel = hasTransactions ? table->transactionSetWindowLevel : NULL;
+        _cgsTransactionCommit = hasTransactions ? table->transactionCommit : NULL;
+
+        // Nothing may be looked up lazily over the installed functions
+        _triedToResolveDefaultConnection = YES;
+        _triedToResolveSetWindowSharingState = YES;
+        _triedToResolveGetWindowSharingState = YES;
+        _triedToResolveSetWindowLevel = YES;
+        _triedToResolveGetWindowLevel = YES;
+        _triedToResolveNotifyProcs = YES;
+        _triedToResolveBatchFunctions = YES;
+        _functionsResolved = YES;
+        _functionTableInstalled = YES;
+    }
+
+    [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                 category:@"CGS"
+                                     file:__FILE__
+                                     line:__LINE__
+                                 function:__PRETTY_FUNCTION__
+                                   format:@"Using replacement CGS functions"];
+}
+
 #pragma mark - Lazy Function Resolution
 
 // These methods attempt to resolve functions on-demand if they haven't been resolved yet
@@ -286,10 +364,114 @@
     return _cgsGetWindowLevel;
 }
 
+/**
+ * Resolve a symbol from CoreGraphics, falling back to its SkyLight name
+ * since newer systems only export many functions from SkyLight under the SLS prefix
+ */
+- (void *)resolveSymbol:(const char *)cgsName skyLightName:(const char *)skyLightName {
+    void *symbol = NULL;
+
+    if (_cgsHandle && cgsName) {
+        symbol = dlsym(_cgsHandle, cgsName);
+    }
+
+    if (!symbol && skyLightName) {
+        if (!_skyLightHandle) {
+            _skyLightHandle = dlopen("/System/Library/PrivateFrameworks/SkyLight.framework/SkyLight", RTLD_NOW);
+        }
+        if (_skyLightHandle) {
+            symbol = dlsym(_skyLightHandle, skyLightName);
+        }
+    }
+
+    return symbol;
+}
+
+- (void)resolveNotifyProcs {
+    if (_triedToResolveNotifyProcs) return;
+    _triedToResolveNotifyProcs = YES;
+
+    _cgsRegisterNotifyProc = (CGSRegisterNotifyProcPtr)[self resolveSymbol:"CGSRegisterNotifyProc"
+                                                              skyLightName:"SLSRegisterNotifyProc"];
+    _cgsRemoveNotifyProc = (CGSRemoveNotifyProcPtr)[self resolveSymbol:"CGSRemoveNotifyProc"
+                                                          skyLightName:"SLSRemoveNotifyProc"];
+
+    if (_cgsRegisterNotifyProc && _cgsRemoveNotifyProc) {
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                     category:@"CGS"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Successfully resolved window server notification functions"];
+    } else {
+        _cgsRegisterNotifyProc = NULL;
+        _cgsRemoveNotifyProc = NULL;
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelWarning
+                                     category:@"CGS"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Window server notification functions unavailable"];
+    }
+}
+
+- (void)resolveBatchFunctions {
+    // Batches run on the scanner queue while other callers may be on the main thread
+    @synchronized(self) {
+        if (_triedToResolveBatchFunctions) return;
+        [self resolveBatchFunctionsLocked];
+        _triedToResolveBatchFunctions = YES;
+    }
+}
+
+- (void)resolveBatchFunctionsLocked {
+
+    _cgsSetWindowTags = (CGSSetWindowTagsPtr)[self resolveSymbol:"CGSSetWindowTags" skyLightName:"SLSSetWindowTags"];
+    _cgsClearWindowTags = (CGSClearWindowTagsPtr)[self resolveSymbol:"CGSClearWindowTags" skyLightName:"SLSClearWindowTags"];
+    _cgsDisableUpdate = (CGSDisableUpdatePtr)[self resolveSymbol:"CGSDisableUpdate" skyLightName:"SLSDisableUpdate"];
+    _cgsReenableUpdate = (CGSReenableUpdatePtr)[self resolveSymbol:"CGSReenableUpdate" skyLightName:"SLSReenableUpdate"];
+
+    // Transactions only exist in SkyLight
+    _cgsTransactionCreate = (CGSTransactionCreatePtr)[self resolveSymbol:NULL skyLightName:"SLSTransactionCreate"];
+    _cgsTransactionSetWindowLevel = (CGSTransactionSetWindowLevelPtr)[self resolveSymbol:NULL
+                                                                            skyLightName:"SLSTransactionSetWindowLevel"];
+    _cgsTransactionCommit = (CGSTransactionCommitPtr)[self resolveSymbol:NULL skyLightName:"SLSTransactionCommit"];
+
+    if (!_cgsTransactionCreate || !_cgsTransactionSetWindowLevel || !_cgsTransactionCommit) {
+        _cgsTransactionCreate = NULL;
+        _cgsTransactionSetWindowLevel = NULL;
+        _cgsTransactionCommit = NULL;
+    }
+    if (!_cgsDisableUpdate || !_cgsReenableUpdate) {
+        _cgsDisableUpdate = NULL;
+        _cgsReenableUpdate = NULL;
+    }
+
+    [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                 category:@"CGS"
+                                     file:__FILE__
+                                     line:__LINE__
+                                 function:__PRETTY_FUNCTION__
+                                   format:@"Batch functions resolved (tags: %@, transactions: %@, update suspension: %@)",
+                                         (_cgsSetWindowTags && _cgsClearWindowTags) ? @"YES" : @"NO",
+                                         _cgsTransactionCreate ? @"YES" : @"NO",
+                                         _cgsDisableUpdate ? @"YES" : @"NO"];
+}
+
+- (CGSRegisterNotifyProcPtr)CGSRegisterNotifyProc {
+    [self resolveNotifyProcs];
+    return _cgsRegisterNotifyProc;
+}
+
+- (CGSRemoveNotifyProcPtr)CGSRemoveNotifyProc {
+    [self resolveNotifyProcs];
+    return _cgsRemoveNotifyProc;
+}
+
 #pragma mark - Availability Checks
 
 - (BOOL)isAvailable {
-    return _cgsHandle != NULL && _cgsDefaultConnection != NULL;
+    return (_cgsHandle != NULL || _functionTableInstalled) && _cgsDefaultConnection != NULL;
 }
 
 - (BOOL)canSetWindowSharingState {
@@ -300,6 +482,10 @@
     return self.isAvailable && self.CGSSetWindowLevel != NULL;
 }
 
+- (BOOL)canRegisterNotifications {
+    return self.CGSRegisterNotifyProc != NULL && self.CGSRemoveNotifyProc != NULL;
+}
+
 #pragma mark - CGS Operation Utilities
 
 - (BOOL)performCGSOperation:(NSString *)operationName
@@ -329,8 +515,10 @@
 
     // Perform operation with diagnostics
     CGError error = operation(cid, windowID);
+    WCMetricsIncrement(WCMetricCounterCGSCalls);
 
     if (error) {
+        WCMetricsIncrement(WCMetricCounterCGSErrors);
         [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
                                      category:@"CGS"
                                          file:__FILE__
@@ -351,6 +539,145 @@
     return YES;
 }
 
+#pragma mark - Batch Operations
+
+- (NSUInteger)applyOperations:(WCCGSBatchOperations)operations
+                  toWindowIDs:(const CGSWindowID *)windowIDs
+                        count:(NSUInteger)count
+                 sharingState:(CGSWindowSharingType)sharingState
+                        level:(CGWindowLevel)level
+                      results:(WCCGSBatchResult *)results {
+    if (count == 0 || !windowIDs) return 0;
+
+    // Results are needed internally to attribute transaction commit failures
+    WCCGSBatchResult stackResults[64];
+    WCCGSBatchResult *outcomes = results;
+    if (!outcomes) {
+        outcomes = count <= 64 ? stackResults : calloc(count, sizeof(WCCGSBatchResult));
+        if (!outcomes) return 0;
+    }
+
+    for (NSUInteger i = 0; i < count; i++) {
+        outcomes[i].windowID = windowIDs[i];
+        outcomes[i].sharingError = kCGErrorSuccess;
+        outcomes[i].levelError = kCGErrorSuccess;
+        outcomes[i].tagsError = kCGErrorSuccess;
+    }
+
+    CGSConnectionID cid = self.isAvailable ? self.CGSDefaultConnection() : 0;
+    if (cid == 0) {
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
+                                     category:@"CGS"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Cannot apply batch to %lu windows - no CGS connection", (unsigned long)count];
+        for (NSUInteger i = 0; i < count; i++) {
+            if (operations & WCCGSBatchOperationSharingState) outcomes[i].sharingError = kCGErrorCannotComplete;
+            if (operations & WCCGSBatchOperationLevel) outcomes[i].levelError = kCGErrorCannotComplete;
+            if (operations & WCCGSBatchOperationMissionControlTags) outcomes[i].tagsError = kCGErrorCannotComplete;
+        }
+        if (outcomes != results && outcomes != stackResults) free(outcomes);
+        return 0;
+    }
+
+    [self resolveBatchFunctions];
+
+    CGSSetWindowSharingStatePtr setSharing = self.CGSSetWindowSharingState;
+    CGSSetWindowLevelPtr setLevel = self.CGSSetWindowLevel;
+
+    // Same tags WCWindowInfo uses to keep windows out of Mission Control and Exposé
+    static const CGSWindowTag kClearTags[] = { 3, 4, 5, 6, 7 };
+    static const CGSWindowTag kSetTags[] = { 1, 2, 8 };
+
+    // Counted locally and published once so the loops stay free of atomics
+    uint64_t calls = 0;
+
+    BOOL suspendUpdates = count > 1 && _cgsDisableUpdate != NULL;
+    if (suspendUpdates) {
+        _cgsDisableUpdate(cid);
+        calls++;
+    }
+
+    // Sharing state and tags have no transaction equivalent, so set them directly
+    for (NSUInteger i = 0; i < count; i++) {
+        CGSWindowID wid = windowIDs[i];
+
+        if (operations & WCCGSBatchOperationSharingState) {
+            outcomes[i].sharingError = setSharing ? setSharing(cid, wid, sharingState) : kCGErrorCannotComplete;
+            if (setSharing) calls++;
+        }
+
+        if (operations & WCCGSBatchOperationMissionControlTags) {
+            if (_cgsSetWindowTags && _cgsClearWindowTags) {
+                _cgsClearWindowTags(cid, wid, kClearTags, (int)(sizeof(kClearTags) / sizeof(kClearTags[0])));
+                outcomes[i].tagsError = _cgsSetWindowTags(cid, wid, kSetTags, (int)(sizeof(kSetTags) / sizeof(kSetTags[0])));
+                calls += 2;
+            } else {
+                outcomes[i].tagsError = kCGErrorCannotComplete;
+            }
+        }
+    }
+
+    if (operations & WCCGSBatchOperationLevel) {
+        CGSTransactionRef transaction = _cgsTransactionCreate ? _cgsTransactionCreate(cid) : NULL;
+
+        if (transaction) {
+            for (NSUInteger i = 0; i < count; i++) {
+                outcomes[i].levelError = _cgsTransactionSetWindowLevel(transaction, windowIDs[i], level);
+            }
+
+            // Levels are only queued on the transaction; the create and commit are the round trips
+            CGError commitError = _cgsTransactionCommit(transaction, 0);
+            CFRelease(transaction);
+            calls += 2;
+
+            if (commitError != kCGErrorSuccess) {
+                for (NSUInteger i = 0; i < count; i++) {
+                    if (outcomes[i].levelError == kCGErrorSuccess) {
+                        outcomes[i].levelError = commitError;
+                    }
+                }
+            }
+        } else {
+            for (NSUInteger i = 0; i < count; i++) {
+                outcomes[i].levelError = setLevel ? setLevel(cid, windowIDs[i], level) : kCGErrorCannotComplete;
+            }
+            if (setLevel) calls += count;
+        }
+    }
+
+    if (suspendUpdates) {
+        _cgsReenableUpdate(cid);
+        calls++;
+    }
+
+    NSUInteger succeeded = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        if (WCCGSBatchResultSucceeded(&outcomes[i])) {
+            succeeded++;
+        }
+    }
+
+    WCMetricsAdd(WCMetricCounterCGSCalls, calls);
+    if (succeeded < count) {
+        WCMetricsAdd(WCMetricCounterCGSErrors, count - succeeded);
+    }
+
+    if (outcomes != results && outcomes != stackResults) {
+        free(outcomes);
+    }
+
+    [[WCLogger sharedLogger] logWithLevel:(succeeded == count) ? WCLogLevelDebug : WCLogLevelWarning
+                                 category:@"CGS"
+                                     file:__FILE__
+                                     line:__LINE__
+                                 function:__PRETTY_FUNCTION__
+                                   format:@"Batch operations 0x%lx succeeded for %lu of %lu windows",
+                                         (unsigned long)operations, (unsigned long)succeeded, (unsigned long)count];
+    return succeeded;
+}
+
 #pragma mark - Cleanup
 
 - (void)dealloc {
@@ -358,6 +685,10 @@
         dlclose(_cgsHandle);
         _cgsHandle = NULL;
     }
+    if (_skyLightHandle) {
+        dlclose(_skyLightHandle);
+        _skyLightHandle = NULL;
+    }
 }
 
 @end
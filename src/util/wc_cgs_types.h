@@ -26,11 +26,36 @@ typedef enum {
     CGSWindowSharingReadWrite = 2
 } CGSWindowSharingType;
 
+// Window server notification types (subset used for event-driven discovery)
+typedef uint32_t CGSNotificationType;
+
+enum {
+    kCGSWindowIsOrderedIn = 802,
+    kCGSWindowIsOrderedOut = 803,
+    kCGSWindowIsTerminated = 804,
+    kCGSWindowDidCreate = 811
+};
+
+// Notification callback; for window notifications data begins with the CGSWindowID
+typedef void (*CGSNotifyProcPtr)(CGSNotificationType type, void *data, uint32_t dataLength, void *userData);
+
 // Function pointer types
 typedef CGSConnectionID (*CGSDefaultConnectionPtr)(void);
+typedef CGError (*CGSRegisterNotifyProcPtr)(CGSNotifyProcPtr proc, CGSNotificationType type, void *userData);
+typedef CGError (*CGSRemoveNotifyProcPtr)(CGSNotifyProcPtr proc, CGSNotificationType type, void *userData);
 typedef CGError (*CGSSetWindowSharingStatePtr)(CGSConnectionID cid, CGSWindowID wid, CGSWindowSharingType sharing);
 typedef CGError (*CGSGetWindowSharingStatePtr)(CGSConnectionID cid, CGSWindowID wid, CGSWindowSharingType *sharing);
 typedef CGError (*CGSSetWindowLevelPtr)(CGSConnectionID cid, CGSWindowID wid, CGWindowLevel level);
 typedef CGError (*CGSGetWindowLevelPtr)(CGSConnectionID cid, CGSWindowID wid, CGWindowLevel *level);
+typedef CGError (*CGSSetWindowTagsPtr)(CGSConnectionID cid, CGSWindowID wid, const CGSWindowTag *tags, int tagSize);
+typedef CGError (*CGSClearWindowTagsPtr)(CGSConnectionID cid, CGSWindowID wid, const CGSWindowTag *tags, int tagSize);
+typedef CGError (*CGSDisableUpdatePtr)(CGSConnectionID cid);
+typedef CGError (*CGSReenableUpdatePtr)(CGSConnectionID cid);
+
+// Window server transactions (SkyLight); changes are applied together on commit
+typedef CFTypeRef CGSTransactionRef;
+typedef CGSTransactionRef (*CGSTransactionCreatePtr)(CGSConnectionID cid);
+typedef CGError (*CGSTransactionSetWindowLevelPtr)(CGSTransactionRef transaction, CGSWindowID wid, CGWindowLevel level);
+typedef CGError (*CGSTransactionCommitPtr)(CGSTransactionRef transaction, int32_t synchronous);
 
 #endif /* WC_CGS_TYPES_H */
@@ -0,0 +1,142 @@
+/**
+ * @file wc_event_trace.h
+ * @brief Window and process event traces for WindowControlInjector
+ *
+ * This file defines a recorder for the events that drive the scanner:
+ * windows appearing, disappearing and changing level or sharing state,
+ * and helper processes forking and exiting. Events are appended as
+ * fixed-size binary entries with a monotonic timestamp, buffered in memory
+ * and written by a background queue, so recording costs a lock and a copy
+ * per event. A recorded trace can be fed back through the scanner against
+ * mocked window server and process back ends by `make replay`, which gives
+ * repeatable numbers for workloads that only occur in real applications.
+ *
+ * Recording is off unless WCI_TRACE_PATH (or "traceFile") is set, and an
+ * event that is not recorded costs one relaxed atomic load.
+ */
+
+#ifndef WC_EVENT_TRACE_H
+#define WC_EVENT_TRACE_H
+
+#import <Foundation/Foundation.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+/**
+ * @brief Kinds of traced events
+ */
+typedef NS_ENUM(uint8_t, WCEventTraceKind) {
+    WCEventTraceKindConfigured = 1,     // The scanner was configured; value is the WCApplicationType
+    WCEventTraceKindWindowCreated,      // A window appeared; pid owns it, value is its level
+    WCEventTraceKindWindowDestroyed,    // A window was destroyed or left the window list
+    WCEventTraceKindWindowLevel,        // A window's level changed to value
+    WCEventTraceKindWindowSharing,      // A window's sharing state changed to value
+    WCEventTraceKindProcessForked,      // A helper process pid appeared; value is its parent
+    WCEventTraceKindProcessExited       // A helper process pid exited
+};
+
+/**
+ * @brief One traced event
+ *
+ * Created windows carry their sharing state in flags, so a window's whole
+ * initial state is a single entry.
+ */
+typedef struct {
+    uint64_t time;          // Nanoseconds since the trace started
+    uint32_t windowID;      // Window the event is about, 0 for process events
+    int32_t pid;            // Owner of the window, or the process the event is about
+    int32_t value;          // Kind-specific value
+    uint8_t kind;           // WCEventTraceKind
+    uint8_t flags;          // Sharing state of created windows
+    uint16_t reserved;
+} WCEventTraceEntry;
+
+/**
+ * @brief Header at the start of every trace file
+ */
+typedef struct {
+    char magic[4];          // "WCTR"
+    uint16_t version;
+    uint16_t entrySize;     // sizeof(WCEventTraceEntry) of the writer
+    int32_t pid;            // Process that recorded the trace
+    uint32_t reserved;
+    uint64_t startTime;     // Wall clock time the trace started, in microseconds
+    char name[64];          // Program name of the recording process
+} WCEventTraceHeader;
+
+/**
+ * @brief Whether events are being recorded; read through WCEventTraceIsRecording
+ */
+extern _Atomic(bool) WCEventTraceRecording;
+
+/**
+ * @brief Check if events are being recorded
+ *
+ * @return YES if a trace is open
+ */
+static inline BOOL WCEventTraceIsRecording(void) {
+    return atomic_load_explicit(&WCEventTraceRecording, memory_order_relaxed) ? YES : NO;
+}
+
+/**
+ * @brief Append an event to the open trace
+ *
+ * Use WCEventTraceRecord, which skips the call when nothing is recorded.
+ */
+void WCEventTraceAppend(WCEventTraceKind kind, uint32_t windowID, int32_t pid, int32_t value, uint8_t flags);
+
+/**
+ * @brief Record an event if a trace is open
+ *
+ * @param kind The kind of event
+ * @param windowID The window, or 0 for process events
+ * @param pid The window owner or the process
+ * @param value Kind-specific value
+ * @param flags Kind-specific flags
+ */
+static inline void WCEventTraceRecord(WCEventTraceKind kind, uint32_t windowID, int32_t pid, int32_t value,
+                                      uint8_t flags) {
+    if (WCEventTraceIsRecording()) {
+        WCEventTraceAppend(kind, windowID, pid, value, flags);
+    }
+}
+
+/**
+ * @brief Start recording to a file
+ *
+ * An existing file is replaced. When path is a directory the trace is
+ * written to <pid>.wctrace inside it, so several processes can share one
+ * setting. Buffered events are written at exit. Only the first successful
+ * call does anything.
+ *
+ * @param path The trace file or directory
+ * @return YES if events are being recorded, NO otherwise
+ */
+BOOL WCEventTraceStart(NSString *path);
+
+/**
+ * @brief Write buffered events to the trace file and wait until they are written
+ */
+void WCEventTraceFlush(void);
+
+/**
+ * @brief Read a trace file
+ *
+ * A trailing partial entry, left by a process that was killed while
+ * writing, is ignored.
+ *
+ * @param path The trace file
+ * @param header Receives the header
+ * @return The entries, as consecutive WCEventTraceEntry values, or nil if the file is not a trace
+ */
+NSData *WCEventTraceReadFile(NSString *path, WCEventTraceHeader *header);
+
+/**
+ * @brief Get the name of an event kind
+ *
+ * @param kind The kind of event
+ * @return A short name such as "windowCreated", or "unknown"
+ */
+const char *WCEventTraceKindName(WCEventTraceKind kind);
+
+#endif /* WC_EVENT_TRACE_H */
@@ -0,0 +1,217 @@
+/**
+ * @file wc_event_trace.m
+ * @brief Implementation of the window and process event trace
+ */
+
+#import "wc_event_trace.h"
+#import "logger.h"
+#import "wc_metrics.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <os/lock.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+static const char kWCEventTraceMagic[4] = { 'W', 'C', 'T', 'R' };
+static const uint16_t kWCEventTraceVersion = 1;
+
+// Entries buffered before they are handed to the writer queue
+static const NSUInteger kWCEventTraceBufferCapacity = 512;
+
+_Atomic(bool) WCEventTraceRecording = false;
+
+// Buffer being filled, guarded by gTraceLock
+static os_unfair_lock gTraceLock = OS_UNFAIR_LOCK_INIT;
+static WCEventTraceEntry *gTraceBuffer;
+static NSUInteger gTraceBufferCount;
+
+// Set once by WCEventTraceStart
+static int gTraceFile = -1;
+static uint64_t gTraceStartTime;
+static dispatch_queue_t gTraceWriteQueue;
+
+#pragma mark - Writing
+
+/**
+ * Write full entries to the trace file; runs on the writer queue
+ */
+static void WCEventTraceWriteEntries(const WCEventTraceEntry *entries, NSUInteger count) {
+    const char *bytes = (const char *)entries;
+    size_t remaining = count * sizeof(WCEventTraceEntry);
+
+    while (remaining > 0) {
+        ssize_t written = write(gTraceFile, bytes, remaining);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) {
+            // A full disk shouldn't take the application down; stop recording instead
+            atomic_store_explicit(&WCEventTraceRecording, false, memory_order_relaxed);
+            WCLogError(@"Trace", @"Could not write the event trace: %s", strerror(errno));
+            return;
+        }
+        bytes += written;
+        remaining -= (size_t)written;
+    }
+}
+
+/**
+ * Take the filled buffer and leave an empty one in its place; call with gTraceLock held
+ */
+static WCEventTraceEntry *WCEventTraceTakeBufferLocked(NSUInteger *count) {
+    WCEventTraceEntry *full = gTraceBuffer;
+    *count = gTraceBufferCount;
+    gTraceBuffer = malloc(kWCEventTraceBufferCapacity * sizeof(WCEventTraceEntry));
+    gTraceBufferCount = 0;
+    return full;
+}
+
+void WCEventTraceAppend(WCEventTraceKind kind, uint32_t windowID, int32_t pid, int32_t value, uint8_t flags) {
+    WCEventTraceEntry entry = {
+        .time = WCMetricsNow() - gTraceStartTime,
+        .windowID = windowID,
+        .pid = pid,
+        .value = value,
+        .kind = kind,
+        .flags = flags,
+        .reserved = 0
+    };
+
+    WCEventTraceEntry *full = NULL;
+    NSUInteger fullCount = 0;
+
+    os_unfair_lock_lock(&gTraceLock);
+    if (gTraceBuffer) {
+        gTraceBuffer[gTraceBufferCount++] = entry;
+        if (gTraceBufferCount == kWCEventTraceBufferCapacity) {
+            full = WCEventTraceTakeBufferLocked(&fullCount);
+        }
+    }
+    os_unfair_lock_unlock(&gTraceLock);
+
+    // Queued in the order the buffers filled, so the file stays in time order
+    if (full) {
+        dispatch_async(gTraceWriteQueue, ^{
+            WCEventTraceWriteEntries(full, fullCount);
+            free(full);
+        });
+    }
+}
+
+void WCEventTraceFlush(void) {
+    if (!gTraceWriteQueue) return;
+
+    os_unfair_lock_lock(&gTraceLock);
+    NSUInteger count = 0;
+    WCEventTraceEntry *pending = gTraceBuffer ? WCEventTraceTakeBufferLocked(&count) : NULL;
+    os_unfair_lock_unlock(&gTraceLock);
+
+    // Runs after every buffer queued before it
+    dispatch_sync(gTraceWriteQueue, ^{
+        if (pending && count > 0) {
+            WCEventTraceWriteEntries(pending, count);
+        }
+        free(pending);
+        fsync(gTraceFile);
+    });
+}
+
+static void WCEventTraceFlushAtExit(void) {
+    if (WCEventTraceIsRecording()) {
+        WCEventTraceFlush();
+    }
+}
+
+#pragma mark - Starting
+
+BOOL WCEventTraceStart(NSString *path) {
+    static BOOL started = NO;
+    static dispatch_once_t onceToken;
+    if (path.length == 0) return NO;
+
+    dispatch_once(&onceToken, ^{
+        NSString *tracePath = [path stringByExpandingTildeInPath];
+        BOOL isDirectory = NO;
+        if ([[NSFileManager defaultManager] fileExistsAtPath:tracePath isDirectory:&isDirectory] && isDirectory) {
+            tracePath = [tracePath stringByAppendingPathComponent:
+                         [NSString stringWithFormat:@"%d.wctrace", (int)getpid()]];
+        }
+
+        int file = open(tracePath.fileSystemRepresentation, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (file < 0) {
+            WCLogError(@"Trace", @"Could not open event trace %@: %s", tracePath, strerror(errno));
+            return;
+        }
+
+        WCEventTraceHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, kWCEventTraceMagic, sizeof(header.magic));
+        header.version = kWCEventTraceVersion;
+        header.entrySize = sizeof(WCEventTraceEntry);
+        header.pid = getpid();
+        strlcpy(header.name, getprogname(), sizeof(header.name));
+
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        header.startTime = (uint64_t)now.tv_sec * USEC_PER_SEC + (uint64_t)now.tv_usec;
+
+        if (write(file, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+            WCLogError(@"Trace", @"Could not write event trace header to %@: %s", tracePath, strerror(errno));
+            close(file);
+            return;
+        }
+
+        gTraceBuffer = malloc(kWCEventTraceBufferCapacity * sizeof(WCEventTraceEntry));
+        if (!gTraceBuffer) {
+            close(file);
+            return;
+        }
+
+        gTraceFile = file;
+        gTraceStartTime = WCMetricsNow();
+        gTraceWriteQueue = dispatch_queue_create("com.windowcontrolinjector.trace",
+                                                 dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL,
+                                                                                         QOS_CLASS_UTILITY, 0));
+        atexit(WCEventTraceFlushAtExit);
+        atomic_store_explicit(&WCEventTraceRecording, true, memory_order_release);
+        started = YES;
+
+        WCLogInfo(@"Trace", @"Recording window and process events to %@", tracePath);
+    });
+
+    return started;
+}
+
+#pragma mark - Reading
+
+NSData *WCEventTraceReadFile(NSString *path, WCEventTraceHeader *header) {
+    NSData *contents = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:NULL];
+    if (contents.length < sizeof(WCEventTraceHeader)) return nil;
+
+    WCEventTraceHeader fileHeader;
+    memcpy(&fileHeader, contents.bytes, sizeof(fileHeader));
+    if (memcmp(fileHeader.magic, kWCEventTraceMagic, sizeof(fileHeader.magic)) != 0 ||
+        fileHeader.version != kWCEventTraceVersion ||
+        fileHeader.entrySize != sizeof(WCEventTraceEntry)) {
+        return nil;
+    }
+    fileHeader.name[sizeof(fileHeader.name) - 1] = '\0';
+    if (header) *header = fileHeader;
+
+    NSUInteger entryBytes = contents.length - sizeof(WCEventTraceHeader);
+    entryBytes -= entryBytes % sizeof(WCEventTraceEntry);
+    return [contents subdataWithRange:NSMakeRange(sizeof(WCEventTraceHeader), entryBytes)];
+}
+
+const char *WCEventTraceKindName(WCEventTraceKind kind) {
+    switch (kind) {
+        case WCEventTraceKindConfigured: return "configured";
+        case WCEventTraceKindWindowCreated: return "windowCreated";
+        case WCEventTraceKindWindowDestroyed: return "windowDestroyed";
+        case WCEventTraceKindWindowLevel: return "windowLevel";
+        case WCEventTraceKindWindowSharing: return "windowSharing";
+        case WCEventTraceKindProcessForked: return "processForked";
+        case WCEventTraceKindProcessExited: return "processExited";
+    }
+    return "unknown";
+}
@@ -0,0 +1,87 @@
+/**
+ * @file wc_fleet_metrics.h
+ * @brief Metrics aggregation across every protected process for WindowControlInjector
+ *
+ * This file defines the fleet view of the instrumentation in wc_metrics.h.
+ * Each injected process moves its counters and histograms into a one-page
+ * file named after its PID in a shared directory, so updating them costs
+ * the same as before and publishing costs nothing. The injector reads all
+ * pages on demand and reports them as JSON or StatsD, instead of the text
+ * logs being parsed. Pages of processes that exited are removed by the
+ * reader.
+ */
+
+#ifndef WC_FLEET_METRICS_H
+#define WC_FLEET_METRICS_H
+
+#import <Foundation/Foundation.h>
+
+/**
+ * @brief Share of wall time spent scanning above which a process is reported as runaway
+ */
+extern const double WCFleetMetricsRunawayScanShare;
+
+/**
+ * @brief Directory that holds the published metrics pages
+ *
+ * WCI_FLEET_METRICS_PATH overrides the default of Metrics in the
+ * WindowControlInjector Application Support directory.
+ *
+ * @return The directory path
+ */
+NSString *WCFleetMetricsDirectory(void);
+
+/**
+ * @brief Publish this process's metrics to its page in the fleet directory
+ *
+ * The page is removed again when the process exits normally. Only the
+ * first call does anything.
+ *
+ * @return YES if the metrics are published, NO otherwise
+ */
+BOOL WCFleetMetricsPublish(void);
+
+/**
+ * @brief Check if a process publishes its metrics, which shows it loaded the dylib
+ *
+ * The page must be readable and name the running process, so a page left
+ * by an earlier process with the same PID does not count.
+ *
+ * @param pid The process to check
+ * @return YES if the process has a live metrics page
+ */
+BOOL WCFleetMetricsIsPublishedByProcess(pid_t pid);
+
+/**
+ * @brief Read the metrics of every protected process
+ *
+ * Each entry has the keys of WCMetricsSnapshotDictionary with the
+ * publisher's pid, plus "name", "scanShare" (scan time over uptime) and
+ * "runaway". Pages whose process is gone are deleted.
+ *
+ * @return One dictionary per live process, ordered by PID
+ */
+NSArray<NSDictionary *> *WCFleetMetricsCollect(void);
+
+/**
+ * @brief Aggregate the metrics of every protected process
+ *
+ * @return Dictionary with "processes" from WCFleetMetricsCollect, "totals"
+ *         with every counter summed, and "runaway" with the PIDs of runaway
+ *         processes, suitable for NSJSONSerialization
+ */
+NSDictionary *WCFleetMetricsReport(void);
+
+/**
+ * @brief Format a report as StatsD gauges
+ *
+ * Per-process gauges are named prefix.<name>.<pid>.<metric> and totals
+ * prefix.fleet.<metric>; histograms contribute their p50, p99 and max.
+ *
+ * @param report A report from WCFleetMetricsReport
+ * @param prefix Metric name prefix, such as "wci"
+ * @return Newline-separated StatsD lines
+ */
+NSString *WCFleetMetricsStatsDLines(NSDictionary *report, NSString *prefix);
+
+#endif /* WC_FLEET_METRICS_H */
@@ -0,0 +1,230 @@
+/**
+ * @file wc_fleet_metrics.m
+ * @brief Implementation of the fleet metrics pages and their aggregation
+ */
+
+#import "wc_fleet_metrics.h"
+#import "wc_metrics.h"
+#import "logger.h"
+#import "path_resolver.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sysctl.h>
+#include <unistd.h>
+
+const double WCFleetMetricsRunawayScanShare = 0.05;
+
+// Page of this process, removed at exit by the process that published it
+static char *gPublishedPath;
+static pid_t gPublisherPID;
+
+#pragma mark - Paths
+
+NSString *WCFleetMetricsDirectory(void) {
+    NSString *overridePath = [[NSProcessInfo processInfo] environment][@"WCI_FLEET_METRICS_PATH"];
+    if (overridePath.length > 0) {
+        return [overridePath stringByExpandingTildeInPath];
+    }
+
+    NSString *supportPath = [[WCPathResolver sharedResolver] applicationSupportDirectoryPath];
+    return [[supportPath stringByAppendingPathComponent:@"WindowControlInjector"]
+            stringByAppendingPathComponent:@"Metrics"];
+}
+
+static NSString *WCFleetMetricsPagePath(NSString *directory, pid_t pid) {
+    return [directory stringByAppendingPathComponent:[NSString stringWithFormat:@"%d.metrics", (int)pid]];
+}
+
+/**
+ * Start time of a process on the wall clock in microseconds
+ */
+static BOOL WCFleetMetricsProcessStartTime(pid_t pid, uint64_t *startTime) {
+    int mib[4] = {CTL_KERN, KERN_PROC, KERN_PROC_PID, pid};
+    struct kinfo_proc info;
+    size_t size = sizeof(info);
+    if (sysctl(mib, 4, &info, &size, NULL, 0) != 0 || size == 0) return NO;
+
+    struct timeval start = info.kp_proc.p_starttime;
+    *startTime = (uint64_t)start.tv_sec * USEC_PER_SEC + (uint64_t)start.tv_usec;
+    return YES;
+}
+
+#pragma mark - Publishing
+
+static void WCFleetMetricsRemovePage(void) {
+    // Forked children run the exit handlers too and must leave the parent's page alone
+    if (gPublishedPath && getpid() == gPublisherPID) {
+        unlink(gPublishedPath);
+    }
+}
+
+BOOL WCFleetMetricsPublish(void) {
+    static BOOL published = NO;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        NSString *directory = WCFleetMetricsDirectory();
+        [[NSFileManager defaultManager] createDirectoryAtPath:directory
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:NULL];
+
+        WCMetricsPublisher publisher;
+        memset(&publisher, 0, sizeof(publisher));
+        publisher.pid = getpid();
+        WCFleetMetricsProcessStartTime(publisher.pid, &publisher.startTime);
+        strlcpy(publisher.name, getprogname(), sizeof(publisher.name));
+
+        NSString *path = WCFleetMetricsPagePath(directory, publisher.pid);
+        if (!WCMetricsPublishToPath(path, &publisher)) return;
+
+        gPublishedPath = strdup(path.fileSystemRepresentation);
+        gPublisherPID = publisher.pid;
+        atexit(WCFleetMetricsRemovePage);
+        published = YES;
+
+        WCLogDebug(@"Metrics", @"Publishing metrics to %@", path);
+    });
+
+    return published;
+}
+
+BOOL WCFleetMetricsIsPublishedByProcess(pid_t pid) {
+    NSString *path = WCFleetMetricsPagePath(WCFleetMetricsDirectory(), pid);
+    WCMetricsPublisher publisher;
+    WCMetricsSnapshot snapshot;
+    if (!WCMetricsReadPublishedPath(path, &publisher, &snapshot) || publisher.pid != pid) return NO;
+
+    uint64_t startTime = 0;
+    return WCFleetMetricsProcessStartTime(pid, &startTime) && startTime == publisher.startTime;
+}
+
+#pragma mark - Aggregation
+
+NSArray<NSDictionary *> *WCFleetMetricsCollect(void) {
+    NSString *directory = WCFleetMetricsDirectory();
+    NSArray<NSString *> *fileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:directory error:NULL];
+
+    NSMutableArray<NSDictionary *> *processes = [NSMutableArray arrayWithCapacity:fileNames.count];
+    for (NSString *fileName in fileNames) {
+        if (![fileName.pathExtension isEqualToString:@"metrics"]) continue;
+
+        NSString *path = [directory stringByAppendingPathComponent:fileName];
+        WCMetricsPublisher publisher;
+        WCMetricsSnapshot snapshot;
+        if (!WCMetricsReadPublishedPath(path, &publisher, &snapshot)) {
+            // Half-written pages of processes that crashed while publishing
+            pid_t pid = (pid_t)[fileName.stringByDeletingPathExtension intValue];
+            if (pid > 0 && kill(pid, 0) != 0 && errno == ESRCH) {
+                unlink(path.fileSystemRepresentation);
+            }
+            continue;
+        }
+
+        // Exited without running exit handlers, or the PID now belongs to another process
+        uint64_t startTime = 0;
+        if (!WCFleetMetricsProcessStartTime(publisher.pid, &startTime) || startTime != publisher.startTime) {
+            unlink(path.fileSystemRepresentation);
+            continue;
+        }
+
+        uint64_t scanTime = snapshot.histograms[WCMetricHistogramScanDuration].sum;
+        double scanShare = snapshot.uptime > 0 ? (double)scanTime / (double)snapshot.uptime : 0.0;
+
+        NSMutableDictionary *entry = [WCMetricsSnapshotDictionary(&snapshot) mutableCopy];
+        entry[@"pid"] = @(publisher.pid);
+        entry[@"name"] = [NSString stringWithUTF8String:publisher.name] ?: @"";
+        entry[@"scanShare"] = @(scanShare);
+        entry[@"runaway"] = @(scanShare > WCFleetMetricsRunawayScanShare);
+        [processes addObject:entry];
+    }
+
+    [processes sortUsingComparator:^NSComparisonResult(NSDictionary *first, NSDictionary *second) {
+        return [first[@"pid"] compare:second[@"pid"]];
+    }];
+    return processes;
+}
+
+NSDictionary *WCFleetMetricsReport(void) {
+    NSArray<NSDictionary *> *processes = WCFleetMetricsCollect();
+
+    uint64_t totals[WCMetricCounterCount] = {0};
+    NSMutableArray<NSNumber *> *runaway = [NSMutableArray array];
+    for (NSDictionary *process in processes) {
+        NSDictionary *counters = process[@"counters"];
+        for (int i = 0; i < WCMetricCounterCount; i++) {
+            totals[i] += [counters[@(WCMetricCounterName(i))] unsignedLongLongValue];
+        }
+        if ([process[@"runaway"] boolValue]) {
+            [runaway addObject:process[@"pid"]];
+        }
+    }
+
+    NSMutableDictionary *totalCounters = [NSMutableDictionary dictionaryWithCapacity:WCMetricCounterCount];
+    for (int i = 0; i < WCMetricCounterCount; i++) {
+        totalCounters[@(WCMetricCounterName(i))] = @(totals[i]);
+    }
+
+    return @{
+        @"processCount": @(processes.count),
+        @"processes": processes,
+        @"totals": totalCounters,
+        @"runaway": runaway
+    };
+}
+
+#pragma mark - StatsD
+
+/**
+ * Make a string safe to use as one component of a StatsD name
+ */
+static NSString *WCFleetMetricsStatsDComponent(NSString *string) {
+    NSMutableString *component = [NSMutableString stringWithCapacity:string.length];
+    for (NSUInteger i = 0; i < string.length; i++) {
+        unichar character = [string characterAtIndex:i];
+        BOOL allowed = (character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z') ||
+                       (character >= '0' && character <= '9') || character == '-' || character == '_';
+        [component appendFormat:@"%C", allowed ? character : (unichar)'_'];
+    }
+    return component.length > 0 ? component : @"unknown";
+}
+
+NSString *WCFleetMetricsStatsDLines(NSDictionary *report, NSString *prefix) {
+    NSMutableString *lines = [NSMutableString string];
+    NSString *root = WCFleetMetricsStatsDComponent(prefix ?: @"wci");
+
+    for (NSDictionary *process in report[@"processes"]) {
+        NSString *base = [NSString stringWithFormat:@"%@.%@.%@", root,
+                          WCFleetMetricsStatsDComponent(process[@"name"]), process[@"pid"]];
+
+        [lines appendFormat:@"%@.uptimeNs:%@|g\n", base, process[@"uptimeNs"]];
+        [lines appendFormat:@"%@.scanShare:%.6f|g\n", base, [process[@"scanShare"] doubleValue]];
+
+        NSDictionary *counters = process[@"counters"];
+        for (int i = 0; i < WCMetricCounterCount; i++) {
+            NSString *name = @(WCMetricCounterName(i));
+            [lines appendFormat:@"%@.%@:%@|g\n", base, name, counters[name] ?: @0];
+        }
+
+        NSDictionary *histograms = process[@"histograms"];
+        for (int i = 0; i < WCMetricHistogramCount; i++) {
+            NSString *name = @(WCMetricHistogramName(i));
+            NSDictionary *histogram = histograms[name];
+            for (NSString *statistic in @[@"p50", @"p99", @"max"]) {
+                [lines appendFormat:@"%@.%@.%@:%@|g\n", base, name, statistic, histogram[statistic] ?: @0];
+            }
+        }
+    }
+
+    NSDictionary *totals = report[@"totals"];
+    for (int i = 0; i < WCMetricCounterCount; i++) {
+        NSString *name = @(WCMetricCounterName(i));
+        [lines appendFormat:@"%@.fleet.%@:%@|g\n", root, name, totals[name] ?: @0];
+    }
+    [lines appendFormat:@"%@.fleet.processes:%@|g\n", root, report[@"processCount"] ?: @0];
+    [lines appendFormat:@"%@.fleet.runaway:%lu|g\n", root, (unsigned long)[report[@"runaway"] count]];
+
+    return lines;
+}
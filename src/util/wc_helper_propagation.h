@@ -0,0 +1,40 @@
+/**
+ * @file wc_helper_propagation.h
+ * @brief Dylib propagation into helper processes for WindowControlInjector
+ *
+ * This file defines an opt-in launch hook that makes helper processes of a
+ * protected application load the dylib too. posix_spawn, posix_spawnp and
+ * execve are interposed; when propagation is enabled and the executable
+ * lies inside the application bundle, DYLD_INSERT_LIBRARIES and the WCI_
+ * settings of this process are added to the child's environment if the
+ * caller left them out. Each helper then protects its own windows locally.
+ *
+ * Helpers built with the hardened runtime and without the
+ * com.apple.security.cs.allow-dyld-environment-variables entitlement ignore
+ * DYLD_INSERT_LIBRARIES, so they keep being covered only by the main process.
+ */
+
+#ifndef WC_HELPER_PROPAGATION_H
+#define WC_HELPER_PROPAGATION_H
+
+#import <Foundation/Foundation.h>
+
+/**
+ * @brief Start propagating the dylib into helpers launched from the main bundle
+ *
+ * Captures the environment entries to propagate and the bundle path once;
+ * later calls do nothing. Until this is called the hooks pass every launch
+ * through unchanged.
+ *
+ * @return YES if propagation is enabled, NO if the dylib path could not be determined
+ */
+BOOL WCHelperPropagationEnable(void);
+
+/**
+ * @brief Check if propagation is enabled
+ *
+ * @return YES once WCHelperPropagationEnable succeeded
+ */
+BOOL WCHelperPropagationIsEnabled(void);
+
+#endif /* WC_HELPER_PROPAGATION_H */
@@ -0,0 +1,200 @@
+/**
+ * @file wc_helper_propagation.m
+ * @brief Implementation of dylib propagation into helper processes
+ */
+
+#import "wc_helper_propagation.h"
+#import "logger.h"
+#include <crt_externs.h>
+#include <dlfcn.h>
+#include <spawn.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+
+// Environment variable that loads the dylib
+static const char kWCDyldInsertKey[] = "DYLD_INSERT_LIBRARIES=";
+
+// Prefix of the settings a helper needs to configure itself like this process
+static const char kWCSettingPrefix[] = "WCI_";
+
+// Makes helpers propagate further and scan only their own windows
+static const char kWCPropagateEntry[] = "WCI_PROPAGATE_TO_HELPERS=1";
+
+// Upper bound on propagated entries; the WCI_ settings are few
+enum { kWCMaximumPropagatedEntries = 32 };
+
+/**
+ * Captured once by WCHelperPropagationEnable and only read afterwards,
+ * including in forked children before execve, so the hooks never allocate
+ */
+static _Atomic(bool) gPropagationEnabled;
+static char *gPropagatedEntries[kWCMaximumPropagatedEntries];
+static size_t gPropagatedKeyLengths[kWCMaximumPropagatedEntries];  // Including the '='
+static size_t gPropagatedEntryCount;
+static char *gBundlePrefix;  // Main bundle path with a trailing '/'
+static size_t gBundlePrefixLength;
+
+#pragma mark - Setup
+
+static void WCHelperPropagationAddEntry(const char *entry) {
+    const char *separator = strchr(entry, '=');
+    if (!separator || gPropagatedEntryCount >= kWCMaximumPropagatedEntries) return;
+
+    size_t keyLength = (size_t)(separator - entry) + 1;
+    for (size_t i = 0; i < gPropagatedEntryCount; i++) {
+        if (gPropagatedKeyLengths[i] == keyLength && strncmp(gPropagatedEntries[i], entry, keyLength) == 0) {
+            return;
+        }
+    }
+
+    char *copy = strdup(entry);
+    if (!copy) return;
+
+    gPropagatedEntries[gPropagatedEntryCount] = copy;
+    gPropagatedKeyLengths[gPropagatedEntryCount] = keyLength;
+    gPropagatedEntryCount++;
+}
+
+BOOL WCHelperPropagationEnable(void) {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        BOOL hasDyldInsert = NO;
+        for (char **entry = *_NSGetEnviron(); entry && *entry; entry++) {
+            if (strncmp(*entry, kWCDyldInsertKey, sizeof(kWCDyldInsertKey) - 1) == 0) {
+                hasDyldInsert = YES;
+                WCHelperPropagationAddEntry(*entry);
+            } else if (strncmp(*entry, kWCSettingPrefix, sizeof(kWCSettingPrefix) - 1) == 0) {
+                WCHelperPropagationAddEntry(*entry);
+            }
+        }
+
+        // Loaded some other way; point helpers at the image this code lives in
+        if (!hasDyldInsert) {
+            Dl_info info;
+            if (dladdr((const void *)&WCHelperPropagationEnable, &info) && info.dli_fname) {
+                NSString *entry = [NSString stringWithFormat:@"%s%s", kWCDyldInsertKey, info.dli_fname];
+                WCHelperPropagationAddEntry(entry.UTF8String);
+                hasDyldInsert = YES;
+            }
+        }
+        WCHelperPropagationAddEntry(kWCPropagateEntry);
+
+        NSString *bundlePath = [[NSBundle mainBundle] bundlePath];
+        if (!hasDyldInsert || bundlePath.length == 0) {
+            WCLogWarning(@"Propagation", @"Could not determine what to propagate, helpers will not load the dylib");
+            return;
+        }
+
+        gBundlePrefix = strdup([[bundlePath stringByAppendingString:@"/"] fileSystemRepresentation]);
+        if (!gBundlePrefix) return;
+        gBundlePrefixLength = strlen(gBundlePrefix);
+
+        atomic_store_explicit(&gPropagationEnabled, true, memory_order_release);
+        WCLogInfo(@"Propagation", @"Propagating the dylib and %zu settings into helpers under %@",
+                  gPropagatedEntryCount - 1, bundlePath);
+    });
+
+    return WCHelperPropagationIsEnabled();
+}
+
+BOOL WCHelperPropagationIsEnabled(void) {
+    return atomic_load_explicit(&gPropagationEnabled, memory_order_acquire);
+}
+
+#pragma mark - Environment
+
+static bool WCHelperPropagationAppliesToPath(const char *path) {
+    if (!atomic_load_explicit(&gPropagationEnabled, memory_order_acquire) || !path) return false;
+    return strncmp(path, gBundlePrefix, gBundlePrefixLength) == 0;
+}
+
+static size_t WCEnvironmentCount(char *const envp[]) {
+    size_t count = 0;
+    while (envp && envp[count]) count++;
+    return count;
+}
+
+/**
+ * Copy envp into merged, adding the propagated entries it lacks
+ *
+ * merged must have room for the envp entries, every propagated entry and
+ * the terminating NULL.
+ */
+static void WCEnvironmentMerge(char *const envp[], char **merged) {
+    size_t count = 0;
+    for (size_t i = 0; envp && envp[i]; i++) {
+        merged[count++] = envp[i];
+    }
+
+    size_t callerCount = count;
+    for (size_t i = 0; i < gPropagatedEntryCount; i++) {
+        bool present = false;
+        for (size_t j = 0; j < callerCount; j++) {
+            if (strncmp(merged[j], gPropagatedEntries[i], gPropagatedKeyLengths[i]) == 0) {
+                present = true;
+                break;
+            }
+        }
+        if (!present) {
+            merged[count++] = gPropagatedEntries[i];
+        }
+    }
+
+    merged[count] = NULL;
+}
+
+#pragma mark - Interposed Launch Functions
+
+static int WCInterposedPosixSpawn(pid_t *pid, const char *path,
+                                  const posix_spawn_file_actions_t *fileActions,
+                                  const posix_spawnattr_t *attributes,
+                                  char *const argv[], char *const envp[]) {
+    if (!WCHelperPropagationAppliesToPath(path)) {
+        return posix_spawn(pid, path, fileActions, attributes, argv, envp);
+    }
+
+    char *merged[WCEnvironmentCount(envp) + gPropagatedEntryCount + 1];
+    WCEnvironmentMerge(envp, merged);
+    return posix_spawn(pid, path, fileActions, attributes, argv, merged);
+}
+
+static int WCInterposedPosixSpawnp(pid_t *pid, const char *file,
+                                   const posix_spawn_file_actions_t *fileActions,
+                                   const posix_spawnattr_t *attributes,
+                                   char *const argv[], char *const envp[]) {
+    // Bare names are looked up in PATH and never name a helper inside the bundle
+    if (!WCHelperPropagationAppliesToPath(file)) {
+        return posix_spawnp(pid, file, fileActions, attributes, argv, envp);
+    }
+
+    char *merged[WCEnvironmentCount(envp) + gPropagatedEntryCount + 1];
+    WCEnvironmentMerge(envp, merged);
+    return posix_spawnp(pid, file, fileActions, attributes, argv, merged);
+}
+
+static int WCInterposedExecve(const char *path, char *const argv[], char *const envp[]) {
+    // May run in a forked child, so only the stack is used
+    if (!WCHelperPropagationAppliesToPath(path)) {
+        return execve(path, argv, envp);
+    }
+
+    char *merged[WCEnvironmentCount(envp) + gPropagatedEntryCount + 1];
+    WCEnvironmentMerge(envp, merged);
+    return execve(path, argv, merged);
+}
+
+/**
+ * dyld interposing tuples; calls from this image still reach the originals
+ */
+typedef struct {
+    const void *replacement;
+    const void *replacee;
+} WCInterposeTuple;
+
+__attribute__((used, section("__DATA,__interpose")))
+static const WCInterposeTuple gWCLaunchInterposers[] = {
+    { (const void *)WCInterposedPosixSpawn, (const void *)posix_spawn },
+    { (const void *)WCInterposedPosixSpawnp, (const void *)posix_spawnp },
+    { (const void *)WCInterposedExecve, (const void *)execve },
+};
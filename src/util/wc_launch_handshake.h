@@ -0,0 +1,58 @@
+/**
+ * @file wc_launch_handshake.h
+ * @brief Launch handshake between a launcher and the dylib for WindowControlInjector
+ *
+ * This file defines the child side of the suspended-start launch path. A
+ * launcher that spawns the application itself passes the write end of a
+ * pipe in WCI_HANDSHAKE_FD, and the dylib writes one byte per stage it
+ * reaches: loaded by dyld, initialized, and the first window protected.
+ * The launcher reads the bytes instead of waiting for a fixed timeout, so it
+ * knows whether and when protection actually landed.
+ *
+ * Processes started any other way have no handshake descriptor and every
+ * call here does nothing.
+ */
+
+#ifndef WC_LAUNCH_HANDSHAKE_H
+#define WC_LAUNCH_HANDSHAKE_H
+
+#import <Foundation/Foundation.h>
+
+// Environment variable that carries the handshake descriptor number
+extern NSString *const WCLaunchHandshakeEnvironmentKey;
+
+/**
+ * @brief Stages the dylib reports, in the order they are normally reached
+ *
+ * Each stage is written as its value, a single byte.
+ */
+typedef NS_ENUM(char, WCLaunchHandshakeStage) {
+    WCLaunchHandshakeStageLoaded    = 'L',  // The dylib constructor ran
+    WCLaunchHandshakeStageReady     = 'R',  // Interceptors and the scanner are set up
+    WCLaunchHandshakeStageProtected = 'P'   // The first window is fully protected
+};
+
+/**
+ * @brief Take over the handshake descriptor named in the environment
+ *
+ * Validates that the descriptor is a pipe, marks it close-on-exec and
+ * removes the variable, so neither helpers nor later executables inherit
+ * it. Call once from the dylib constructor, before anything can capture
+ * the environment.
+ *
+ * @return YES if a handshake descriptor was attached
+ */
+BOOL WCLaunchHandshakeAttach(void);
+
+/**
+ * @brief Report a stage to the launcher
+ *
+ * Thread-safe. Reporting WCLaunchHandshakeStageProtected closes the
+ * descriptor, so later stages are dropped; reporting a stage twice is
+ * harmless.
+ *
+ * @param stage The stage that was reached
+ */
+void WCLaunchHandshakeSignal(WCLaunchHandshakeStage stage);
+
+#endif /* WC_LAUNCH_HANDSHAKE_H */
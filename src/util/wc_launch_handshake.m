@@ -0,0 +1,70 @@
+/**
+ * @file wc_launch_handshake.m
+ * @brief Implementation of the dylib side of the launch handshake
+ */
+
+#import "wc_launch_handshake.h"
+#import "logger.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <os/lock.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+NSString *const WCLaunchHandshakeEnvironmentKey = @"WCI_HANDSHAKE_FD";
+
+// Descriptor to report to, -1 when there is no launcher or it was told everything
+static int gHandshakeDescriptor = -1;
+static os_unfair_lock gHandshakeLock = OS_UNFAIR_LOCK_INIT;
+
+BOOL WCLaunchHandshakeAttach(void) {
+    const char *key = WCLaunchHandshakeEnvironmentKey.UTF8String;
+    const char *value = getenv(key);
+    if (!value) return NO;
+
+    char *end = NULL;
+    long descriptor = strtol(value, &end, 10);
+    BOOL parsed = end != value && *end == '\0' && descriptor > STDERR_FILENO && descriptor <= INT_MAX;
+
+    // Nothing launched from here may report on this process's behalf
+    unsetenv(key);
+
+    // A stale variable can name a descriptor the process opened for something else
+    struct stat info;
+    if (!parsed || fstat((int)descriptor, &info) != 0 || !S_ISFIFO(info.st_mode)) {
+        WCLogWarning(@"Handshake", @"Ignoring invalid handshake descriptor %s", value);
+        return NO;
+    }
+
+    // A launcher that already gave up must not be able to kill the process
+    fcntl((int)descriptor, F_SETFD, FD_CLOEXEC);
+    fcntl((int)descriptor, F_SETNOSIGPIPE, 1);
+
+    os_unfair_lock_lock(&gHandshakeLock);
+    gHandshakeDescriptor = (int)descriptor;
+    os_unfair_lock_unlock(&gHandshakeLock);
+
+    WCLogDebug(@"Handshake", @"Reporting launch stages on descriptor %ld", descriptor);
+    return YES;
+}
+
+void WCLaunchHandshakeSignal(WCLaunchHandshakeStage stage) {
+    os_unfair_lock_lock(&gHandshakeLock);
+    int descriptor = gHandshakeDescriptor;
+    if (descriptor >= 0) {
+        char byte = (char)stage;
+        ssize_t written;
+        do {
+            written = write(descriptor, &byte, 1);
+        } while (written < 0 && errno == EINTR);
+
+        // The launcher is done after the last stage, or gone if the write failed
+        if (stage == WCLaunchHandshakeStageProtected || written < 0) {
+            close(descriptor);
+            gHandshakeDescriptor = -1;
+        }
+    }
+    os_unfair_lock_unlock(&gHandshakeLock);
+}
@@ -0,0 +1,268 @@
+/**
+ * @file wc_log_ring.h
+ * @brief Lock-free log record ring buffer and binary log format for WindowControlInjector
+ *
+ * This file defines the fixed-size binary records that log producers write
+ * into a bounded multi-producer, single-consumer ring buffer, the on-disk
+ * binary log format a drainer writes them out in, and the decoder that turns
+ * a binary log back into the same text the file handler produces.
+ */
+
+#ifndef WC_LOG_RING_H
+#define WC_LOG_RING_H
+
+#include <CoreFoundation/CoreFoundation.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Category ID used when the category table is full
+ */
+#define WCLogCategoryIDUnknown UINT16_MAX
+
+/**
+ * @brief Maximum number of bytes of message text stored in a record
+ */
+#define WCLogRecordTextCapacity 454
+
+/**
+ * @brief Record flags
+ */
+enum {
+    WCLogRecordFlagTruncated = 1 << 0   // The message did not fit and was cut short
+};
+
+/**
+ * @brief One log message as written by a producer
+ *
+ * The file and function pointers are the string constants passed to the
+ * logger (__FILE__ and __PRETTY_FUNCTION__) and are only dereferenced by the
+ * in-process drainer. The record is sized so that a ring slot is exactly 512
+ * bytes and slots never share cache lines.
+ */
+typedef struct {
+    uint64_t timestamp;       // Wall clock time in nanoseconds since 1970
+    uint64_t threadID;        // pthread_threadid_np of the producer
+    const char *file;         // Source file, or NULL
+    const char *function;     // Function name, or NULL
+    uint32_t line;            // Source line, or 0
+    uint16_t categoryID;      // From WCLogCategoryIDForName
+    uint16_t textLength;      // Bytes used in text
+    uint8_t level;            // WCLogLevel
+    uint8_t flags;            // WCLogRecordFlag values
+    char text[WCLogRecordTextCapacity]; // UTF-8 message, not NUL-terminated
+} WCLogRecord;
+
+/**
+ * @brief Bounded MPSC ring buffer of log records
+ *
+ * Producers never block: when the ring is full the record is dropped and the
+ * drop counter is incremented. Exactly one thread may drain the ring at a time.
+ */
+typedef struct WCLogRing WCLogRing;
+
+/**
+ * @brief Create a ring buffer
+ *
+ * @param capacity Number of records; rounded up to a power of two
+ * @return The new ring, or NULL if allocation failed
+ */
+WCLogRing *WCLogRingCreate(uint32_t capacity);
+
+/**
+ * @brief Destroy a ring buffer; no producer may be using it
+ *
+ * @param ring The ring to destroy
+ */
+void WCLogRingDestroy(WCLogRing *ring);
+
+/**
+ * @brief Claim a record to fill in
+ *
+ * Every record returned must be passed to WCLogRingCommit, which makes it
+ * visible to the drainer.
+ *
+ * @param ring The ring to write to
+ * @return The record to fill in, or NULL if the ring is full
+ */
+WCLogRecord *WCLogRingReserve(WCLogRing *ring);
+
+/**
+ * @brief Publish a record claimed with WCLogRingReserve
+ *
+ * @param ring The ring the record belongs to
+ * @param record The filled in record
+ */
+void WCLogRingCommit(WCLogRing *ring, WCLogRecord *record);
+
+/**
+ * @brief Pass committed records to a visitor in order, freeing their slots
+ *
+ * @param ring The ring to drain
+ * @param visitor Function called with each record and the context pointer
+ * @param context Caller data passed through to the visitor
+ * @return Number of records drained
+ */
+size_t WCLogRingDrain(WCLogRing *ring,
+                      void (*visitor)(const WCLogRecord *record, void *context),
+                      void *context);
+
+/**
+ * @brief Number of records dropped because the ring was full
+ *
+ * @param ring The ring to query
+ * @return Total drops since the ring was created
+ */
+uint64_t WCLogRingDroppedCount(const WCLogRing *ring);
+
+/**
+ * @brief Map a category name to a small stable ID
+ *
+ * IDs are process-wide and assigned on first use. Lookups of categories that
+ * are already known do not lock.
+ *
+ * @param category The category name
+ * @return The category ID, or WCLogCategoryIDUnknown if the table is full
+ */
+uint16_t WCLogCategoryIDForName(CFStringRef category);
+
+/**
+ * @brief Get the name of a category ID
+ *
+ * @param categoryID An ID returned by WCLogCategoryIDForName
+ * @return The NUL-terminated UTF-8 name
+ */
+const char *WCLogCategoryNameForID(uint16_t categoryID);
+
+/**
+ * @brief Number of category IDs assigned so far
+ */
+uint16_t WCLogCategoryIDCount(void);
+
+/**
+ * @brief Format one message as a text log line
+ *
+ * Produces the same layout as WCLogMessage formattedMessage followed by a newline.
+ *
+ * @param buffer Output buffer
+ * @param size Size of the output buffer
+ * @param timestamp Nanoseconds since 1970
+ * @param level The WCLogLevel
+ * @param category Category name
+ * @param text Message bytes
+ * @param textLength Number of message bytes
+ * @param file Source file path, or NULL
+ * @param line Source line
+ * @param function Function name, or NULL
+ * @return Number of bytes written, excluding the NUL terminator
+ */
+size_t WCLogFormatLine(char *buffer, size_t size,
+                       uint64_t timestamp, uint8_t level, const char *category,
+                       const char *text, size_t textLength,
+                       const char *file, uint32_t line, const char *function);
+
+/**
+ * @brief Format the warning line written when messages were dropped
+ *
+ * @param buffer Output buffer
+ * @param size Size of the output buffer
+ * @param timestamp When the drops were noticed, in nanoseconds since 1970
+ * @param count Number of messages dropped
+ * @return Number of bytes written, excluding the NUL terminator
+ */
+size_t WCLogFormatDroppedLine(char *buffer, size_t size, uint64_t timestamp, uint64_t count);
+
+#pragma mark - Binary Log Format
+
+/**
+ * @brief Binary log file signature and version
+ */
+#define WCLogBinaryMagic "WCLG"
+#define WCLogBinaryVersion 1
+
+/**
+ * @brief Header at the start of every binary log file
+ *
+ * Fields are in host byte order; logs are decoded on the machine that wrote them.
+ */
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t headerSize;
+} WCLogBinaryFileHeader;
+
+/**
+ * @brief Binary log entry types
+ */
+enum {
+    WCLogBinaryEntryMessage = 1,   // A log message
+    WCLogBinaryEntryCategory = 2,  // Defines the name of categoryID; the name is the text
+    WCLogBinaryEntryDropped = 3    // Messages lost to overflow; the count is in value
+};
+
+/**
+ * @brief Header of one binary log entry
+ *
+ * Followed by fileLength bytes of file name, functionLength bytes of
+ * function name and textLength bytes of text, none NUL-terminated.
+ */
+typedef struct {
+    uint8_t type;             // WCLogBinaryEntry value
+    uint8_t level;
+    uint16_t categoryID;
+    uint32_t line;
+    uint64_t timestamp;
+    uint64_t value;           // Thread ID for messages, drop count for WCLogBinaryEntryDropped
+    uint16_t fileLength;
+    uint16_t functionLength;
+    uint16_t textLength;
+    uint16_t flags;
+} WCLogBinaryEntryHeader;
+
+/**
+ * @brief Upper bound on the encoded size of one entry
+ *
+ * File and function names are cut to 255 bytes each when encoded.
+ */
+#define WCLogBinaryEntryMaxSize 1024
+
+/**
+ * @brief Encode a message record as a binary log entry
+ *
+ * @param record The record to encode
+ * @param buffer Output buffer of at least WCLogBinaryEntryMaxSize bytes
+ * @return Number of bytes written
+ */
+size_t WCLogBinaryEncodeRecord(const WCLogRecord *record, uint8_t *buffer);
+
+/**
+ * @brief Encode a category definition entry
+ *
+ * @param categoryID The category to define
+ * @param buffer Output buffer of at least WCLogBinaryEntryMaxSize bytes
+ * @return Number of bytes written
+ */
+size_t WCLogBinaryEncodeCategory(uint16_t categoryID, uint8_t *buffer);
+
+/**
+ * @brief Encode an entry recording dropped messages
+ *
+ * @param timestamp When the drops were noticed, in nanoseconds since 1970
+ * @param count Number of messages dropped since the previous such entry
+ * @param buffer Output buffer of at least WCLogBinaryEntryMaxSize bytes
+ * @return Number of bytes written
+ */
+size_t WCLogBinaryEncodeDropped(uint64_t timestamp, uint64_t count, uint8_t *buffer);
+
+/**
+ * @brief Decode a binary log into text
+ *
+ * @param path Path of the binary log
+ * @param output Stream to write text lines to
+ * @return true if the whole file was decoded, false if it could not be read or was malformed
+ */
+bool WCLogDecodeBinaryFile(const char *path, FILE *output);
+
+#endif /* WC_LOG_RING_H */
@@ -0,0 +1,443 @@
+/**
+ * @file wc_log_ring.m
+ * @brief Implementation of the log record ring buffer and binary log format
+ */
+
+#include "wc_log_ring.h"
+#include <os/lock.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define WCLogNanosecondsPerSecond 1000000000ULL
+#define WCLogCategoryTableCapacity 256
+#define WCLogCategoryNameCapacity 64
+#define WCLogBinaryNameLimit 255
+
+#pragma mark - Ring Buffer
+
+/**
+ * One ring slot; sequence tells producers and the drainer whose turn it is
+ */
+typedef struct {
+    _Atomic(uint64_t) sequence;
+    uint64_t position;        // Enqueue position, set by the producer that claimed the slot
+    WCLogRecord record;
+} WCLogRingSlot;
+
+_Static_assert(sizeof(WCLogRingSlot) == 512, "log ring slots must be 512 bytes");
+
+struct WCLogRing {
+    // Producers and the drainer each get their own cache line
+    _Alignas(64) _Atomic(uint64_t) enqueuePosition;
+    _Alignas(64) uint64_t dequeuePosition;
+    _Atomic(uint64_t) dropped;
+    uint32_t mask;
+    WCLogRingSlot *slots;
+};
+
+WCLogRing *WCLogRingCreate(uint32_t capacity) {
+    uint32_t slotCount = 2;
+    while (slotCount < capacity && slotCount < (1u << 20)) {
+        slotCount <<= 1;
+    }
+
+    WCLogRing *ring = NULL;
+    if (posix_memalign((void **)&ring, 64, sizeof(WCLogRing)) != 0) {
+        return NULL;
+    }
+    memset(ring, 0, sizeof(WCLogRing));
+
+    if (posix_memalign((void **)&ring->slots, 64, slotCount * sizeof(WCLogRingSlot)) != 0) {
+        free(ring);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < slotCount; i++) {
+        atomic_init(&ring->slots[i].sequence, i);
+    }
+
+    atomic_init(&ring->enqueuePosition, 0);
+    atomic_init(&ring->dropped, 0);
+    ring->dequeuePosition = 0;
+    ring->mask = slotCount - 1;
+    return ring;
+}
+
+void WCLogRingDestroy(WCLogRing *ring) {
+    if (!ring) return;
+    free(ring->slots);
+    free(ring);
+}
+
+WCLogRecord *WCLogRingReserve(WCLogRing *ring) {
+    uint64_t position = atomic_load_explicit(&ring->enqueuePosition, memory_order_relaxed);
+
+    for (;;) {
+        WCLogRingSlot *slot = &ring->slots[position & ring->mask];
+        uint64_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int64_t difference = (int64_t)(sequence - position);
+
+        if (difference == 0) {
+            // Slot is free for this position; a failed exchange reloads position
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueuePosition, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                slot->position = position;
+                return &slot->record;
+            }
+        } else if (difference < 0) {
+            // The drainer has not freed this slot yet, so the ring is full
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return NULL;
+        } else {
+            position = atomic_load_explicit(&ring->enqueuePosition, memory_order_relaxed);
+        }
+    }
+}
+
+void WCLogRingCommit(WCLogRing *ring, WCLogRecord *record) {
+    (void)ring;
+    WCLogRingSlot *slot = (WCLogRingSlot *)((char *)record - offsetof(WCLogRingSlot, record));
+    atomic_store_explicit(&slot->sequence, slot->position + 1, memory_order_release);
+}
+
+size_t WCLogRingDrain(WCLogRing *ring,
+                      void (*visitor)(const WCLogRecord *record, void *context),
+                      void *context) {
+    size_t drained = 0;
+
+    // Bound one pass to a ring's worth so a flood of producers cannot starve the caller
+    while (drained <= ring->mask) {
+        WCLogRingSlot *slot = &ring->slots[ring->dequeuePosition & ring->mask];
+        uint64_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (sequence != ring->dequeuePosition + 1) {
+            // Empty, or the next producer has not committed yet
+            break;
+        }
+
+        visitor(&slot->record, context);
+
+        atomic_store_explicit(&slot->sequence, ring->dequeuePosition + ring->mask + 1, memory_order_release);
+        ring->dequeuePosition++;
+        drained++;
+    }
+
+    return drained;
+}
+
+uint64_t WCLogRingDroppedCount(const WCLogRing *ring) {
+    return atomic_load_explicit(&((WCLogRing *)ring)->dropped, memory_order_relaxed);
+}
+
+#pragma mark - Category IDs
+
+typedef struct {
+    CFStringRef name;
+    CFHashCode hash;
+    char utf8[WCLogCategoryNameCapacity];
+} WCLogCategorySlot;
+
+// Append-only; entries below gCategoryCount are immutable once published
+static WCLogCategorySlot gCategories[WCLogCategoryTableCapacity];
+static _Atomic(uint16_t) gCategoryCount = 0;
+static os_unfair_lock gCategoryLock = OS_UNFAIR_LOCK_INIT;
+
+static uint16_t WCLogCategoryFind(CFStringRef category, uint16_t start, uint16_t count, CFHashCode hash) {
+    for (uint16_t i = start; i < count; i++) {
+        if (gCategories[i].hash == hash && CFEqual(gCategories[i].name, category)) {
+            return i;
+        }
+    }
+    return WCLogCategoryIDUnknown;
+}
+
+uint16_t WCLogCategoryIDForName(CFStringRef category) {
+    if (!category) {
+        return WCLogCategoryIDUnknown;
+    }
+
+    uint16_t count = atomic_load_explicit(&gCategoryCount, memory_order_acquire);
+
+    // Categories are almost always string constants, so try identity before hashing
+    for (uint16_t i = 0; i < count; i++) {
+        if (gCategories[i].name == category) {
+            return i;
+        }
+    }
+
+    CFHashCode hash = CFHash(category);
+    uint16_t categoryID = WCLogCategoryFind(category, 0, count, hash);
+    if (categoryID != WCLogCategoryIDUnknown) {
+        return categoryID;
+    }
+
+    os_unfair_lock_lock(&gCategoryLock);
+
+    // Another thread may have added it since the count was read
+    uint16_t lockedCount = atomic_load_explicit(&gCategoryCount, memory_order_relaxed);
+    categoryID = WCLogCategoryFind(category, count, lockedCount, hash);
+
+    if (categoryID == WCLogCategoryIDUnknown && lockedCount < WCLogCategoryTableCapacity) {
+        WCLogCategorySlot *slot = &gCategories[lockedCount];
+        slot->name = CFStringCreateCopy(kCFAllocatorDefault, category);
+        slot->hash = hash;
+
+        CFIndex used = 0;
+        CFStringGetBytes(category, CFRangeMake(0, CFStringGetLength(category)), kCFStringEncodingUTF8, '?',
+                         false, (UInt8 *)slot->utf8, WCLogCategoryNameCapacity - 1, &used);
+        slot->utf8[used] = '\0';
+
+        categoryID = lockedCount;
+        atomic_store_explicit(&gCategoryCount, lockedCount + 1, memory_order_release);
+    }
+
+    os_unfair_lock_unlock(&gCategoryLock);
+    return categoryID;
+}
+
+const char *WCLogCategoryNameForID(uint16_t categoryID) {
+    if (categoryID < atomic_load_explicit(&gCategoryCount, memory_order_acquire)) {
+        return gCategories[categoryID].utf8;
+    }
+    return "Uncategorized";
+}
+
+uint16_t WCLogCategoryIDCount(void) {
+    return atomic_load_explicit(&gCategoryCount, memory_order_acquire);
+}
+
+#pragma mark - Text Formatting
+
+static const char *WCLogLevelName(uint8_t level) {
+    switch (level) {
+        case 1: return "ERROR";
+        case 2: return "WARNING";
+        case 3: return "INFO";
+        case 4: return "DEBUG";
+        default: return "UNKNOWN";
+    }
+}
+
+// Append to a NUL-terminated buffer, clamping at its end
+static size_t WCLogAppend(char *buffer, size_t size, size_t used, const char *format, ...) {
+    if (used + 1 >= size) {
+        return used;
+    }
+
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer + used, size - used, format, args);
+    va_end(args);
+
+    if (written < 0) {
+        return used;
+    }
+    used += (size_t)written;
+    return used < size ? used : size - 1;
+}
+
+size_t WCLogFormatLine(char *buffer, size_t size,
+                       uint64_t timestamp, uint8_t level, const char *category,
+                       const char *text, size_t textLength,
+                       const char *file, uint32_t line, const char *function) {
+    if (size == 0) return 0;
+    buffer[0] = '\0';
+
+    time_t seconds = (time_t)(timestamp / WCLogNanosecondsPerSecond);
+    unsigned milliseconds = (unsigned)((timestamp % WCLogNanosecondsPerSecond) / 1000000ULL);
+    struct tm local;
+    char date[32] = "";
+    if (localtime_r(&seconds, &local)) {
+        strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &local);
+    }
+
+    size_t used = WCLogAppend(buffer, size, 0, "[%s.%03u] [%s] [%s] %.*s",
+                              date, milliseconds, WCLogLevelName(level),
+                              category ? category : "Uncategorized", (int)textLength, text);
+
+    if (file && file[0]) {
+        const char *fileName = strrchr(file, '/');
+        used = WCLogAppend(buffer, size, used, " (%s:%u", fileName ? fileName + 1 : file, line);
+        if (function && function[0]) {
+            used = WCLogAppend(buffer, size, used, ", %s", function);
+        }
+        used = WCLogAppend(buffer, size, used, ")");
+    }
+
+    return WCLogAppend(buffer, size, used, "\n");
+}
+
+size_t WCLogFormatDroppedLine(char *buffer, size_t size, uint64_t timestamp, uint64_t count) {
+    char text[96];
+    int length = snprintf(text, sizeof(text), "%llu log messages dropped because the log buffer was full",
+                          (unsigned long long)count);
+    return WCLogFormatLine(buffer, size, timestamp, 2, "Logging",
+                           text, length > 0 ? (size_t)length : 0, NULL, 0, NULL);
+}
+
+#pragma mark - Binary Encoding
+
+static size_t WCLogBinaryEncode(uint8_t *buffer, const WCLogBinaryEntryHeader *header,
+                                const char *file, const char *function, const char *text) {
+    size_t offset = sizeof(WCLogBinaryEntryHeader);
+    memcpy(buffer, header, sizeof(WCLogBinaryEntryHeader));
+
+    if (header->fileLength) {
+        memcpy(buffer + offset, file, header->fileLength);
+        offset += header->fileLength;
+    }
+    if (header->functionLength) {
+        memcpy(buffer + offset, function, header->functionLength);
+        offset += header->functionLength;
+    }
+    if (header->textLength) {
+        memcpy(buffer + offset, text, header->textLength);
+        offset += header->textLength;
+    }
+
+    return offset;
+}
+
+static uint16_t WCLogBinaryNameLength(const char *name) {
+    if (!name) return 0;
+    size_t length = strlen(name);
+    return (uint16_t)(length < WCLogBinaryNameLimit ? length : WCLogBinaryNameLimit);
+}
+
+size_t WCLogBinaryEncodeRecord(const WCLogRecord *record, uint8_t *buffer) {
+    // Only the file name is kept; the decoder prints nothing more
+    const char *file = record->file;
+    if (file) {
+        const char *fileName = strrchr(file, '/');
+        file = fileName ? fileName + 1 : file;
+    }
+
+    WCLogBinaryEntryHeader header = {
+        .type = WCLogBinaryEntryMessage,
+        .level = record->level,
+        .categoryID = record->categoryID,
+        .line = record->line,
+        .timestamp = record->timestamp,
+        .value = record->threadID,
+        .fileLength = WCLogBinaryNameLength(file),
+        .functionLength = WCLogBinaryNameLength(record->function),
+        .textLength = record->textLength,
+        .flags = record->flags
+    };
+    return WCLogBinaryEncode(buffer, &header, file, record->function, record->text);
+}
+
+size_t WCLogBinaryEncodeCategory(uint16_t categoryID, uint8_t *buffer) {
+    const char *name = WCLogCategoryNameForID(categoryID);
+    WCLogBinaryEntryHeader header = {
+        .type = WCLogBinaryEntryCategory,
+        .categoryID = categoryID,
+        .textLength = (uint16_t)strlen(name)
+    };
+    return WCLogBinaryEncode(buffer, &header, NULL, NULL, name);
+}
+
+size_t WCLogBinaryEncodeDropped(uint64_t timestamp, uint64_t count, uint8_t *buffer) {
+    WCLogBinaryEntryHeader header = {
+        .type = WCLogBinaryEntryDropped,
+        .level = 2,
+        .categoryID = WCLogCategoryIDUnknown,
+        .timestamp = timestamp,
+        .value = count
+    };
+    return WCLogBinaryEncode(buffer, &header, NULL, NULL, NULL);
+}
+
+#pragma mark - Decoding
+
+bool WCLogDecodeBinaryFile(const char *path, FILE *output) {
+    FILE *input = fopen(path, "rb");
+    if (!input) {
+        return false;
+    }
+
+    WCLogBinaryFileHeader fileHeader;
+    if (fread(&fileHeader, sizeof(fileHeader), 1, input) != 1 ||
+        memcmp(fileHeader.magic, WCLogBinaryMagic, sizeof(fileHeader.magic)) != 0 ||
+        fileHeader.version != WCLogBinaryVersion ||
+        fileHeader.headerSize < sizeof(fileHeader) ||
+        fseek(input, fileHeader.headerSize, SEEK_SET) != 0) {
+        fclose(input);
+        return false;
+    }
+
+    // Category names as defined by the log itself, not by this process
+    char *categoryNames[WCLogCategoryTableCapacity] = { NULL };
+
+    size_t payloadCapacity = 3 * (size_t)UINT16_MAX + 3;
+    size_t lineCapacity = payloadCapacity + 256;
+    char *payload = malloc(payloadCapacity);
+    char *line = malloc(lineCapacity);
+    bool complete = (payload && line);
+
+    WCLogBinaryEntryHeader header;
+    while (complete && fread(&header, sizeof(header), 1, input) == 1) {
+        size_t payloadLength = (size_t)header.fileLength + header.functionLength + header.textLength;
+        if (fread(payload, 1, payloadLength, input) != payloadLength) {
+            // Usually the last entry of a log whose writer was killed mid-write
+            complete = false;
+            break;
+        }
+
+        char *file = payload;
+        char *function = file + header.fileLength;
+        char *text = function + header.functionLength;
+
+        switch (header.type) {
+            case WCLogBinaryEntryCategory:
+                if (header.categoryID < WCLogCategoryTableCapacity) {
+                    free(categoryNames[header.categoryID]);
+                    categoryNames[header.categoryID] = strndup(text, header.textLength);
+                }
+                break;
+
+            case WCLogBinaryEntryMessage: {
+                const char *category = header.categoryID < WCLogCategoryTableCapacity ?
+                    categoryNames[header.categoryID] : NULL;
+
+                // The names are not NUL-terminated on disk
+                char fileName[WCLogBinaryNameLimit + 1];
+                char functionName[WCLogBinaryNameLimit + 1];
+                size_t fileLength = header.fileLength <= WCLogBinaryNameLimit ? header.fileLength : WCLogBinaryNameLimit;
+                size_t functionLength = header.functionLength <= WCLogBinaryNameLimit ? header.functionLength : WCLogBinaryNameLimit;
+                memcpy(fileName, file, fileLength);
+                fileName[fileLength] = '\0';
+                memcpy(functionName, function, functionLength);
+                functionName[functionLength] = '\0';
+
+                WCLogFormatLine(line, lineCapacity, header.timestamp, header.level, category,
+                                text, header.textLength, fileName, header.line, functionName);
+                fputs(line, output);
+                break;
+            }
+
+            case WCLogBinaryEntryDropped:
+                WCLogFormatDroppedLine(line, lineCapacity, header.timestamp, header.value);
+                fputs(line, output);
+                break;
+
+            default:
+                // Entry types from newer writers are skipped
+                break;
+        }
+    }
+
+    if (complete && ferror(input)) {
+        complete = false;
+    }
+
+    for (size_t i = 0; i < WCLogCategoryTableCapacity; i++) {
+        free(categoryNames[i]);
+    }
+    free(payload);
+    free(line);
+    fclose(input);
+    return complete;
+}
@@ -0,0 +1,257 @@
+/**
+ * @file wc_metrics.h
+ * @brief Protection latency and overhead instrumentation for WindowControlInjector
+ *
+ * This file defines process-wide counters and histograms that the scanner,
+ * window bridge, process manager and CGS layer update on their hot paths,
+ * the os_signpost log their scan phases are recorded under, and the
+ * snapshot and dump functions used to read them back. Updates are relaxed
+ * atomic operations and never lock.
+ *
+ * The storage can be moved into a memory-mapped page once per process, so
+ * other processes read the live values without any cooperation from this
+ * one (see wc_fleet_metrics.h).
+ */
+
+#ifndef WC_METRICS_H
+#define WC_METRICS_H
+
+#import <Foundation/Foundation.h>
+#include <os/signpost.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * @brief Monotonic event counters
+ */
+typedef enum {
+    WCMetricCounterScanTicks = 0,          // scanAndProtectWindows runs
+    WCMetricCounterWindowEvents,           // Window server and AppKit window events handled
+    WCMetricCounterWindowsProtected,       // Windows that became fully protected for the first time
+    WCMetricCounterWindowsReprotected,     // Protections reapplied to windows that drifted
+    WCMetricCounterProtectionPasses,       // Batches of windows protected together
+    WCMetricCounterCGSCalls,               // Individual CGS calls issued
+    WCMetricCounterCGSErrors,              // Failed CGS calls, counted per window for batches
+    WCMetricCounterWindowEnumerations,     // Window lists assembled by WCWindowBridge
+    WCMetricCounterProcessTreeSnapshots,   // Process tables read from the kernel
+    WCMetricCounterHelperLookups,          // Helper process lookups by name
+    WCMetricCounterCount
+} WCMetricCounter;
+
+/**
+ * @brief Distributions recorded as log2 histograms
+ */
+typedef enum {
+    WCMetricHistogramProtectionLatency = 0, // Nanoseconds from first sighting of a window to fully protected
+    WCMetricHistogramScanDuration,          // Nanoseconds spent in one scan tick
+    WCMetricHistogramCGSCallsPerPass,       // CGS calls issued by one protection pass
+    WCMetricHistogramProcessTreeDuration,   // Nanoseconds to read the process table
+    WCMetricHistogramLaunchToFirstProtection, // Nanoseconds from exec to the first window fully protected, once per process
+    WCMetricHistogramCount
+} WCMetricHistogram;
+
+/**
+ * @brief Number of buckets per histogram
+ *
+ * Bucket 0 counts zero values; bucket i counts values in [2^(i-1), 2^i).
+ */
+#define WCMetricsHistogramBucketCount 64
+
+/**
+ * @brief Counter storage; use the functions below rather than touching it directly
+ *
+ * Points into the process's own storage until it is published to a page.
+ */
+extern _Atomic(_Atomic(uint64_t) *) WCMetricCounters;
+
+/**
+ * @brief Add to a counter
+ */
+static inline void WCMetricsAdd(WCMetricCounter counter, uint64_t amount) {
+    _Atomic(uint64_t) *counters = atomic_load_explicit(&WCMetricCounters, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters[counter], amount, memory_order_relaxed);
+}
+
+/**
+ * @brief Increment a counter by one
+ */
+static inline void WCMetricsIncrement(WCMetricCounter counter) {
+    WCMetricsAdd(counter, 1);
+}
+
+/**
+ * @brief Read a counter
+ */
+static inline uint64_t WCMetricsCounterValue(WCMetricCounter counter) {
+    _Atomic(uint64_t) *counters = atomic_load_explicit(&WCMetricCounters, memory_order_relaxed);
+    return atomic_load_explicit(&counters[counter], memory_order_relaxed);
+}
+
+/**
+ * @brief Current monotonic time in nanoseconds, for measuring durations
+ */
+static inline uint64_t WCMetricsNow(void) {
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+/**
+ * @brief Monotonic time at which this process was exec'd
+ *
+ * Derived once from the kernel's process start time, on the WCMetricsNow()
+ * clock. Falls back to the time of the first call if the start time cannot
+ * be read.
+ *
+ * @return Launch time in nanoseconds
+ */
+uint64_t WCMetricsProcessLaunchTime(void);
+
+/**
+ * @brief Record one value in a histogram
+ *
+ * @param histogram The histogram to update
+ * @param value The value, in the histogram's unit
+ */
+void WCMetricsRecord(WCMetricHistogram histogram, uint64_t value);
+
+/**
+ * @brief Record the time from exec to now as the first protection, once per process
+ *
+ * Only the first call records anything, so it can be called for every
+ * window that becomes protected.
+ */
+void WCMetricsRecordFirstProtection(void);
+
+/**
+ * @brief Point-in-time copy of one histogram
+ */
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t buckets[WCMetricsHistogramBucketCount];
+} WCMetricHistogramSnapshot;
+
+/**
+ * @brief Point-in-time copy of all metrics
+ *
+ * Each value is read atomically, but the snapshot as a whole is not taken
+ * under a lock, so related values may be off by in-flight updates.
+ */
+typedef struct {
+    uint64_t uptime;    // Nanoseconds since the metrics were initialized or reset
+    uint64_t counters[WCMetricCounterCount];
+    WCMetricHistogramSnapshot histograms[WCMetricHistogramCount];
+} WCMetricsSnapshot;
+
+/**
+ * @brief Copy the current values of all metrics
+ *
+ * @param snapshot Receives the values
+ */
+void WCMetricsTakeSnapshot(WCMetricsSnapshot *snapshot);
+
+/**
+ * @brief Reset all counters and histograms to zero
+ */
+void WCMetricsReset(void);
+
+/**
+ * @brief Estimate a percentile from a histogram snapshot
+ *
+ * @param histogram The histogram snapshot
+ * @param percentile The percentile, from 0 to 100
+ * @return Upper bound of the bucket containing the percentile, capped at the maximum
+ */
+uint64_t WCMetricsHistogramPercentile(const WCMetricHistogramSnapshot *histogram, double percentile);
+
+/**
+ * @brief Get the name of a counter as used in snapshots
+ */
+const char *WCMetricCounterName(WCMetricCounter counter);
+
+/**
+ * @brief Get the name of a histogram as used in snapshots
+ */
+const char *WCMetricHistogramName(WCMetricHistogram histogram);
+
+/**
+ * @brief Convert a snapshot to property list types
+ *
+ * Histograms are reported with count, sum, min, max, p50, p90 and p99.
+ *
+ * @param snapshot The snapshot to convert
+ * @return Dictionary suitable for NSJSONSerialization
+ */
+NSDictionary *WCMetricsSnapshotDictionary(const WCMetricsSnapshot *snapshot);
+
+/**
+ * @brief Take a snapshot of the current metrics as a dictionary
+ *
+ * @return Dictionary in the format of WCMetricsSnapshotDictionary
+ */
+NSDictionary *WCMetricsCurrentSnapshot(void);
+
+/**
+ * @brief Write the current metrics to a file as JSON
+ *
+ * @param path The file to write
+ * @return YES if the file was written, NO otherwise
+ */
+BOOL WCMetricsWriteSnapshotToPath(NSString *path);
+
+/**
+ * @brief Identity of the process that published a metrics page
+ */
+typedef struct {
+    int32_t pid;
+    uint32_t reserved;
+    uint64_t startTime;   // Process start on the wall clock in microseconds, tells a reused PID apart
+    char name[64];        // Process name, NUL-terminated
+} WCMetricsPublisher;
+
+/**
+ * @brief Move this process's metrics into a shared page in a file
+ *
+ * The file is created or truncated, sized to one page and mapped shared;
+ * the current values are copied in and every later update goes to the
+ * page, so readers see them live. Only the first call does anything.
+ * Updates that race with the move may be lost, so call it before the
+ * scanner starts.
+ *
+ * @param path The file to publish to
+ * @param publisher Identity recorded in the page for readers
+ * @return YES if the metrics live in the page, NO otherwise
+ */
+BOOL WCMetricsPublishToPath(NSString *path, const WCMetricsPublisher *publisher);
+
+/**
+ * @brief Read the metrics another process published
+ *
+ * @param path The published file
+ * @param publisher Receives the publisher's identity
+ * @param snapshot Receives the values, with the uptime measured now
+ * @return YES if the file holds a page of this layout, NO otherwise
+ */
+BOOL WCMetricsReadPublishedPath(NSString *path, WCMetricsPublisher *publisher, WCMetricsSnapshot *snapshot);
+
+/**
+ * @brief Dump the metrics when the process receives SIGUSR1
+ *
+ * Each SIGUSR1 writes the snapshot as JSON to ~/wci_metrics_<pid>.json and
+ * logs a summary. Nothing is installed if the host already handles SIGUSR1.
+ *
+ * @return YES if the handler was installed, NO otherwise
+ */
+BOOL WCMetricsInstallSignalHandler(void);
+
+/**
+ * @brief Signpost log for scan phase intervals
+ *
+ * Intervals appear in Instruments under the com.windowcontrolinjector
+ * subsystem, category "Performance".
+ */
+os_log_t WCMetricsSignpostLog(void);
+
+#endif /* WC_METRICS_H */
@@ -0,0 +1,471 @@
+/**
+ * @file wc_metrics.m
+ * @brief Implementation of the instrumentation counters, histograms and dumps
+ */
+
+#import "wc_metrics.h"
+#import "logger.h"
+#import "path_resolver.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sysctl.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/**
+ * Live histogram; min is stored inverted so the zero-initialized state means "no samples"
+ */
+typedef struct {
+    _Atomic(uint64_t) count;
+    _Atomic(uint64_t) sum;
+    _Atomic(uint64_t) invertedMin;
+    _Atomic(uint64_t) max;
+    _Atomic(uint64_t) buckets[WCMetricsHistogramBucketCount];
+} WCMetricHistogramStorage;
+
+/**
+ * Everything the metrics record, in one block so it can move into a shared page
+ */
+typedef struct {
+    _Atomic(uint64_t) startTime;  // Monotonic time the uptime in snapshots is measured from
+    _Atomic(uint64_t) counters[WCMetricCounterCount];
+    WCMetricHistogramStorage histograms[WCMetricHistogramCount];
+} WCMetricsStorage;
+
+// Identifies a published metrics file and its layout
+static const uint32_t kWCMetricsPageMagic = 0x504D4357; // "WCMP"
+static const uint32_t kWCMetricsPageLayoutVersion = 1;
+static const size_t kWCMetricsPageSize = 4096;
+
+/**
+ * Layout of a published metrics file
+ *
+ * The magic is written last, so a reader that sees it sees the whole header.
+ * Readers from another build reject pages whose counts differ from theirs.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t layoutVersion;
+    uint32_t counterCount;
+    uint32_t histogramCount;
+    WCMetricsPublisher publisher;
+    WCMetricsStorage storage;
+} WCMetricsPage;
+
+_Static_assert(sizeof(WCMetricsPage) <= 4096, "metrics page must fit in one page");
+
+// The process's own storage, used until the metrics are published
+static WCMetricsStorage gProcessStorage;
+
+// Storage all updates and snapshots go to
+static _Atomic(WCMetricsStorage *) gStorage = &gProcessStorage;
+
+_Atomic(_Atomic(uint64_t) *) WCMetricCounters = gProcessStorage.counters;
+
+static inline WCMetricsStorage *WCMetricsActiveStorage(void) {
+    return atomic_load_explicit(&gStorage, memory_order_relaxed);
+}
+
+static const char *const kWCMetricCounterNames[WCMetricCounterCount] = {
+    [WCMetricCounterScanTicks] = "scanTicks",
+    [WCMetricCounterWindowEvents] = "windowEvents",
+    [WCMetricCounterWindowsProtected] = "windowsProtected",
+    [WCMetricCounterWindowsReprotected] = "windowsReprotected",
+    [WCMetricCounterProtectionPasses] = "protectionPasses",
+    [WCMetricCounterCGSCalls] = "cgsCalls",
+    [WCMetricCounterCGSErrors] = "cgsErrors",
+    [WCMetricCounterWindowEnumerations] = "windowEnumerations",
+    [WCMetricCounterProcessTreeSnapshots] = "processTreeSnapshots",
+    [WCMetricCounterHelperLookups] = "helperLookups"
+};
+
+static const char *const kWCMetricHistogramNames[WCMetricHistogramCount] = {
+    [WCMetricHistogramProtectionLatency] = "protectionLatencyNs",
+    [WCMetricHistogramScanDuration] = "scanDurationNs",
+    [WCMetricHistogramCGSCallsPerPass] = "cgsCallsPerPass",
+    [WCMetricHistogramProcessTreeDuration] = "processTreeDurationNs",
+    [WCMetricHistogramLaunchToFirstProtection] = "launchToFirstProtectionNs"
+};
+
+__attribute__((constructor))
+static void WCMetricsInitialize(void) {
+    atomic_store_explicit(&gProcessStorage.startTime, WCMetricsNow(), memory_order_relaxed);
+
+    // Pin the launch time while the wall clock is least likely to have been adjusted
+    WCMetricsProcessLaunchTime();
+}
+
+#pragma mark - Launch Time
+
+uint64_t WCMetricsProcessLaunchTime(void) {
+    static uint64_t launchTime = 0;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        uint64_t now = WCMetricsNow();
+        launchTime = now;
+
+        // The kernel records the start time on the wall clock; convert via the time elapsed since
+        int mib[4] = {CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid()};
+        struct kinfo_proc info;
+        size_t size = sizeof(info);
+        struct timeval wallNow;
+        if (sysctl(mib, 4, &info, &size, NULL, 0) != 0 || size == 0 || gettimeofday(&wallNow, NULL) != 0) {
+            return;
+        }
+
+        struct timeval start = info.kp_proc.p_starttime;
+        int64_t sinceExec = ((int64_t)wallNow.tv_sec - start.tv_sec) * (int64_t)NSEC_PER_SEC +
+                            ((int64_t)wallNow.tv_usec - start.tv_usec) * (int64_t)NSEC_PER_USEC;
+        if (sinceExec > 0 && (uint64_t)sinceExec < now) {
+            launchTime = now - (uint64_t)sinceExec;
+        }
+    });
+
+    return launchTime;
+}
+
+#pragma mark - Recording
+
+static inline unsigned WCMetricsBucketForValue(uint64_t value) {
+    if (value == 0) return 0;
+    unsigned bucket = 64 - (unsigned)__builtin_clzll(value);
+    return bucket < WCMetricsHistogramBucketCount ? bucket : WCMetricsHistogramBucketCount - 1;
+}
+
+static inline void WCMetricsStoreMax(_Atomic(uint64_t) *slot, uint64_t value) {
+    uint64_t current = atomic_load_explicit(slot, memory_order_relaxed);
+    while (value > current &&
+           !atomic_compare_exchange_weak_explicit(slot, &current, value,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void WCMetricsRecord(WCMetricHistogram histogram, uint64_t value) {
+    WCMetricHistogramStorage *storage = &WCMetricsActiveStorage()->histograms[histogram];
+
+    atomic_fetch_add_explicit(&storage->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&storage->sum, value, memory_order_relaxed);
+    atomic_fetch_add_explicit(&storage->buckets[WCMetricsBucketForValue(value)], 1, memory_order_relaxed);
+    WCMetricsStoreMax(&storage->max, value);
+    WCMetricsStoreMax(&storage->invertedMin, UINT64_MAX - value);
+}
+
+void WCMetricsRecordFirstProtection(void) {
+    static atomic_bool recorded = false;
+
+    if (!atomic_exchange_explicit(&recorded, true, memory_order_relaxed)) {
+        WCMetricsRecord(WCMetricHistogramLaunchToFirstProtection, WCMetricsNow() - WCMetricsProcessLaunchTime());
+    }
+}
+
+#pragma mark - Snapshots
+
+/**
+ * Copy storage into a snapshot; the storage may be mapped read-only from another process
+ */
+static void WCMetricsCopyStorage(const WCMetricsStorage *source, WCMetricsSnapshot *snapshot) {
+    // Only ever loaded here, so the casts never lead to a store into a read-only mapping
+    WCMetricsStorage *storage = (WCMetricsStorage *)source;
+
+    snapshot->uptime = WCMetricsNow() - atomic_load_explicit(&storage->startTime, memory_order_relaxed);
+
+    for (int i = 0; i < WCMetricCounterCount; i++) {
+        snapshot->counters[i] = atomic_load_explicit(&storage->counters[i], memory_order_relaxed);
+    }
+
+    for (int i = 0; i < WCMetricHistogramCount; i++) {
+        WCMetricHistogramStorage *histogram = &storage->histograms[i];
+        WCMetricHistogramSnapshot *copy = &snapshot->histograms[i];
+
+        copy->count = atomic_load_explicit(&histogram->count, memory_order_relaxed);
+        copy->sum = atomic_load_explicit(&histogram->sum, memory_order_relaxed);
+        copy->max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+        copy->min = copy->count ? UINT64_MAX - atomic_load_explicit(&histogram->invertedMin, memory_order_relaxed) : 0;
+        for (int bucket = 0; bucket < WCMetricsHistogramBucketCount; bucket++) {
+            copy->buckets[bucket] = atomic_load_explicit(&histogram->buckets[bucket], memory_order_relaxed);
+        }
+    }
+}
+
+void WCMetricsTakeSnapshot(WCMetricsSnapshot *snapshot) {
+    if (!snapshot) return;
+
+    WCMetricsCopyStorage(WCMetricsActiveStorage(), snapshot);
+}
+
+void WCMetricsReset(void) {
+    WCMetricsStorage *storage = WCMetricsActiveStorage();
+
+    for (int i = 0; i < WCMetricCounterCount; i++) {
+        atomic_store_explicit(&storage->counters[i], 0, memory_order_relaxed);
+    }
+
+    for (int i = 0; i < WCMetricHistogramCount; i++) {
+        WCMetricHistogramStorage *histogram = &storage->histograms[i];
+        atomic_store_explicit(&histogram->count, 0, memory_order_relaxed);
+        atomic_store_explicit(&histogram->sum, 0, memory_order_relaxed);
+        atomic_store_explicit(&histogram->invertedMin, 0, memory_order_relaxed);
+        atomic_store_explicit(&histogram->max, 0, memory_order_relaxed);
+        for (int bucket = 0; bucket < WCMetricsHistogramBucketCount; bucket++) {
+            atomic_store_explicit(&histogram->buckets[bucket], 0, memory_order_relaxed);
+        }
+    }
+
+    atomic_store_explicit(&storage->startTime, WCMetricsNow(), memory_order_relaxed);
+}
+
+uint64_t WCMetricsHistogramPercentile(const WCMetricHistogramSnapshot *histogram, double percentile) {
+    if (!histogram) return 0;
+
+    // Buckets are read one at a time, so trust their sum over the separately read count
+    uint64_t total = 0;
+    for (int bucket = 0; bucket < WCMetricsHistogramBucketCount; bucket++) {
+        total += histogram->buckets[bucket];
+    }
+    if (total == 0) return 0;
+
+    if (percentile < 0.0) percentile = 0.0;
+    if (percentile > 100.0) percentile = 100.0;
+
+    uint64_t rank = (uint64_t)((percentile / 100.0) * (double)total + 0.5);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < WCMetricsHistogramBucketCount; bucket++) {
+        seen += histogram->buckets[bucket];
+        if (seen >= rank) {
+            uint64_t upperBound = bucket == 0 ? 0 : (UINT64_C(1) << bucket) - 1;
+            return upperBound < histogram->max ? upperBound : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+const char *WCMetricCounterName(WCMetricCounter counter) {
+    return (unsigned)counter < WCMetricCounterCount ? kWCMetricCounterNames[counter] : "unknown";
+}
+
+const char *WCMetricHistogramName(WCMetricHistogram histogram) {
+    return (unsigned)histogram < WCMetricHistogramCount ? kWCMetricHistogramNames[histogram] : "unknown";
+}
+
+NSDictionary *WCMetricsSnapshotDictionary(const WCMetricsSnapshot *snapshot) {
+    if (!snapshot) return @{};
+
+    NSMutableDictionary *counters = [NSMutableDictionary dictionaryWithCapacity:WCMetricCounterCount];
+    for (int i = 0; i < WCMetricCounterCount; i++) {
+        counters[@(WCMetricCounterName(i))] = @(snapshot->counters[i]);
+    }
+
+    NSMutableDictionary *histograms = [NSMutableDictionary dictionaryWithCapacity:WCMetricHistogramCount];
+    for (int i = 0; i < WCMetricHistogramCount; i++) {
+        const WCMetricHistogramSnapshot *histogram = &snapshot->histograms[i];
+        histograms[@(WCMetricHistogramName(i))] = @{
+            @"count": @(histogram->count),
+            @"sum": @(histogram->sum),
+            @"min": @(histogram->min),
+            @"max": @(histogram->max),
+            @"p50": @(WCMetricsHistogramPercentile(histogram, 50.0)),
+            @"p90": @(WCMetricsHistogramPercentile(histogram, 90.0)),
+            @"p99": @(WCMetricsHistogramPercentile(histogram, 99.0))
+        };
+    }
+
+    return @{
+        @"pid": @([[NSProcessInfo processInfo] processIdentifier]),
+        @"uptimeNs": @(snapshot->uptime),
+        @"counters": counters,
+        @"histograms": histograms
+    };
+}
+
+NSDictionary *WCMetricsCurrentSnapshot(void) {
+    WCMetricsSnapshot snapshot;
+    WCMetricsTakeSnapshot(&snapshot);
+    return WCMetricsSnapshotDictionary(&snapshot);
+}
+
+BOOL WCMetricsWriteSnapshotToPath(NSString *path) {
+    if (!path) return NO;
+
+    NSData *json = [NSJSONSerialization dataWithJSONObject:WCMetricsCurrentSnapshot()
+                                                   options:NSJSONWritingPrettyPrinted
+                                                     error:NULL];
+    return json && [json writeToFile:path atomically:YES];
+}
+
+#pragma mark - Shared Pages
+
+/**
+ * Copy one storage block into another, value by value
+ */
+static void WCMetricsMoveStorage(WCMetricsStorage *from, WCMetricsStorage *to) {
+    atomic_store_explicit(&to->startTime, atomic_load_explicit(&from->startTime, memory_order_relaxed), memory_order_relaxed);
+
+    for (int i = 0; i < WCMetricCounterCount; i++) {
+        atomic_store_explicit(&to->counters[i], atomic_load_explicit(&from->counters[i], memory_order_relaxed),
+                              memory_order_relaxed);
+    }
+
+    for (int i = 0; i < WCMetricHistogramCount; i++) {
+        WCMetricHistogramStorage *source = &from->histograms[i];
+        WCMetricHistogramStorage *destination = &to->histograms[i];
+        atomic_store_explicit(&destination->count, atomic_load_explicit(&source->count, memory_order_relaxed), memory_order_relaxed);
+        atomic_store_explicit(&destination->sum, atomic_load_explicit(&source->sum, memory_order_relaxed), memory_order_relaxed);
+        atomic_store_explicit(&destination->invertedMin, atomic_load_explicit(&source->invertedMin, memory_order_relaxed),
+                              memory_order_relaxed);
+        atomic_store_explicit(&destination->max, atomic_load_explicit(&source->max, memory_order_relaxed), memory_order_relaxed);
+        for (int bucket = 0; bucket < WCMetricsHistogramBucketCount; bucket++) {
+            atomic_store_explicit(&destination->buckets[bucket],
+                                  atomic_load_explicit(&source->buckets[bucket], memory_order_relaxed),
+                                  memory_order_relaxed);
+        }
+    }
+}
+
+BOOL WCMetricsPublishToPath(NSString *path, const WCMetricsPublisher *publisher) {
+    static BOOL published = NO;
+    static dispatch_once_t onceToken;
+
+    if (!path || !publisher) return NO;
+
+    dispatch_once(&onceToken, ^{
+        int fd = open(path.fileSystemRepresentation, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            WCLogWarning(@"Metrics", @"Could not create metrics page %@: %s", path, strerror(errno));
+            return;
+        }
+
+        WCMetricsPage *page = MAP_FAILED;
+        if (ftruncate(fd, (off_t)kWCMetricsPageSize) == 0) {
+            page = mmap(NULL, kWCMetricsPageSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (page == MAP_FAILED) {
+            WCLogWarning(@"Metrics", @"Could not map metrics page %@: %s", path, strerror(errno));
+            unlink(path.fileSystemRepresentation);
+            return;
+        }
+
+        // The mapping lives as long as the process, even after the file is removed
+        page->layoutVersion = kWCMetricsPageLayoutVersion;
+        page->counterCount = WCMetricCounterCount;
+        page->histogramCount = WCMetricHistogramCount;
+        page->publisher = *publisher;
+        page->publisher.name[sizeof(page->publisher.name) - 1] = '\0';
+        WCMetricsMoveStorage(&gProcessStorage, &page->storage);
+
+        atomic_store_explicit(&gStorage, &page->storage, memory_order_release);
+        atomic_store_explicit(&WCMetricCounters, page->storage.counters, memory_order_release);
+
+        atomic_thread_fence(memory_order_release);
+        page->magic = kWCMetricsPageMagic;
+        published = YES;
+    });
+
+    return published;
+}
+
+BOOL WCMetricsReadPublishedPath(NSString *path, WCMetricsPublisher *publisher, WCMetricsSnapshot *snapshot) {
+    if (!path || !publisher || !snapshot) return NO;
+
+    int fd = open(path.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NO;
+
+    struct stat info;
+    const WCMetricsPage *page = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size >= kWCMetricsPageSize) {
+        page = mmap(NULL, kWCMetricsPageSize, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (page == MAP_FAILED) return NO;
+
+    BOOL valid = page->magic == kWCMetricsPageMagic;
+    atomic_thread_fence(memory_order_acquire);
+    valid = valid && page->layoutVersion == kWCMetricsPageLayoutVersion &&
+            page->counterCount == WCMetricCounterCount && page->histogramCount == WCMetricHistogramCount;
+
+    if (valid) {
+        *publisher = page->publisher;
+        publisher->name[sizeof(publisher->name) - 1] = '\0';
+        WCMetricsCopyStorage(&page->storage, snapshot);
+    }
+
+    munmap((void *)page, kWCMetricsPageSize);
+    return valid;
+}
+
+#pragma mark - Signal Dump
+
+static void WCMetricsDumpForSignal(void) {
+    NSString *fileName = [NSString stringWithFormat:@"wci_metrics_%d.json", (int)getpid()];
+    NSString *path = [[[WCPathResolver sharedResolver] homeDirectoryPath] stringByAppendingPathComponent:fileName];
+    BOOL written = WCMetricsWriteSnapshotToPath(path);
+
+    WCMetricsSnapshot snapshot;
+    WCMetricsTakeSnapshot(&snapshot);
+    const WCMetricHistogramSnapshot *latency = &snapshot.histograms[WCMetricHistogramProtectionLatency];
+    const WCMetricHistogramSnapshot *scan = &snapshot.histograms[WCMetricHistogramScanDuration];
+    const WCMetricHistogramSnapshot *launch = &snapshot.histograms[WCMetricHistogramLaunchToFirstProtection];
+
+    WCLogInfo(@"Metrics",
+              @"First window protected %.1f ms after launch, protection latency p50 %.2f ms p99 %.2f ms, "
+              @"scan p50 %.2f ms p99 %.2f ms over %llu ticks, "
+              @"%llu CGS calls, %llu windows protected, %llu reprotected%@",
+              launch->min / 1e6,
+              WCMetricsHistogramPercentile(latency, 50.0) / 1e6, WCMetricsHistogramPercentile(latency, 99.0) / 1e6,
+              WCMetricsHistogramPercentile(scan, 50.0) / 1e6, WCMetricsHistogramPercentile(scan, 99.0) / 1e6,
+              snapshot.counters[WCMetricCounterScanTicks], snapshot.counters[WCMetricCounterCGSCalls],
+              snapshot.counters[WCMetricCounterWindowsProtected], snapshot.counters[WCMetricCounterWindowsReprotected],
+              written ? [NSString stringWithFormat:@", written to %@", path] : @"");
+}
+
+BOOL WCMetricsInstallSignalHandler(void) {
+    static dispatch_source_t source = nil;
+    static BOOL installed = NO;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        // Leave SIGUSR1 alone if the host uses it
+        struct sigaction current;
+        if (sigaction(SIGUSR1, NULL, &current) != 0 ||
+            (current.sa_flags & SA_SIGINFO) || current.sa_handler != SIG_DFL) {
+            WCLogWarning(@"Metrics", @"SIGUSR1 is already handled, metrics dump not installed");
+            return;
+        }
+
+        // The default action terminates the process; the dispatch source still sees ignored signals
+        signal(SIGUSR1, SIG_IGN);
+
+        source = dispatch_source_create(DISPATCH_SOURCE_TYPE_SIGNAL, SIGUSR1, 0,
+                                        dispatch_get_global_queue(QOS_CLASS_UTILITY, 0));
+        if (!source) {
+            signal(SIGUSR1, SIG_DFL);
+            return;
+        }
+
+        dispatch_source_set_event_handler(source, ^{
+            WCMetricsDumpForSignal();
+        });
+        dispatch_resume(source);
+        installed = YES;
+    });
+
+    return installed;
+}
+
+#pragma mark - Signposts
+
+os_log_t WCMetricsSignpostLog(void) {
+    static os_log_t log = NULL;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        log = os_log_create("com.windowcontrolinjector", "Performance");
+    });
+    return log;
+}
@@ -17,7 +17,8 @@
  *
  * This class provides utilities for managing processes, including
  * detecting child processes and handling application-specific
- * process hierarchies.
+ * process hierarchies. Queries are answered from a shared WCProcessTree
+ * snapshot rather than by launching ps.
  */
 @interface WCProcessManager : NSObject
 
@@ -53,6 +54,21 @@
  */
 + (NSArray<NSNumber *> *)getChromeRendererProcessesForMainPID:(pid_t)mainPID;
 
+/**
+ * @brief Get helper processes of a main process by name
+ *
+ * A direct child whose name contains any of the patterns is a helper, as
+ * are its descendants down to descendantDepth generations.
+ *
+ * @param mainPID The main process ID
+ * @param namePatterns Substrings that identify helper processes
+ * @param descendantDepth Generations below a matching child to include
+ * @return Array of NSNumbers containing helper process IDs
+ */
++ (NSArray<NSNumber *> *)getHelperProcessesForMainPID:(pid_t)mainPID
+                                         namePatterns:(NSArray<NSString *> *)namePatterns
+                                      descendantDepth:(NSUInteger)descendantDepth;
+
 /**
  * @brief Get the application path for a process
  *
@@ -0,0 +1,130 @@
+/**
+ * @file wc_process_tree.h
+ * @brief In-process process tree snapshots for WindowControlInjector
+ *
+ * This file defines a class that captures the system process table with
+ * sysctl(KERN_PROC) and libproc and answers parent, child, descendant and
+ * name queries from memory, without launching any helper processes.
+ */
+
+#ifndef WC_PROCESS_TREE_H
+#define WC_PROCESS_TREE_H
+
+#import <Foundation/Foundation.h>
+
+/**
+ * @brief Block that fills a process table in place of the system's
+ *
+ * @param parentByPID Receives the parent of every process
+ * @param nameByPID Receives the executable path or name of every process
+ */
+typedef void (^WCProcessTableLoader)(NSMutableDictionary<NSNumber *, NSNumber *> *parentByPID,
+                                     NSMutableDictionary<NSNumber *, NSString *> *nameByPID);
+
+/**
+ * @brief Immutable snapshot of the ppid to pid process tree
+ *
+ * Process names are the executable path reported by proc_pidpath, which
+ * contains the helper bundle name used to classify Electron and Chrome
+ * helpers. Names are resolved on first use and cached in the snapshot;
+ * the short command name from the process table is used when the path is
+ * unavailable.
+ */
+@interface WCProcessTree : NSObject
+
+/**
+ * @brief Number of processes in the snapshot
+ */
+@property (nonatomic, readonly) NSUInteger processCount;
+
+/**
+ * @brief Time at which the process table was captured
+ */
+@property (nonatomic, readonly) NSDate *captureTime;
+
+/**
+ * @brief Capture a new snapshot of the process table
+ *
+ * @return A new process tree
+ */
+- (instancetype)init;
+
+/**
+ * @brief Get a recently captured shared snapshot
+ *
+ * Returns the shared snapshot if it is younger than a short maximum age,
+ * otherwise captures a new one. This coalesces the many process queries
+ * made during a single scan tick into one capture.
+ *
+ * @return A process tree no older than the maximum age
+ */
++ (instancetype)recentTree;
+
+/**
+ * @brief Discard the shared snapshot so the next query captures a fresh one
+ */
++ (void)invalidateRecentTree;
+
+/**
+ * @brief Capture snapshots from a loader instead of the system process table
+ *
+ * Names then come only from the loader, never from proc_pidpath. The
+ * trace replay driver uses this to serve recorded helper processes. The
+ * shared snapshot is discarded.
+ *
+ * @param loader The loader, or nil to read the system process table again
+ */
++ (void)setProcessTableLoader:(WCProcessTableLoader)loader;
+
+/**
+ * @brief Check if a process is in the snapshot
+ *
+ * @param pid The process ID to check
+ * @return YES if the process existed when the snapshot was captured
+ */
+- (BOOL)containsPID:(pid_t)pid;
+
+/**
+ * @brief Get the parent of a process
+ *
+ * @param pid The process ID
+ * @return The parent process ID, or 0 if the process is unknown
+ */
+- (pid_t)parentOfPID:(pid_t)pid;
+
+/**
+ * @brief Get the direct children of a process
+ *
+ * @param pid The parent process ID
+ * @return Array of NSNumbers containing child process IDs
+ */
+- (NSArray<NSNumber *> *)childrenOfPID:(pid_t)pid;
+
+/**
+ * @brief Get all descendants of a process
+ *
+ * @param pid The ancestor process ID
+ * @return Array of NSNumbers containing descendant process IDs in breadth-first order
+ */
+- (NSArray<NSNumber *> *)descendantsOfPID:(pid_t)pid;
+
+/**
+ * @brief Get descendants of a process down to a maximum depth
+ *
+ * @param pid The ancestor process ID
+ * @param maxDepth The number of generations to include (1 returns only children)
+ * @return Array of NSNumbers containing descendant process IDs in breadth-first order
+ */
+- (NSArray<NSNumber *> *)descendantsOfPID:(pid_t)pid maxDepth:(NSUInteger)maxDepth;
+
+/**
+ * @brief Get the name of a process
+ *
+ * @param pid The process ID
+ * @return The executable path, the short command name, or an empty string if unknown
+ */
+- (NSString *)nameForPID:(pid_t)pid;
+
+@end
+
+#endif /* WC_PROCESS_TREE_H */
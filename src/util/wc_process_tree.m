@@ -0,0 +1,286 @@
+/**
+ * @file wc_process_tree.m
+ * @brief Implementation of in-process process tree snapshots
+ */
+
+#import "wc_process_tree.h"
+#import "logger.h"
+#import "wc_metrics.h"
+#import <libproc.h>
+#import <sys/sysctl.h>
+#import <errno.h>
+
+// Maximum age of the shared snapshot before a query captures a new one
+static const NSTimeInterval kWCProcessTreeMaxAge = 0.5;
+
+// Shared snapshot used by +recentTree
+static WCProcessTree *gRecentTree = nil;
+
+// Replaces the system process table when set, guarded by @synchronized on the class
+static WCProcessTableLoader gProcessTableLoader = nil;
+
+@implementation WCProcessTree {
+    NSDate *_captureTime;
+    NSDictionary<NSNumber *, NSNumber *> *_parentByPID;
+    NSDictionary<NSNumber *, NSArray<NSNumber *> *> *_childrenByPID;
+    NSDictionary<NSNumber *, NSString *> *_commandByPID;
+    BOOL _loadedFromLoader;
+
+    // Executable paths resolved on demand
+    NSMutableDictionary<NSNumber *, NSString *> *_pathByPID;
+}
+
+#pragma mark - Initialization
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _captureTime = [NSDate date];
+        _pathByPID = [NSMutableDictionary dictionary];
+
+        uint64_t loadStart = WCMetricsNow();
+        os_log_t signpostLog = WCMetricsSignpostLog();
+        os_signpost_id_t signpostID = os_signpost_id_generate(signpostLog);
+        os_signpost_interval_begin(signpostLog, signpostID, "ProcessTreeSnapshot");
+
+        NSMutableDictionary<NSNumber *, NSNumber *> *parentByPID = [NSMutableDictionary dictionary];
+        NSMutableDictionary<NSNumber *, NSString *> *commandByPID = [NSMutableDictionary dictionary];
+
+        WCProcessTableLoader loader = nil;
+        @synchronized([WCProcessTree class]) {
+            loader = gProcessTableLoader;
+        }
+
+        if (loader) {
+            loader(parentByPID, commandByPID);
+            _loadedFromLoader = YES;
+        } else if (![self loadProcessTableWithSysctl:parentByPID commands:commandByPID]) {
+            [self loadProcessTableWithLibproc:parentByPID commands:commandByPID];
+        }
+
+        WCMetricsIncrement(WCMetricCounterProcessTreeSnapshots);
+        WCMetricsRecord(WCMetricHistogramProcessTreeDuration, WCMetricsNow() - loadStart);
+        os_signpost_interval_end(signpostLog, signpostID, "ProcessTreeSnapshot",
+                                 "%lu processes", (unsigned long)parentByPID.count);
+
+        // Build the child lists from the parent map
+        NSMutableDictionary<NSNumber *, NSMutableArray<NSNumber *> *> *childrenByPID = [NSMutableDictionary dictionary];
+        [parentByPID enumerateKeysAndObjectsUsingBlock:^(NSNumber *pid, NSNumber *ppid, BOOL *stop) {
+            NSMutableArray<NSNumber *> *children = childrenByPID[ppid];
+            if (!children) {
+                children = [NSMutableArray array];
+                childrenByPID[ppid] = children;
+            }
+            [children addObject:pid];
+        }];
+
+        _parentByPID = [parentByPID copy];
+        _childrenByPID = [childrenByPID copy];
+        _commandByPID = [commandByPID copy];
+
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
+                                     category:@"ProcessManager"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Captured process tree with %lu processes",
+                                             (unsigned long)_parentByPID.count];
+    }
+    return self;
+}
+
++ (instancetype)recentTree {
+    @synchronized(self) {
+        if (!gRecentTree || -[gRecentTree.captureTime timeIntervalSinceNow] > kWCProcessTreeMaxAge) {
+            gRecentTree = [[self alloc] init];
+        }
+        return gRecentTree;
+    }
+}
+
++ (void)invalidateRecentTree {
+    @synchronized(self) {
+        gRecentTree = nil;
+    }
+}
+
++ (void)setProcessTableLoader:(WCProcessTableLoader)loader {
+    @synchronized([WCProcessTree class]) {
+        gProcessTableLoader = [loader copy];
+    }
+    [self invalidateRecentTree];
+}
+
+#pragma mark - Process Table Loading
+
+- (BOOL)loadProcessTableWithSysctl:(NSMutableDictionary<NSNumber *, NSNumber *> *)parentByPID
+                          commands:(NSMutableDictionary<NSNumber *, NSString *> *)commandByPID {
+    int mib[3] = { CTL_KERN, KERN_PROC, KERN_PROC_ALL };
+    struct kinfo_proc *processes = NULL;
+    size_t size = 0;
+
+    // The table can grow between the size query and the copy, so retry with some headroom
+    for (int attempt = 0; attempt < 3; attempt++) {
+        if (sysctl(mib, 3, NULL, &size, NULL, 0) != 0 || size == 0) {
+            break;
+        }
+
+        size += size / 4;
+        struct kinfo_proc *buffer = realloc(processes, size);
+        if (!buffer) {
+            break;
+        }
+        processes = buffer;
+
+        if (sysctl(mib, 3, processes, &size, NULL, 0) == 0) {
+            size_t count = size / sizeof(struct kinfo_proc);
+            for (size_t i = 0; i < count; i++) {
+                pid_t pid = processes[i].kp_proc.p_pid;
+                NSNumber *pidNumber = @(pid);
+                parentByPID[pidNumber] = @(processes[i].kp_eproc.e_ppid);
+
+                NSString *command = [NSString stringWithUTF8String:processes[i].kp_proc.p_comm];
+                if (command) {
+                    commandByPID[pidNumber] = command;
+                }
+            }
+            free(processes);
+            return YES;
+        }
+
+        if (errno != ENOMEM) {
+            break;
+        }
+    }
+
+    free(processes);
+
+    [[WCLogger sharedLogger] logWithLevel:WCLogLevelWarning
+                                 category:@"ProcessManager"
+                                     file:__FILE__
+                                     line:__LINE__
+                                 function:__PRETTY_FUNCTION__
+                                   format:@"sysctl(KERN_PROC) failed (%s), falling back to libproc", strerror(errno)];
+    return NO;
+}
+
+- (BOOL)loadProcessTableWithLibproc:(NSMutableDictionary<NSNumber *, NSNumber *> *)parentByPID
+                           commands:(NSMutableDictionary<NSNumber *, NSString *> *)commandByPID {
+    int estimatedCount = proc_listallpids(NULL, 0);
+    if (estimatedCount <= 0) {
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
+                                     category:@"ProcessManager"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"proc_listallpids failed, process tree is empty"];
+        return NO;
+    }
+
+    // Leave headroom for processes started after the estimate
+    int capacity = estimatedCount + estimatedCount / 4 + 16;
+    pid_t *pids = calloc((size_t)capacity, sizeof(pid_t));
+    if (!pids) {
+        return NO;
+    }
+
+    int count = proc_listallpids(pids, capacity * (int)sizeof(pid_t));
+    for (int i = 0; i < count; i++) {
+        struct proc_bsdinfo info;
+        if (proc_pidinfo(pids[i], PROC_PIDTBSDINFO, 0, &info, sizeof(info)) != (int)sizeof(info)) {
+            continue;  // Process exited or is not visible to us
+        }
+
+        NSNumber *pidNumber = @(pids[i]);
+        parentByPID[pidNumber] = @(info.pbi_ppid);
+
+        const char *name = info.pbi_name[0] ? info.pbi_name : info.pbi_comm;
+        NSString *command = [NSString stringWithUTF8String:name];
+        if (command) {
+            commandByPID[pidNumber] = command;
+        }
+    }
+
+    free(pids);
+    return count > 0;
+}
+
+#pragma mark - Queries
+
+- (NSUInteger)processCount {
+    return _parentByPID.count;
+}
+
+- (NSDate *)captureTime {
+    return _captureTime;
+}
+
+- (BOOL)containsPID:(pid_t)pid {
+    return _parentByPID[@(pid)] != nil;
+}
+
+- (pid_t)parentOfPID:(pid_t)pid {
+    return (pid_t)[_parentByPID[@(pid)] intValue];
+}
+
+- (NSArray<NSNumber *> *)childrenOfPID:(pid_t)pid {
+    NSArray<NSNumber *> *children = _childrenByPID[@(pid)];
+    return children ? children : @[];
+}
+
+- (NSArray<NSNumber *> *)descendantsOfPID:(pid_t)pid {
+    return [self descendantsOfPID:pid maxDepth:NSUIntegerMax];
+}
+
+- (NSArray<NSNumber *> *)descendantsOfPID:(pid_t)pid maxDepth:(NSUInteger)maxDepth {
+    NSMutableArray<NSNumber *> *descendants = [NSMutableArray array];
+    NSArray<NSNumber *> *generation = [self childrenOfPID:pid];
+    NSUInteger depth = 0;
+
+    while (generation.count > 0 && depth < maxDepth) {
+        [descendants addObjectsFromArray:generation];
+
+        NSMutableArray<NSNumber *> *nextGeneration = [NSMutableArray array];
+        for (NSNumber *childPID in generation) {
+            // pid 0 is its own parent in the process table; never walk back into it
+            if ([childPID intValue] == pid || [childPID intValue] == 0) continue;
+            [nextGeneration addObjectsFromArray:[self childrenOfPID:[childPID intValue]]];
+        }
+
+        generation = nextGeneration;
+        depth++;
+    }
+
+    return [descendants copy];
+}
+
+- (NSString *)nameForPID:(pid_t)pid {
+    NSNumber *pidNumber = @(pid);
+
+    @synchronized(_pathByPID) {
+        NSString *cachedPath = _pathByPID[pidNumber];
+        if (cachedPath) {
+            return cachedPath;
+        }
+    }
+
+    NSString *name = nil;
+    char pathBuffer[PROC_PIDPATHINFO_MAXSIZE];
+    if (!_loadedFromLoader && proc_pidpath(pid, pathBuffer, sizeof(pathBuffer)) > 0) {
+        name = [NSString stringWithUTF8String:pathBuffer];
+    }
+
+    if (!name) {
+        name = _commandByPID[pidNumber];
+    }
+
+    if (!name) {
+        return @"";
+    }
+
+    @synchronized(_pathByPID) {
+        _pathByPID[pidNumber] = name;
+    }
+    return name;
+}
+
+@end
@@ -0,0 +1,110 @@
+/**
+ * @file wc_process_watcher.h
+ * @brief Incremental helper process tracking for WindowControlInjector
+ *
+ * This file defines a watcher that keeps the set of helper processes of a
+ * multi-process application up to date using kqueue EVFILT_PROC events,
+ * so the process tree only has to be walked when it actually changes.
+ */
+
+#ifndef WC_PROCESS_WATCHER_H
+#define WC_PROCESS_WATCHER_H
+
+#import <Foundation/Foundation.h>
+
+/**
+ * @brief Block that computes the helper set for a root process
+ *
+ * Called on the watcher's queue when the tree below the root changes.
+ *
+ * @param rootPID The watched root process
+ * @return Array of NSNumbers containing helper process IDs
+ */
+typedef NSArray<NSNumber *> * _Nonnull (^WCProcessSetProvider)(pid_t rootPID);
+
+/**
+ * @brief Block invoked on the handler queue when the helper set changes
+ *
+ * @param processIDs The new helper set
+ */
+typedef void (^WCProcessSetChangeHandler)(NSArray<NSNumber *> * _Nonnull processIDs);
+
+/**
+ * @brief Watcher for the helper processes of an application
+ *
+ * The watcher registers NOTE_FORK, NOTE_EXEC and NOTE_EXIT on the root
+ * process and on every helper. An exit removes the helper from the set
+ * directly; a fork or exec re-runs the provider against a fresh process
+ * tree and registers any new helpers.
+ */
+@interface WCProcessWatcher : NSObject
+
+/**
+ * @brief Handler invoked on changeHandlerQueue after the helper set changes
+ */
+@property (nonatomic, copy, nullable) WCProcessSetChangeHandler changeHandler;
+
+/**
+ * @brief Queue the change handler runs on; the main queue when nil
+ */
+@property (nonatomic, strong, nullable) dispatch_queue_t changeHandlerQueue;
+
+/**
+ * @brief Get the shared watcher instance
+ *
+ * @return Shared singleton instance of WCProcessWatcher
+ */
++ (nonnull instancetype)sharedWatcher;
+
+/**
+ * @brief Start watching a root process
+ *
+ * The provider is run once synchronously to seed the helper set.
+ *
+ * @param rootPID The process whose helpers should be tracked
+ * @param provider Block that computes the helper set for the root
+ * @return YES if the kqueue was set up, NO otherwise
+ */
+- (BOOL)startWatchingRootPID:(pid_t)rootPID provider:(nonnull WCProcessSetProvider)provider;
+
+/**
+ * @brief Stop watching and release the kqueue
+ */
+- (void)stopWatching;
+
+/**
+ * @brief Check if the watcher is active
+ *
+ * @return YES if a root process is being watched, NO otherwise
+ */
+- (BOOL)isWatching;
+
+/**
+ * @brief Recompute the helper set as if a fork had been reported
+ *
+ * Used when the process table changes without kqueue events, such as
+ * when a trace is replayed against a mocked process table. Does nothing
+ * when no root process is watched.
+ */
+- (void)refreshProcesses;
+
+/**
+ * @brief Get the current helper set
+ *
+ * @return Array of NSNumbers containing helper process IDs
+ */
+- (nonnull NSArray<NSNumber *> *)currentProcesses;
+
+/**
+ * @brief Get the number of times the helper set has changed
+ *
+ * Callers can compare this against a previously seen value to skip work
+ * when nothing changed.
+ *
+ * @return The change counter
+ */
+- (NSUInteger)changeCount;
+
+@end
+
+#endif /* WC_PROCESS_WATCHER_H */
@@ -0,0 +1,316 @@
+/**
+ * @file wc_process_watcher.m
+ * @brief Implementation of incremental helper process tracking
+ */
+
+#import "wc_process_watcher.h"
+#import "wc_process_tree.h"
+#import "logger.h"
+#import "wc_event_trace.h"
+#import <sys/event.h>
+#import <errno.h>
+#import <unistd.h>
+
+// Process events that can change the helper set
+static const uint32_t kWCWatchedProcessEvents = NOTE_FORK | NOTE_EXEC | NOTE_EXIT;
+
+@implementation WCProcessWatcher {
+    dispatch_queue_t _queue;
+    dispatch_source_t _kqueueSource;
+    int _kqueue;
+    pid_t _rootPID;
+    WCProcessSetProvider _provider;
+
+    // Guarded by @synchronized(self)
+    NSArray<NSNumber *> *_currentProcesses;
+    NSUInteger _changeCount;
+
+    // Only touched on _queue
+    NSMutableSet<NSNumber *> *_registeredPIDs;
+}
+
+#pragma mark - Lifecycle
+
++ (instancetype)sharedWatcher {
+    static WCProcessWatcher *instance = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        instance = [[self alloc] init];
+    });
+    return instance;
+}
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _queue = dispatch_queue_create("com.windowcontrolinjector.processwatcher", DISPATCH_QUEUE_SERIAL);
+        _kqueueSource = nil;
+        _kqueue = -1;
+        _rootPID = 0;
+        _provider = nil;
+        _currentProcesses = @[];
+        _changeCount = 0;
+        _registeredPIDs = [NSMutableSet set];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [self stopWatching];
+}
+
+#pragma mark - Watching Control
+
+- (BOOL)startWatchingRootPID:(pid_t)rootPID provider:(WCProcessSetProvider)provider {
+    if (!provider || rootPID <= 0) {
+        return NO;
+    }
+
+    [self stopWatching];
+
+    int kq = kqueue();
+    if (kq < 0) {
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelError
+                                     category:@"ProcessManager"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Failed to create kqueue for process watching: %s", strerror(errno)];
+        return NO;
+    }
+
+    _kqueue = kq;
+    _rootPID = rootPID;
+    _provider = [provider copy];
+
+    _kqueueSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)kq, 0, _queue);
+
+    typeof(self) selfRef = self;
+    dispatch_source_set_event_handler(_kqueueSource, ^{
+        [selfRef drainEvents];
+    });
+    dispatch_source_set_cancel_handler(_kqueueSource, ^{
+        close(kq);
+    });
+
+    // Seed the helper set before events can arrive
+    dispatch_sync(_queue, ^{
+        [self registerPID:rootPID];
+        [self refreshHelperSet];
+    });
+
+    dispatch_resume(_kqueueSource);
+
+    [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                 category:@"ProcessManager"
+                                     file:__FILE__
+                                     line:__LINE__
+                                 function:__PRETTY_FUNCTION__
+                                   format:@"Started watching helper processes of PID %d (%lu helpers)",
+                                         (int)rootPID, (unsigned long)[self currentProcesses].count];
+    return YES;
+}
+
+- (void)stopWatching {
+    if (!_kqueueSource) return;
+
+    dispatch_source_cancel(_kqueueSource);
+    _kqueueSource = nil;
+    _kqueue = -1;
+
+    dispatch_sync(_queue, ^{
+        [self->_registeredPIDs removeAllObjects];
+    });
+
+    @synchronized(self) {
+        _currentProcesses = @[];
+    }
+
+    [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                 category:@"ProcessManager"
+                                     file:__FILE__
+                                     line:__LINE__
+                                 function:__PRETTY_FUNCTION__
+                                   format:@"Stopped watching helper processes of PID %d", (int)_rootPID];
+
+    _rootPID = 0;
+    _provider = nil;
+}
+
+- (BOOL)isWatching {
+    return _kqueueSource != nil;
+}
+
+- (NSArray<NSNumber *> *)currentProcesses {
+    @synchronized(self) {
+        return _currentProcesses;
+    }
+}
+
+- (NSUInteger)changeCount {
+    @synchronized(self) {
+        return _changeCount;
+    }
+}
+
+- (void)refreshProcesses {
+    if (!_kqueueSource) return;
+
+    dispatch_async(_queue, ^{
+        if (self->_provider) {
+            [self refreshHelperSet];
+        }
+    });
+}
+
+#pragma mark - kqueue Handling
+
+- (BOOL)registerPID:(pid_t)pid {
+    struct kevent change;
+    EV_SET(&change, (uintptr_t)pid, EVFILT_PROC, EV_ADD | EV_CLEAR, kWCWatchedProcessEvents, 0, NULL);
+
+    if (kevent(_kqueue, &change, 1, NULL, 0, NULL) != 0) {
+        // ESRCH just means the process already exited
+        if (errno != ESRCH) {
+            [[WCLogger sharedLogger] logWithLevel:WCLogLevelWarning
+                                         category:@"ProcessManager"
+                                             file:__FILE__
+                                             line:__LINE__
+                                         function:__PRETTY_FUNCTION__
+                                           format:@"Failed to watch PID %d: %s", (int)pid, strerror(errno)];
+        }
+        return NO;
+    }
+
+    [_registeredPIDs addObject:@(pid)];
+    return YES;
+}
+
+- (void)unregisterPID:(pid_t)pid {
+    struct kevent change;
+    EV_SET(&change, (uintptr_t)pid, EVFILT_PROC, EV_DELETE, 0, 0, NULL);
+    kevent(_kqueue, &change, 1, NULL, 0, NULL);
+    [_registeredPIDs removeObject:@(pid)];
+}
+
+- (void)drainEvents {
+    struct kevent events[32];
+    struct timespec timeout = { 0, 0 };
+    BOOL needsRefresh = NO;
+    NSMutableSet<NSNumber *> *exitedPIDs = [NSMutableSet set];
+
+    int count;
+    while ((count = kevent(_kqueue, NULL, 0, events, 32, &timeout)) > 0) {
+        for (int i = 0; i < count; i++) {
+            pid_t pid = (pid_t)events[i].ident;
+
+            if (events[i].fflags & NOTE_EXIT) {
+                // The kernel drops the registration on exit
+                [_registeredPIDs removeObject:@(pid)];
+                [exitedPIDs addObject:@(pid)];
+            }
+            if (events[i].fflags & (NOTE_FORK | NOTE_EXEC)) {
+                needsRefresh = YES;
+            }
+        }
+
+        if (count < 32) break;
+    }
+
+    if ([exitedPIDs containsObject:@(_rootPID)]) {
+        [[WCLogger sharedLogger] logWithLevel:WCLogLevelInfo
+                                     category:@"ProcessManager"
+                                         file:__FILE__
+                                         line:__LINE__
+                                     function:__PRETTY_FUNCTION__
+                                       format:@"Watched root PID %d exited", (int)_rootPID];
+    }
+
+    if (needsRefresh) {
+        [self refreshHelperSet];
+    } else if (exitedPIDs.count > 0) {
+        // Exits alone never add helpers, so just drop them from the set
+        NSMutableArray<NSNumber *> *remaining = [[self currentProcesses] mutableCopy];
+        [remaining removeObjectsInArray:[exitedPIDs allObjects]];
+        [self publishHelperSet:remaining];
+    }
+}
+
+- (void)refreshHelperSet {
+    // The tree changed, so the provider must not see a cached snapshot
+    [WCProcessTree invalidateRecentTree];
+    NSArray<NSNumber *> *helpers = _provider(_rootPID);
+
+    NSSet<NSNumber *> *helperSet = [NSSet setWithArray:helpers];
+
+    // Stop watching processes that are no longer helpers (for example after an exec)
+    for (NSNumber *pid in [_registeredPIDs allObjects]) {
+        if ([pid intValue] != _rootPID && ![helperSet containsObject:pid]) {
+            [self unregisterPID:[pid intValue]];
+        }
+    }
+
+    // Start watching new helpers so their own forks are seen
+    for (NSNumber *pid in helperSet) {
+        if (![_registeredPIDs containsObject:pid]) {
+            [self registerPID:[pid intValue]];
+        }
+    }
+
+    [self publishHelperSet:helpers];
+}
+
+/**
+ * Record helpers that appeared or went away in the event trace
+ */
+- (void)traceChangeFromProcesses:(NSArray<NSNumber *> *)oldProcesses toProcesses:(NSArray<NSNumber *> *)newProcesses {
+    NSSet<NSNumber *> *oldSet = [NSSet setWithArray:oldProcesses];
+    NSSet<NSNumber *> *newSet = [NSSet setWithArray:newProcesses];
+
+    WCProcessTree *tree = nil;
+    for (NSNumber *pid in newProcesses) {
+        if ([oldSet containsObject:pid]) continue;
+        if (!tree) tree = [WCProcessTree recentTree];
+        WCEventTraceRecord(WCEventTraceKindProcessForked, 0, [pid intValue], [tree parentOfPID:[pid intValue]], 0);
+    }
+    for (NSNumber *pid in oldProcesses) {
+        if (![newSet containsObject:pid]) {
+            WCEventTraceRecord(WCEventTraceKindProcessExited, 0, [pid intValue], 0, 0);
+        }
+    }
+}
+
+- (void)publishHelperSet:(NSArray<NSNumber *> *)helpers {
+    NSArray<NSNumber *> *newProcesses = [helpers copy];
+    NSArray<NSNumber *> *oldProcesses = nil;
+
+    @synchronized(self) {
+        if ([_currentProcesses isEqualToArray:newProcesses]) {
+            return;
+        }
+        oldProcesses = _currentProcesses;
+        _currentProcesses = newProcesses;
+        _changeCount++;
+    }
+
+    if (WCEventTraceIsRecording()) {
+        [self traceChangeFromProcesses:oldProcesses toProcesses:newProcesses];
+    }
+
+    [[WCLogger sharedLogger] logWithLevel:WCLogLevelDebug
+                                 category:@"ProcessManager"
+                                     file:__FILE__
+                                     line:__LINE__
+                                 function:__PRETTY_FUNCTION__
+                                   format:@"Helper set for PID %d changed, now %lu processes",
+                                         (int)_rootPID, (unsigned long)newProcesses.count];
+
+    WCProcessSetChangeHandler handler = self.changeHandler;
+    if (handler) {
+        dispatch_queue_t handlerQueue = self.changeHandlerQueue;
+        dispatch_async(handlerQueue ? handlerQueue : dispatch_get_main_queue(), ^{
+            handler(newProcesses);
+        });
+    }
+}
+
+@end
@@ -0,0 +1,115 @@
+/**
+ * @file wc_shared_config.h
+ * @brief Shared-memory live configuration for WindowControlInjector
+ *
+ * This file defines a small configuration block in a memory-mapped file that
+ * every protected process maps read-only. A controller publishes new values
+ * under a sequence counter and posts a notify(3) notification; injected
+ * processes pick the change up with a single atomic load per scan tick or
+ * as soon as the notification arrives, without relaunching.
+ */
+
+#ifndef WC_SHARED_CONFIG_H
+#define WC_SHARED_CONFIG_H
+
+#import <Foundation/Foundation.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+/**
+ * @brief notify(3) name posted after every publish
+ */
+#define WCSharedConfigNotificationName "com.windowcontrolinjector.config.changed"
+
+/**
+ * @brief Configuration values carried by the shared block
+ */
+typedef struct {
+    int64_t windowLevel;   // Level protected windows are raised to
+    uint64_t options;      // WCConfigurationOptions bits
+} WCSharedConfigValues;
+
+/**
+ * @brief Path of the shared configuration file
+ *
+ * WCI_SHARED_CONFIG_PATH overrides the default of shared_config in the
+ * WindowControlInjector Application Support directory.
+ *
+ * @return The file path
+ */
+NSString *WCSharedConfigPath(void);
+
+/**
+ * @brief Publish new values to every protected process
+ *
+ * Creates the file if needed, writes the values under the sequence counter
+ * and posts WCSharedConfigNotificationName. Concurrent publishers are
+ * serialized with an advisory file lock.
+ *
+ * @param values The values to publish
+ * @param generation Receives the new generation, may be NULL
+ * @return YES if the values were published, NO otherwise
+ */
+BOOL WCSharedConfigPublish(const WCSharedConfigValues *values, uint64_t *generation);
+
+/**
+ * @brief Read the currently published values
+ *
+ * @param values Receives the values
+ * @param generation Receives their generation, may be NULL
+ * @return YES if values have been published, NO if there is no shared block yet
+ */
+BOOL WCSharedConfigRead(WCSharedConfigValues *values, uint64_t *generation);
+
+/**
+ * @brief Copy the published values if they changed since the last call
+ *
+ * The unchanged case costs one atomic load, so it is safe to call on every
+ * scan tick. The shared file is mapped on first use and again after each
+ * notification, so it may be created after the process started.
+ *
+ * @param lastGeneration Generation the caller last saw; updated on change
+ * @param values Receives the values when they changed
+ * @return YES if newer values were copied, NO otherwise
+ */
+BOOL WCSharedConfigCopyIfChanged(uint64_t *lastGeneration, WCSharedConfigValues *values);
+
+/**
+ * @brief Run a handler on a queue whenever new values are published
+ *
+ * Uses a notify(3) token, so nothing polls. Only the first call registers.
+ *
+ * @param queue The queue the handler runs on
+ * @param handler Called after each publish notification
+ * @return YES if the notification was registered, NO otherwise
+ */
+BOOL WCSharedConfigStartMonitoring(dispatch_queue_t queue, dispatch_block_t handler);
+
+/**
+ * @brief Active protection settings of this process; use the functions below
+ */
+extern _Atomic(int64_t) WCSharedConfigActiveLevel;
+extern _Atomic(int32_t) WCSharedConfigActiveSharing;
+
+/**
+ * @brief Make values the active protection settings of this process
+ *
+ * @param values The values to activate
+ */
+void WCSharedConfigActivate(const WCSharedConfigValues *values);
+
+/**
+ * @brief Window level protections currently apply
+ */
+static inline int64_t WCSharedConfigActiveWindowLevel(void) {
+    return atomic_load_explicit(&WCSharedConfigActiveLevel, memory_order_relaxed);
+}
+
+/**
+ * @brief Sharing type protections currently apply, as an NSWindowSharingType value
+ */
+static inline int32_t WCSharedConfigActiveSharingType(void) {
+    return atomic_load_explicit(&WCSharedConfigActiveSharing, memory_order_relaxed);
+}
+
+#endif /* WC_SHARED_CONFIG_H */
@@ -0,0 +1,259 @@
+/**
+ * @file wc_shared_config.m
+ * @brief Implementation of the shared-memory live configuration block
+ */
+
+#import "wc_shared_config.h"
+#import "configuration_manager.h"
+#import "logger.h"
+#import "path_resolver.h"
+#import <AppKit/AppKit.h>
+#include <fcntl.h>
+#include <notify.h>
+#include <os/lock.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Identifies a shared configuration file and its layout
+static const uint32_t kWCSharedConfigMagic = 0x43534357; // "WCSC"
+static const uint32_t kWCSharedConfigLayoutVersion = 1;
+
+// The block occupies one page so readers never map a partial structure
+static const size_t kWCSharedConfigFileSize = 4096;
+
+/**
+ * Layout of the shared file
+ *
+ * The sequence is odd while a publisher is writing. Readers retry until they
+ * see the same even sequence before and after copying the values.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t layoutVersion;
+    _Atomic(uint64_t) sequence;
+    _Atomic(int64_t) windowLevel;
+    _Atomic(uint64_t) options;
+} WCSharedConfigBlock;
+
+_Static_assert(sizeof(WCSharedConfigBlock) <= 4096, "shared config block must fit in one page");
+
+_Atomic(int64_t) WCSharedConfigActiveLevel = NSFloatingWindowLevel;
+_Atomic(int32_t) WCSharedConfigActiveSharing = NSWindowSharingNone;
+
+// Read-only mapping used by this process, published once mapped
+static _Atomic(const WCSharedConfigBlock *) gReaderBlock;
+
+// Identity of the mapped file, so a recreated file is mapped again
+static dev_t gReaderDevice;
+static ino_t gReaderInode;
+static os_unfair_lock gReaderLock = OS_UNFAIR_LOCK_INIT;
+
+#pragma mark - Paths
+
+NSString *WCSharedConfigPath(void) {
+    NSString *overridePath = [[NSProcessInfo processInfo] environment][@"WCI_SHARED_CONFIG_PATH"];
+    if (overridePath.length > 0) {
+        return [overridePath stringByExpandingTildeInPath];
+    }
+
+    NSString *supportPath = [[WCPathResolver sharedResolver] applicationSupportDirectoryPath];
+    return [[supportPath stringByAppendingPathComponent:@"WindowControlInjector"]
+            stringByAppendingPathComponent:@"shared_config"];
+}
+
+#pragma mark - Reading
+
+static BOOL WCSharedConfigBlockIsValid(const WCSharedConfigBlock *block) {
+    return block->magic == kWCSharedConfigMagic && block->layoutVersion == kWCSharedConfigLayoutVersion;
+}
+
+static BOOL WCSharedConfigReadBlock(const WCSharedConfigBlock *block, WCSharedConfigValues *values, uint64_t *sequence) {
+    if (!WCSharedConfigBlockIsValid(block)) return NO;
+
+    // Mapped read-only, so the atomics are only ever loaded here
+    _Atomic(uint64_t) *sequenceSlot = (_Atomic(uint64_t) *)&block->sequence;
+    _Atomic(int64_t) *levelSlot = (_Atomic(int64_t) *)&block->windowLevel;
+    _Atomic(uint64_t) *optionsSlot = (_Atomic(uint64_t) *)&block->options;
+
+    for (;;) {
+        uint64_t before = atomic_load_explicit(sequenceSlot, memory_order_acquire);
+        if (before == 0) return NO;
+        if (before & 1) continue;
+
+        values->windowLevel = atomic_load_explicit(levelSlot, memory_order_relaxed);
+        values->options = atomic_load_explicit(optionsSlot, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(sequenceSlot, memory_order_relaxed) == before) {
+            if (sequence) *sequence = before;
+            return YES;
+        }
+    }
+}
+
+/**
+ * Map the shared file read-only, or map it again if it was recreated
+ *
+ * Old mappings are never unmapped because other threads may still be reading them.
+ */
+static const WCSharedConfigBlock *WCSharedConfigMapReader(void) {
+    os_unfair_lock_lock(&gReaderLock);
+
+    const WCSharedConfigBlock *block = atomic_load_explicit(&gReaderBlock, memory_order_acquire);
+    int fd = open(WCSharedConfigPath().fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        struct stat info;
+        BOOL sameFile = block && fstat(fd, &info) == 0 &&
+                        info.st_dev == gReaderDevice && info.st_ino == gReaderInode;
+
+        if (!sameFile && fstat(fd, &info) == 0 && (size_t)info.st_size >= kWCSharedConfigFileSize) {
+            void *mapping = mmap(NULL, kWCSharedConfigFileSize, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapping != MAP_FAILED) {
+                block = mapping;
+                gReaderDevice = info.st_dev;
+                gReaderInode = info.st_ino;
+                atomic_store_explicit(&gReaderBlock, block, memory_order_release);
+            }
+        }
+        close(fd);
+    }
+
+    os_unfair_lock_unlock(&gReaderLock);
+    return block;
+}
+
+BOOL WCSharedConfigRead(WCSharedConfigValues *values, uint64_t *generation) {
+    if (!values) return NO;
+
+    const WCSharedConfigBlock *block = atomic_load_explicit(&gReaderBlock, memory_order_acquire);
+    if (!block) block = WCSharedConfigMapReader();
+    if (!block) return NO;
+
+    uint64_t sequence = 0;
+    if (!WCSharedConfigReadBlock(block, values, &sequence)) return NO;
+    if (generation) *generation = sequence / 2;
+    return YES;
+}
+
+BOOL WCSharedConfigCopyIfChanged(uint64_t *lastGeneration, WCSharedConfigValues *values) {
+    if (!lastGeneration || !values) return NO;
+
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        WCSharedConfigMapReader();
+    });
+
+    const WCSharedConfigBlock *block = atomic_load_explicit(&gReaderBlock, memory_order_acquire);
+    if (!block) return NO;
+
+    // The common unchanged case
+    _Atomic(uint64_t) *sequenceSlot = (_Atomic(uint64_t) *)&block->sequence;
+    uint64_t sequence = atomic_load_explicit(sequenceSlot, memory_order_acquire);
+    if (sequence / 2 == *lastGeneration) return NO;
+
+    if (!WCSharedConfigReadBlock(block, values, &sequence)) return NO;
+    *lastGeneration = sequence / 2;
+    return YES;
+}
+
+#pragma mark - Publishing
+
+BOOL WCSharedConfigPublish(const WCSharedConfigValues *values, uint64_t *generation) {
+    if (!values) return NO;
+
+    NSString *path = WCSharedConfigPath();
+    [[NSFileManager defaultManager] createDirectoryAtPath:[path stringByDeletingLastPathComponent]
+                              withIntermediateDirectories:YES
+                                               attributes:nil
+                                                    error:NULL];
+
+    int fd = open(path.fileSystemRepresentation, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        WCLogError(@"Configuration", @"Could not open shared configuration %@: %s", path, strerror(errno));
+        return NO;
+    }
+
+    if (flock(fd, LOCK_EX) != 0) {
+        close(fd);
+        return NO;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 ||
+        ((size_t)info.st_size < kWCSharedConfigFileSize && ftruncate(fd, (off_t)kWCSharedConfigFileSize) != 0)) {
+        WCLogError(@"Configuration", @"Could not size shared configuration %@: %s", path, strerror(errno));
+        flock(fd, LOCK_UN);
+        close(fd);
+        return NO;
+    }
+
+    WCSharedConfigBlock *block = mmap(NULL, kWCSharedConfigFileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (block == MAP_FAILED) {
+        WCLogError(@"Configuration", @"Could not map shared configuration %@: %s", path, strerror(errno));
+        flock(fd, LOCK_UN);
+        close(fd);
+        return NO;
+    }
+
+    if (!WCSharedConfigBlockIsValid(block)) {
+        // A fresh or incompatible file; zeroed sequence tells readers nothing was published yet
+        atomic_store_explicit(&block->sequence, 0, memory_order_relaxed);
+        block->magic = kWCSharedConfigMagic;
+        block->layoutVersion = kWCSharedConfigLayoutVersion;
+    }
+
+    uint64_t sequence = atomic_load_explicit(&block->sequence, memory_order_relaxed) & ~(uint64_t)1;
+    atomic_store_explicit(&block->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&block->windowLevel, values->windowLevel, memory_order_relaxed);
+    atomic_store_explicit(&block->options, values->options, memory_order_relaxed);
+    atomic_store_explicit(&block->sequence, sequence + 2, memory_order_release);
+
+    munmap(block, kWCSharedConfigFileSize);
+    flock(fd, LOCK_UN);
+    close(fd);
+
+    notify_post(WCSharedConfigNotificationName);
+
+    if (generation) *generation = (sequence + 2) / 2;
+    return YES;
+}
+
+#pragma mark - Monitoring
+
+BOOL WCSharedConfigStartMonitoring(dispatch_queue_t queue, dispatch_block_t handler) {
+    static int token = NOTIFY_TOKEN_INVALID;
+    static BOOL registered = NO;
+    static dispatch_once_t onceToken;
+
+    if (!queue || !handler) return NO;
+
+    dispatch_once(&onceToken, ^{
+        uint32_t status = notify_register_dispatch(WCSharedConfigNotificationName, &token, queue, ^(int notifyToken) {
+            (void)notifyToken;
+
+            // The file may have been created after this process started
+            WCSharedConfigMapReader();
+            handler();
+        });
+        registered = status == NOTIFY_STATUS_OK;
+
+        if (!registered) {
+            WCLogWarning(@"Configuration", @"Could not register for shared configuration changes: %u", status);
+        }
+    });
+
+    return registered;
+}
+
+#pragma mark - Active Settings
+
+void WCSharedConfigActivate(const WCSharedConfigValues *values) {
+    if (!values) return;
+
+    NSWindowSharingType sharingType = (values->options & WCConfigurationOptionPreventScreenCapture) ? NSWindowSharingNone : NSWindowSharingReadOnly;
+    atomic_store_explicit(&WCSharedConfigActiveLevel, values->windowLevel, memory_order_relaxed);
+    atomic_store_explicit(&WCSharedConfigActiveSharing, (int32_t)sharingType, memory_order_relaxed);
+}
@@ -0,0 +1,113 @@
+/**
+ * @file wc_timing_wheel.h
+ * @brief Hashed timing wheel of per-window deadlines for WindowControlInjector
+ *
+ * This file defines a timing wheel that remembers, for each window ID, a
+ * deadline on the monotonic clock. It answers "is this window still within
+ * its interval" with one hash lookup and forgets windows as their deadlines
+ * pass, so debounce state stays proportional to the windows touched within
+ * the interval rather than to every window ever seen.
+ */
+
+#ifndef WC_TIMING_WHEEL_H
+#define WC_TIMING_WHEEL_H
+
+#include <CoreGraphics/CoreGraphics.h>
+#include <stdbool.h>
+#include <stdint.h>
+#import "wc_window_id_set.h"
+
+/**
+ * @brief One slot of the wheel, a reusable list of window IDs
+ */
+typedef struct {
+    CGWindowID *windowIDs;
+    uint32_t count;
+    uint32_t capacity;
+} WCTimingWheelSlot;
+
+/**
+ * @brief Window ID deadlines bucketed by expiry tick
+ *
+ * Each window's authoritative deadline lives in a WCWindowIDMap. Slots may
+ * hold stale IDs of windows that were rescheduled or removed; those are
+ * dropped when their slot is swept. Deadlines further out than one turn of
+ * the wheel stay in their slot until the turn they expire in. Slot storage is
+ * kept between turns, so steady-state scheduling does not allocate. The
+ * wheel is not thread-safe; each owner guards it the same way it guards its
+ * other state.
+ */
+typedef struct {
+    WCWindowIDMap deadlines;      // Window ID to uint64_t deadline in nanoseconds
+    WCTimingWheelSlot *slots;
+    uint32_t slotCount;           // Always a power of two
+    uint64_t resolution;          // Nanoseconds per slot
+    uint64_t lastSweptTick;       // Last tick whose slot was swept
+} WCTimingWheel;
+
+/**
+ * @brief Initialize an empty wheel
+ *
+ * @param wheel The wheel to initialize
+ * @param resolution Nanoseconds covered by each slot
+ * @param slotCount Number of slots, rounded up to a power of two
+ * @param now Current time in nanoseconds, e.g. WCMetricsNow()
+ */
+void WCTimingWheelInit(WCTimingWheel *wheel, uint64_t resolution, uint32_t slotCount, uint64_t now);
+
+/**
+ * @brief Release the storage of a wheel
+ *
+ * @param wheel The wheel to destroy; it may be re-initialized afterwards
+ */
+void WCTimingWheelDestroy(WCTimingWheel *wheel);
+
+/**
+ * @brief Forget every window while keeping the allocated storage
+ *
+ * @param wheel The wheel to clear
+ */
+void WCTimingWheelClear(WCTimingWheel *wheel);
+
+/**
+ * @brief Forget windows whose deadlines have passed
+ *
+ * Sweeps only the slots between the previous call and now; scheduling and
+ * lookups call it themselves.
+ *
+ * @param wheel The wheel to advance
+ * @param now Current time in nanoseconds
+ */
+void WCTimingWheelAdvance(WCTimingWheel *wheel, uint64_t now);
+
+/**
+ * @brief Set or replace a window's deadline
+ *
+ * @param wheel The wheel to modify
+ * @param windowID The window to schedule
+ * @param deadline Deadline in nanoseconds
+ * @param now Current time in nanoseconds
+ * @return true if the window was scheduled, false if the ID is invalid or allocation failed
+ */
+bool WCTimingWheelSchedule(WCTimingWheel *wheel, CGWindowID windowID, uint64_t deadline, uint64_t now);
+
+/**
+ * @brief Check if a window's deadline is still ahead
+ *
+ * @param wheel The wheel to search
+ * @param windowID The window to check
+ * @param now Current time in nanoseconds
+ * @param remaining Receives the nanoseconds left when pending; may be NULL
+ * @return true if the window has a deadline later than now
+ */
+bool WCTimingWheelIsPending(WCTimingWheel *wheel, CGWindowID windowID, uint64_t now, uint64_t *remaining);
+
+/**
+ * @brief Forget a window, for example after it is destroyed
+ *
+ * @param wheel The wheel to modify
+ * @param windowID The window to forget
+ */
+void WCTimingWheelRemove(WCTimingWheel *wheel, CGWindowID windowID);
+
+#endif /* WC_TIMING_WHEEL_H */
@@ -0,0 +1,169 @@
+/**
+ * @file wc_timing_wheel.m
+ * @brief Implementation of the hashed timing wheel of window deadlines
+ */
+
+#import "wc_timing_wheel.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Smallest ID list allocated for a slot on first use
+static const uint32_t kWCMinimumSlotCapacity = 8;
+
+/**
+ * Deadline of one window, stored inline in the deadline map
+ */
+typedef struct {
+    uint64_t deadline;  // Nanoseconds
+    uint64_t slotTick;  // Tick of the slot the window was filed under
+} WCTimingWheelEntry;
+
+static inline uint64_t WCTimingWheelTick(const WCTimingWheel *wheel, uint64_t time) {
+    return time / wheel->resolution;
+}
+
+static bool WCTimingWheelSlotAppend(WCTimingWheelSlot *slot, CGWindowID windowID) {
+    if (slot->count == slot->capacity) {
+        uint32_t capacity = slot->capacity > 0 ? slot->capacity * 2 : kWCMinimumSlotCapacity;
+        CGWindowID *windowIDs = realloc(slot->windowIDs, (size_t)capacity * sizeof(CGWindowID));
+        if (!windowIDs) return false;
+
+        slot->windowIDs = windowIDs;
+        slot->capacity = capacity;
+    }
+
+    slot->windowIDs[slot->count++] = windowID;
+    return true;
+}
+
+/**
+ * Drop expired and stale IDs from one slot, keeping windows due on a later turn
+ */
+static void WCTimingWheelSweepSlot(WCTimingWheel *wheel, uint32_t index, uint64_t sweptTick) {
+    WCTimingWheelSlot *slot = &wheel->slots[index];
+    uint32_t mask = wheel->slotCount - 1;
+    uint32_t kept = 0;
+
+    for (uint32_t i = 0; i < slot->count; i++) {
+        CGWindowID windowID = slot->windowIDs[i];
+        WCTimingWheelEntry *entry = WCWindowIDMapGet(&wheel->deadlines, windowID);
+
+        // Removed, or rescheduled into another slot
+        if (!entry || (uint32_t)(entry->slotTick & mask) != index) continue;
+
+        if (entry->slotTick <= sweptTick) {
+            WCWindowIDMapRemove(&wheel->deadlines, windowID);
+            continue;
+        }
+
+        slot->windowIDs[kept++] = windowID;
+    }
+
+    slot->count = kept;
+}
+
+void WCTimingWheelInit(WCTimingWheel *wheel, uint64_t resolution, uint32_t slotCount, uint64_t now) {
+    uint32_t count = 1;
+    while (count < slotCount && count < (1u << 16)) {
+        count <<= 1;
+    }
+
+    wheel->resolution = resolution > 0 ? resolution : 1;
+    wheel->slotCount = count;
+    wheel->slots = calloc(count, sizeof(WCTimingWheelSlot));
+    if (!wheel->slots) {
+        wheel->slotCount = 0;
+    }
+
+    uint64_t tick = WCTimingWheelTick(wheel, now);
+    wheel->lastSweptTick = tick > 0 ? tick - 1 : 0;
+
+    WCWindowIDMapInit(&wheel->deadlines, sizeof(WCTimingWheelEntry), 0);
+}
+
+void WCTimingWheelDestroy(WCTimingWheel *wheel) {
+    for (uint32_t i = 0; i < wheel->slotCount; i++) {
+        free(wheel->slots[i].windowIDs);
+    }
+    free(wheel->slots);
+    wheel->slots = NULL;
+    wheel->slotCount = 0;
+
+    WCWindowIDMapDestroy(&wheel->deadlines);
+}
+
+void WCTimingWheelClear(WCTimingWheel *wheel) {
+    for (uint32_t i = 0; i < wheel->slotCount; i++) {
+        wheel->slots[i].count = 0;
+    }
+    WCWindowIDMapClear(&wheel->deadlines);
+}
+
+void WCTimingWheelAdvance(WCTimingWheel *wheel, uint64_t now) {
+    if (wheel->slotCount == 0) return;
+
+    // Only ticks that are fully in the past can be swept
+    uint64_t currentTick = WCTimingWheelTick(wheel, now);
+    if (currentTick == 0) return;
+
+    uint64_t sweptTick = currentTick - 1;
+    if (sweptTick <= wheel->lastSweptTick) return;
+
+    uint64_t ticks = sweptTick - wheel->lastSweptTick;
+    if (ticks > wheel->slotCount) {
+        ticks = wheel->slotCount;
+    }
+
+    uint32_t mask = wheel->slotCount - 1;
+    for (uint64_t tick = sweptTick - ticks + 1; tick <= sweptTick; tick++) {
+        WCTimingWheelSweepSlot(wheel, (uint32_t)(tick & mask), sweptTick);
+    }
+
+    wheel->lastSweptTick = sweptTick;
+}
+
+bool WCTimingWheelSchedule(WCTimingWheel *wheel, CGWindowID windowID, uint64_t deadline, uint64_t now) {
+    if (wheel->slotCount == 0) return false;
+
+    WCTimingWheelAdvance(wheel, now);
+
+    bool created = false;
+    WCTimingWheelEntry *entry = WCWindowIDMapUpsert(&wheel->deadlines, windowID, &created);
+    if (!entry) return false;
+
+    // A deadline in an already swept tick goes into the next slot to be swept
+    uint64_t slotTick = WCTimingWheelTick(wheel, deadline);
+    if (slotTick <= wheel->lastSweptTick) {
+        slotTick = wheel->lastSweptTick + 1;
+    }
+
+    uint32_t mask = wheel->slotCount - 1;
+    uint32_t index = (uint32_t)(slotTick & mask);
+    bool alreadyFiled = !created && (uint32_t)(entry->slotTick & mask) == index;
+
+    entry->deadline = deadline;
+    entry->slotTick = slotTick;
+
+    if (!alreadyFiled && !WCTimingWheelSlotAppend(&wheel->slots[index], windowID)) {
+        // Without a slot entry the deadline would never be swept
+        WCWindowIDMapRemove(&wheel->deadlines, windowID);
+        return false;
+    }
+
+    return true;
+}
+
+bool WCTimingWheelIsPending(WCTimingWheel *wheel, CGWindowID windowID, uint64_t now, uint64_t *remaining) {
+    WCTimingWheelAdvance(wheel, now);
+
+    const WCTimingWheelEntry *entry = WCWindowIDMapGet(&wheel->deadlines, windowID);
+    if (!entry || entry->deadline <= now) return false;
+
+    if (remaining) *remaining = entry->deadline - now;
+    return true;
+}
+
+void WCTimingWheelRemove(WCTimingWheel *wheel, CGWindowID windowID) {
+    // The slot entry becomes stale and is dropped when its slot is swept
+    WCWindowIDMapRemove(&wheel->deadlines, windowID);
+}
@@ -0,0 +1,163 @@
+/**
+ * @file wc_window_id_set.h
+ * @brief Compact hash set and map of window IDs for WindowControlInjector
+ *
+ * This file defines an open-addressing hash set and map keyed on raw
+ * CGWindowID values. They are used for window de-duplication, "already
+ * protected" checks and per-window state on hot paths where boxing every
+ * ID into an NSNumber is too costly.
+ */
+
+#ifndef WC_WINDOW_ID_SET_H
+#define WC_WINDOW_ID_SET_H
+
+#include <CoreGraphics/CoreGraphics.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Open-addressing set of CGWindowID values
+ *
+ * Uses linear probing over a power-of-two table. kCGNullWindowID marks an
+ * empty slot and UINT32_MAX marks a deleted one, so neither can be stored.
+ * The set is not thread-safe; each owner guards it the same way it guards
+ * its other state.
+ */
+typedef struct {
+    CGWindowID *slots;
+    uint32_t capacity;     // Number of slots, always a power of two or 0
+    uint32_t count;        // Number of stored IDs
+    uint32_t tombstones;   // Number of deleted slots awaiting reuse
+} WCWindowIDSet;
+
+/**
+ * @brief Initialize an empty set
+ *
+ * @param set The set to initialize
+ * @param expectedCount Number of IDs the set should hold without growing
+ */
+void WCWindowIDSetInit(WCWindowIDSet *set, uint32_t expectedCount);
+
+/**
+ * @brief Release the storage of a set
+ *
+ * @param set The set to destroy; it may be re-initialized afterwards
+ */
+void WCWindowIDSetDestroy(WCWindowIDSet *set);
+
+/**
+ * @brief Remove all IDs while keeping the allocated storage
+ *
+ * @param set The set to clear
+ */
+void WCWindowIDSetClear(WCWindowIDSet *set);
+
+/**
+ * @brief Check if a window ID is in the set
+ *
+ * @param set The set to search
+ * @param windowID The window ID to look for
+ * @return true if the ID is present
+ */
+bool WCWindowIDSetContains(const WCWindowIDSet *set, CGWindowID windowID);
+
+/**
+ * @brief Add a window ID to the set
+ *
+ * @param set The set to modify
+ * @param windowID The window ID to add
+ * @return true if the ID was added, false if it was already present or invalid
+ */
+bool WCWindowIDSetInsert(WCWindowIDSet *set, CGWindowID windowID);
+
+/**
+ * @brief Remove a window ID from the set
+ *
+ * @param set The set to modify
+ * @param windowID The window ID to remove
+ * @return true if the ID was present
+ */
+bool WCWindowIDSetRemove(WCWindowIDSet *set, CGWindowID windowID);
+
+/**
+ * @brief Open-addressing map from CGWindowID to a fixed-size value
+ *
+ * Same probing scheme and key restrictions as WCWindowIDSet. Values are
+ * plain bytes of valueSize each, stored inline and zero-initialized on
+ * insert. Pointers returned by the map are invalidated by the next insert.
+ */
+typedef struct {
+    CGWindowID *keys;
+    uint8_t *values;
+    size_t valueSize;
+    uint32_t capacity;
+    uint32_t count;
+    uint32_t tombstones;
+} WCWindowIDMap;
+
+/**
+ * @brief Initialize an empty map
+ *
+ * @param map The map to initialize
+ * @param valueSize Size in bytes of each value
+ * @param expectedCount Number of entries the map should hold without growing
+ */
+void WCWindowIDMapInit(WCWindowIDMap *map, size_t valueSize, uint32_t expectedCount);
+
+/**
+ * @brief Release the storage of a map
+ *
+ * @param map The map to destroy; it may be re-initialized afterwards
+ */
+void WCWindowIDMapDestroy(WCWindowIDMap *map);
+
+/**
+ * @brief Remove all entries while keeping the allocated storage
+ *
+ * @param map The map to clear
+ */
+void WCWindowIDMapClear(WCWindowIDMap *map);
+
+/**
+ * @brief Look up the value for a window ID
+ *
+ * @param map The map to search
+ * @param windowID The window ID to look for
+ * @return Pointer to the stored value, or NULL if the ID is absent
+ */
+void *WCWindowIDMapGet(const WCWindowIDMap *map, CGWindowID windowID);
+
+/**
+ * @brief Look up the value for a window ID, inserting a zeroed value if absent
+ *
+ * @param map The map to modify
+ * @param windowID The window ID to look up or add
+ * @param created Set to true if a new entry was inserted; may be NULL
+ * @return Pointer to the stored value, or NULL if the ID is invalid or allocation failed
+ */
+void *WCWindowIDMapUpsert(WCWindowIDMap *map, CGWindowID windowID, bool *created);
+
+/**
+ * @brief Remove the entry for a window ID
+ *
+ * @param map The map to modify
+ * @param windowID The window ID to remove
+ * @return true if the entry was present
+ */
+bool WCWindowIDMapRemove(WCWindowIDMap *map, CGWindowID windowID);
+
+/**
+ * @brief Visit every entry in the map
+ *
+ * The visitor must not insert into or remove from the map.
+ *
+ * @param map The map to walk
+ * @param visitor Function called with each key, value and the context pointer
+ * @param context Caller data passed through to the visitor
+ */
+void WCWindowIDMapForEach(const WCWindowIDMap *map,
+                          void (*visitor)(CGWindowID windowID, void *value, void *context),
+                          void *context);
+
+#endif /* WC_WINDOW_ID_SET_H */
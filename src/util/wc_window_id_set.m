@@ -0,0 +1,335 @@
+/**
+ * @file wc_window_id_set.m
+ * @brief Implementation of the compact window ID hash set and map
+ */
+
+#import "wc_window_id_set.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Slot markers; neither is a window ID the WindowServer hands out
+static const CGWindowID kWCEmptySlot = kCGNullWindowID;
+static const CGWindowID kWCDeletedSlot = UINT32_MAX;
+
+// Smallest table allocated on first insert
+static const uint32_t kWCMinimumCapacity = 16;
+
+static inline uint32_t WCWindowIDHash(CGWindowID windowID) {
+    // Fibonacci hashing spreads the mostly sequential window IDs across the table
+    return windowID * 2654435769u;
+}
+
+static uint32_t WCCapacityForCount(uint32_t count) {
+    // Keep the load factor at or below 70%
+    uint64_t needed = ((uint64_t)count * 10) / 7 + 1;
+    uint32_t capacity = kWCMinimumCapacity;
+    while (capacity < needed && capacity < (1u << 31)) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+static void WCWindowIDSetRehash(WCWindowIDSet *set, uint32_t newCapacity) {
+    CGWindowID *oldSlots = set->slots;
+    uint32_t oldCapacity = set->capacity;
+
+    CGWindowID *newSlots = calloc(newCapacity, sizeof(CGWindowID));
+    if (!newSlots) {
+        return;  // Keep the old table; inserts fail once it is full
+    }
+
+    set->slots = newSlots;
+    set->capacity = newCapacity;
+    set->count = 0;
+    set->tombstones = 0;
+
+    uint32_t mask = newCapacity - 1;
+    for (uint32_t i = 0; i < oldCapacity; i++) {
+        CGWindowID windowID = oldSlots[i];
+        if (windowID == kWCEmptySlot || windowID == kWCDeletedSlot) continue;
+
+        uint32_t index = WCWindowIDHash(windowID) & mask;
+        while (newSlots[index] != kWCEmptySlot) {
+            index = (index + 1) & mask;
+        }
+        newSlots[index] = windowID;
+        set->count++;
+    }
+
+    free(oldSlots);
+}
+
+void WCWindowIDSetInit(WCWindowIDSet *set, uint32_t expectedCount) {
+    set->slots = NULL;
+    set->capacity = 0;
+    set->count = 0;
+    set->tombstones = 0;
+
+    if (expectedCount > 0) {
+        WCWindowIDSetRehash(set, WCCapacityForCount(expectedCount));
+    }
+}
+
+void WCWindowIDSetDestroy(WCWindowIDSet *set) {
+    free(set->slots);
+    set->slots = NULL;
+    set->capacity = 0;
+    set->count = 0;
+    set->tombstones = 0;
+}
+
+void WCWindowIDSetClear(WCWindowIDSet *set) {
+    if (set->slots) {
+        memset(set->slots, 0, set->capacity * sizeof(CGWindowID));
+    }
+    set->count = 0;
+    set->tombstones = 0;
+}
+
+bool WCWindowIDSetContains(const WCWindowIDSet *set, CGWindowID windowID) {
+    if (set->capacity == 0 || windowID == kWCEmptySlot || windowID == kWCDeletedSlot) {
+        return false;
+    }
+
+    uint32_t mask = set->capacity - 1;
+    uint32_t index = WCWindowIDHash(windowID) & mask;
+
+    for (uint32_t probes = 0; probes < set->capacity; probes++) {
+        CGWindowID slot = set->slots[index];
+        if (slot == windowID) return true;
+        if (slot == kWCEmptySlot) return false;
+        index = (index + 1) & mask;
+    }
+
+    return false;
+}
+
+bool WCWindowIDSetInsert(WCWindowIDSet *set, CGWindowID windowID) {
+    if (windowID == kWCEmptySlot || windowID == kWCDeletedSlot) {
+        return false;
+    }
+
+    // Grow (or purge tombstones) before the table gets too crowded to probe quickly
+    if (set->capacity == 0 ||
+        (uint64_t)(set->count + set->tombstones + 1) * 10 > (uint64_t)set->capacity * 7) {
+        WCWindowIDSetRehash(set, WCCapacityForCount(set->count + 1));
+        if (set->capacity == 0) return false;
+    }
+
+    uint32_t mask = set->capacity - 1;
+    uint32_t index = WCWindowIDHash(windowID) & mask;
+    int64_t firstDeleted = -1;
+
+    for (uint32_t probes = 0; probes < set->capacity; probes++) {
+        CGWindowID slot = set->slots[index];
+
+        if (slot == windowID) {
+            return false;
+        }
+        if (slot == kWCDeletedSlot && firstDeleted < 0) {
+            firstDeleted = index;
+        } else if (slot == kWCEmptySlot) {
+            break;
+        }
+        index = (index + 1) & mask;
+    }
+
+    if (firstDeleted >= 0) {
+        index = (uint32_t)firstDeleted;
+        set->tombstones--;
+    } else if (set->slots[index] != kWCEmptySlot) {
+        return false;  // Table is full; only possible if a rehash allocation failed
+    }
+
+    set->slots[index] = windowID;
+    set->count++;
+    return true;
+}
+
+bool WCWindowIDSetRemove(WCWindowIDSet *set, CGWindowID windowID) {
+    if (set->capacity == 0 || windowID == kWCEmptySlot || windowID == kWCDeletedSlot) {
+        return false;
+    }
+
+    uint32_t mask = set->capacity - 1;
+    uint32_t index = WCWindowIDHash(windowID) & mask;
+
+    for (uint32_t probes = 0; probes < set->capacity; probes++) {
+        CGWindowID slot = set->slots[index];
+        if (slot == windowID) {
+            set->slots[index] = kWCDeletedSlot;
+            set->count--;
+            set->tombstones++;
+            return true;
+        }
+        if (slot == kWCEmptySlot) return false;
+        index = (index + 1) & mask;
+    }
+
+    return false;
+}
+
+#pragma mark - Map
+
+static void WCWindowIDMapRehash(WCWindowIDMap *map, uint32_t newCapacity) {
+    CGWindowID *oldKeys = map->keys;
+    uint8_t *oldValues = map->values;
+    uint32_t oldCapacity = map->capacity;
+
+    CGWindowID *newKeys = calloc(newCapacity, sizeof(CGWindowID));
+    uint8_t *newValues = calloc(newCapacity, map->valueSize);
+    if (!newKeys || !newValues) {
+        free(newKeys);
+        free(newValues);
+        return;  // Keep the old table; inserts fail once it is full
+    }
+
+    map->keys = newKeys;
+    map->values = newValues;
+    map->capacity = newCapacity;
+    map->count = 0;
+    map->tombstones = 0;
+
+    uint32_t mask = newCapacity - 1;
+    for (uint32_t i = 0; i < oldCapacity; i++) {
+        CGWindowID windowID = oldKeys[i];
+        if (windowID == kWCEmptySlot || windowID == kWCDeletedSlot) continue;
+
+        uint32_t index = WCWindowIDHash(windowID) & mask;
+        while (newKeys[index] != kWCEmptySlot) {
+            index = (index + 1) & mask;
+        }
+        newKeys[index] = windowID;
+        memcpy(newValues + (size_t)index * map->valueSize, oldValues + (size_t)i * map->valueSize, map->valueSize);
+        map->count++;
+    }
+
+    free(oldKeys);
+    free(oldValues);
+}
+
+void WCWindowIDMapInit(WCWindowIDMap *map, size_t valueSize, uint32_t expectedCount) {
+    map->keys = NULL;
+    map->values = NULL;
+    map->valueSize = valueSize > 0 ? valueSize : 1;
+    map->capacity = 0;
+    map->count = 0;
+    map->tombstones = 0;
+
+    if (expectedCount > 0) {
+        WCWindowIDMapRehash(map, WCCapacityForCount(expectedCount));
+    }
+}
+
+void WCWindowIDMapDestroy(WCWindowIDMap *map) {
+    free(map->keys);
+    free(map->values);
+    map->keys = NULL;
+    map->values = NULL;
+    map->capacity = 0;
+    map->count = 0;
+    map->tombstones = 0;
+}
+
+void WCWindowIDMapClear(WCWindowIDMap *map) {
+    if (map->keys) {
+        memset(map->keys, 0, map->capacity * sizeof(CGWindowID));
+    }
+    map->count = 0;
+    map->tombstones = 0;
+}
+
+void *WCWindowIDMapGet(const WCWindowIDMap *map, CGWindowID windowID) {
+    if (map->capacity == 0 || windowID == kWCEmptySlot || windowID == kWCDeletedSlot) {
+        return NULL;
+    }
+
+    uint32_t mask = map->capacity - 1;
+    uint32_t index = WCWindowIDHash(windowID) & mask;
+
+    for (uint32_t probes = 0; probes < map->capacity; probes++) {
+        CGWindowID key = map->keys[index];
+        if (key == windowID) return map->values + (size_t)index * map->valueSize;
+        if (key == kWCEmptySlot) return NULL;
+        index = (index + 1) & mask;
+    }
+
+    return NULL;
+}
+
+void *WCWindowIDMapUpsert(WCWindowIDMap *map, CGWindowID windowID, bool *created) {
+    if (created) *created = false;
+
+    if (windowID == kWCEmptySlot || windowID == kWCDeletedSlot) {
+        return NULL;
+    }
+
+    void *existing = WCWindowIDMapGet(map, windowID);
+    if (existing) {
+        return existing;
+    }
+
+    if (map->capacity == 0 ||
+        (uint64_t)(map->count + map->tombstones + 1) * 10 > (uint64_t)map->capacity * 7) {
+        WCWindowIDMapRehash(map, WCCapacityForCount(map->count + 1));
+        if (map->capacity == 0) return NULL;
+    }
+
+    // The key is known to be absent, so the first free slot on its probe path is where it goes
+    uint32_t mask = map->capacity - 1;
+    uint32_t index = WCWindowIDHash(windowID) & mask;
+
+    for (uint32_t probes = 0; probes < map->capacity; probes++) {
+        CGWindowID key = map->keys[index];
+        if (key == kWCEmptySlot || key == kWCDeletedSlot) {
+            if (key == kWCDeletedSlot) {
+                map->tombstones--;
+            }
+
+            map->keys[index] = windowID;
+            map->count++;
+
+            uint8_t *value = map->values + (size_t)index * map->valueSize;
+            memset(value, 0, map->valueSize);
+
+            if (created) *created = true;
+            return value;
+        }
+        index = (index + 1) & mask;
+    }
+
+    return NULL;  // Table is full; only possible if a rehash allocation failed
+}
+
+bool WCWindowIDMapRemove(WCWindowIDMap *map, CGWindowID windowID) {
+    if (map->capacity == 0 || windowID == kWCEmptySlot || windowID == kWCDeletedSlot) {
+        return false;
+    }
+
+    uint32_t mask = map->capacity - 1;
+    uint32_t index = WCWindowIDHash(windowID) & mask;
+
+    for (uint32_t probes = 0; probes < map->capacity; probes++) {
+        CGWindowID key = map->keys[index];
+        if (key == windowID) {
+            map->keys[index] = kWCDeletedSlot;
+            map->count--;
+            map->tombstones++;
+            return true;
+        }
+        if (key == kWCEmptySlot) return false;
+        index = (index + 1) & mask;
+    }
+
+    return false;
+}
+
+void WCWindowIDMapForEach(const WCWindowIDMap *map,
+                          void (*visitor)(CGWindowID windowID, void *value, void *context),
+                          void *context) {
+    for (uint32_t i = 0; i < map->capacity; i++) {
+        CGWindowID key = map->keys[i];
+        if (key == kWCEmptySlot || key == kWCDeletedSlot) continue;
+        visitor(key, map->values + (size_t)i * map->valueSize, context);
+    }
+}
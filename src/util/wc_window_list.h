@@ -0,0 +1,40 @@
+/**
+ * @file wc_window_list.h
+ * @brief Replaceable window list source for WindowControlInjector
+ *
+ * Every read of the window server's window list goes through
+ * WCWindowListCopy, which calls CGWindowListCopyWindowInfo unless another
+ * source is installed. The trace replay driver installs one that serves
+ * recorded windows, so the scanner runs unmodified against a mock window
+ * server.
+ */
+
+#ifndef WC_WINDOW_LIST_H
+#define WC_WINDOW_LIST_H
+
+#include <CoreGraphics/CoreGraphics.h>
+
+/**
+ * @brief Function with the contract of CGWindowListCopyWindowInfo
+ *
+ * May be called on any thread. The caller owns the returned array.
+ */
+typedef CFArrayRef (*WCWindowListCopyFunction)(CGWindowListOption option, CGWindowID relativeToWindow);
+
+/**
+ * @brief Replace the window list source
+ *
+ * @param function The source to use, or NULL to go back to CGWindowListCopyWindowInfo
+ */
+void WCWindowListSetCopyFunction(WCWindowListCopyFunction function);
+
+/**
+ * @brief Copy the window list from the installed source
+ *
+ * @param option Which windows to list
+ * @param relativeToWindow The window the option refers to, or kCGNullWindowID
+ * @return Array of window dictionaries owned by the caller, or NULL
+ */
+CFArrayRef WCWindowListCopy(CGWindowListOption option, CGWindowID relativeToWindow);
+
+#endif /* WC_WINDOW_LIST_H */
@@ -0,0 +1,21 @@
+/**
+ * @file wc_window_list.m
+ * @brief Implementation of the replaceable window list source
+ */
+
+#import "wc_window_list.h"
+#include <stdatomic.h>
+
+static _Atomic(WCWindowListCopyFunction) gCopyFunction = NULL;
+
+void WCWindowListSetCopyFunction(WCWindowListCopyFunction function) {
+    atomic_store_explicit(&gCopyFunction, function, memory_order_release);
+}
+
+CFArrayRef WCWindowListCopy(CGWindowListOption option, CGWindowID relativeToWindow) {
+    WCWindowListCopyFunction function = atomic_load_explicit(&gCopyFunction, memory_order_acquire);
+    if (function) {
+        return function(option, relativeToWindow);
+    }
+    return CGWindowListCopyWindowInfo(option, relativeToWindow);
+}